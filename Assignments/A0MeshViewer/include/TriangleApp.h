@@ -32,6 +32,7 @@ private:
 
   ComPtr<ID3D12Resource>  m_indexBuffer;
   D3D12_INDEX_BUFFER_VIEW m_indexBufferView;
+  gims::ui32              m_nIndices; //! Number of indices, 16 or 32 bit depending on the number of vertices.
 
   std::vector<ComPtr<ID3D12Resource>> m_constantBuffers;
   ComPtr<ID3D12DescriptorHeap>        m_cbv;
@@ -6,7 +6,10 @@
 #include <gimslib/d3d/DX12Util.hpp>
 #include <gimslib/d3d/UploadHelper.hpp>
 #include <gimslib/dbg/HrException.hpp>
-#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/io/CograBinaryMeshView.hpp>
+#include <gimslib/mesh/MeshBounds.hpp>
+#include <gimslib/mesh/MeshNormals.hpp>
+#include <gimslib/mesh/MeshSplitter.hpp>
 #include <gimslib/sys/Event.hpp>
 #include <imgui.h>
 #include <iostream>
@@ -20,15 +23,9 @@ namespace math
 f32m4 static getNormalizationTransformation(f32v3 const* const positions, ui32 nPositions)
 {
   // Find the minimum and maximum bounds of the mesh vertices
-  f32v3 minPosition = positions[0];
-  f32v3 maxPosition = positions[0];
-
-  // Loop to determine the minimum and maximum points along each axis
-  for (ui32 i = 1; i < nPositions; ++i)
-  {
-    minPosition = glm::min(minPosition, positions[i]);
-    maxPosition = glm::max(maxPosition, positions[i]);
-  }
+  const MeshBounds::Bounds bounds      = MeshBounds::computeBounds(&positions->x, nPositions);
+  const f32v3              minPosition = bounds.lower;
+  const f32v3              maxPosition = bounds.upper;
 
   // Calculate the center of the model (bounding box midpoint)
   f32v3 center = (minPosition + maxPosition) * 0.5f;
@@ -59,6 +56,7 @@ MeshViewer::MeshViewer(const DX12AppConfig config)
     , m_vertexBufferView()
     , m_indexBuffer()
     , m_indexBufferView()
+    , m_nIndices(0)
     , m_constantBuffers()
     , m_cbv()
     , m_normalizationTransformation()
@@ -180,8 +178,8 @@ void MeshViewer::createPipeline()
 
 void MeshViewer::loadMesh()
 {
-  // Load mesh data from a custom Cogra Binary Mesh (CBM) file
-  CograBinaryMeshFile cbm("../../../data/bunny.cbm");
+  // Map the custom Cogra Binary Mesh (CBM) file, its payloads are read straight from the mapping
+  CograBinaryMeshView cbm("../../../data/bunny.cbm");
 
   // Retrieve vertex positions and calculate normalization transformation
   const f32*   positionsRaw = cbm.getPositionsPtr();
@@ -191,12 +189,31 @@ void MeshViewer::loadMesh()
   // Normalize the mesh to fit within a unit cube centered at the origin
   m_normalizationTransformation = math::getNormalizationTransformation(positions, numVertices);
 
-  // Load vertex attributes: normals and texture coordinates
-  const f32*   normalsRaw = static_cast<const f32*>(cbm.getAttributePtr(0));
-  const f32v3* normals    = reinterpret_cast<const f32v3*>(normalsRaw);
+  // The triangle indices are uploaded directly from the mapped file, or as 16 bit indices if the mesh is small enough
+  const ui32* indices    = cbm.getTriangleIndices();
+  ui32        nTriangles = cbm.getNumTriangles();
+  m_nIndices             = nTriangles * 3;
+
+  // Load vertex attributes: normals and texture coordinates. Files without normals get smooth normals generated from
+  // the triangles instead.
+  const int          normalsIdx = cbm.getAttributeIdx("Normals");
+  std::vector<f32v3> generatedNormals;
+  const f32v3*       normals = nullptr;
+  if (normalsIdx >= 0)
+  {
+    normals = static_cast<const f32v3*>(cbm.getAttributePtr(normalsIdx));
+  }
+  else
+  {
+    generatedNormals.resize(numVertices);
+    MeshNormals::generateNormals(&generatedNormals.data()->x, sizeof(f32v3), indices, m_nIndices, positionsRaw,
+                                 sizeof(f32v3), numVertices);
+    normals = generatedNormals.data();
+  }
 
-  const f32*   texCoordsRaw = static_cast<const f32*>(cbm.getAttributePtr(1));
-  const f32v2* texCoords    = reinterpret_cast<const f32v2*>(texCoordsRaw);
+  const int    texCoordsIdx = cbm.getAttributeIdx("UVs");
+  const f32v2* texCoords =
+      texCoordsIdx >= 0 ? static_cast<const f32v2*>(cbm.getAttributePtr(texCoordsIdx)) : nullptr;
 
   // Prepare the CPU-side vertex buffer to transfer to GPU
   std::vector<Vertex> vertexBufferCPU(numVertices);
@@ -207,18 +224,21 @@ void MeshViewer::loadMesh()
     Vertex nVertex     = {};
     nVertex.position   = positions[i];
     nVertex.normal     = normals[i];
-    nVertex.texCoord   = texCoords[i];
+    nVertex.texCoord   = texCoords ? texCoords[i] : f32v2(0.0f);
     vertexBufferCPU[i] = nVertex;
   }
 
-  // Retrieve triangle indices for the mesh and prepare an index buffer
-  const ui32*       indices    = cbm.getTriangleIndices();
-  ui32              nTriangles = cbm.getNumTriangles();
-  std::vector<ui32> indexBufferCPU(indices, indices + nTriangles * 3);
+  const bool        use16BitIndices = MeshSplitter::fits16BitIndices(numVertices);
+  std::vector<ui16> indices16Bit;
+  if (use16BitIndices)
+  {
+    indices16Bit.resize(m_nIndices);
+    MeshSplitter::convertTo16BitIndices(indices16Bit.data(), indices, m_nIndices);
+  }
 
   // Calculate sizes in bytes for the vertex and index buffers
   const ui64 vertexBufferCPUSizeInBytes = vertexBufferCPU.size() * sizeof(Vertex);
-  const ui64 indexBufferCPUSizeInBytes  = indexBufferCPU.size() * sizeof(ui32);
+  const ui64 indexBufferCPUSizeInBytes  = ui64(m_nIndices) * (use16BitIndices ? sizeof(ui16) : sizeof(ui32));
 
   // Initialize an upload helper to facilitate buffer uploads to GPU
   UploadHelper uploadBuffer(getDevice(), std::max(vertexBufferCPUSizeInBytes, indexBufferCPUSizeInBytes));
@@ -245,10 +265,11 @@ void MeshViewer::loadMesh()
   // Set up the index buffer view for the GPU
   m_indexBufferView.BufferLocation = m_indexBuffer->GetGPUVirtualAddress();
   m_indexBufferView.SizeInBytes    = static_cast<ui32>(indexBufferCPUSizeInBytes);
-  m_indexBufferView.Format         = DXGI_FORMAT_R32_UINT;
+  m_indexBufferView.Format         = use16BitIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 
   // Upload index buffer data to the GPU
-  uploadBuffer.uploadBuffer(indexBufferCPU.data(), m_indexBuffer, indexBufferCPUSizeInBytes, getCommandQueue());
+  const void* indexData = use16BitIndices ? static_cast<const void*>(indices16Bit.data()) : indices;
+  uploadBuffer.uploadBuffer(indexData, m_indexBuffer, indexBufferCPUSizeInBytes, getCommandQueue());
 }
 
 void MeshViewer::loadTexture()
@@ -456,13 +477,13 @@ void MeshViewer::onDraw()
   commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
   commandList->IASetIndexBuffer(&m_indexBufferView);
   commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-  commandList->DrawIndexedInstanced(m_indexBufferView.SizeInBytes / sizeof(ui32), 1, 0, 0, 0);
+  commandList->DrawIndexedInstanced(m_nIndices, 1, 0, 0, 0);
 
   // Second Pass: Render wireframe overlay if enabled
   if (m_uiData.overlayWireframe)
   {
     commandList->SetPipelineState(m_wireframePipelineState.Get());
-    commandList->DrawIndexedInstanced(m_indexBufferView.SizeInBytes / sizeof(ui32), 1, 0, 0, 0);
+    commandList->DrawIndexedInstanced(m_nIndices, 1, 0, 0, 0);
   }
 }
 
@@ -0,0 +1,424 @@
+// BenchmarkScene.cpp
+
+#include "BenchmarkScene.hpp"
+#include "NodeHierarchy.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace
+{
+/// <summary>
+/// A JSON value, as far as the node hierarchy of a glTF file needs it. Objects keep their members in file order.
+/// </summary>
+struct JsonValue
+{
+  enum class Type
+  {
+    Null,
+    Boolean,
+    Number,
+    String,
+    Array,
+    Object
+  };
+
+  Type                     type   = Type::Null;
+  gims::f64                number = 0.0; //! Value of a number, 1 or 0 for a boolean.
+  std::string              string;       //! Value of a string.
+  std::vector<std::string> keys;         //! Names of the members of an object.
+  std::vector<JsonValue>   values;       //! Elements of an array, or values of the members of an object.
+};
+} // namespace
+
+/// <summary>
+/// Throws std::runtime_error with the position in the file.
+/// </summary>
+[[noreturn]] void static fail(const char* message, size_t pos)
+{
+  throw std::runtime_error(std::string("glTF: ") + message + " at byte " + std::to_string(pos) + ".");
+}
+
+/// <summary>
+/// Skips white space and returns the next character.
+/// </summary>
+char static peek(const std::string& text, size_t& pos)
+{
+  while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+  {
+    pos++;
+  }
+  if (pos >= text.size())
+  {
+    fail("Unexpected end of file", pos);
+  }
+  return text[pos];
+}
+
+/// <summary>
+/// Parses a string starting at the quotation mark. Escaped code points are replaced by '?', names do not matter here.
+/// </summary>
+std::string static parseString(const std::string& text, size_t& pos)
+{
+  std::string result;
+  pos++;
+  while (pos < text.size() && text[pos] != '"')
+  {
+    if (text[pos] == '\\' && pos + 1 < text.size())
+    {
+      const char escaped = text[pos + 1];
+      pos += 2;
+      if (escaped == 'u')
+      {
+        result += '?';
+        pos += 4;
+      }
+      else
+      {
+        const char* const escapes   = "\"\\/bfnrt";
+        const char* const unescaped = "\"\\/\b\f\n\r\t";
+        const char* const found     = std::strchr(escapes, escaped);
+        result += found != nullptr ? unescaped[found - escapes] : escaped;
+      }
+    }
+    else
+    {
+      result += text[pos++];
+    }
+  }
+  if (pos >= text.size())
+  {
+    fail("Unterminated string", pos);
+  }
+  pos++;
+  return result;
+}
+
+/// <summary>
+/// Parses the value starting at pos, and moves pos after it.
+/// </summary>
+JsonValue static parseValue(const std::string& text, size_t& pos)
+{
+  JsonValue  result;
+  const char c = peek(text, pos);
+  if (c == '{' || c == '[')
+  {
+    const char close = c == '{' ? '}' : ']';
+    result.type      = c == '{' ? JsonValue::Type::Object : JsonValue::Type::Array;
+    pos++;
+    if (peek(text, pos) == close)
+    {
+      pos++;
+      return result;
+    }
+    while (true)
+    {
+      if (result.type == JsonValue::Type::Object)
+      {
+        if (peek(text, pos) != '"')
+        {
+          fail("Expected a member name", pos);
+        }
+        result.keys.push_back(parseString(text, pos));
+        if (peek(text, pos) != ':')
+        {
+          fail("Expected ':'", pos);
+        }
+        pos++;
+      }
+      result.values.push_back(parseValue(text, pos));
+      const char separator = peek(text, pos);
+      pos++;
+      if (separator == close)
+      {
+        return result;
+      }
+      if (separator != ',')
+      {
+        fail("Expected ',' or the end of an object or array", pos - 1);
+      }
+    }
+  }
+  if (c == '"')
+  {
+    result.type   = JsonValue::Type::String;
+    result.string = parseString(text, pos);
+    return result;
+  }
+  for (const char* literal : {"true", "false", "null"})
+  {
+    if (text.compare(pos, std::strlen(literal), literal) == 0)
+    {
+      result.type   = literal[0] == 'n' ? JsonValue::Type::Null : JsonValue::Type::Boolean;
+      result.number = literal[0] == 't' ? 1.0 : 0.0;
+      pos += std::strlen(literal);
+      return result;
+    }
+  }
+  char* end     = nullptr;
+  result.type   = JsonValue::Type::Number;
+  result.number = std::strtod(text.c_str() + pos, &end);
+  if (end == text.c_str() + pos)
+  {
+    fail("Unexpected character", pos);
+  }
+  pos = static_cast<size_t>(end - text.c_str());
+  return result;
+}
+
+/// <summary>
+/// Returns the member of an object with the given name, or nullptr, if there is none.
+/// </summary>
+static const JsonValue* findMember(const JsonValue& object, const char* key)
+{
+  for (size_t i = 0; i < object.keys.size(); i++)
+  {
+    if (object.keys[i] == key)
+    {
+      return &object.values[i];
+    }
+  }
+  return nullptr;
+}
+
+/// <summary>
+/// Returns the element of an array member, or defaultValue, if the member or the element does not exist.
+/// </summary>
+gims::f32 static getElement(const JsonValue& object, const char* key, size_t i, gims::f32 defaultValue)
+{
+  const JsonValue* const member = findMember(object, key);
+  if (member == nullptr || i >= member->values.size())
+  {
+    return defaultValue;
+  }
+  return static_cast<gims::f32>(member->values[i].number);
+}
+
+/// <summary>
+/// Returns the local transformation of a glTF node, given either as a column-major matrix or as translation, rotation
+/// quaternion and scale.
+/// </summary>
+gims::f32m4 static getTransformation(const JsonValue& node)
+{
+  gims::f32m4 result(1.0f);
+  if (findMember(node, "matrix") != nullptr)
+  {
+    for (int column = 0; column < 4; column++)
+    {
+      for (int row = 0; row < 4; row++)
+      {
+        const size_t i      = static_cast<size_t>(column * 4 + row);
+        result[column][row] = getElement(node, "matrix", i, column == row ? 1.0f : 0.0f);
+      }
+    }
+    return result;
+  }
+
+  const gims::f32 x = getElement(node, "rotation", 0, 0.0f);
+  const gims::f32 y = getElement(node, "rotation", 1, 0.0f);
+  const gims::f32 z = getElement(node, "rotation", 2, 0.0f);
+  const gims::f32 w = getElement(node, "rotation", 3, 1.0f);
+  result[0]         = gims::f32v4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f);
+  result[1]         = gims::f32v4(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f);
+  result[2]         = gims::f32v4(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f);
+  for (int c = 0; c < 3; c++)
+  {
+    result[c] *= getElement(node, "scale", static_cast<size_t>(c), 1.0f);
+    result[3][c] = getElement(node, "translation", static_cast<size_t>(c), 0.0f);
+  }
+  return result;
+}
+
+BenchmarkScene BenchmarkScene::createRandom(gims::ui32 nNodes, gims::ui32 nMeshes, gims::ui32 seed)
+{
+  constexpr gims::ui32 maxDepth = 12;
+
+  BenchmarkScene                        scene;
+  std::mt19937                          random(seed);
+  std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+  std::uniform_int_distribution<int>    nLevelsUp(0, 2);
+  for (gims::ui32 meshIdx = 0; meshIdx < nMeshes; meshIdx++)
+  {
+    const gims::f32v3 center(uniform(random), uniform(random), uniform(random));
+    const gims::f32v3 size(uniform(random), uniform(random), uniform(random));
+    const gims::f32v3 halfExtent = gims::f32v3(0.55f) + 0.45f * size;
+    scene.meshAABBs.push_back(AABB(center - halfExtent, center + halfExtent));
+  }
+
+  // The ancestors of the next node. Going up zero to two levels per node keeps the depth between 1 and maxDepth.
+  std::vector<gims::ui32> path;
+  for (gims::ui32 nodeIdx = 0; nodeIdx < nNodes; nodeIdx++)
+  {
+    const int nUp = path.size() >= maxDepth ? std::max(1, nLevelsUp(random)) : nLevelsUp(random);
+    for (int i = 0; i < nUp && path.size() > 1; i++)
+    {
+      path.pop_back();
+    }
+    scene.parents.push_back(path.empty() ? NodeHierarchy::NO_PARENT : path.back());
+    path.push_back(nodeIdx);
+
+    // A rotation about the y axis and a translation, which spread the children of a node over a few units.
+    const gims::f32 angle = 3.14159265f * uniform(random);
+    gims::f32m4     local(1.0f);
+    local[0] = gims::f32v4(std::cos(angle), 0.0f, -std::sin(angle), 0.0f);
+    local[2] = gims::f32v4(std::sin(angle), 0.0f, std::cos(angle), 0.0f);
+    local[3] = gims::f32v4(4.0f * uniform(random), uniform(random), 4.0f * uniform(random), 1.0f);
+    scene.localTransformations.push_back(nodeIdx == 0 ? gims::f32m4(1.0f) : local);
+    scene.meshIndices.emplace_back();
+    if (nodeIdx % 2 == 1)
+    {
+      scene.meshIndices.back().push_back(static_cast<gims::ui32>(random() % nMeshes));
+    }
+  }
+  return scene;
+}
+
+BenchmarkScene BenchmarkScene::loadGltf(const std::filesystem::path& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+  {
+    throw std::runtime_error("Cannot open " + path.string() + ".");
+  }
+  std::stringstream stream;
+  stream << file.rdbuf();
+  const std::string text = stream.str();
+  size_t            pos  = 0;
+  const JsonValue   gltf = parseValue(text, pos);
+
+  static const JsonValue empty;
+  const auto             getArray = [](const JsonValue& object, const char* key) -> const std::vector<JsonValue>&
+  {
+    const JsonValue* const member = findMember(object, key);
+    return member != nullptr ? member->values : empty.values;
+  };
+  const std::vector<JsonValue>& nodes     = getArray(gltf, "nodes");
+  const std::vector<JsonValue>& meshes    = getArray(gltf, "meshes");
+  const std::vector<JsonValue>& accessors = getArray(gltf, "accessors");
+
+  // Each primitive becomes a mesh. The meshes of a glTF mesh are consecutive.
+  BenchmarkScene          scene;
+  std::vector<gims::ui32> firstMeshes;
+  for (const JsonValue& mesh : meshes)
+  {
+    firstMeshes.push_back(static_cast<gims::ui32>(scene.meshAABBs.size()));
+    for (const JsonValue& primitive : getArray(mesh, "primitives"))
+    {
+      const JsonValue* const attributes = findMember(primitive, "attributes");
+      const JsonValue* const position   = attributes != nullptr ? findMember(*attributes, "POSITION") : nullptr;
+      const size_t           accessor   = position != nullptr ? static_cast<size_t>(position->number) : ~size_t(0);
+      if (accessor < accessors.size() && findMember(accessors[accessor], "min") != nullptr)
+      {
+        const JsonValue&  a = accessors[accessor];
+        const gims::f32v3 lower(getElement(a, "min", 0, 0.0f), getElement(a, "min", 1, 0.0f),
+                                getElement(a, "min", 2, 0.0f));
+        const gims::f32v3 upper(getElement(a, "max", 0, 0.0f), getElement(a, "max", 1, 0.0f),
+                                getElement(a, "max", 2, 0.0f));
+        scene.meshAABBs.push_back(AABB(lower, upper));
+      }
+      else
+      {
+        scene.meshAABBs.push_back(AABB());
+      }
+    }
+  }
+  firstMeshes.push_back(static_cast<gims::ui32>(scene.meshAABBs.size()));
+
+  // The root nodes of the default scene, or all nodes without a parent, below one root with the identity.
+  std::vector<gims::ui32>       roots;
+  const JsonValue* const        sceneIdx = findMember(gltf, "scene");
+  const std::vector<JsonValue>& scenes   = getArray(gltf, "scenes");
+  if (!scenes.empty())
+  {
+    const size_t idx = sceneIdx != nullptr ? static_cast<size_t>(sceneIdx->number) : 0;
+    for (const JsonValue& root : getArray(scenes.at(idx), "nodes"))
+    {
+      roots.push_back(static_cast<gims::ui32>(root.number));
+    }
+  }
+  else
+  {
+    std::vector<bool> isChild(nodes.size(), false);
+    for (const JsonValue& node : nodes)
+    {
+      for (const JsonValue& child : getArray(node, "children"))
+      {
+        isChild.at(static_cast<size_t>(child.number)) = true;
+      }
+    }
+    for (gims::ui32 nodeIdx = 0; nodeIdx < nodes.size(); nodeIdx++)
+    {
+      if (!isChild[nodeIdx])
+      {
+        roots.push_back(nodeIdx);
+      }
+    }
+  }
+  scene.parents.push_back(NodeHierarchy::NO_PARENT);
+  scene.localTransformations.push_back(gims::f32m4(1.0f));
+  scene.meshIndices.emplace_back();
+
+  // Depth-first preorder with an explicit stack of glTF nodes and the index of their parent in the scene.
+  std::vector<std::pair<gims::ui32, gims::ui32>> stack;
+  for (size_t i = roots.size(); i-- > 0;)
+  {
+    stack.emplace_back(roots[i], 0);
+  }
+  while (!stack.empty())
+  {
+    const auto [gltfNodeIdx, parentIdx] = stack.back();
+    stack.pop_back();
+    const JsonValue& node = nodes.at(gltfNodeIdx);
+    scene.parents.push_back(parentIdx);
+    scene.localTransformations.push_back(getTransformation(node));
+    scene.meshIndices.emplace_back();
+    if (const JsonValue* const mesh = findMember(node, "mesh"))
+    {
+      const size_t meshIdx = static_cast<size_t>(mesh->number);
+      for (gims::ui32 i = firstMeshes.at(meshIdx); i < firstMeshes.at(meshIdx + 1); i++)
+      {
+        scene.meshIndices.back().push_back(i);
+      }
+    }
+    const gims::ui32              nodeIdx  = static_cast<gims::ui32>(scene.parents.size() - 1);
+    const std::vector<JsonValue>& children = getArray(node, "children");
+    for (size_t i = children.size(); i-- > 0;)
+    {
+      stack.emplace_back(static_cast<gims::ui32>(children[i].number), nodeIdx);
+    }
+  }
+  return scene;
+}
+
+gims::ui32 BenchmarkScene::getNumberOfMeshInstances() const
+{
+  gims::ui32 result = 0;
+  for (const std::vector<gims::ui32>& indices : meshIndices)
+  {
+    result += static_cast<gims::ui32>(indices.size());
+  }
+  return result;
+}
+
+gims::ui32 BenchmarkScene::getDepth() const
+{
+  // Parents precede their children.
+  std::vector<gims::ui32> depths(parents.size(), 1);
+  gims::ui32              result = 0;
+  for (size_t nodeIdx = 0; nodeIdx < parents.size(); nodeIdx++)
+  {
+    if (parents[nodeIdx] != NodeHierarchy::NO_PARENT)
+    {
+      depths[nodeIdx] = depths[parents[nodeIdx]] + 1;
+    }
+    result = std::max(result, depths[nodeIdx]);
+  }
+  return result;
+}
@@ -0,0 +1,48 @@
+// BenchmarkScene.hpp
+#ifndef BENCHMARK_SCENE_CLASS
+#define BENCHMARK_SCENE_CLASS
+
+#include "AABB.hpp"
+#include <filesystem>
+#include <gimslib/types.hpp>
+#include <vector>
+
+/// <summary>
+/// The part of a scene that the node hierarchy and the culling see, without any GPU resources: the nodes in
+/// depth-first preorder with their parent, local transformation and meshes, and the bounding box of each mesh. There
+/// is always a single root, node 0, like the root node of a scene imported with assimp.
+/// </summary>
+struct BenchmarkScene
+{
+  std::vector<gims::ui32>              parents;              //! Parent of each node, NodeHierarchy::NO_PARENT for 0.
+  std::vector<gims::f32m4>             localTransformations; //! Transformation of each node to its parent node.
+  std::vector<std::vector<gims::ui32>> meshIndices;          //! Indices of the meshes of each node.
+  std::vector<AABB>                    meshAABBs;            //! Bounding box of each mesh in mesh coordinates.
+
+  /// <summary>
+  /// Creates a random hierarchy of at most 12 levels, in which every other node has one of nMeshes random meshes.
+  /// </summary>
+  /// <param name="nNodes">Number of nodes.</param>
+  /// <param name="nMeshes">Number of distinct meshes.</param>
+  /// <param name="seed">Seed of the random numbers, the same seed gives the same scene.</param>
+  static BenchmarkScene createRandom(gims::ui32 nNodes, gims::ui32 nMeshes, gims::ui32 seed);
+
+  /// <summary>
+  /// Reads the node hierarchy of a glTF file with JSON encoding. Each primitive of a glTF mesh becomes a mesh, as in
+  /// assimp, and its bounding box is the minimum and maximum of its POSITION accessor. The buffers are not read. Throws
+  /// std::runtime_error, if the file cannot be read or parsed.
+  /// </summary>
+  /// <param name="path">Path of the .gltf file.</param>
+  static BenchmarkScene loadGltf(const std::filesystem::path& path);
+
+  /// <summary>
+  /// Returns the total number of mesh instances, i.e., the sum of the number of meshes of all nodes.
+  /// </summary>
+  gims::ui32 getNumberOfMeshInstances() const;
+
+  /// <summary>
+  /// Returns the number of levels of the hierarchy.
+  /// </summary>
+  gims::ui32 getDepth() const;
+};
+#endif // BENCHMARK_SCENE_CLASS
@@ -0,0 +1,431 @@
+// SceneGraphBenchmark.cpp
+
+#include "BenchmarkScene.hpp"
+#include "BenchmarkUtil.hpp"
+#include "InstanceBVH.hpp"
+#include "NodeHierarchy.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <gimslib/mesh/Meshlets.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// A node of the scene graph as it was stored before NodeHierarchy. The children are referenced by index, and the
+/// world transformations are accumulated by a recursive traversal from node 0.
+/// </summary>
+struct Node
+{
+  gims::f32m4             transformation = gims::f32m4(1.0f);
+  std::vector<gims::ui32> meshIndices;
+  std::vector<gims::ui32> childIndices;
+};
+
+/// <summary>
+/// Creates the nodes of the former scene graph.
+/// </summary>
+std::vector<Node> static createNodes(const BenchmarkScene& scene)
+{
+  std::vector<Node> nodes(scene.parents.size());
+  for (size_t nodeIdx = 0; nodeIdx < nodes.size(); nodeIdx++)
+  {
+    nodes[nodeIdx].transformation = scene.localTransformations[nodeIdx];
+    nodes[nodeIdx].meshIndices    = scene.meshIndices[nodeIdx];
+    if (scene.parents[nodeIdx] != NodeHierarchy::NO_PARENT)
+    {
+      nodes[scene.parents[nodeIdx]].childIndices.push_back(static_cast<gims::ui32>(nodeIdx));
+    }
+  }
+  return nodes;
+}
+
+/// <summary>
+/// Creates the flat hierarchy, as SceneFactory does.
+/// </summary>
+NodeHierarchy static createHierarchy(const BenchmarkScene& scene)
+{
+  NodeHierarchy     hierarchy;
+  std::vector<AABB> meshAABBs;
+  for (size_t nodeIdx = 0; nodeIdx < scene.parents.size(); nodeIdx++)
+  {
+    meshAABBs.clear();
+    for (const gims::ui32 meshIdx : scene.meshIndices[nodeIdx])
+    {
+      meshAABBs.push_back(scene.meshAABBs[meshIdx]);
+    }
+    hierarchy.addNode(scene.parents[nodeIdx], scene.localTransformations[nodeIdx], scene.meshIndices[nodeIdx],
+                      meshAABBs);
+  }
+  return hierarchy;
+}
+
+/// <summary>
+/// The former traversal of Scene::addToCommandList without the commands: each node is copied, its transformation is
+/// accumulated, and the model view matrix of each mesh is read, as if it was passed to the command list.
+/// </summary>
+/// <returns>The sum of one element of the model view matrices, so the traversal cannot be optimized away.</returns>
+gims::f64 static traverseRecursively(const std::vector<Node>& nodes, gims::ui32 nodeIdx, gims::f32m4 transformation)
+{
+  const Node        currentNode               = nodes[nodeIdx];
+  const gims::f32m4 accumulatedTransformation = transformation * currentNode.transformation;
+  gims::f64         result                    = 0.0;
+  for (size_t i = 0; i < currentNode.meshIndices.size(); i++)
+  {
+    result += accumulatedTransformation[3][0];
+  }
+  for (const gims::ui32 childIdx : currentNode.childIndices)
+  {
+    result += traverseRecursively(nodes, childIdx, accumulatedTransformation);
+  }
+  return result;
+}
+
+/// <summary>
+/// The traversal of Scene::addToCommandList without the commands: the dirty subtrees are updated, then the arrays are
+/// walked in storage order.
+/// </summary>
+/// <returns>The sum of one element of the model view matrices, so the traversal cannot be optimized away.</returns>
+gims::f64 static traverseFlat(NodeHierarchy& hierarchy, const gims::f32m4& transformation)
+{
+  hierarchy.updateWorldTransformations();
+  gims::f64 result = 0.0;
+  for (gims::ui32 nodeIdx = 0; nodeIdx < hierarchy.getNumberOfNodes(); nodeIdx++)
+  {
+    const gims::f32m4 accumulatedTransformation = transformation * hierarchy.getWorldTransformation(nodeIdx);
+    for (size_t i = 0; i < hierarchy.getMeshIndices(nodeIdx).size(); i++)
+    {
+      result += accumulatedTransformation[3][0];
+    }
+  }
+  return result;
+}
+
+/// <summary>
+/// Prints the time per frame of the former recursive traversal and of the flat hierarchy, for a static scene and for a
+/// scene in which the root, and therefore every node, moves in every frame.
+/// </summary>
+void static benchmarkTraversal(const std::string& name, const BenchmarkScene& scene)
+{
+  const std::vector<Node> nodes     = createNodes(scene);
+  NodeHierarchy           hierarchy = createHierarchy(scene);
+  const gims::f32m4       view      = glm::translate(gims::f32m4(1.0f), gims::f32v3(0.0f, 0.0f, 10.0f));
+  const auto              moveRoot  = [&] { hierarchy.setLocalTransformation(0, scene.localTransformations[0]); };
+
+  gims::f64       recursiveSum  = 0.0;
+  gims::f64       flatSum       = 0.0;
+  const gims::f64 recursiveTime = gims::test::measure([&] { recursiveSum = traverseRecursively(nodes, 0, view); });
+  const gims::f64 staticTime    = gims::test::measure([&] { flatSum = traverseFlat(hierarchy, view); });
+  const gims::f64 updateTime    = gims::test::measure(
+      [&]
+      {
+        moveRoot();
+        hierarchy.updateWorldTransformations();
+      });
+  const gims::f64 movingTime = gims::test::measure(
+      [&]
+      {
+        moveRoot();
+        flatSum = traverseFlat(hierarchy, view);
+      });
+
+  std::printf("%s: %u nodes, %u mesh instances, %u levels\n", name.c_str(), hierarchy.getNumberOfNodes(),
+              hierarchy.getNumberOfMeshInstances(), scene.getDepth());
+  std::printf("  recursive traversal, us              %10.1f\n", recursiveTime * 1e6);
+  std::printf("  flat traversal, static scene, us     %10.1f\n", staticTime * 1e6);
+  std::printf("  flat traversal, all nodes moved, us  %10.1f\n", movingTime * 1e6);
+  std::printf("    of which updating, us              %10.1f\n", updateTime * 1e6);
+  if (std::abs(recursiveSum - flatSum) > 1e-3 * std::abs(recursiveSum) + 1e-3)
+  {
+    std::printf("  the traversals differ: %f %f\n", recursiveSum, flatSum);
+  }
+}
+
+/// <summary>
+/// Prints the time of updateWorldTransformations after the root has moved, on a thread pool of 1 to maxThreads
+/// threads, and whether the world transformations equal those of the update on the calling thread.
+/// </summary>
+void static benchmarkParallelUpdate(const BenchmarkScene& scene, gims::ui32 maxThreads)
+{
+  NodeHierarchy hierarchy = createHierarchy(scene);
+  const auto    update    = [&](gims::ThreadPool* threadPool)
+  {
+    hierarchy.setLocalTransformation(0, scene.localTransformations[0]);
+    hierarchy.updateWorldTransformations(threadPool);
+  };
+  const gims::f64                sequentialTime = gims::test::measure([&] { update(nullptr); });
+  const std::vector<gims::f32m4> expected(&hierarchy.getWorldTransformation(0),
+                                          &hierarchy.getWorldTransformation(0) + hierarchy.getNumberOfNodes());
+  std::printf("  updateWorldTransformations, all nodes moved\n");
+  std::printf("  threads         us  speedup\n");
+  std::printf("  calling %10.1f %8.2f\n", sequentialTime * 1e6, 1.0);
+  for (const gims::ui32 nThreads : gims::test::getThreadCounts(maxThreads))
+  {
+    gims::ThreadPool threadPool(nThreads);
+    const gims::f64  seconds = gims::test::measure([&] { update(&threadPool); });
+    const bool       equal   = std::memcmp(expected.data(), &hierarchy.getWorldTransformation(0),
+                                           expected.size() * sizeof(gims::f32m4)) == 0;
+    std::printf("  %7u %10.1f %8.2f%s\n", nThreads, seconds * 1e6, sequentialTime / seconds,
+                equal ? "" : " (results differ)");
+  }
+}
+
+/// <summary>
+/// Returns true, if a bounding box is completely behind one of the planes, tested one box at a time like the scalar
+/// remainder of NodeHierarchy::cullMeshInstances.
+/// </summary>
+bool static isOutside(const AABB& aabb, std::span<const gims::f32v4> planes)
+{
+  for (const gims::f32v4& plane : planes)
+  {
+    gims::f32 distance = plane.w;
+    for (int c = 0; c < 3; c++)
+    {
+      distance += plane[c] * (plane[c] >= 0.0f ? aabb.getUpperRightTop()[c] : aabb.getLowerLeftBottom()[c]);
+    }
+    if (distance < 0.0f)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// <summary>
+/// Prints the time of NodeHierarchy::cullMeshInstances, which tests four bounding boxes at a time with SSE2, and of
+/// testing one mesh instance at a time, and whether both find the same visible mesh instances. The cameras are at the
+/// center of the scene and look along the six axes, so together they see every mesh instance at least once.
+/// </summary>
+void static benchmarkCulling(const BenchmarkScene& scene)
+{
+  const NodeHierarchy         hierarchy = createHierarchy(scene);
+  const std::span<const AABB> aabbs     = hierarchy.getMeshInstanceWorldAABBs();
+  const AABB                  sceneAABB = hierarchy.getAABB();
+  const gims::f32v3           center    = (sceneAABB.getLowerLeftBottom() + sceneAABB.getUpperRightTop()) * 0.5f;
+  const gims::f32v3           extent    = sceneAABB.getUpperRightTop() - sceneAABB.getLowerLeftBottom();
+  const gims::f32m4           projection =
+      glm::perspectiveFovLH_ZO<gims::f32>(glm::radians(45.0f), 16.0f, 9.0f, 0.1f, glm::length(extent));
+
+  std::vector<gims::ui8> batchVisible;
+  std::vector<gims::ui8> scalarVisible(aabbs.size());
+  gims::ui32             nVisible   = 0;
+  gims::f64              batchTime  = 0.0;
+  gims::f64              scalarTime = 0.0;
+  bool                   equal      = true;
+  for (int axis = 0; axis < 6; axis++)
+  {
+    gims::f32v3 direction(0.0f);
+    direction[axis / 2]    = axis % 2 == 0 ? 1.0f : -1.0f;
+    const gims::f32v3 up   = axis / 2 == 1 ? gims::f32v3(0.0f, 0.0f, 1.0f) : gims::f32v3(0.0f, 1.0f, 0.0f);
+    const gims::f32m4 view = glm::lookAtLH(center, center + direction, up);
+    const gims::Meshlets::CullingView  cullingView = gims::Meshlets::createCullingView(view, projection, false);
+    const std::span<const gims::f32v4> planes      = cullingView.planes;
+
+    nVisible += hierarchy.cullMeshInstances(planes, batchVisible);
+    batchTime += gims::test::measure([&] { hierarchy.cullMeshInstances(planes, batchVisible); });
+    scalarTime += gims::test::measure(
+        [&]
+        {
+          for (size_t instanceIdx = 0; instanceIdx < aabbs.size(); instanceIdx++)
+          {
+            scalarVisible[instanceIdx] = isOutside(aabbs[instanceIdx], planes) ? 0 : 1;
+          }
+        });
+    equal = equal && batchVisible == scalarVisible;
+  }
+  std::printf("  cullMeshInstances, %u mesh instances, %.1f%% visible per view%s\n",
+              hierarchy.getNumberOfMeshInstances(), 100.0 * nVisible / 6.0 / static_cast<gims::f64>(aabbs.size()),
+              equal ? "" : " (results differ)");
+  std::printf("  SSE2 batch %10.1f us per view\n", batchTime * 1e6 / 6.0);
+  std::printf("  scalar     %10.1f us per view, %.2fx\n", scalarTime * 1e6 / 6.0, scalarTime / batchTime);
+}
+
+/// <summary>
+/// Returns the ray parameter at which a ray enters a bounding box, clamped to 0, or a negative value, if the ray misses
+/// the box, like InstanceBVH::intersectRay.
+/// </summary>
+gims::f32 static intersect(const AABB& aabb, const gims::f32v3& origin, const gims::f32v3& direction)
+{
+  gims::f32 entry = 0.0f;
+  gims::f32 exit  = std::numeric_limits<gims::f32>::max();
+  for (int c = 0; c < 3; c++)
+  {
+    const gims::f32 t0 = (aabb.getLowerLeftBottom()[c] - origin[c]) / direction[c];
+    const gims::f32 t1 = (aabb.getUpperRightTop()[c] - origin[c]) / direction[c];
+    entry              = std::max(entry, std::min(t0, t1));
+    exit               = std::min(exit, std::max(t0, t1));
+  }
+  return aabb.isValid() && entry <= exit ? entry : -1.0f;
+}
+
+/// <summary>
+/// Returns true, if two bounding boxes overlap, like InstanceBVH::queryAABB.
+/// </summary>
+bool static overlap(const AABB& a, const AABB& b)
+{
+  for (int c = 0; c < 3; c++)
+  {
+    if (a.getLowerLeftBottom()[c] > b.getUpperRightTop()[c] || b.getLowerLeftBottom()[c] > a.getUpperRightTop()[c])
+    {
+      return false;
+    }
+  }
+  return a.isValid() && b.isValid();
+}
+
+/// <summary>
+/// Prints the time of building and refitting the bounding volume hierarchy of the mesh instances, and of its queries
+/// compared to testing every mesh instance: frustum culling against NodeHierarchy::cullMeshInstances, and rays and
+/// box queries against a loop over all bounding boxes. The camera, the rays and the boxes are inside the scene.
+/// </summary>
+void static benchmarkInstanceBVH(const BenchmarkScene& scene, gims::ui32 maxThreads)
+{
+  constexpr gims::ui32 nQueries = 256;
+
+  const NodeHierarchy         hierarchy = createHierarchy(scene);
+  const std::span<const AABB> aabbs     = hierarchy.getMeshInstanceWorldAABBs();
+  const AABB                  sceneAABB = hierarchy.getAABB();
+  const gims::f32v3           center    = (sceneAABB.getLowerLeftBottom() + sceneAABB.getUpperRightTop()) * 0.5f;
+  const gims::f32v3           extent    = sceneAABB.getUpperRightTop() - sceneAABB.getLowerLeftBottom();
+
+  InstanceBVH      bvh;
+  gims::ThreadPool threadPool(gims::test::getThreadCounts(maxThreads).back());
+  const gims::f64  buildTime         = gims::test::measure([&] { bvh.build(aabbs); }, 3);
+  const gims::f64  parallelBuildTime = gims::test::measure([&] { bvh.build(aabbs, &threadPool); }, 3);
+  const gims::f64  refitTime         = gims::test::measure([&] { bvh.refit(aabbs); });
+
+  // A camera at the center of the scene, looking along +z.
+  const gims::f32m4 view       = glm::translate(gims::f32m4(1.0f), -center);
+  const gims::f32m4 projection = glm::perspectiveFovLH_ZO<gims::f32>(glm::radians(45.0f), 16.0f, 9.0f, 0.1f,
+                                                                     glm::length(extent));
+  const gims::Meshlets::CullingView  cullingView = gims::Meshlets::createCullingView(view, projection, false);
+  const std::span<const gims::f32v4> planes      = cullingView.planes;
+  std::vector<gims::ui8>             bvhVisible;
+  std::vector<gims::ui8>             linearVisible;
+  gims::ui32                         nVisible = 0;
+
+  const gims::f64 bvhCullTime    = gims::test::measure([&] { nVisible = bvh.cullFrustum(planes, bvhVisible); });
+  const gims::f64 linearCullTime = gims::test::measure([&] { hierarchy.cullMeshInstances(planes, linearVisible); });
+
+  // Rays from the middle of the scene in random directions, and boxes of 2% of the extent of the scene.
+  std::mt19937                          random(1);
+  std::uniform_real_distribution<float> uniform(-0.5f, 0.5f);
+  std::vector<gims::f32v3>              origins;
+  std::vector<gims::f32v3>              directions;
+  std::vector<AABB>                     boxes;
+  for (gims::ui32 i = 0; i < nQueries; i++)
+  {
+    origins.push_back(center + 0.5f * extent * gims::f32v3(uniform(random), uniform(random), uniform(random)));
+    directions.push_back(gims::f32v3(uniform(random), uniform(random), uniform(random)));
+    const gims::f32v3 boxCenter = center + extent * gims::f32v3(uniform(random), uniform(random), uniform(random));
+    boxes.push_back(AABB(boxCenter - 0.01f * extent, boxCenter + 0.01f * extent));
+  }
+  std::vector<gims::f32>  bvhDistances(nQueries);
+  std::vector<gims::f32>  linearDistances(nQueries);
+  std::vector<gims::ui32> bvhCounts(nQueries);
+  std::vector<gims::ui32> linearCounts(nQueries);
+  const gims::f64         bvhRayTime = gims::test::measure(
+      [&]
+      {
+        for (gims::ui32 i = 0; i < nQueries; i++)
+        {
+          bvhDistances[i] = bvh.intersectRay(origins[i], directions[i]).distance;
+        }
+      });
+  const gims::f64 linearRayTime = gims::test::measure(
+      [&]
+      {
+        for (gims::ui32 i = 0; i < nQueries; i++)
+        {
+          linearDistances[i] = std::numeric_limits<gims::f32>::max();
+          for (const AABB& aabb : aabbs)
+          {
+            const gims::f32 distance = intersect(aabb, origins[i], directions[i]);
+            if (distance >= 0.0f && distance < linearDistances[i])
+            {
+              linearDistances[i] = distance;
+            }
+          }
+        }
+      },
+      1);
+  std::vector<gims::ui32> meshInstances;
+  const gims::f64         bvhBoxTime = gims::test::measure(
+      [&]
+      {
+        for (gims::ui32 i = 0; i < nQueries; i++)
+        {
+          bvh.queryAABB(boxes[i], meshInstances);
+          bvhCounts[i] = static_cast<gims::ui32>(meshInstances.size());
+        }
+      });
+  const gims::f64 linearBoxTime = gims::test::measure(
+      [&]
+      {
+        for (gims::ui32 i = 0; i < nQueries; i++)
+        {
+          linearCounts[i] = 0;
+          for (const AABB& aabb : aabbs)
+          {
+            linearCounts[i] += overlap(aabb, boxes[i]) ? 1 : 0;
+          }
+        }
+      },
+      1);
+
+  gims::ui32 nHits  = 0;
+  gims::ui32 nFound = 0;
+  for (gims::ui32 i = 0; i < nQueries; i++)
+  {
+    nHits += bvhDistances[i] < std::numeric_limits<gims::f32>::max() ? 1 : 0;
+    nFound += bvhCounts[i];
+  }
+  const bool equal = bvhVisible == linearVisible && bvhDistances == linearDistances && bvhCounts == linearCounts;
+  std::printf("  InstanceBVH, %u nodes%s\n", bvh.getNumberOfNodes(), equal ? "" : " (results differ)");
+  std::printf("                                        BVH, us   linear, us\n");
+  std::printf("  build, calling thread             %12.1f\n", buildTime * 1e6);
+  std::printf("  build, %2u threads                 %12.1f\n", threadPool.getNumThreads(), parallelBuildTime * 1e6);
+  std::printf("  refit                             %12.1f\n", refitTime * 1e6);
+  std::printf("  frustum, %7u visible          %12.1f %12.1f\n", nVisible, bvhCullTime * 1e6, linearCullTime * 1e6);
+  std::printf("  ray, %3u of %3u hit                %12.2f %12.2f\n", nHits, nQueries, bvhRayTime * 1e6 / nQueries,
+              linearRayTime * 1e6 / nQueries);
+  std::printf("  box, %8.1f found on average    %12.2f %12.2f\n", static_cast<gims::f64>(nFound) / nQueries,
+              bvhBoxTime * 1e6 / nQueries, linearBoxTime * 1e6 / nQueries);
+}
+
+/// <summary>
+/// Usage: SceneGraphBenchmark [maxThreads [nNodes [scene.gltf ...]]]. Measures a random hierarchy of nNodes nodes, one
+/// million by default, and the node hierarchy of each glTF file. maxThreads 0 uses one thread per hardware thread.
+/// </summary>
+int main(int argc, char** argv)
+{
+  try
+  {
+    const gims::ui32     maxThreads = gims::test::getArgument(argc, argv, 1, 0);
+    const gims::ui32     nNodes     = gims::test::getArgument(argc, argv, 2, 1 << 20);
+    const BenchmarkScene random     = BenchmarkScene::createRandom(nNodes, 1000, 1);
+    benchmarkTraversal("random", random);
+    benchmarkParallelUpdate(random, maxThreads);
+    benchmarkCulling(random);
+    benchmarkInstanceBVH(random, maxThreads);
+    for (int argIdx = 3; argIdx < argc; argIdx++)
+    {
+      const BenchmarkScene scene = BenchmarkScene::loadGltf(argv[argIdx]);
+      benchmarkTraversal(argv[argIdx], scene);
+      benchmarkParallelUpdate(scene, maxThreads);
+      benchmarkCulling(scene);
+      benchmarkInstanceBVH(scene, maxThreads);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -26,6 +26,15 @@ public:
   /// <param name="nPositions">Number of positions.</param>
   AABB(gims::f32v3 const* const positions, gims::ui32 nPositions);
 
+  /// <summary>
+  /// Computes a bounding box from 3D positions that are strideInBytes bytes apart, e.g., in an interleaved vertex
+  /// buffer.
+  /// </summary>
+  /// <param name="positions">The first 3D position.</param>
+  /// <param name="nPositions">Number of positions.</param>
+  /// <param name="strideInBytes">Distance between two consecutive positions in bytes.</param>
+  AABB(gims::f32v3 const* const positions, gims::ui32 nPositions, size_t strideInBytes);
+
   /// <summary>
   /// Creates a bounding box from the provided 3D positions.
   /// </summary>
@@ -59,12 +68,17 @@ public:
   const gims::f32v3& getUpperRightTop() const;
 
   /// <summary>
-  /// Returns a transformed copy of this bounding box.
-  /// The corner points of the bounding box are transformed by the given matrix.
+  /// Returns the smallest bounding box that contains all eight corners of this bounding box, transformed by the given
+  /// affine matrix. An invalid bounding box stays invalid.
+  /// </summary>
+  /// <param name="transformation">An affine matrix that transforms points.</param>
+  /// <returns>The transformed bounding box.</returns>
+  AABB getTransformed(const gims::f32m4& transformation) const;
+
+  /// <summary>
+  /// Returns false for the bounding box of no positions.
   /// </summary>
-  /// <param name="transformation">A matrix that transforms points.</param>
-  /// <returns>The transformed matrix.</returns>
-  AABB getTransformed(gims::f32m4& transformation) const;
+  bool isValid() const;
 
 private:
   //! The lower left bottom corner of the AABB.
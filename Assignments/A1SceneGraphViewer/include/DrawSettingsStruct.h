@@ -0,0 +1,31 @@
+// DrawSettingsStruct.h
+#ifndef DRAW_SETTINGS_STRUCT
+#define DRAW_SETTINGS_STRUCT
+
+#include <gimslib/types.hpp>
+
+/// <summary>
+/// Settings that control which clusters and which level of detail of each mesh are drawn.
+/// </summary>
+struct DrawSettings
+{
+  gims::f32m4 projectionMatrix       = gims::f32m4(1.0f); //! The projection matrix used for rendering.
+  gims::f32   viewportHeight         = gims::f32(1.0f);   //! Height of the viewport in pixels.
+  bool        cullMeshInstances      = true;              //! Skips mesh instances outside the view frustum.
+  bool        cullClusters           = true;              //! Skips clusters outside the view frustum.
+  bool        cullBackFacingClusters = false;             //! Skips clusters facing away from the camera.
+  bool        selectLevelOfDetail    = true;              //! Draws coarser levels of detail of distant meshes.
+  gims::f32   maxScreenSpaceError    = gims::f32(1.0f);   //! Maximum error of a level of detail in pixels.
+};
+
+/// <summary>
+/// What has been drawn with a set of draw settings.
+/// </summary>
+struct DrawStatistics
+{
+  gims::ui32 numberOfDrawnMeshInstances  = gims::ui32(0);
+  gims::ui32 numberOfCulledMeshInstances = gims::ui32(0);
+  gims::ui32 numberOfDrawnClusters       = gims::ui32(0);
+  gims::ui32 numberOfDrawnTriangles      = gims::ui32(0);
+};
+#endif // DRAW_SETTINGS_STRUCT
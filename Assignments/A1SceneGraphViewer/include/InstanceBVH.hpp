@@ -0,0 +1,149 @@
+// InstanceBVH.hpp
+#ifndef INSTANCE_BVH_CLASS
+#define INSTANCE_BVH_CLASS
+
+#include "AABB.hpp"
+#include <gimslib/sys/ThreadPool.hpp>
+#include <gimslib/types.hpp>
+#include <limits>
+#include <span>
+#include <vector>
+
+/// <summary>
+/// Bounding volume hierarchy over the world bounding boxes of the mesh instances of a scene, see
+/// NodeHierarchy::getFirstMeshInstance. Queries visit only the subtrees whose bounding box passes the test, instead of
+/// testing every mesh instance.
+///
+/// The hierarchy is built top down with the surface area heuristic, evaluated for a fixed number of bins of the
+/// centroids on each axis. Large subtrees are built in parallel on a thread pool. When mesh instances move, refit
+/// recomputes the bounding boxes of all nodes and keeps the structure, which stays valid, but becomes less efficient
+/// the further the instances move.
+/// </summary>
+class InstanceBVH
+{
+public:
+  /// <summary>
+  /// Number of bins per axis, in which the split with the lowest surface area heuristic is searched.
+  /// </summary>
+  static constexpr gims::ui32 NUMBER_OF_BINS = 16;
+
+  /// <summary>
+  /// Nodes with at most this number of mesh instances become leaves.
+  /// </summary>
+  static constexpr gims::ui32 MAX_INSTANCES_PER_LEAF = 4;
+
+  /// <summary>
+  /// Subtrees with fewer mesh instances are built by a single task.
+  /// </summary>
+  static constexpr gims::ui32 MIN_INSTANCES_PER_TASK = 1 << 12;
+
+  /// <summary>
+  /// Mesh instance of a ray that hits nothing.
+  /// </summary>
+  static constexpr gims::ui32 NO_INSTANCE = ~0u;
+
+  /// <summary>
+  /// The closest bounding box hit by a ray.
+  /// </summary>
+  struct RayHit
+  {
+    gims::ui32 meshInstance = NO_INSTANCE;                           //! The mesh instance, or NO_INSTANCE.
+    gims::f32  distance     = std::numeric_limits<gims::f32>::max(); //! Ray parameter of the entry point.
+  };
+
+  /// <summary>
+  /// Creates an empty hierarchy.
+  /// </summary>
+  InstanceBVH() = default;
+
+  /// <summary>
+  /// Builds the hierarchy. Mesh instances with an invalid bounding box are never found by a query.
+  /// </summary>
+  /// <param name="meshInstanceAABBs">Bounding box of each mesh instance.</param>
+  /// <param name="threadPool">Pool on which large subtrees are built in parallel, or nullptr to build on the calling
+  /// thread. Must not be called from a task of the pool.</param>
+  void build(std::span<const AABB> meshInstanceAABBs, gims::ThreadPool* threadPool = nullptr);
+
+  /// <summary>
+  /// Recomputes the bounding boxes of all nodes after the mesh instances have moved, without changing the structure.
+  /// </summary>
+  /// <param name="meshInstanceAABBs">Bounding box of each mesh instance, as many as in build.</param>
+  void refit(std::span<const AABB> meshInstanceAABBs);
+
+  /// <summary>
+  /// Returns the number of nodes, 0 if the hierarchy is empty.
+  /// </summary>
+  gims::ui32 getNumberOfNodes() const;
+
+  /// <summary>
+  /// Tests the mesh instances against a set of planes with the same result as NodeHierarchy::cullMeshInstances. Skips
+  /// the subtrees that are completely behind one plane, and does not test the mesh instances of subtrees that are
+  /// completely in front of all planes. Within a subtree, only the planes it intersects are tested.
+  /// </summary>
+  /// <param name="planes">Planes in the coordinate system of the scene. Normals point inwards.</param>
+  /// <param name="visible">Receives 1 for each visible mesh instance and 0 for each culled one.</param>
+  /// <returns>The number of visible mesh instances.</returns>
+  gims::ui32 cullFrustum(std::span<const gims::f32v4> planes, std::vector<gims::ui8>& visible) const;
+
+  /// <summary>
+  /// Finds the mesh instance whose bounding box is entered first by a ray, e.g., for picking.
+  /// </summary>
+  /// <param name="origin">Origin of the ray in the coordinate system of the scene.</param>
+  /// <param name="direction">Direction of the ray. Does not need to be normalized.</param>
+  /// <param name="maxDistance">Bounding boxes entered at a larger ray parameter are ignored.</param>
+  /// <returns>The mesh instance and the ray parameter, or NO_INSTANCE, if no bounding box is hit. A ray starting
+  /// inside a bounding box hits it at distance 0.</returns>
+  RayHit intersectRay(const gims::f32v3& origin, const gims::f32v3& direction,
+                      gims::f32 maxDistance = std::numeric_limits<gims::f32>::max()) const;
+
+  /// <summary>
+  /// Finds all mesh instances whose bounding box overlaps a bounding box.
+  /// </summary>
+  /// <param name="aabb">The bounding box in the coordinate system of the scene.</param>
+  /// <param name="meshInstances">Receives the mesh instances in no particular order. Cleared first.</param>
+  void queryAABB(const AABB& aabb, std::vector<gims::ui32>& meshInstances) const;
+
+private:
+  /// <summary>
+  /// A node of the hierarchy. The children of an inner node are stored next to each other after the node. The mesh
+  /// instances of every subtree are a contiguous range of m_meshInstances.
+  /// </summary>
+  struct Node
+  {
+    AABB       aabb;              //! Bounding box of all mesh instances of the subtree.
+    gims::ui32 firstChild    = 0; //! Index of the first child, 0 for a leaf.
+    gims::ui32 firstInstance = 0; //! Position of the first mesh instance of the subtree in m_meshInstances.
+    gims::ui32 nInstances    = 0; //! Number of mesh instances of the subtree.
+  };
+
+  /// <summary>
+  /// A subtree, whose root node has been added, but whose descendants are built by a task.
+  /// </summary>
+  struct Subtree
+  {
+    gims::ui32 nodeIdx = 0; //! Index of the root of the subtree.
+    gims::ui32 begin   = 0; //! Position of the first mesh instance of the subtree in m_meshInstances.
+    gims::ui32 end     = 0; //! Position after the last mesh instance of the subtree in m_meshInstances.
+  };
+
+  /// <summary>
+  /// Builds the subtree of the mesh instances m_meshInstances[begin] to [end-1] with its root at nodes[nodeIdx], and
+  /// appends its other nodes to nodes. If subtrees is not nullptr, subtrees of at most maxTaskInstances mesh instances
+  /// are only added to subtrees, to be built later.
+  /// </summary>
+  void buildNode(std::vector<Node>& nodes, gims::ui32 nodeIdx, gims::ui32 begin, gims::ui32 end,
+                 gims::ui32 maxTaskInstances, std::vector<Subtree>* subtrees);
+
+  /// <summary>
+  /// Partitions the mesh instances m_meshInstances[begin] to [end-1] with the binned split of the lowest surface area
+  /// heuristic.
+  /// </summary>
+  /// <returns>The position of the first mesh instance of the second child, or begin, if the range becomes a
+  /// leaf.</returns>
+  gims::ui32 split(gims::ui32 begin, gims::ui32 end);
+
+  std::vector<Node>       m_nodes;         //! The nodes, the root first. Children follow their parent.
+  std::vector<gims::ui32> m_meshInstances; //! Mesh instances with a valid bounding box, ordered by leaves.
+  std::vector<AABB>       m_aabbs;         //! Bounding box of each mesh instance, as passed to build or refit.
+};
+#endif // INSTANCE_BVH_CLASS
@@ -0,0 +1,197 @@
+// NodeHierarchy.hpp
+#ifndef NODE_HIERARCHY_CLASS
+#define NODE_HIERARCHY_CLASS
+
+#include "AABB.hpp"
+#include <gimslib/sys/ThreadPool.hpp>
+#include <gimslib/types.hpp>
+#include <span>
+#include <vector>
+
+/// <summary>
+/// The nodes of the scene graph, stored as one array per member in depth-first order. Each node refers to its parent
+/// by index, and a parent is always stored before its children, so the world transformations of all nodes are
+/// computed in a single pass over the arrays, without recursion or allocation.
+///
+/// The descendants of a node directly follow it, so every subtree is a contiguous range of nodes. Changing the local
+/// transformation of a node marks it as dirty, and updateWorldTransformations only recomputes the world
+/// transformations and bounding boxes of the dirty subtrees and the bounding boxes of their ancestors. The cached
+/// values of all other nodes are kept.
+///
+/// Large dirty subtrees are split into smaller subtrees, which are updated in parallel on a thread pool. Each node is
+/// computed the same way by any thread, so the result does not depend on the number of threads.
+///
+/// Each entry of the mesh indices of a node is a mesh instance. The world bounding boxes of all mesh instances are
+/// stored in one array, so they are culled in one batch, four at a time with SSE2.
+/// </summary>
+class NodeHierarchy
+{
+public:
+  /// <summary>
+  /// Parent index of the root nodes.
+  /// </summary>
+  static constexpr gims::ui32 NO_PARENT = ~0u;
+
+  /// <summary>
+  /// Subtrees with fewer nodes are updated by a single task.
+  /// </summary>
+  static constexpr gims::ui32 MIN_NODES_PER_TASK = 1 << 12;
+
+  /// <summary>
+  /// Creates an empty hierarchy.
+  /// </summary>
+  NodeHierarchy() = default;
+
+  /// <summary>
+  /// Appends a node, and computes its world transformation and bounding boxes. Nodes have to be added in depth-first
+  /// preorder, i.e., each node after its parent and before the next sibling of its parent or of any other ancestor.
+  /// The parent therefore has to be NO_PARENT, the node added last, or one of the ancestors of that node. Throws
+  /// std::out_of_range if the parent has not been added before, and std::invalid_argument if the subtree of the
+  /// parent has already been followed by another node, or if there is not one bounding box per mesh.
+  /// </summary>
+  /// <param name="parentIdx">Index of the parent node, or NO_PARENT for a root node.</param>
+  /// <param name="localTransformation">Transformation to the parent node.</param>
+  /// <param name="meshIndices">Indices of the meshes of the node, i.e., Scene::m_meshes[].</param>
+  /// <param name="meshAABBs">Bounding box of each mesh of meshIndices in the coordinate system of the mesh.</param>
+  /// <returns>The index of the new node.</returns>
+  gims::ui32 addNode(gims::ui32 parentIdx, const gims::f32m4& localTransformation,
+                     std::span<const gims::ui32> meshIndices, std::span<const AABB> meshAABBs);
+
+  /// <summary>
+  /// Returns the total number of nodes.
+  /// </summary>
+  gims::ui32 getNumberOfNodes() const;
+
+  /// <summary>
+  /// Returns the index of the parent of a node, or NO_PARENT for a root node.
+  /// </summary>
+  /// <param name="nodeIdx">Index of the node.</param>
+  gims::ui32 getParent(gims::ui32 nodeIdx) const;
+
+  /// <summary>
+  /// Returns the index after the last descendant of a node. The subtree of the node are the nodes nodeIdx to
+  /// getSubtreeEnd(nodeIdx) - 1.
+  /// </summary>
+  /// <param name="nodeIdx">Index of the node.</param>
+  gims::ui32 getSubtreeEnd(gims::ui32 nodeIdx) const;
+
+  /// <summary>
+  /// Returns the transformation of a node to its parent node.
+  /// </summary>
+  /// <param name="nodeIdx">Index of the node.</param>
+  const gims::f32m4& getLocalTransformation(gims::ui32 nodeIdx) const;
+
+  /// <summary>
+  /// Changes the transformation of a node to its parent node, and marks the node as dirty. The world transformations
+  /// and bounding boxes are updated by the next call of updateWorldTransformations.
+  /// </summary>
+  /// <param name="nodeIdx">Index of the node.</param>
+  /// <param name="localTransformation">Transformation to the parent node.</param>
+  void setLocalTransformation(gims::ui32 nodeIdx, const gims::f32m4& localTransformation);
+
+  /// <summary>
+  /// Returns true, if the local transformation of the node has changed since the last update.
+  /// </summary>
+  /// <param name="nodeIdx">Index of the node.</param>
+  bool isDirty(gims::ui32 nodeIdx) const;
+
+  /// <summary>
+  /// Returns the transformation of a node to the scene, as computed by the last call of updateWorldTransformations.
+  /// </summary>
+  /// <param name="nodeIdx">Index of the node.</param>
+  const gims::f32m4& getWorldTransformation(gims::ui32 nodeIdx) const;
+
+  /// <summary>
+  /// Returns the total number of mesh instances, i.e., the sum of the number of meshes of all nodes.
+  /// </summary>
+  gims::ui32 getNumberOfMeshInstances() const;
+
+  /// <summary>
+  /// Returns the index of the mesh instance of the first mesh of a node. The meshes of the nodes are numbered in
+  /// storage order.
+  /// </summary>
+  /// <param name="nodeIdx">Index of the node.</param>
+  gims::ui32 getFirstMeshInstance(gims::ui32 nodeIdx) const;
+
+  /// <summary>
+  /// Returns the indices of the meshes of a node, i.e., Scene::m_meshes[].
+  /// </summary>
+  /// <param name="nodeIdx">Index of the node.</param>
+  std::span<const gims::ui32> getMeshIndices(gims::ui32 nodeIdx) const;
+
+  /// <summary>
+  /// Returns the bounding boxes of the meshes of a node in the coordinate system of the scene, in the order of
+  /// getMeshIndices.
+  /// </summary>
+  /// <param name="nodeIdx">Index of the node.</param>
+  std::span<const AABB> getMeshWorldAABBs(gims::ui32 nodeIdx) const;
+
+  /// <summary>
+  /// Returns the bounding boxes of all mesh instances in the coordinate system of the scene, in the order of
+  /// getFirstMeshInstance.
+  /// </summary>
+  std::span<const AABB> getMeshInstanceWorldAABBs() const;
+
+  /// <summary>
+  /// Returns the bounding box of the meshes of a node and all its descendants in the coordinate system of the scene.
+  /// </summary>
+  /// <param name="nodeIdx">Index of the node.</param>
+  const AABB& getSubtreeAABB(gims::ui32 nodeIdx) const;
+
+  /// <summary>
+  /// Returns the bounding box of all meshes in the coordinate system of the scene.
+  /// </summary>
+  AABB getAABB() const;
+
+  /// <summary>
+  /// Tests the world bounding boxes of all mesh instances against a set of planes, e.g., of the view frustum. A mesh
+  /// instance is culled, if its bounding box is completely behind one of the planes. Conservative, mesh instances
+  /// intersecting the volume are never culled. Mesh instances without positions are always culled.
+  /// </summary>
+  /// <param name="planes">Planes in the coordinate system of the scene. Normals point inwards.</param>
+  /// <param name="visible">Receives 1 for each visible mesh instance and 0 for each culled one, in the order of
+  /// getFirstMeshInstance.</param>
+  /// <returns>The number of visible mesh instances.</returns>
+  gims::ui32 cullMeshInstances(std::span<const gims::f32v4> planes, std::vector<gims::ui8>& visible) const;
+
+  /// <summary>
+  /// Recomputes the world transformations and bounding boxes of the subtrees of all dirty nodes in storage order, and
+  /// the bounding boxes of their ancestors. Does nothing, if no node is dirty.
+  /// </summary>
+  /// <param name="threadPool">Pool on which large subtrees are updated in parallel, or nullptr to update all nodes on
+  /// the calling thread. Must not be called from a task of the pool.</param>
+  /// <returns>The number of nodes whose world transformation has been recomputed.</returns>
+  gims::ui32 updateWorldTransformations(gims::ThreadPool* threadPool = nullptr);
+
+private:
+  /// <summary>
+  /// Computes the world transformation of a node and the bounding boxes of its meshes from the world transformation
+  /// of its parent.
+  /// </summary>
+  void updateNode(gims::ui32 nodeIdx);
+
+  /// <summary>
+  /// Computes the bounding box of the subtree of a node from the bounding boxes of its meshes and of the subtrees of
+  /// its children.
+  /// </summary>
+  void updateSubtreeAABB(gims::ui32 nodeIdx);
+
+  /// <summary>
+  /// Computes the world transformations and bounding boxes of a node and all its descendants. The world
+  /// transformation of the parent of the node has to be up to date.
+  /// </summary>
+  void updateSubtree(gims::ui32 nodeIdx);
+
+  std::vector<gims::ui32>  m_parents;              //! Index of the parent of each node.
+  std::vector<gims::ui32>  m_subtreeEnds;          //! Index after the last descendant of each node.
+  std::vector<gims::f32m4> m_localTransformations; //! Transformation of each node to its parent node.
+  std::vector<gims::f32m4> m_worldTransformations; //! Transformation of each node to the scene.
+  std::vector<AABB>        m_subtreeAABBs;         //! Bounding box of each subtree in scene coordinates.
+  std::vector<bool>        m_dirty;                //! Marks the nodes whose local transformation has changed.
+  std::vector<gims::ui32>  m_dirtyNodes;           //! Indices of the dirty nodes, in the order they were marked.
+  std::vector<gims::ui32>  m_meshOffsets;          //! Meshes of node i are m_meshIndices[m_meshOffsets[i]] to [i+1]-1.
+  std::vector<gims::ui32>  m_meshIndices;          //! Mesh indices of all nodes, one range per node.
+  std::vector<AABB>        m_meshAABBs;            //! Bounding box of each entry of m_meshIndices in mesh coordinates.
+  std::vector<AABB>        m_meshWorldAABBs;       //! Bounding box of each entry of m_meshIndices in scene coordinates.
+};
+#endif // NODE_HIERARCHY_CLASS
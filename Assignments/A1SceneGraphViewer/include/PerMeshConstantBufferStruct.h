@@ -4,8 +4,15 @@
 
 #include <gimslib/types.hpp>
 
+/// <summary>
+/// Root constants of a draw call. The layout follows the HLSL packing rules, a float3 and a scalar share 16 bytes.
+/// </summary>
 struct PerMeshConstantBuffer
 {
   gims::f32m4 modelViewMatrix;
+  gims::f32v3 positionOffset; //! Position dequantization: position = positionOffset + positionScale * encoded.
+  gims::ui32  normalFormat;   //! gims::VertexQuantization::NormalFormat of the vertex buffer.
+  gims::f32v3 positionScale;
+  gims::ui32  pad;
 };
 #endif // PER_MESH_CONSTANT_BUFFER_STRUCT
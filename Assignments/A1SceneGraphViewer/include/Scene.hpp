@@ -4,12 +4,17 @@
 
 #include "MaterialConstantBufferStruct.h"
 #include "MaterialStruct.h"
-#include "NodeStruct.h"
+#include "NodeHierarchy.hpp"
 #include "TriangleMeshD3D12.hpp"
 #include "BoundingBox.h"
+#include "DrawSettingsStruct.h"
+#include "InstanceBVH.hpp"
 #include <Texture2DD3D12.hpp>
 #include <d3d12.h>
+#include <gimslib/mesh/MeshWelder.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
 #include <gimslib/types.hpp>
+#include <memory>
 #include <vector>
 
 class SceneGraphFactory;
@@ -31,18 +36,28 @@ public:
   const AABB& getAABB() const;
 
   /// <summary>
-  /// Nodes are stored in a flat 1D array. This functions returns the Node at the respecitve index.
+  /// Returns the nodes of the scene graph, stored as flat arrays in depth-first order.
   /// </summary>
-  /// <param name="nodeIdx">Index of the node within the array of nodes.</param>
-  /// <returns></returns>
-  const Node& getNode(gims::ui32 nodeIdx) const;
+  const NodeHierarchy& getNodeHierarchy() const;
 
   /// <summary>
-  /// Nodes are stored in a flat 1D array. This functions returns the Node at the respecitve index.
+  /// Returns the nodes of the scene graph, stored as flat arrays in depth-first order.
   /// </summary>
-  /// <param name="nodeIdx">Index of the node within the array of nodes.</param>
-  /// <returns></returns>
-  Node& getNode(gims::ui32 nodeIdx);
+  NodeHierarchy& getNodeHierarchy();
+
+  /// <summary>
+  /// Returns the bounding volume hierarchy over the world bounding boxes of all mesh instances, see
+  /// NodeHierarchy::getFirstMeshInstance. Use it for ray and box queries; frustum culling every frame is faster with
+  /// NodeHierarchy::cullMeshInstances.
+  /// </summary>
+  const InstanceBVH& getInstanceBVH() const;
+
+  /// <summary>
+  /// Recomputes the world transformations and bounding boxes of the nodes whose local transformation has been changed
+  /// with NodeHierarchy::setLocalTransformation, and the bounding box of the scene. All other nodes keep their cached
+  /// values. Large dirty subtrees are updated in parallel. The bounding volume hierarchy is refitted.
+  /// </summary>
+  void updateWorldTransformations();
 
   /// <summary>
   /// Returns the total number of nodes.
@@ -64,6 +79,21 @@ public:
 
   const gims::ui32 getNumberOfTextures() const;
 
+  /// <summary>
+  /// Returns the number of clusters all meshes are split into.
+  /// </summary>
+  const gims::ui32 getNumberOfClusters() const;
+
+  /// <summary>
+  /// Returns the number of triangles of all meshes at their finest level of detail.
+  /// </summary>
+  const gims::ui32 getNumberOfTriangles() const;
+
+  /// <summary>
+  /// Returns how many vertices and triangles have been removed by joining equal vertices while importing the scene.
+  /// </summary>
+  const gims::MeshWelder::WeldReport& getWeldReport() const;
+
   /// <summary>
   /// Materials are stored in a 1D array. This function returns the Material at the respective index.
   /// </summary>
@@ -84,6 +114,25 @@ public:
                         const gims::f32m4 transformation, gims::ui32 modelViewRootParameterIdx,
                         gims::ui32 materialConstantsRootParameterIdx, gims::ui32 srvRootParameterIdx);
 
+  /// <summary>
+  /// Like addToCommandList, but draws each mesh with the coarsest level of detail whose error, projected to the screen,
+  /// is small enough. Optionally only draws the clusters that intersect the view frustum and face the camera.
+  /// </summary>
+  /// <param name="commandList">The command list to which the commands will be added.</param>
+  /// <param name="transformation">The view matrix (or camera matrix).</param>
+  /// <param name="drawSettings">Projection, viewport height, culling, and level of detail settings. Culling back-facing
+  /// clusters is only correct, if back faces are not visible.</param>
+  /// <param name="pipelineState">Pipeline for meshes without tangents.</param>
+  /// <param name="normalMappedPipelineState">Pipeline for meshes with tangents, whose material has a normal
+  /// map.</param>
+  /// <returns>The number of clusters and triangles drawn.</returns>
+  DrawStatistics addToCommandList(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList,
+                                  const gims::f32m4 transformation, const DrawSettings& drawSettings,
+                                  const Microsoft::WRL::ComPtr<ID3D12PipelineState>& pipelineState,
+                                  const Microsoft::WRL::ComPtr<ID3D12PipelineState>& normalMappedPipelineState,
+                                  gims::ui32 modelViewRootParameterIdx, gims::ui32 materialConstantsRootParameterIdx,
+                                  gims::ui32 srvRootParameterIdx);
+
   void addToCommandListBB(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList,
                           const gims::f32m4 transformation, gims::ui32 modelViewRootParameterIdx,
                           gims::ui32 materialConstantsRootParameterIdx, gims::ui32 srvRootParameterIdx);
@@ -92,12 +141,15 @@ public:
   friend class SceneGraphFactory;
 
 private:
-  std::vector<Node>              m_nodes;  //! The nodes of the scene.
-  std::vector<TriangleMeshD3D12> m_meshes; //! Array meshes of the scene. m_meshesBB
-  std::vector<BoundingBox>       m_meshesBB;
-  AABB                           m_aabb;      //! The axis-aligned bounding box of the scene.
-  std::vector<Material>          m_materials; //! Material information for each mesh.
-  std::vector<Texture2DD3D12>    m_textures;  //! Array of textures.
+  NodeHierarchy                     m_nodeHierarchy; //! The nodes of the scene.
+  InstanceBVH                       m_instanceBVH;   //! Hierarchy over the bounding boxes of the mesh instances.
+  std::vector<TriangleMeshD3D12>    m_meshes;        //! Array meshes of the scene. m_meshesBB
+  std::vector<BoundingBox>          m_meshesBB;
+  AABB                              m_aabb;       //! The axis-aligned bounding box of the scene.
+  std::vector<Material>             m_materials;  //! Material information for each mesh.
+  std::vector<Texture2DD3D12>       m_textures;   //! Array of textures.
+  gims::MeshWelder::WeldReport      m_weldReport; //! Savings of joining equal vertices of all meshes.
+  std::unique_ptr<gims::ThreadPool> m_threadPool; //! Workers for updating the world transformations.
 };
 
 #endif // SCENE_CLASS
@@ -4,6 +4,7 @@
 
 #include "Scene.hpp"
 #include <filesystem>
+#include <gimslib/mesh/VertexQuantization.hpp>
 #include <unordered_map>
 
 struct aiScene;
@@ -14,18 +15,30 @@ class SceneGraphFactory
 public:
   static Scene createFromAssImpScene(const std::filesystem::path                       pathToScene,
                                      const Microsoft::WRL::ComPtr<ID3D12Device>&       device,
-                                     const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue);
+                                     const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue,
+                                     const gims::VertexQuantization::VertexFormat&     vertexFormat);
+
+  /// <summary>
+  /// Returns the vertex format of meshes whose material has a normal map. These meshes have an additional tangent
+  /// stream, in floats if the normals are uncompressed and in 16 bit signed normalized integers otherwise.
+  /// </summary>
+  /// <param name="vertexFormat">Vertex format of the meshes without normal map.</param>
+  /// <returns>The vertex format with tangents.</returns>
+  static gims::VertexQuantization::VertexFormat
+  getNormalMappedVertexFormat(const gims::VertexQuantization::VertexFormat& vertexFormat);
 
 private:
   static void createMeshes(aiScene const* const inputScene, const Microsoft::WRL::ComPtr<ID3D12Device>& device,
-                           const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue, Scene& outputScene);
+                           const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue,
+                           const gims::VertexQuantization::VertexFormat& vertexFormat, Scene& outputScene,
+                           std::vector<std::vector<gims::ui32>>& meshIndicesOfAiMeshes);
 
   static void createMeshesBB(const Microsoft::WRL::ComPtr<ID3D12Device>& device,
                            const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue, Scene& outputScene);
 
-  static gims::ui32 createNodes(aiScene const* const inputScene, Scene& outputScene, aiNode const* const inputNode);
-
-  static void computeSceneAABB(Scene& scene, AABB& aabb, gims::ui32 nodeIdx, gims::f32m4 transformation);
+  static gims::ui32 createNodes(aiScene const* const inputScene, Scene& outputScene, aiNode const* const inputNode,
+                                gims::ui32                                  parentIdx,
+                                const std::vector<std::vector<gims::ui32>>& meshIndicesOfAiMeshes);
 
   static void createTextures(const std::unordered_map<std::filesystem::path, gims::ui32>& textureFileNameToTextureIndex,
                              std::filesystem::path parentPath, const Microsoft::WRL::ComPtr<ID3D12Device>& device,
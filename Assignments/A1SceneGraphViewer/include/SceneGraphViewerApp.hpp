@@ -2,10 +2,12 @@
 #ifndef SCENE_GRAPH_VIEWER_APP_CLASS
 #define SCENE_GRAPH_VIEWER_APP_CLASS
 
+#include "DrawSettingsStruct.h"
 #include "LightStruct.h"
 #include "Scene.hpp"
 #include "UiDataStruct.h"
 #include <gimslib/d3d/DX12App.hpp>
+#include <gimslib/mesh/VertexQuantization.hpp>
 #include <gimslib/types.hpp>
 #include <gimslib/ui/ExaminerController.hpp>
 
@@ -19,7 +21,10 @@ public:
   /// Creates the SceneGraphViewerApp and loads a scene.
   /// </summary>
   /// <param name="config">Configuration.</param>
-  SceneGraphViewerApp(const gims::DX12AppConfig config, const std::filesystem::path pathToScene);
+  /// <param name="pathToScene">The scene to load.</param>
+  /// <param name="vertexFormat">Encoding of the vertices on the GPU, compact by default.</param>
+  SceneGraphViewerApp(const gims::DX12AppConfig config, const std::filesystem::path pathToScene,
+                      const gims::VertexQuantization::VertexFormat vertexFormat = {});
 
   ~SceneGraphViewerApp() = default;
 
@@ -54,11 +59,14 @@ private:
 
   void updateSceneConstantBuffer();
 
+  gims::f32m4 getProjectionMatrix();
+
   gims::f32v3 getCameraPosition();
 
   void updateUiDataStruct();
 
   ComPtr<ID3D12PipelineState>      m_pipelineState;
+  ComPtr<ID3D12PipelineState>      m_pipelineStateNormalMapped; //! For meshes with tangents.
   ComPtr<ID3D12PipelineState>      m_pipelineStateBB;
   ComPtr<ID3D12RootSignature>      m_rootSignature;
   std::vector<ConstantBufferD3D12> m_constantBuffers;
@@ -68,5 +76,8 @@ private:
   int                              m_numOfLights = {1};
   Light                            m_Lights[8];
   bool                             m_displayBoundingBoxes;
+  DrawSettings                     m_drawSettings; //! Culling and level of detail settings.
+
+  gims::VertexQuantization::VertexFormat m_vertexFormat; //! Encoding of the vertices of all meshes.
 };
 #endif // SCENE_GRAPH_VIEWER_APP_CLASS
@@ -3,33 +3,47 @@
 #define TRIANGLE_MESH_D3D12_CLASS
 
 #include "AABB.hpp"
+#include "DrawSettingsStruct.h"
+#include "VertexStruct.h"
 #include <d3d12.h>
+#include <gimslib/mesh/MeshSimplifier.hpp>
+#include <gimslib/mesh/Meshlets.hpp>
+#include <gimslib/mesh/VertexQuantization.hpp>
 #include <gimslib/types.hpp>
 #include <vector>
 #include <wrl.h>
 
 /// <summary>
 /// A D3D12 GPU triangle mesh.
+/// The triangles are split into clusters (meshlets), each of which is a range of the index buffer, so that clusters
+/// outside the view frustum or facing away from the camera can be skipped.
+/// Coarser levels of detail are stored behind the original triangles in the same index buffer. Clusters are only
+/// built for the original triangles, coarser levels are culled as a whole.
+/// The vertex buffer may be quantized. Positions are then stored relative to the bounding box of the mesh, the vertex
+/// shader maps them back with the position dequantization passed in the per-mesh constants.
+/// Meshes with a normal map additionally store a tangent per vertex, see hasTangents.
 /// </summary>
 class TriangleMeshD3D12
 {
 public:
   /// <summary>
-  /// Constructor that creates a D3D12 GPU Triangle mesh from positions, normals, and texture coordiantes.
+  /// Constructor that creates a D3D12 GPU Triangle mesh from interleaved vertices, which are encoded in the given
+  /// vertex format before the upload.
   /// </summary>
-  /// <param name="positions">Array of 3D positions. There must be nVertices elements in this array.</param>
-  /// <param name="normals">Array of 3D normal vector. There must be nVertices elements in this array.</param>
-  /// <param name="textureCoordinates">Array of 3D texture Coordinates. This class ignores the third component of each
-  /// texture coordinate. There must be nVertices elements in this array.</param>
+  /// <param name="vertices">Array of vertices. There must be nVertices elements in this array.</param>
   /// <param name="nVertices">Number of vertices.</param>
   /// <param name="indexBuffer">Index buffer for triangle list. Triples of integer indices form a triangle.</param>
   /// <param name="nIndices">Number of indices (NOT the number triangles!)</param>
   /// <param name="materialIndex">Material index.</param>
+  /// <param name="vertexFormat">Encoding of the vertices in the vertex buffer.</param>
+  /// <param name="tangents">Tangent and handedness of each vertex, see gims::MeshTangents. Required if the vertex
+  /// format has a tangent stream, nullptr otherwise.</param>
   /// <param name="device">Device on which the GPU buffers should be created.</param>
   /// <param name="commandQueue">Command queue used to copy the data from the GPU to the GPU.</param>
-  TriangleMeshD3D12(gims::f32v3 const* const positions, gims::f32v3 const* const normals,
-                    gims::f32v3 const* const textureCoordinates, gims::ui32 nVertices,
-                    gims::ui32v3 const* const indexBuffer, gims::ui32 nIndices, gims::ui32 materialIndex,
+  TriangleMeshD3D12(Vertex const* const vertices, gims::ui32 nVertices, gims::ui32 const* const indexBuffer,
+                    gims::ui32 nIndices, gims::ui32 materialIndex,
+                    const gims::VertexQuantization::VertexFormat&     vertexFormat,
+                    gims::f32v4 const* const                          tangents,
                     const Microsoft::WRL::ComPtr<ID3D12Device>&       device,
                     const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue);
 
@@ -39,6 +53,36 @@ public:
   /// <param name="commandList">The command list</param>
   void addToCommandList(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList) const;
 
+  /// <summary>
+  /// Adds the commands neccessary for rendering this triangle mesh to the provided commandList. Selects the coarsest
+  /// level of detail whose error projected to the screen is small enough, and draws only the clusters that pass
+  /// culling. Consecutive visible clusters are drawn with a single draw call.
+  /// </summary>
+  /// <param name="commandList">The command list</param>
+  /// <param name="modelView">Transforms from the coordinate system of the mesh to view space.</param>
+  /// <param name="drawSettings">Culling and level of detail settings.</param>
+  /// <returns>The number of clusters and triangles drawn.</returns>
+  DrawStatistics addToCommandList(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList,
+                                  const gims::f32m4& modelView, const DrawSettings& drawSettings) const;
+
+  /// <summary>
+  /// Returns the number of clusters the mesh is split into.
+  /// </summary>
+  /// <returns>The number of clusters.</returns>
+  const gims::ui32 getNumberOfClusters() const;
+
+  /// <summary>
+  /// Returns the number of triangles of the finest level of detail.
+  /// </summary>
+  /// <returns>The number of triangles.</returns>
+  const gims::ui32 getNumberOfTriangles() const;
+
+  /// <summary>
+  /// Returns the number of levels of detail, including the original mesh.
+  /// </summary>
+  /// <returns>The number of levels of detail.</returns>
+  const gims::ui32 getNumberOfLevelsOfDetail() const;
+
   /// <summary>
   /// Returns the axis-aligned bounding-box of the mesh.
   /// </summary>
@@ -51,11 +95,31 @@ public:
   /// <returns><The material index of the mesh./returns>
   const gims::ui32 getMaterialIndex() const;
 
+  /// <summary>
+  /// Returns the transformation from encoded positions back to the coordinate system of the mesh.
+  /// </summary>
+  /// <returns>The position dequantization, the identity for uncompressed positions.</returns>
+  const gims::VertexQuantization::PositionDequantization& getPositionDequantization() const;
+
+  /// <summary>
+  /// Returns the encoding of the vertices in the vertex buffer.
+  /// </summary>
+  /// <returns>The vertex format.</returns>
+  const gims::VertexQuantization::VertexFormat& getVertexFormat() const;
+
+  /// <summary>
+  /// Returns whether the vertex buffer has a tangent stream, which is needed for normal mapping.
+  /// </summary>
+  /// <returns>True, if the vertex format has tangents.</returns>
+  const bool hasTangents() const;
+
   /// <summary>
   /// Returns the input element descriptors required for the pipeline.
   /// </summary>
+  /// <param name="vertexFormat">Encoding of the vertices in the vertex buffer.</param>
   /// <returns>The input element descriptor.</returns>
-  static const std::vector<D3D12_INPUT_ELEMENT_DESC>& getInputElementDescriptors();
+  static std::vector<D3D12_INPUT_ELEMENT_DESC>
+  getInputElementDescriptors(const gims::VertexQuantization::VertexFormat& vertexFormat);
 
   TriangleMeshD3D12();
   TriangleMeshD3D12(const TriangleMeshD3D12& other)                = default;
@@ -64,7 +128,7 @@ public:
   TriangleMeshD3D12& operator=(TriangleMeshD3D12&& other) noexcept = default;
 
 private:
-  gims::ui32                             m_nIndices;         //! Number of indices in the index buffer.
+  gims::ui32                             m_nIndices;         //! Number of indices of the finest level of detail.
   gims::ui32                             m_vertexBufferSize; //! Vertex buffer size in bytes.
   gims::ui32                             m_indexBufferSize;  //! Index buffer size in bytes.
   AABB                                   m_aabb;             //! Axis aligned bounding box of the mesh.
@@ -73,8 +137,12 @@ private:
   D3D12_VERTEX_BUFFER_VIEW               m_vertexBufferView;
   Microsoft::WRL::ComPtr<ID3D12Resource> m_indexBuffer; //! The index buffer on the GPU.
   D3D12_INDEX_BUFFER_VIEW                m_indexBufferView;
+  std::vector<gims::Meshlets::Meshlet>   m_meshlets; //! Clusters of triangles, in the order of the index buffer.
+
+  //! Levels of detail as ranges of the index buffer, from finest to coarsest.
+  std::vector<gims::MeshSimplifier::LevelOfDetail> m_levelsOfDetail;
 
-  //! Input element descriptor defining the vertex format.
-  static const std::vector<D3D12_INPUT_ELEMENT_DESC> m_inputElementDescs;
+  gims::VertexQuantization::VertexFormat           m_vertexFormat;           //! Encoding of the vertex buffer.
+  gims::VertexQuantization::PositionDequantization m_positionDequantization; //! Maps encoded positions to the mesh.
 };
 #endif // TRIANGLE_MESH_D3D12_CLASS
@@ -11,6 +11,17 @@ struct UiData
   gims::ui32  numberOfMeshes             = gims::ui32(0);
   gims::ui32  numberOfMaterials          = gims::ui32(0);
   gims::ui32  numberOfTextures           = gims::ui32(0);
+  gims::ui32  numberOfMeshInstances      = gims::ui32(0);
+  gims::ui32  numberOfDrawnInstances     = gims::ui32(0);
+  gims::ui32  numberOfCulledInstances    = gims::ui32(0);
+  gims::ui32  numberOfClusters           = gims::ui32(0);
+  gims::ui32  numberOfDrawnClusters      = gims::ui32(0);
+  gims::ui32  numberOfTriangles          = gims::ui32(0);
+  gims::ui32  numberOfDrawnTriangles     = gims::ui32(0);
+  gims::ui32  numberOfWeldedVertices     = gims::ui32(0);
+  gims::ui32  numberOfImportedVertices   = gims::ui32(0);
+  gims::ui32  numberOfRemovedTriangles   = gims::ui32(0);
+  gims::ui32  numberOfBytesPerVertex     = gims::ui32(0);
   gims::f32v3 sceneLowerleftAABBPosition = gims::f32v3(0.0f, 0.0f, 0.0f);
   gims::f32v3 sceneTopRightAABBPosition  = gims::f32v3(0.0f, 0.0f, 0.0f);
 };
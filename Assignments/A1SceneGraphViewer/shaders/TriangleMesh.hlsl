@@ -3,7 +3,7 @@
 struct VertexInput
 {
     float3 position : POSITION;
-    float3 normal : NORMAL;
+    float4 normal : NORMAL;
     float2 texCoord : TEXCOORD;
 };
 
@@ -15,6 +15,26 @@ struct VertexShaderOutput
     float2 texCoord : TEXCOOD;
 };
 
+/// <summary>
+/// Vertices of meshes with a normal map. The tangent is in the coordinate system of the mesh, w is the handedness.
+/// </summary>
+struct NormalMappedVertexInput
+{
+    float3 position : POSITION;
+    float4 normal : NORMAL;
+    float2 texCoord : TEXCOORD;
+    float4 tangent : TANGENT;
+};
+
+struct NormalMappedVertexShaderOutput
+{
+    float4 clipSpacePosition : SV_POSITION;
+    float3 viewSpacePosition : POSITION;
+    float3 viewSpaceNormal : NORMAL;
+    float2 texCoord : TEXCOOD;
+    float4 viewSpaceTangent : TANGENT;
+};
+
 struct Light
 {
     float3 position;
@@ -40,8 +60,17 @@ cbuffer PerFrameConstants : register(b0)
 cbuffer PerMeshConstants : register(b1)
 {
     float4x4 modelViewMatrix;
+    float3   positionOffset;
+    uint     normalFormat;
+    float3   positionScale;
+    uint     pad;
 }
 
+// Values of gims::VertexQuantization::NormalFormat.
+static const uint NORMAL_FLOAT3             = 0;
+static const uint NORMAL_OCTAHEDRAL_SNORM16 = 1;
+static const uint NORMAL_UNORM10_10_10_2    = 2;
+
 /// <summary>
 /// Constants that are really constant for the entire scene.
 /// </summary>
@@ -61,36 +90,78 @@ Texture2D<float4> g_textureNormal : register(t4);
 
 SamplerState g_sampler : register(s0);
 
+/// <summary>
+/// Decodes a normal of the vertex buffer. The result is not normalized.
+/// </summary>
+float3 decodeNormal(float4 encoded)
+{
+    if (normalFormat == NORMAL_OCTAHEDRAL_SNORM16)
+    {
+        // Unfold the lower hemisphere from the corners of the octahedral map.
+        float3 n = float3(encoded.xy, 1.0f - abs(encoded.x) - abs(encoded.y));
+        float  t = max(-n.z, 0.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return n;
+    }
+    if (normalFormat == NORMAL_UNORM10_10_10_2)
+    {
+        return encoded.xyz * 2.0f - 1.0f;
+    }
+    return encoded.xyz;
+}
+
 VertexShaderOutput VS_main(VertexInput input)
 {
     VertexShaderOutput output;
 
-    float4 p4 = mul(modelViewMatrix, float4(input.position, 1.0f));
+    // Quantized positions are relative to the bounding box of the mesh, the identity is passed for floats.
+    float3 position = positionOffset + positionScale * input.position;
+
+    float4 p4 = mul(modelViewMatrix, float4(position, 1.0f));
     output.viewSpacePosition = p4.xyz;
-    output.viewSpaceNormal = mul(modelViewMatrix, float4(input.normal, 0.0f)).xyz;
+    output.viewSpaceNormal = mul(modelViewMatrix, float4(decodeNormal(input.normal), 0.0f)).xyz;
     output.clipSpacePosition = mul(projectionMatrix, p4);
     output.texCoord = input.texCoord;
 
     return output;
 }
 
-float4 PS_main(VertexShaderOutput input)
-    : SV_TARGET
+NormalMappedVertexShaderOutput VS_mainNormalMapped(NormalMappedVertexInput input)
 {
-    float3 sampledAmbientColor  = g_textureAmbient.Sample(g_sampler, input.texCoord, 0);
-    float3 sampledDiffuseColor  = g_textureDiffuse.Sample(g_sampler, input.texCoord, 0);
-    float3 sampledSpecularColor = g_textureSpecular.Sample(g_sampler, input.texCoord, 0);
-    float3 sampledEmissiveColor = g_textureEmissive.Sample(g_sampler, input.texCoord, 0);
-    float3 sampledNormals       = g_textureNormal.Sample(g_sampler, input.texCoord, 0);
-    
+    VertexInput vertex;
+    vertex.position = input.position;
+    vertex.normal   = input.normal;
+    vertex.texCoord = input.texCoord;
+    VertexShaderOutput transformed = VS_main(vertex);
+
+    NormalMappedVertexShaderOutput output;
+    output.clipSpacePosition = transformed.clipSpacePosition;
+    output.viewSpacePosition = transformed.viewSpacePosition;
+    output.viewSpaceNormal = transformed.viewSpaceNormal;
+    output.texCoord = transformed.texCoord;
+    output.viewSpaceTangent = float4(mul(modelViewMatrix, float4(input.tangent.xyz, 0.0f)).xyz, input.tangent.w);
+
+    return output;
+}
+
+/// <summary>
+/// Lights a surface point with the material and all lights.
+/// </summary>
+float4 shade(float3 viewSpacePosition, float2 texCoord, float3 normal)
+{
+    float3 sampledAmbientColor  = g_textureAmbient.Sample(g_sampler, texCoord, 0);
+    float3 sampledDiffuseColor  = g_textureDiffuse.Sample(g_sampler, texCoord, 0);
+    float3 sampledSpecularColor = g_textureSpecular.Sample(g_sampler, texCoord, 0);
+    float3 sampledEmissiveColor = g_textureEmissive.Sample(g_sampler, texCoord, 0);
+
     float3 mixedAmbientColor  = sampledAmbientColor * ambientColor.rgb;
     float3 mixedDiffuseColor  = sampledDiffuseColor * diffuseColor.rgb;
     float3 mixedSpecularColor = sampledSpecularColor + specularColorAndExponent.rgb;
     float3 mixedEmissiveColor = sampledEmissiveColor * emissiveColor.rgb;
     float  exponent           = specularColorAndExponent.a;
     
-    float3 normal = normalize(input.viewSpaceNormal);
-    float3 viewDirection = normalize(cameraPosition - input.viewSpacePosition);
+    float3 viewDirection = normalize(cameraPosition - viewSpacePosition);
 
     // Initialize lighting components
     float3 ambientLighting = mixedAmbientColor;
@@ -100,7 +171,7 @@ float4 PS_main(VertexShaderOutput input)
     // Accumulate lighting from all lights
     for (int i = 0; i < numOfLights; ++i)
     {
-        float3 lightDirection = normalize(lights[i].position - input.viewSpacePosition);
+        float3 lightDirection = normalize(lights[i].position - viewSpacePosition);
         float diffuseFactor = max(dot(normal, lightDirection), 0.0f);
 
         // Diffuse lighting
@@ -117,3 +188,21 @@ float4 PS_main(VertexShaderOutput input)
 
     return float4(finalColor.rgb, 1.0f);
 }
+
+float4 PS_main(VertexShaderOutput input)
+    : SV_TARGET
+{
+    return shade(input.viewSpacePosition, input.texCoord, normalize(input.viewSpaceNormal));
+}
+
+float4 PS_mainNormalMapped(NormalMappedVertexShaderOutput input)
+    : SV_TARGET
+{
+    // As required by MikkTSpace, the bitangent is computed per pixel from the interpolated normal and tangent, which
+    // are not normalized before the normal of the normal map is transformed.
+    float3 bitangent    = input.viewSpaceTangent.w * cross(input.viewSpaceNormal, input.viewSpaceTangent.xyz);
+    float3 mappedNormal = g_textureNormal.Sample(g_sampler, input.texCoord).xyz * 2.0f - 1.0f;
+    float3 normal       = normalize(mappedNormal.x * input.viewSpaceTangent.xyz + mappedNormal.y * bitangent +
+                                    mappedNormal.z * input.viewSpaceNormal);
+    return shade(input.viewSpacePosition, input.texCoord, normal);
+}
@@ -1,6 +1,7 @@
 // AABB.cpp
 
 #include "AABB.hpp"
+#include <gimslib/mesh/MeshBounds.hpp>
 
 AABB::AABB()
     : m_lowerLeftBottom(std::numeric_limits<gims::f32>::max())
@@ -9,16 +10,15 @@ AABB::AABB()
 }
 
 AABB::AABB(gims::f32v3 const* const positions, gims::ui32 nPositions)
-    : m_lowerLeftBottom(std::numeric_limits<gims::f32>::max())
-    , m_upperRightTop(-std::numeric_limits<gims::f32>::max())
+    : AABB(positions, nPositions, sizeof(gims::f32v3))
+{
+}
 
+AABB::AABB(gims::f32v3 const* const positions, gims::ui32 nPositions, size_t strideInBytes)
 {
-  for (gims::ui32 i = 0; i < nPositions; i++)
-  {
-    const glm::vec3& p = positions[i];
-    m_lowerLeftBottom  = glm::min(m_lowerLeftBottom, p);
-    m_upperRightTop    = glm::max(m_upperRightTop, p);
-  }
+  const gims::MeshBounds::Bounds bounds = gims::MeshBounds::computeBounds(&positions->x, nPositions, strideInBytes);
+  m_lowerLeftBottom = bounds.lower;
+  m_upperRightTop   = bounds.upper;
 }
 
 AABB::AABB(const gims::f32v3& lowerLeft, const gims::f32v3& upperRight)
@@ -55,7 +55,28 @@ const gims::f32v3& AABB::getUpperRightTop() const
   return m_upperRightTop;
 }
 
-AABB AABB::getTransformed(gims::f32m4& transformation) const
+AABB AABB::getTransformed(const gims::f32m4& transformation) const
+{
+  if (!isValid())
+  {
+    return AABB();
+  }
+
+  // The transformed box is centered at the transformed center. Its half extent along an axis is the sum of the
+  // absolute lengths of the half extents projected onto the axis.
+  const gims::f32v3 center     = (m_lowerLeftBottom + m_upperRightTop) * 0.5f;
+  const gims::f32v3 halfExtent = (m_upperRightTop - m_lowerLeftBottom) * 0.5f;
+  const gims::f32v3 newCenter  = gims::f32v3(transformation * gims::f32v4(center, 1.0f));
+  gims::f32v3       newHalfExtent(0.0f);
+  for (int column = 0; column < 3; column++)
+  {
+    newHalfExtent += glm::abs(gims::f32v3(transformation[column])) * halfExtent[column];
+  }
+  return {newCenter - newHalfExtent, newCenter + newHalfExtent};
+}
+
+bool AABB::isValid() const
 {
-  return {transformation * gims::f32v4(m_lowerLeftBottom, 1.0f), transformation * gims::f32v4(m_upperRightTop, 1.0f)};
+  return m_lowerLeftBottom.x <= m_upperRightTop.x && m_lowerLeftBottom.y <= m_upperRightTop.y &&
+         m_lowerLeftBottom.z <= m_upperRightTop.z;
 }
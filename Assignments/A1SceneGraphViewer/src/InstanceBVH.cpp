@@ -0,0 +1,448 @@
+// InstanceBVH.cpp
+
+#include "InstanceBVH.hpp"
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+
+/// <summary>
+/// Returns half the surface area of a bounding box, 0 for an invalid one.
+/// </summary>
+gims::f32 static getHalfArea(const AABB& aabb)
+{
+  if (!aabb.isValid())
+  {
+    return 0.0f;
+  }
+  const gims::f32v3 extent = aabb.getUpperRightTop() - aabb.getLowerLeftBottom();
+  return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+/// <summary>
+/// Returns the signed distance of the corner of a bounding box that is furthest along the normal of a plane, or with
+/// furthest = false, of the corner that is furthest against the normal. Summed like in NodeHierarchy.
+/// </summary>
+gims::f32 static getCornerDistance(const AABB& aabb, const gims::f32v4& plane, bool furthest)
+{
+  gims::f32 distance = plane.w;
+  for (int c = 0; c < 3; c++)
+  {
+    const bool      upper  = (plane[c] >= 0.0f) == furthest;
+    const gims::f32 corner = upper ? aabb.getUpperRightTop()[c] : aabb.getLowerLeftBottom()[c];
+    distance += plane[c] * corner;
+  }
+  return distance;
+}
+
+/// <summary>
+/// Returns true, if two bounding boxes overlap. Touching boxes overlap.
+/// </summary>
+bool static overlap(const AABB& a, const AABB& b)
+{
+  for (int c = 0; c < 3; c++)
+  {
+    if (a.getLowerLeftBottom()[c] > b.getUpperRightTop()[c] || b.getLowerLeftBottom()[c] > a.getUpperRightTop()[c])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// <summary>
+/// Returns the ray parameter at which a ray enters a bounding box, clamped to 0, or a negative value, if the ray misses
+/// the box before maxDistance.
+/// </summary>
+gims::f32 static intersect(const AABB& aabb, const gims::f32v3& origin, const gims::f32v3& direction,
+                           gims::f32 maxDistance)
+{
+  gims::f32 entry = 0.0f;
+  gims::f32 exit  = maxDistance;
+  for (int c = 0; c < 3; c++)
+  {
+    const gims::f32 lower = aabb.getLowerLeftBottom()[c];
+    const gims::f32 upper = aabb.getUpperRightTop()[c];
+    if (direction[c] == 0.0f)
+    {
+      // Parallel to the slab, so the ray is either always or never inside.
+      if (origin[c] < lower || origin[c] > upper)
+      {
+        return -1.0f;
+      }
+      continue;
+    }
+    const gims::f32 t0 = (lower - origin[c]) / direction[c];
+    const gims::f32 t1 = (upper - origin[c]) / direction[c];
+    entry              = std::max(entry, std::min(t0, t1));
+    exit               = std::min(exit, std::max(t0, t1));
+  }
+  if (entry > exit)
+  {
+    return -1.0f;
+  }
+  return entry;
+}
+
+void InstanceBVH::build(std::span<const AABB> meshInstanceAABBs, gims::ThreadPool* threadPool)
+{
+  m_aabbs.assign(meshInstanceAABBs.begin(), meshInstanceAABBs.end());
+  m_meshInstances.clear();
+  m_nodes.clear();
+  for (gims::ui32 i = 0; i < static_cast<gims::ui32>(m_aabbs.size()); i++)
+  {
+    if (m_aabbs[i].isValid())
+    {
+      m_meshInstances.push_back(i);
+    }
+  }
+  const gims::ui32 nInstances = static_cast<gims::ui32>(m_meshInstances.size());
+  if (nInstances == 0)
+  {
+    return;
+  }
+  m_nodes.push_back(Node());
+  if (threadPool == nullptr || threadPool->getNumThreads() <= 1 || nInstances <= MIN_INSTANCES_PER_TASK)
+  {
+    buildNode(m_nodes, 0, 0, nInstances, nInstances, nullptr);
+    return;
+  }
+
+  // The top of the hierarchy is split on the calling thread, until the subtrees are small enough for a task. More
+  // tasks than threads let idle workers steal the tasks of busy ones.
+  const gims::ui32 maxTaskInstances = std::max(MIN_INSTANCES_PER_TASK, nInstances / (4 * threadPool->getNumThreads()));
+
+  std::vector<Subtree> subtrees;
+  buildNode(m_nodes, 0, 0, nInstances, maxTaskInstances, &subtrees);
+
+  // Each task builds its subtree into its own array, with the root first. Subtrees cover disjoint ranges of
+  // m_meshInstances, which they partition independently.
+  std::vector<std::vector<Node>> subtreeNodes(subtrees.size());
+  std::vector<std::future<void>> futures;
+  for (size_t i = 0; i < subtrees.size(); i++)
+  {
+    futures.push_back(threadPool->submit(
+        [this, &subtrees, &subtreeNodes, i]
+        {
+          subtreeNodes[i].push_back(Node());
+          buildNode(subtreeNodes[i], 0, subtrees[i].begin, subtrees[i].end, subtrees[i].end - subtrees[i].begin,
+                    nullptr);
+        }));
+  }
+  for (auto& f : futures)
+  {
+    f.get();
+  }
+
+  // The root of a subtree replaces its node, the other nodes are appended. Children still follow their parent.
+  for (size_t i = 0; i < subtrees.size(); i++)
+  {
+    const gims::ui32 offset = static_cast<gims::ui32>(m_nodes.size()) - 1;
+    for (Node& node : subtreeNodes[i])
+    {
+      if (node.firstChild != 0)
+      {
+        node.firstChild += offset;
+      }
+    }
+    m_nodes[subtrees[i].nodeIdx] = subtreeNodes[i][0];
+    m_nodes.insert(m_nodes.end(), subtreeNodes[i].begin() + 1, subtreeNodes[i].end());
+  }
+}
+
+void InstanceBVH::refit(std::span<const AABB> meshInstanceAABBs)
+{
+  if (meshInstanceAABBs.size() != m_aabbs.size())
+  {
+    throw std::invalid_argument("The number of mesh instances has changed since the hierarchy was built.");
+  }
+  m_aabbs.assign(meshInstanceAABBs.begin(), meshInstanceAABBs.end());
+
+  // Children follow their parent, so in reverse order the children of a node are refitted before the node.
+  for (size_t nodeIdx = m_nodes.size(); nodeIdx-- > 0;)
+  {
+    Node& node = m_nodes[nodeIdx];
+    AABB  aabb;
+    if (node.firstChild != 0)
+    {
+      aabb = m_nodes[node.firstChild].aabb.getUnion(m_nodes[node.firstChild + 1].aabb);
+    }
+    else
+    {
+      for (gims::ui32 i = node.firstInstance; i < node.firstInstance + node.nInstances; i++)
+      {
+        aabb = aabb.getUnion(m_aabbs[m_meshInstances[i]]);
+      }
+    }
+    node.aabb = aabb;
+  }
+}
+
+gims::ui32 InstanceBVH::getNumberOfNodes() const
+{
+  return static_cast<gims::ui32>(m_nodes.size());
+}
+
+gims::ui32 InstanceBVH::cullFrustum(std::span<const gims::f32v4> planes, std::vector<gims::ui8>& visible) const
+{
+  if (planes.size() > 32)
+  {
+    throw std::invalid_argument("At most 32 planes are supported.");
+  }
+  visible.assign(m_aabbs.size(), 0);
+  if (m_nodes.empty())
+  {
+    return 0;
+  }
+
+  // Each entry holds a node and a bit mask of the planes its bounding box intersects. Planes the box is completely in
+  // front of are not tested for its descendants.
+  const gims::ui32                               allPlanes = planes.size() == 32 ? ~0u : (1u << planes.size()) - 1;
+  gims::ui32                                     nVisible  = 0;
+  std::vector<std::pair<gims::ui32, gims::ui32>> stack     = {{0, allPlanes}};
+  while (!stack.empty())
+  {
+    const auto [nodeIdx, parentPlanes] = stack.back();
+    stack.pop_back();
+    const Node& node = m_nodes[nodeIdx];
+
+    bool       outside = false;
+    gims::ui32 active  = 0;
+    for (gims::ui32 p = 0; p < planes.size() && !outside; p++)
+    {
+      if ((parentPlanes >> p) & 1)
+      {
+        outside = getCornerDistance(node.aabb, planes[p], true) < 0.0f;
+        if (getCornerDistance(node.aabb, planes[p], false) < 0.0f)
+        {
+          active |= 1u << p;
+        }
+      }
+    }
+    if (outside)
+    {
+      continue;
+    }
+    if (active == 0 || node.firstChild == 0)
+    {
+      // The mesh instances of a leaf, or of a subtree inside all planes, are tested against the planes its bounding
+      // box intersects.
+      for (gims::ui32 i = node.firstInstance; i < node.firstInstance + node.nInstances; i++)
+      {
+        const AABB& instanceAABB    = m_aabbs[m_meshInstances[i]];
+        bool        instanceOutside = false;
+        for (gims::ui32 p = 0; p < planes.size() && !instanceOutside; p++)
+        {
+          instanceOutside = ((active >> p) & 1) && getCornerDistance(instanceAABB, planes[p], true) < 0.0f;
+        }
+        if (!instanceOutside)
+        {
+          visible[m_meshInstances[i]] = 1;
+          nVisible++;
+        }
+      }
+      continue;
+    }
+    stack.push_back({node.firstChild, active});
+    stack.push_back({node.firstChild + 1, active});
+  }
+  return nVisible;
+}
+
+InstanceBVH::RayHit InstanceBVH::intersectRay(const gims::f32v3& origin, const gims::f32v3& direction,
+                                              gims::f32 maxDistance) const
+{
+  RayHit hit;
+  if (m_nodes.empty() || intersect(m_nodes[0].aabb, origin, direction, maxDistance) < 0.0f)
+  {
+    return hit;
+  }
+
+  // Nearer children are visited first, and subtrees entered behind the closest hit so far are skipped.
+  std::vector<std::pair<gims::ui32, gims::f32>> stack = {{0, 0.0f}};
+  while (!stack.empty())
+  {
+    const auto [nodeIdx, entry] = stack.back();
+    stack.pop_back();
+    const Node& node = m_nodes[nodeIdx];
+    if (entry >= hit.distance)
+    {
+      continue;
+    }
+    if (node.firstChild == 0)
+    {
+      for (gims::ui32 i = node.firstInstance; i < node.firstInstance + node.nInstances; i++)
+      {
+        const gims::f32 distance = intersect(m_aabbs[m_meshInstances[i]], origin, direction, maxDistance);
+        if (distance >= 0.0f && distance < hit.distance)
+        {
+          hit.meshInstance = m_meshInstances[i];
+          hit.distance     = distance;
+        }
+      }
+      continue;
+    }
+    gims::ui32 nearChild = node.firstChild;
+    gims::ui32 farChild  = node.firstChild + 1;
+    gims::f32  nearEntry = intersect(m_nodes[nearChild].aabb, origin, direction, maxDistance);
+    gims::f32  farEntry  = intersect(m_nodes[farChild].aabb, origin, direction, maxDistance);
+    if (farEntry >= 0.0f && (nearEntry < 0.0f || farEntry < nearEntry))
+    {
+      std::swap(nearChild, farChild);
+      std::swap(nearEntry, farEntry);
+    }
+    if (farEntry >= 0.0f)
+    {
+      stack.push_back({farChild, farEntry});
+    }
+    if (nearEntry >= 0.0f)
+    {
+      stack.push_back({nearChild, nearEntry});
+    }
+  }
+  return hit;
+}
+
+void InstanceBVH::queryAABB(const AABB& aabb, std::vector<gims::ui32>& meshInstances) const
+{
+  meshInstances.clear();
+  if (m_nodes.empty() || !aabb.isValid())
+  {
+    return;
+  }
+  std::vector<gims::ui32> stack = {0};
+  while (!stack.empty())
+  {
+    const Node& node = m_nodes[stack.back()];
+    stack.pop_back();
+    if (!overlap(node.aabb, aabb))
+    {
+      continue;
+    }
+    if (node.firstChild == 0)
+    {
+      for (gims::ui32 i = node.firstInstance; i < node.firstInstance + node.nInstances; i++)
+      {
+        if (overlap(m_aabbs[m_meshInstances[i]], aabb))
+        {
+          meshInstances.push_back(m_meshInstances[i]);
+        }
+      }
+      continue;
+    }
+    stack.push_back(node.firstChild);
+    stack.push_back(node.firstChild + 1);
+  }
+}
+
+void InstanceBVH::buildNode(std::vector<Node>& nodes, gims::ui32 nodeIdx, gims::ui32 begin, gims::ui32 end,
+                            gims::ui32 maxTaskInstances, std::vector<Subtree>* subtrees)
+{
+  AABB aabb;
+  for (gims::ui32 i = begin; i < end; i++)
+  {
+    aabb = aabb.getUnion(m_aabbs[m_meshInstances[i]]);
+  }
+  nodes[nodeIdx].aabb          = aabb;
+  nodes[nodeIdx].firstChild    = 0;
+  nodes[nodeIdx].firstInstance = begin;
+  nodes[nodeIdx].nInstances    = end - begin;
+  if (subtrees != nullptr && end - begin <= maxTaskInstances)
+  {
+    subtrees->push_back({nodeIdx, begin, end});
+    return;
+  }
+
+  const gims::ui32 middle = split(begin, end);
+  if (middle == begin)
+  {
+    return;
+  }
+  // Adding the children may reallocate nodes, so the node is accessed by index.
+  const gims::ui32 firstChild = static_cast<gims::ui32>(nodes.size());
+  nodes.resize(nodes.size() + 2);
+  nodes[nodeIdx].firstChild = firstChild;
+  buildNode(nodes, firstChild, begin, middle, maxTaskInstances, subtrees);
+  buildNode(nodes, firstChild + 1, middle, end, maxTaskInstances, subtrees);
+}
+
+gims::ui32 InstanceBVH::split(gims::ui32 begin, gims::ui32 end)
+{
+  if (end - begin <= MAX_INSTANCES_PER_LEAF)
+  {
+    return begin;
+  }
+
+  const auto getCentroid = [this](gims::ui32 meshInstance)
+  {
+    const AABB& aabb = m_aabbs[meshInstance];
+    return (aabb.getLowerLeftBottom() + aabb.getUpperRightTop()) * 0.5f;
+  };
+  gims::f32v3 lower = getCentroid(m_meshInstances[begin]);
+  gims::f32v3 upper = lower;
+  for (gims::ui32 i = begin + 1; i < end; i++)
+  {
+    lower = glm::min(lower, getCentroid(m_meshInstances[i]));
+    upper = glm::max(upper, getCentroid(m_meshInstances[i]));
+  }
+  const auto getBin = [&](gims::ui32 meshInstance, int axis)
+  {
+    const gims::f32 scale    = gims::f32(NUMBER_OF_BINS) / (upper[axis] - lower[axis]);
+    const gims::f32 position = (getCentroid(meshInstance)[axis] - lower[axis]) * scale;
+    return std::min(static_cast<gims::ui32>(std::max(position, 0.0f)), NUMBER_OF_BINS - 1);
+  };
+
+  // For each axis, the cost of each split between two bins is the sum of the half areas of both children, times their
+  // number of mesh instances.
+  gims::f32  bestCost = std::numeric_limits<gims::f32>::max();
+  int        bestAxis = -1;
+  gims::ui32 bestBin  = 0;
+  for (int axis = 0; axis < 3; axis++)
+  {
+    if (!(upper[axis] > lower[axis]))
+    {
+      continue;
+    }
+    AABB       binAABBs[NUMBER_OF_BINS];
+    gims::ui32 binCounts[NUMBER_OF_BINS] = {};
+    for (gims::ui32 i = begin; i < end; i++)
+    {
+      const gims::ui32 bin = getBin(m_meshInstances[i], axis);
+      binAABBs[bin]        = binAABBs[bin].getUnion(m_aabbs[m_meshInstances[i]]);
+      binCounts[bin]++;
+    }
+
+    // rightCosts[b] is the cost of the bins after b.
+    gims::f32  rightCosts[NUMBER_OF_BINS] = {};
+    AABB       right;
+    gims::ui32 rightCount = 0;
+    for (gims::ui32 b = NUMBER_OF_BINS - 1; b > 0; b--)
+    {
+      right = right.getUnion(binAABBs[b]);
+      rightCount += binCounts[b];
+      rightCosts[b - 1] = getHalfArea(right) * gims::f32(rightCount);
+    }
+    AABB       left;
+    gims::ui32 leftCount = 0;
+    for (gims::ui32 b = 0; b + 1 < NUMBER_OF_BINS; b++)
+    {
+      left = left.getUnion(binAABBs[b]);
+      leftCount += binCounts[b];
+      const gims::f32 cost = getHalfArea(left) * gims::f32(leftCount) + rightCosts[b];
+      if (leftCount > 0 && leftCount < end - begin && cost < bestCost)
+      {
+        bestCost = cost;
+        bestAxis = axis;
+        bestBin  = b;
+      }
+    }
+  }
+
+  // All centroids are equal, so any split is as good as any other.
+  if (bestAxis < 0)
+  {
+    return begin + (end - begin) / 2;
+  }
+  const auto isLeft = [&](gims::ui32 meshInstance) { return getBin(meshInstance, bestAxis) <= bestBin; };
+  const auto middle = std::partition(m_meshInstances.begin() + begin, m_meshInstances.begin() + end, isLeft);
+  return static_cast<gims::ui32>(middle - m_meshInstances.begin());
+}
@@ -0,0 +1,425 @@
+// NodeHierarchy.cpp
+
+#include "NodeHierarchy.hpp"
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define NODE_HIERARCHY_SSE2
+#include <emmintrin.h>
+#endif
+
+/// <summary>
+/// Returns a * b. Each column of the result is a linear combination of the columns of a, computed with SSE2, if
+/// available.
+/// </summary>
+gims::f32m4 static multiply(const gims::f32m4& a, const gims::f32m4& b)
+{
+#ifdef NODE_HIERARCHY_SSE2
+  const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+  const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+  const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+  const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+  gims::f32m4  result;
+  for (int column = 0; column < 4; column++)
+  {
+    const __m128 x = _mm_mul_ps(a0, _mm_set1_ps(b[column][0]));
+    const __m128 y = _mm_mul_ps(a1, _mm_set1_ps(b[column][1]));
+    const __m128 z = _mm_mul_ps(a2, _mm_set1_ps(b[column][2]));
+    const __m128 w = _mm_mul_ps(a3, _mm_set1_ps(b[column][3]));
+    _mm_storeu_ps(&result[column][0], _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w)));
+  }
+  return result;
+#else
+  return a * b;
+#endif
+}
+
+/// <summary>
+/// Returns aabb.getTransformed(transformation), computed with SSE2, if available.
+/// </summary>
+AABB static transform(const AABB& aabb, const gims::f32m4& transformation)
+{
+#ifdef NODE_HIERARCHY_SSE2
+  if (!aabb.isValid())
+  {
+    return AABB();
+  }
+
+  // Like AABB::getTransformed, from the center and the half extent of the box.
+  const gims::f32v3 center        = (aabb.getLowerLeftBottom() + aabb.getUpperRightTop()) * 0.5f;
+  const gims::f32v3 halfExtent    = (aabb.getUpperRightTop() - aabb.getLowerLeftBottom()) * 0.5f;
+  const __m128      signMask      = _mm_set1_ps(-0.0f);
+  __m128            newCenter     = _mm_loadu_ps(&transformation[3][0]);
+  __m128            newHalfExtent = _mm_setzero_ps();
+  for (int column = 0; column < 3; column++)
+  {
+    const __m128 axis    = _mm_loadu_ps(&transformation[column][0]);
+    const __m128 absAxis = _mm_andnot_ps(signMask, axis);
+    newCenter            = _mm_add_ps(newCenter, _mm_mul_ps(axis, _mm_set1_ps(center[column])));
+    newHalfExtent        = _mm_add_ps(newHalfExtent, _mm_mul_ps(absAxis, _mm_set1_ps(halfExtent[column])));
+  }
+  gims::f32 lower[4];
+  gims::f32 upper[4];
+  _mm_storeu_ps(lower, _mm_sub_ps(newCenter, newHalfExtent));
+  _mm_storeu_ps(upper, _mm_add_ps(newCenter, newHalfExtent));
+  return AABB(gims::f32v3(lower[0], lower[1], lower[2]), gims::f32v3(upper[0], upper[1], upper[2]));
+#else
+  return aabb.getTransformed(transformation);
+#endif
+}
+/// <summary>
+/// Returns true, if the bounding box is completely behind one of the planes. The distance is summed in the same order
+/// as in NodeHierarchy::cullMeshInstances with SSE2, so both give the same result.
+/// </summary>
+bool static isOutside(const AABB& aabb, std::span<const gims::f32v4> planes)
+{
+  for (const gims::f32v4& plane : planes)
+  {
+    // The corner furthest along the normal. An invalid bounding box has no such corner in front of any plane.
+    gims::f32 distance = plane.w;
+    for (int c = 0; c < 3; c++)
+    {
+      const gims::f32 corner = plane[c] >= 0.0f ? aabb.getUpperRightTop()[c] : aabb.getLowerLeftBottom()[c];
+      distance += plane[c] * corner;
+    }
+    if (distance < 0.0f)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+gims::ui32 NodeHierarchy::addNode(gims::ui32 parentIdx, const gims::f32m4& localTransformation,
+                                  std::span<const gims::ui32> meshIndices, std::span<const AABB> meshAABBs)
+{
+  const gims::ui32 nodeIdx = getNumberOfNodes();
+  if (parentIdx != NO_PARENT && parentIdx >= nodeIdx)
+  {
+    throw std::out_of_range("The parent of a node has to be added before the node.");
+  }
+  if (parentIdx != NO_PARENT && m_subtreeEnds[parentIdx] != nodeIdx)
+  {
+    throw std::invalid_argument("Nodes have to be added in depth-first order. The subtree of the parent is complete.");
+  }
+  if (meshIndices.size() != meshAABBs.size())
+  {
+    throw std::invalid_argument("Each mesh of a node needs a bounding box.");
+  }
+  if (m_meshOffsets.empty())
+  {
+    m_meshOffsets.push_back(0);
+  }
+  m_parents.push_back(parentIdx);
+  m_subtreeEnds.push_back(nodeIdx + 1);
+  m_localTransformations.push_back(localTransformation);
+  m_worldTransformations.push_back(localTransformation);
+  m_subtreeAABBs.push_back(AABB());
+  m_dirty.push_back(false);
+  m_meshIndices.insert(m_meshIndices.end(), meshIndices.begin(), meshIndices.end());
+  m_meshAABBs.insert(m_meshAABBs.end(), meshAABBs.begin(), meshAABBs.end());
+  m_meshWorldAABBs.resize(m_meshAABBs.size());
+  m_meshOffsets.push_back(static_cast<gims::ui32>(m_meshIndices.size()));
+  updateNode(nodeIdx);
+  updateSubtreeAABB(nodeIdx);
+
+  // The new node is the last descendant of all its ancestors so far.
+  for (gims::ui32 ancestorIdx = parentIdx; ancestorIdx != NO_PARENT; ancestorIdx = m_parents[ancestorIdx])
+  {
+    m_subtreeEnds[ancestorIdx]  = nodeIdx + 1;
+    m_subtreeAABBs[ancestorIdx] = m_subtreeAABBs[ancestorIdx].getUnion(m_subtreeAABBs[nodeIdx]);
+  }
+  return nodeIdx;
+}
+
+gims::ui32 NodeHierarchy::getNumberOfNodes() const
+{
+  return static_cast<gims::ui32>(m_parents.size());
+}
+
+gims::ui32 NodeHierarchy::getParent(gims::ui32 nodeIdx) const
+{
+  return m_parents[nodeIdx];
+}
+
+gims::ui32 NodeHierarchy::getSubtreeEnd(gims::ui32 nodeIdx) const
+{
+  return m_subtreeEnds[nodeIdx];
+}
+
+const gims::f32m4& NodeHierarchy::getLocalTransformation(gims::ui32 nodeIdx) const
+{
+  return m_localTransformations[nodeIdx];
+}
+
+void NodeHierarchy::setLocalTransformation(gims::ui32 nodeIdx, const gims::f32m4& localTransformation)
+{
+  m_localTransformations.at(nodeIdx) = localTransformation;
+  if (!m_dirty[nodeIdx])
+  {
+    m_dirty[nodeIdx] = true;
+    m_dirtyNodes.push_back(nodeIdx);
+  }
+}
+
+bool NodeHierarchy::isDirty(gims::ui32 nodeIdx) const
+{
+  return m_dirty[nodeIdx];
+}
+
+const gims::f32m4& NodeHierarchy::getWorldTransformation(gims::ui32 nodeIdx) const
+{
+  return m_worldTransformations[nodeIdx];
+}
+
+gims::ui32 NodeHierarchy::getNumberOfMeshInstances() const
+{
+  return static_cast<gims::ui32>(m_meshIndices.size());
+}
+
+gims::ui32 NodeHierarchy::getFirstMeshInstance(gims::ui32 nodeIdx) const
+{
+  return m_meshOffsets[nodeIdx];
+}
+
+std::span<const gims::ui32> NodeHierarchy::getMeshIndices(gims::ui32 nodeIdx) const
+{
+  return std::span<const gims::ui32>(m_meshIndices).subspan(m_meshOffsets[nodeIdx],
+                                                            m_meshOffsets[nodeIdx + 1] - m_meshOffsets[nodeIdx]);
+}
+
+std::span<const AABB> NodeHierarchy::getMeshWorldAABBs(gims::ui32 nodeIdx) const
+{
+  return std::span<const AABB>(m_meshWorldAABBs).subspan(m_meshOffsets[nodeIdx],
+                                                         m_meshOffsets[nodeIdx + 1] - m_meshOffsets[nodeIdx]);
+}
+
+std::span<const AABB> NodeHierarchy::getMeshInstanceWorldAABBs() const
+{
+  return m_meshWorldAABBs;
+}
+
+const AABB& NodeHierarchy::getSubtreeAABB(gims::ui32 nodeIdx) const
+{
+  return m_subtreeAABBs[nodeIdx];
+}
+
+AABB NodeHierarchy::getAABB() const
+{
+  // The roots follow each other after the subtree of the previous root.
+  AABB aabb;
+  for (gims::ui32 rootIdx = 0; rootIdx < getNumberOfNodes(); rootIdx = m_subtreeEnds[rootIdx])
+  {
+    aabb = aabb.getUnion(m_subtreeAABBs[rootIdx]);
+  }
+  return aabb;
+}
+
+gims::ui32 NodeHierarchy::cullMeshInstances(std::span<const gims::f32v4> planes, std::vector<gims::ui8>& visible) const
+{
+  const gims::ui32 nInstances = getNumberOfMeshInstances();
+  visible.resize(nInstances);
+  gims::ui32 instanceIdx = 0;
+#ifdef NODE_HIERARCHY_SSE2
+  // One bounding box per lane. Like in isOutside, the corner furthest along the normal is tested against each plane.
+  for (; instanceIdx + 4 <= nInstances; instanceIdx += 4)
+  {
+    const AABB* const aabbs = m_meshWorldAABBs.data() + instanceIdx;
+    __m128            lower[3];
+    __m128            upper[3];
+    for (int c = 0; c < 3; c++)
+    {
+      lower[c] = _mm_setr_ps(aabbs[0].getLowerLeftBottom()[c], aabbs[1].getLowerLeftBottom()[c],
+                             aabbs[2].getLowerLeftBottom()[c], aabbs[3].getLowerLeftBottom()[c]);
+      upper[c] = _mm_setr_ps(aabbs[0].getUpperRightTop()[c], aabbs[1].getUpperRightTop()[c],
+                             aabbs[2].getUpperRightTop()[c], aabbs[3].getUpperRightTop()[c]);
+    }
+    __m128 outside = _mm_setzero_ps();
+    for (const gims::f32v4& plane : planes)
+    {
+      __m128 distance = _mm_set1_ps(plane.w);
+      for (int c = 0; c < 3; c++)
+      {
+        const __m128 corner = plane[c] >= 0.0f ? upper[c] : lower[c];
+        distance            = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane[c]), corner));
+      }
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+    }
+    const int outsideMask = _mm_movemask_ps(outside);
+    for (int lane = 0; lane < 4; lane++)
+    {
+      visible[instanceIdx + lane] = static_cast<gims::ui8>(((outsideMask >> lane) & 1) ^ 1);
+    }
+  }
+#endif
+  for (; instanceIdx < nInstances; instanceIdx++)
+  {
+    visible[instanceIdx] = isOutside(m_meshWorldAABBs[instanceIdx], planes) ? 0 : 1;
+  }
+
+  gims::ui32 nVisible = 0;
+  for (const gims::ui8 v : visible)
+  {
+    nVisible += v;
+  }
+  return nVisible;
+}
+
+gims::ui32 NodeHierarchy::updateWorldTransformations(gims::ThreadPool* threadPool)
+{
+  if (m_dirtyNodes.empty())
+  {
+    return 0;
+  }
+
+  // In storage order, the subtree of a dirty node is reached before any dirty node inside it, which is skipped.
+  std::sort(m_dirtyNodes.begin(), m_dirtyNodes.end());
+  std::vector<gims::ui32> dirtySubtrees;
+  gims::ui32              nUpdatedNodes = 0;
+  gims::ui32              updatedEnd    = 0;
+  for (const gims::ui32 dirtyIdx : m_dirtyNodes)
+  {
+    m_dirty[dirtyIdx] = false;
+    if (dirtyIdx >= updatedEnd)
+    {
+      updatedEnd = m_subtreeEnds[dirtyIdx];
+      nUpdatedNodes += updatedEnd - dirtyIdx;
+      dirtySubtrees.push_back(dirtyIdx);
+    }
+  }
+  m_dirtyNodes.clear();
+
+  // Each task updates subtrees of at most maxTaskSize nodes. More tasks than threads let idle workers steal the tasks
+  // of busy ones.
+  gims::ui32 maxTaskSize = nUpdatedNodes;
+  if (threadPool != nullptr && threadPool->getNumThreads() > 1)
+  {
+    maxTaskSize = std::max(MIN_NODES_PER_TASK, nUpdatedNodes / (4 * threadPool->getNumThreads()));
+  }
+
+  // Nodes with larger subtrees are updated on the calling thread, top down, which leaves disjoint subtrees for the
+  // tasks. Their bounding boxes, and those of the ancestors of the dirty subtrees, are updated after the tasks.
+  std::vector<gims::ui32> taskSubtrees;
+  std::vector<gims::ui32> sequentialNodes;
+  for (const gims::ui32 dirtyIdx : dirtySubtrees)
+  {
+    for (gims::ui32 nodeIdx = dirtyIdx; nodeIdx < m_subtreeEnds[dirtyIdx];)
+    {
+      if (m_subtreeEnds[nodeIdx] - nodeIdx <= maxTaskSize)
+      {
+        taskSubtrees.push_back(nodeIdx);
+        nodeIdx = m_subtreeEnds[nodeIdx];
+      }
+      else
+      {
+        updateNode(nodeIdx);
+        sequentialNodes.push_back(nodeIdx);
+        nodeIdx++;
+      }
+    }
+    for (gims::ui32 ancestorIdx = m_parents[dirtyIdx]; ancestorIdx != NO_PARENT; ancestorIdx = m_parents[ancestorIdx])
+    {
+      sequentialNodes.push_back(ancestorIdx);
+    }
+  }
+
+  // Consecutive small subtrees are joined to tasks of about maxTaskSize nodes.
+  std::vector<size_t> taskBegins;
+  gims::ui32          taskSize = maxTaskSize;
+  for (size_t i = 0; i < taskSubtrees.size(); i++)
+  {
+    if (taskSize >= maxTaskSize)
+    {
+      taskBegins.push_back(i);
+      taskSize = 0;
+    }
+    taskSize += m_subtreeEnds[taskSubtrees[i]] - taskSubtrees[i];
+  }
+  taskBegins.push_back(taskSubtrees.size());
+  const auto updateTask = [this, &taskSubtrees, &taskBegins](size_t taskIdx)
+  {
+    for (size_t i = taskBegins[taskIdx]; i < taskBegins[taskIdx + 1]; i++)
+    {
+      updateSubtree(taskSubtrees[i]);
+    }
+  };
+  const size_t nTasks = taskBegins.size() - 1;
+  if (maxTaskSize == nUpdatedNodes || nTasks <= 1)
+  {
+    for (size_t taskIdx = 0; taskIdx < nTasks; taskIdx++)
+    {
+      updateTask(taskIdx);
+    }
+  }
+  else
+  {
+    std::vector<std::future<void>> futures;
+    for (size_t taskIdx = 0; taskIdx < nTasks; taskIdx++)
+    {
+      futures.push_back(threadPool->submit([&updateTask, taskIdx] { updateTask(taskIdx); }));
+    }
+    for (auto& f : futures)
+    {
+      f.get();
+    }
+  }
+
+  // The bounding box of a subtree may shrink, so the remaining nodes are recomputed from their children, descendants
+  // first.
+  std::sort(sequentialNodes.begin(), sequentialNodes.end(), std::greater<gims::ui32>());
+  sequentialNodes.erase(std::unique(sequentialNodes.begin(), sequentialNodes.end()), sequentialNodes.end());
+  for (const gims::ui32 nodeIdx : sequentialNodes)
+  {
+    updateSubtreeAABB(nodeIdx);
+  }
+  return nUpdatedNodes;
+}
+
+void NodeHierarchy::updateNode(gims::ui32 nodeIdx)
+{
+  const gims::ui32 parentIdx = m_parents[nodeIdx];
+  if (parentIdx == NO_PARENT)
+  {
+    m_worldTransformations[nodeIdx] = m_localTransformations[nodeIdx];
+  }
+  else
+  {
+    m_worldTransformations[nodeIdx] = multiply(m_worldTransformations[parentIdx], m_localTransformations[nodeIdx]);
+  }
+  for (gims::ui32 i = m_meshOffsets[nodeIdx]; i < m_meshOffsets[nodeIdx + 1]; i++)
+  {
+    m_meshWorldAABBs[i] = transform(m_meshAABBs[i], m_worldTransformations[nodeIdx]);
+  }
+}
+
+void NodeHierarchy::updateSubtreeAABB(gims::ui32 nodeIdx)
+{
+  AABB aabb;
+  for (const AABB& meshAABB : getMeshWorldAABBs(nodeIdx))
+  {
+    aabb = aabb.getUnion(meshAABB);
+  }
+  // The first child directly follows the node, and each further child follows the subtree of its predecessor.
+  for (gims::ui32 childIdx = nodeIdx + 1; childIdx < m_subtreeEnds[nodeIdx]; childIdx = m_subtreeEnds[childIdx])
+  {
+    aabb = aabb.getUnion(m_subtreeAABBs[childIdx]);
+  }
+  m_subtreeAABBs[nodeIdx] = aabb;
+}
+
+void NodeHierarchy::updateSubtree(gims::ui32 nodeIdx)
+{
+  // The parent precedes the node, so its world transformation is already up to date.
+  const gims::ui32 subtreeEnd = m_subtreeEnds[nodeIdx];
+  for (gims::ui32 i = nodeIdx; i < subtreeEnd; i++)
+  {
+    updateNode(i);
+  }
+  // Children follow their parent, so in reverse order all subtrees of the children are complete.
+  for (gims::ui32 i = subtreeEnd; i-- > nodeIdx;)
+  {
+    updateSubtreeAABB(i);
+  }
+}
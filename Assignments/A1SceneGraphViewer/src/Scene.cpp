@@ -5,68 +5,134 @@
 #include "PerMeshConstantBufferStruct.h"
 #include "BoundingBox.h"
 #include <d3dx12/d3dx12.h>
+#include <gimslib/mesh/Meshlets.hpp>
 #include <unordered_map>
 
-void static addToCommandListImpl(Scene& scene, gims::ui32 nodeIdx, gims::f32m4 transformation,
-                                 const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList,
-                                 gims::ui32 modelViewRootParameterIdx, gims::ui32 materialConstantsRootParameterIdx,
-                                 gims::ui32 srvRootParameterIdx, bool drawBoundingBox)
+DrawStatistics static addToCommandListImpl(Scene& scene, gims::f32m4 transformation,
+                                           const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList,
+                                           gims::ui32 modelViewRootParameterIdx,
+                                           gims::ui32 materialConstantsRootParameterIdx, gims::ui32 srvRootParameterIdx,
+                                           bool drawBoundingBox, const DrawSettings* drawSettings,
+                                           ID3D12PipelineState* pipelineState,
+                                           ID3D12PipelineState* normalMappedPipelineState)
 {
+  DrawStatistics statistics;
 
-  if (nodeIdx >= scene.getNumberOfNodes())
+  scene.updateWorldTransformations();
+  const NodeHierarchy& hierarchy = scene.getNodeHierarchy();
+
+  // All mesh instances are culled before any command is recorded. The frustum planes are extracted in the coordinate
+  // system of the scene, in which the world bounding boxes are stored. The linear SSE2 test of all bounding boxes is
+  // faster per frame than the bounding volume hierarchy, which is kept for ray and box queries.
+  const gims::ui32       nMeshInstances = hierarchy.getNumberOfMeshInstances();
+  std::vector<gims::ui8> visible;
+  if (!drawBoundingBox && drawSettings != nullptr && drawSettings->cullMeshInstances)
   {
-    return;
+    const gims::Meshlets::CullingView view =
+        gims::Meshlets::createCullingView(transformation, drawSettings->projectionMatrix, false);
+    statistics.numberOfDrawnMeshInstances = hierarchy.cullMeshInstances(view.planes, visible);
   }
-
-  Node        currentNode               = scene.getNode(nodeIdx);
-  gims::f32m4 accumulatedTransformation = transformation * currentNode.transformation;
-
-  for (gims::ui32 i = 0; i < currentNode.meshIndices.size(); i++)
+  else
   {
-    Material currMaterial = scene.getMaterial(scene.getMesh(currentNode.meshIndices[i]).getMaterialIndex());
-
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> materialSrvDescriptorHeap = currMaterial.srvDescriptorHeap;
-
-    commandList->SetGraphicsRoot32BitConstants(modelViewRootParameterIdx, 16, &accumulatedTransformation, 0);
-
-    commandList->SetGraphicsRootConstantBufferView(
-        materialConstantsRootParameterIdx, currMaterial.materialConstantBuffer.getResource()->GetGPUVirtualAddress());
-
-    commandList->SetDescriptorHeaps(1, materialSrvDescriptorHeap.GetAddressOf());
+    visible.assign(nMeshInstances, 1);
+    statistics.numberOfDrawnMeshInstances = nMeshInstances;
+  }
+  statistics.numberOfCulledMeshInstances = nMeshInstances - statistics.numberOfDrawnMeshInstances;
 
-    commandList->SetGraphicsRootDescriptorTable(srvRootParameterIdx,
-                                                materialSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+  // Nodes are stored in depth-first order, so walking the arrays draws in the same order as a recursive traversal.
+  for (gims::ui32 nodeIdx = 0; nodeIdx < hierarchy.getNumberOfNodes(); nodeIdx++)
+  {
+    const gims::f32m4 accumulatedTransformation = transformation * hierarchy.getWorldTransformation(nodeIdx);
 
-    if (!drawBoundingBox)
+    // The mesh instances of a node are consecutive.
+    const std::span<const gims::ui32> meshIndices = hierarchy.getMeshIndices(nodeIdx);
+    const gims::ui8* const            meshVisible = visible.data() + hierarchy.getFirstMeshInstance(nodeIdx);
+    for (size_t i = 0; i < meshIndices.size(); i++)
     {
-        scene.getMesh(currentNode.meshIndices[i]).addToCommandList(commandList);
-    }
-    else
-    {
-        scene.getMeshBB(currentNode.meshIndices[i]).addToCommandList(commandList);
+      if (!meshVisible[i])
+      {
+        continue;
+      }
+      const gims::ui32 meshIdx      = meshIndices[i];
+      const Material&  currMaterial = scene.getMaterial(scene.getMesh(meshIdx).getMaterialIndex());
+
+      Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> materialSrvDescriptorHeap = currMaterial.srvDescriptorHeap;
+
+      // The vertex shader needs the vertex format of the mesh to decode quantized vertices.
+      const TriangleMeshD3D12& currMesh = scene.getMesh(meshIdx);
+      PerMeshConstantBuffer    perMeshConstants;
+      perMeshConstants.modelViewMatrix = accumulatedTransformation;
+      perMeshConstants.positionOffset  = currMesh.getPositionDequantization().offset;
+      perMeshConstants.normalFormat    = currMesh.getVertexFormat().normal;
+      perMeshConstants.positionScale   = currMesh.getPositionDequantization().scale;
+      perMeshConstants.pad             = 0;
+      const gims::ui32 nPerMeshConstants = static_cast<gims::ui32>(sizeof(PerMeshConstantBuffer) / sizeof(gims::ui32));
+      commandList->SetGraphicsRoot32BitConstants(modelViewRootParameterIdx, nPerMeshConstants, &perMeshConstants, 0);
+
+      commandList->SetGraphicsRootConstantBufferView(
+          materialConstantsRootParameterIdx, currMaterial.materialConstantBuffer.getResource()->GetGPUVirtualAddress());
+
+      commandList->SetDescriptorHeaps(1, materialSrvDescriptorHeap.GetAddressOf());
+
+      commandList->SetGraphicsRootDescriptorTable(srvRootParameterIdx,
+                                                  materialSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+
+      if (!drawBoundingBox && pipelineState != nullptr && normalMappedPipelineState != nullptr)
+      {
+        // Meshes with tangents have a different input layout and apply the normal map.
+        commandList->SetPipelineState(currMesh.hasTangents() ? normalMappedPipelineState : pipelineState);
+      }
+
+      if (!drawBoundingBox && drawSettings != nullptr)
+      {
+        // Culling and level of detail selection work in the coordinate system of the mesh.
+        const DrawStatistics meshStatistics =
+            currMesh.addToCommandList(commandList, accumulatedTransformation, *drawSettings);
+        statistics.numberOfDrawnClusters += meshStatistics.numberOfDrawnClusters;
+        statistics.numberOfDrawnTriangles += meshStatistics.numberOfDrawnTriangles;
+      }
+      else if (!drawBoundingBox)
+      {
+        currMesh.addToCommandList(commandList);
+        statistics.numberOfDrawnClusters += currMesh.getNumberOfClusters();
+        statistics.numberOfDrawnTriangles += currMesh.getNumberOfTriangles();
+      }
+      else
+      {
+        scene.getMeshBB(meshIdx).addToCommandList(commandList);
+      }
     }
   }
+  return statistics;
+}
 
-  for (const gims::ui32& nodeIndex : currentNode.childIndices)
-  {
-    addToCommandListImpl(scene, nodeIndex, accumulatedTransformation, commandList, modelViewRootParameterIdx,
-                         materialConstantsRootParameterIdx, srvRootParameterIdx, drawBoundingBox);
-  }
+const NodeHierarchy& Scene::getNodeHierarchy() const
+{
+  return m_nodeHierarchy;
+}
+
+NodeHierarchy& Scene::getNodeHierarchy()
+{
+  return m_nodeHierarchy;
 }
 
-const Node& Scene::getNode(gims::ui32 nodeIdx) const
+const InstanceBVH& Scene::getInstanceBVH() const
 {
-  return m_nodes[nodeIdx];
+  return m_instanceBVH;
 }
 
-Node& Scene::getNode(gims::ui32 nodeIdx)
+void Scene::updateWorldTransformations()
 {
-  return m_nodes[nodeIdx];
+  if (m_nodeHierarchy.updateWorldTransformations(m_threadPool.get()) > 0)
+  {
+    m_aabb = m_nodeHierarchy.getAABB();
+    m_instanceBVH.refit(m_nodeHierarchy.getMeshInstanceWorldAABBs());
+  }
 }
 
 const gims::ui32 Scene::getNumberOfNodes() const
 {
-  return static_cast<gims::ui32>(m_nodes.size());
+  return m_nodeHierarchy.getNumberOfNodes();
 }
 
 const gims::ui32 Scene::getNumberOfMeshes() const
@@ -94,6 +160,31 @@ const BoundingBox& Scene::getMeshBB(gims::ui32 meshIdx) const
     return m_meshesBB[meshIdx];
 }
 
+const gims::ui32 Scene::getNumberOfClusters() const
+{
+  gims::ui32 nClusters = 0;
+  for (const TriangleMeshD3D12& mesh : m_meshes)
+  {
+    nClusters += mesh.getNumberOfClusters();
+  }
+  return nClusters;
+}
+
+const gims::ui32 Scene::getNumberOfTriangles() const
+{
+  gims::ui32 nTriangles = 0;
+  for (const TriangleMeshD3D12& mesh : m_meshes)
+  {
+    nTriangles += mesh.getNumberOfTriangles();
+  }
+  return nTriangles;
+}
+
+const gims::MeshWelder::WeldReport& Scene::getWeldReport() const
+{
+  return m_weldReport;
+}
+
 const Material& Scene::getMaterial(gims::ui32 materialIdx) const
 {
   return m_materials[materialIdx];
@@ -108,14 +199,26 @@ void Scene::addToCommandList(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandL
                              const gims::f32m4 transformation, gims::ui32 modelViewRootParameterIdx,
                              gims::ui32 materialConstantsRootParameterIdx, gims::ui32 srvRootParameterIdx)
 {
-  addToCommandListImpl(*this, 0, transformation, commandList, modelViewRootParameterIdx,
-                       materialConstantsRootParameterIdx, srvRootParameterIdx, false);
+  addToCommandListImpl(*this, transformation, commandList, modelViewRootParameterIdx,
+                       materialConstantsRootParameterIdx, srvRootParameterIdx, false, nullptr, nullptr, nullptr);
+}
+
+DrawStatistics Scene::addToCommandList(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList,
+                                       const gims::f32m4 transformation, const DrawSettings& drawSettings,
+                                       const Microsoft::WRL::ComPtr<ID3D12PipelineState>& pipelineState,
+                                       const Microsoft::WRL::ComPtr<ID3D12PipelineState>& normalMappedPipelineState,
+                                       gims::ui32 modelViewRootParameterIdx,
+                                       gims::ui32 materialConstantsRootParameterIdx, gims::ui32 srvRootParameterIdx)
+{
+  return addToCommandListImpl(*this, transformation, commandList, modelViewRootParameterIdx,
+                              materialConstantsRootParameterIdx, srvRootParameterIdx, false, &drawSettings,
+                              pipelineState.Get(), normalMappedPipelineState.Get());
 }
 
 void Scene::addToCommandListBB(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList,
                              const gims::f32m4 transformation, gims::ui32 modelViewRootParameterIdx,
                              gims::ui32 materialConstantsRootParameterIdx, gims::ui32 srvRootParameterIdx)
 {
-  addToCommandListImpl(*this, 0, transformation, commandList, modelViewRootParameterIdx,
-                       materialConstantsRootParameterIdx, srvRootParameterIdx, true);
+  addToCommandListImpl(*this, transformation, commandList, modelViewRootParameterIdx,
+                       materialConstantsRootParameterIdx, srvRootParameterIdx, true, nullptr, nullptr, nullptr);
 }
@@ -1,22 +1,35 @@
 // SceneFactory.cpp
 
 #include "SceneFactory.hpp"
+#include <algorithm>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <d3dx12/d3dx12.h>
 #include <gimslib/d3d/UploadHelper.hpp>
 #include <gimslib/dbg/HrException.hpp>
+#include <gimslib/mesh/MeshNormals.hpp>
+#include <gimslib/mesh/MeshSplitter.hpp>
+#include <gimslib/mesh/MeshTangents.hpp>
+#include <gimslib/mesh/MeshWelder.hpp>
 #include <iostream>
 
+/// <summary>
+/// Steps to which vertex attributes are rounded, before equal vertices are joined. The step of the positions is
+/// relative to the largest extent of the mesh.
+/// </summary>
+constexpr gims::f32 POSITION_QUANTIZATION           = 1.0f / 1048576.0f;
+constexpr gims::f32 NORMAL_QUANTIZATION             = 1.0f / 1024.0f;
+constexpr gims::f32 TEXTURE_COORDINATE_QUANTIZATION = 1.0f / 65536.0f;
+
 /// <summary>
 /// Converts the index buffer required for D3D12 renndering from an aiMesh.
 /// </summary>
 /// <param name="mesh">The ai mesh containing an index buffer.</param>
 /// <returns></returns>
-std::vector<gims::ui32v3> static getTriangleIndicesFromAiMesh(aiMesh const* const mesh)
+std::vector<gims::ui32> static getTriangleIndicesFromAiMesh(aiMesh const* const mesh)
 {
-  std::vector<gims::ui32v3> result;
+  std::vector<gims::ui32> result;
 
   if (!mesh || mesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE)
   {
@@ -28,13 +41,47 @@ std::vector<gims::ui32v3> static getTriangleIndicesFromAiMesh(aiMesh const* cons
     const aiFace& face = mesh->mFaces[i];
     if (face.mNumIndices == 3)
     { // Ensure the face is a triangle.
-      result.emplace_back(gims::ui32v3 {face.mIndices[0], face.mIndices[1], face.mIndices[2]});
+      result.insert(result.end(), {face.mIndices[0], face.mIndices[1], face.mIndices[2]});
     }
   }
 
   return result;
 }
 
+/// <summary>
+/// Replaces the normals of a mesh by smooth normals generated from its triangles. Vertices at the same position share
+/// their normal, even if the importer split them, e.g., at texture seams.
+/// </summary>
+/// <param name="vertices">The vertices, whose normals are overwritten.</param>
+/// <param name="indices">Three indices per triangle.</param>
+/// <param name="positions">The positions of the vertices and the step to which they are rounded for comparison.</param>
+void static generateSmoothNormals(std::vector<Vertex>& vertices, const std::vector<gims::ui32>& indices,
+                                  const gims::MeshWelder::VertexStream& positions)
+{
+  const gims::ui32        nVertices = static_cast<gims::ui32>(vertices.size());
+  std::vector<gims::ui32> remap;
+  const gims::ui32        nPositions = gims::MeshWelder::generateVertexRemap(remap, nVertices, {positions});
+
+  // The triangles reference the first vertex at each position, the normals of the others are copied afterwards.
+  std::vector<gims::ui32> firstVertices(nPositions, nVertices);
+  for (gims::ui32 v = 0; v < nVertices; v++)
+  {
+    firstVertices[remap[v]] = std::min(firstVertices[remap[v]], v);
+  }
+  std::vector<gims::ui32> positionIndices(indices.size());
+  for (size_t i = 0; i < indices.size(); i++)
+  {
+    positionIndices[i] = firstVertices[remap[indices[i]]];
+  }
+
+  gims::MeshNormals::generateNormals(&vertices.data()->normal.x, sizeof(Vertex), positionIndices.data(),
+                                     positionIndices.size(), &vertices.data()->position.x, sizeof(Vertex), nVertices);
+  for (gims::ui32 v = 0; v < nVertices; v++)
+  {
+    vertices[v].normal = vertices[firstVertices[remap[v]]].normal;
+  }
+}
+
 void static addTextureToDescriptorHeap(
     const Microsoft::WRL::ComPtr<ID3D12Device>& device, aiTextureType aiTextureTypeValue, gims::i32 offsetInDescriptors,
     aiMaterial const* const inputMaterial, const std::vector<Texture2DD3D12>& m_textures, Material& material,
@@ -150,7 +197,8 @@ gims::i32 static getTexture(aiTextureType textureType, unsigned int textureIndex
 
 Scene SceneGraphFactory::createFromAssImpScene(const std::filesystem::path                       pathToScene,
                                                const Microsoft::WRL::ComPtr<ID3D12Device>&       device,
-                                               const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue)
+                                               const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue,
+                                               const gims::VertexQuantization::VertexFormat&     vertexFormat)
 {
   Scene outputScene;
 
@@ -160,8 +208,8 @@ Scene SceneGraphFactory::createFromAssImpScene(const std::filesystem::path
     throw std::exception((absolutePath.string() + std::string(" does not exist.")).c_str());
   }
 
-  const gims::ui32 arguments = aiPostProcessSteps::aiProcess_Triangulate | aiProcess_GenSmoothNormals |
-                               aiProcess_GenUVCoords | aiProcess_ConvertToLeftHanded | aiProcess_OptimizeMeshes |
+  const gims::ui32 arguments = aiPostProcessSteps::aiProcess_Triangulate | aiProcess_GenUVCoords |
+                               aiProcess_ConvertToLeftHanded | aiProcess_OptimizeMeshes |
                                aiProcess_RemoveRedundantMaterials | aiProcess_ImproveCacheLocality |
                                aiProcess_FindInvalidData | aiProcess_FindDegenerates;
 
@@ -175,21 +223,43 @@ Scene SceneGraphFactory::createFromAssImpScene(const std::filesystem::path
   const std::unordered_map<std::filesystem::path, gims::ui32> textureFileNameToTextureIndex =
       textureFilenameToIndex(inputScene);
 
-  createMeshes(inputScene, device, commandQueue, outputScene);
+  std::vector<std::vector<gims::ui32>> meshIndicesOfAiMeshes;
+  createMeshes(inputScene, device, commandQueue, vertexFormat, outputScene, meshIndicesOfAiMeshes);
   createMeshesBB(device, commandQueue, outputScene);
 
-  createNodes(inputScene, outputScene, inputScene->mRootNode);
+  createNodes(inputScene, outputScene, inputScene->mRootNode, NodeHierarchy::NO_PARENT, meshIndicesOfAiMeshes);
 
-  computeSceneAABB(outputScene, outputScene.m_aabb, 0, glm::identity<gims::f32m4>());
+  outputScene.m_aabb = outputScene.m_nodeHierarchy.getAABB();
+  if (outputScene.getNumberOfNodes() > NodeHierarchy::MIN_NODES_PER_TASK)
+  {
+    // Smaller scenes are always updated by a single task.
+    outputScene.m_threadPool = std::make_unique<gims::ThreadPool>();
+  }
+  outputScene.m_instanceBVH.build(outputScene.m_nodeHierarchy.getMeshInstanceWorldAABBs(),
+                                  outputScene.m_threadPool.get());
   createTextures(textureFileNameToTextureIndex, absolutePath.parent_path(), device, commandQueue, outputScene);
   createMaterials(inputScene, textureFileNameToTextureIndex, device, outputScene);
 
   return outputScene;
 }
 
+gims::VertexQuantization::VertexFormat
+SceneGraphFactory::getNormalMappedVertexFormat(const gims::VertexQuantization::VertexFormat& vertexFormat)
+{
+  gims::VertexQuantization::VertexFormat result = vertexFormat;
+
+  result.tangent = vertexFormat.normal == gims::VertexQuantization::NORMAL_FLOAT3
+                       ? gims::VertexQuantization::TANGENT_FLOAT4
+                       : gims::VertexQuantization::TANGENT_SNORM16;
+  return result;
+}
+
 void SceneGraphFactory::createMeshes(aiScene const* const                              inputScene,
                                      const Microsoft::WRL::ComPtr<ID3D12Device>&       device,
-                                     const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue, Scene& outputScene)
+                                     const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue,
+                                     const gims::VertexQuantization::VertexFormat&     vertexFormat,
+                                     Scene&                                            outputScene,
+                                     std::vector<std::vector<gims::ui32>>&             meshIndicesOfAiMeshes)
 {
   if (!inputScene || !device || !commandQueue)
   {
@@ -197,6 +267,7 @@ void SceneGraphFactory::createMeshes(aiScene const* const
   }
 
   // Iterate through all meshes in the scene
+  meshIndicesOfAiMeshes.assign(inputScene->mNumMeshes, {});
   for (unsigned int meshIdx = 0; meshIdx < inputScene->mNumMeshes; ++meshIdx)
   {
     aiMesh* mesh = inputScene->mMeshes[meshIdx];
@@ -206,45 +277,120 @@ void SceneGraphFactory::createMeshes(aiScene const* const
       continue; // Skip non-triangular meshes
     }
 
-    // Extract vertex data
-    std::vector<gims::f32v3> positions(mesh->mNumVertices);
-    std::vector<gims::f32v3> normals(mesh->mNumVertices);
-    std::vector<gims::f32v3> texCoords(mesh->mNumVertices, gims::f32v3(0.0f)); // Default to 0 if no UVs
+    // Extract vertex data straight into the layout of the vertex buffer
+    std::vector<Vertex> vertices(mesh->mNumVertices);
+    gims::f32v3         lowerLeftBottom(std::numeric_limits<gims::f32>::max());
+    gims::f32v3         upperRightTop(-std::numeric_limits<gims::f32>::max());
 
     for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
     {
-      positions[i] = gims::f32v3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+      vertices[i].position = gims::f32v3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+      lowerLeftBottom      = glm::min(lowerLeftBottom, vertices[i].position);
+      upperRightTop        = glm::max(upperRightTop, vertices[i].position);
 
       if (mesh->HasNormals())
       {
-        normals[i] = gims::f32v3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+        vertices[i].normal = gims::f32v3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
       }
       else
       {
-        normals[i] = gims::f32v3(0.0f, 0.0f, 1.0f);
+        vertices[i].normal = gims::f32v3(0.0f, 0.0f, 1.0f);
       }
 
       if (mesh->HasTextureCoords(0))
       {
-        texCoords[i] = gims::f32v3(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y, 0.0f);
+        vertices[i].texCoord = gims::f32v2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
       }
       else
       {
-        texCoords[i] = gims::f32v3(0.0f, 0.0f, 0.0f);
+        vertices[i].texCoord = gims::f32v2(0.0f, 0.0f);
       }
     }
 
     // Extract index data using the helper function
-    std::vector<gims::ui32v3> indices = getTriangleIndicesFromAiMesh(mesh);
+    std::vector<gims::ui32> indices = getTriangleIndicesFromAiMesh(mesh);
+
+    // Join vertices that are equal after quantization, and drop degenerate and duplicate triangles. Positions are
+    // quantized relative to the size of the mesh.
+    const gims::f32v3 extent       = glm::max(upperRightTop - lowerLeftBottom, gims::f32v3(0.0f));
+    const gims::f32   positionStep = std::max({extent.x, extent.y, extent.z}) * POSITION_QUANTIZATION;
+
+    const std::vector<gims::MeshWelder::VertexStream> streams = {
+        {&vertices.data()->position.x, 3, sizeof(Vertex), positionStep},
+        {&vertices.data()->normal.x, 3, sizeof(Vertex), NORMAL_QUANTIZATION},
+        {&vertices.data()->texCoord.x, 2, sizeof(Vertex), TEXTURE_COORDINATE_QUANTIZATION}};
+
+    // Assimp's smooth normal generation runs on a single thread, so missing normals are generated here instead.
+    if (!mesh->HasNormals())
+    {
+      generateSmoothNormals(vertices, indices, streams[0]);
+    }
+
+    gims::ui32 nVertices = static_cast<gims::ui32>(vertices.size());
+    outputScene.m_weldReport.add(
+        gims::MeshWelder::weldMesh(vertices.data(), nVertices, sizeof(Vertex), indices, streams));
+    vertices.resize(nVertices);
 
     // Determine material index
     gims::ui32 materialIndex = mesh->mMaterialIndex;
 
-    // Create TriangleMeshD3D12 and add it to the scene's mesh list
-    outputScene.m_meshes.emplace_back(positions.data(), normals.data(), texCoords.data(),
-                                      static_cast<gims::ui32>(positions.size()), indices.data(),
-                                      static_cast<gims::ui32>(indices.size() * 3), materialIndex, device, commandQueue);
+    // Only meshes with a normal map get a tangent stream. Vertices on mirrored texture seams are split first, so that
+    // each vertex has a single handedness, as in MikkTSpace.
+    gims::VertexQuantization::VertexFormat meshVertexFormat = vertexFormat;
+    std::vector<gims::f32v4>               tangents;
+    if (mesh->HasTextureCoords(0) && inputScene->mMaterials[materialIndex]->GetTextureCount(aiTextureType_HEIGHT) > 0)
+    {
+      const std::vector<gims::ui32> originals = gims::MeshTangents::splitMirroredVertices(
+          indices.data(), indices.size(), &vertices.data()->position.x, &vertices.data()->normal.x,
+          &vertices.data()->texCoord.x, sizeof(Vertex), nVertices);
+      vertices.reserve(vertices.size() + originals.size());
+      for (const gims::ui32 original : originals)
+      {
+        vertices.push_back(vertices[original]);
+      }
+      nVertices = static_cast<gims::ui32>(vertices.size());
+
+      tangents.resize(nVertices);
+      gims::MeshTangents::generateTangents(&tangents.data()->x, sizeof(gims::f32v4), indices.data(), indices.size(),
+                                           &vertices.data()->position.x, &vertices.data()->normal.x,
+                                           &vertices.data()->texCoord.x, sizeof(Vertex), nVertices);
+      meshVertexFormat = getNormalMappedVertexFormat(vertexFormat);
+    }
+
+    // Create TriangleMeshD3D12 and add it to the scene's mesh list. Meshes with too many vertices for 16 bit indices
+    // are split into sub-meshes, which are drawn as meshes of their own.
+    if (gims::MeshSplitter::fits16BitIndices(nVertices))
+    {
+      meshIndicesOfAiMeshes[meshIdx].push_back(static_cast<gims::ui32>(outputScene.m_meshes.size()));
+      outputScene.m_meshes.emplace_back(vertices.data(), nVertices, indices.data(),
+                                        static_cast<gims::ui32>(indices.size()), materialIndex, meshVertexFormat,
+                                        tangents.empty() ? nullptr : tangents.data(), device, commandQueue);
+      continue;
+    }
+    for (const gims::MeshSplitter::SubMesh& subMesh :
+         gims::MeshSplitter::splitMesh(indices.data(), indices.size(), nVertices))
+    {
+      std::vector<Vertex> subMeshVertices(subMesh.vertexIndices.size());
+      gims::MeshSplitter::gatherVertices(subMeshVertices.data(), vertices.data(), sizeof(Vertex), subMesh);
+      std::vector<gims::f32v4> subMeshTangents(tangents.empty() ? 0 : subMesh.vertexIndices.size());
+      if (!tangents.empty())
+      {
+        gims::MeshSplitter::gatherVertices(subMeshTangents.data(), tangents.data(), sizeof(gims::f32v4), subMesh);
+      }
+
+      meshIndicesOfAiMeshes[meshIdx].push_back(static_cast<gims::ui32>(outputScene.m_meshes.size()));
+      outputScene.m_meshes.emplace_back(subMeshVertices.data(), static_cast<gims::ui32>(subMeshVertices.size()),
+                                        subMesh.indices.data(), static_cast<gims::ui32>(subMesh.indices.size()),
+                                        materialIndex, meshVertexFormat,
+                                        subMeshTangents.empty() ? nullptr : subMeshTangents.data(), device,
+                                        commandQueue);
+    }
   }
+
+  const gims::MeshWelder::WeldReport& report = outputScene.m_weldReport;
+  std::cout << "Welded " << report.nVerticesBefore << " vertices to " << report.nVerticesAfter << ", removed "
+            << report.nDegenerateTriangles << " degenerate and " << report.nDuplicateTriangles
+            << " duplicate triangles of " << report.nTrianglesBefore << "\n";
 }
 
 void SceneGraphFactory::createMeshesBB(const Microsoft::WRL::ComPtr<ID3D12Device>&       device,
@@ -265,81 +411,44 @@ void SceneGraphFactory::createMeshesBB(const Microsoft::WRL::ComPtr<ID3D12Device
 }
 
 gims::ui32 SceneGraphFactory::createNodes(aiScene const* const inputScene, Scene& outputScene,
-                                          aiNode const* const inputNode)
+                                          aiNode const* const                         inputNode, gims::ui32 parentIdx,
+                                          const std::vector<std::vector<gims::ui32>>& meshIndicesOfAiMeshes)
 {
   if (!inputScene || !inputNode)
     throw std::invalid_argument("Input scene or node is null.");
 
-  // Create a new node in the Scene
-  Node newNode;
-
-  // Convert the node's transformation matrix
-  newNode.transformation = convertAssimpMatrixToGims(inputNode->mTransformation);
-
   // Map the node's meshes
+  std::vector<gims::ui32> meshIndices;
+  std::vector<AABB>       meshAABBs;
   for (unsigned int i = 0; i < inputNode->mNumMeshes; ++i)
   {
     const unsigned int meshIndex = inputNode->mMeshes[i];
     if (meshIndex >= inputScene->mNumMeshes)
       throw std::out_of_range("Mesh index out of range in inputNode.");
 
-    // Add the mesh index to the node
-    newNode.meshIndices.push_back(meshIndex);
+    // Add the indices of the meshes created for the aiMesh to the node
+    meshIndices.insert(meshIndices.end(), meshIndicesOfAiMeshes[meshIndex].begin(),
+                       meshIndicesOfAiMeshes[meshIndex].end());
+  }
+  for (const gims::ui32 meshIdx : meshIndices)
+  {
+    meshAABBs.push_back(outputScene.getMesh(meshIdx).getAABB());
   }
 
-  // Add the node to the outputScene's m_nodes array and get its index
-  gims::ui32 currentIndex = static_cast<gims::ui32>(outputScene.m_nodes.size());
-  outputScene.m_nodes.push_back(newNode);
+  // Add the node before its children, so that the nodes are stored in depth-first order
+  const gims::ui32 currentIndex = outputScene.m_nodeHierarchy.addNode(
+      parentIdx, convertAssimpMatrixToGims(inputNode->mTransformation), meshIndices, meshAABBs);
 
   // Process child nodes recursively
   for (unsigned int i = 0; i < inputNode->mNumChildren; ++i)
   {
-    // Recursively create child nodes and get their index
-    gims::ui32 childIndex = createNodes(inputScene, outputScene, inputNode->mChildren[i]);
-
-    // Add the child index to the current node's childIndices
-    outputScene.m_nodes[currentIndex].childIndices.push_back(childIndex);
+    createNodes(inputScene, outputScene, inputNode->mChildren[i], currentIndex, meshIndicesOfAiMeshes);
   }
 
   // Return the index of the newly created node
   return currentIndex;
 }
 
-void SceneGraphFactory::computeSceneAABB(Scene& scene, AABB& aabb, gims::ui32 nodeIdx, gims::f32m4 transformation)
-{
-  // Validierung: Prfen, ob der Knotenindex gltig ist
-  if (nodeIdx >= scene.getNumberOfNodes())
-  {
-    return;
-  }
-
-  // Hole den aktuellen Knoten
-  const Node& currentNode = scene.getNode(nodeIdx);
-
-  // Transformation des aktuellen Knotens anwenden
-  gims::f32m4 nodeTransformation = transformation * currentNode.transformation;
-
-  // Verarbeite alle Meshes des Knotens
-  for (gims::ui32 meshIdx : currentNode.meshIndices)
-  {
-    // Hole die AABB des Meshes
-    const TriangleMeshD3D12& mesh     = scene.getMesh(meshIdx);
-    AABB                     meshAABB = mesh.getAABB();
-
-    // Transformiere die AABB mit der aktuellen Transformation
-    AABB transformedAABB = meshAABB.getTransformed(nodeTransformation);
-
-    // Fge die transformierte AABB zur globalen AABB hinzu
-    aabb = aabb.getUnion(transformedAABB);
-  }
-
-  // Rekursiv alle Kindknoten traversieren
-  for (gims::ui32 childIdx : currentNode.childIndices)
-  {
-    computeSceneAABB(scene, aabb, childIdx, nodeTransformation);
-  }
-}
-
 void SceneGraphFactory::createTextures(
     const std::unordered_map<std::filesystem::path, gims::ui32>& textureFileNameToTextureIndex,
     std::filesystem::path parentPath, const Microsoft::WRL::ComPtr<ID3D12Device>& device,
@@ -15,11 +15,14 @@
 #include <iostream>
 #include <vector>
 
-SceneGraphViewerApp::SceneGraphViewerApp(const DX12AppConfig config, const std::filesystem::path pathToScene)
+SceneGraphViewerApp::SceneGraphViewerApp(const DX12AppConfig config, const std::filesystem::path pathToScene,
+                                         const gims::VertexQuantization::VertexFormat vertexFormat)
     : DX12App(config)
     , m_examinerController(true)
-    , m_scene(SceneGraphFactory::createFromAssImpScene(pathToScene, getDevice(), getCommandQueue()))
+    , m_scene(SceneGraphFactory::createFromAssImpScene(pathToScene, getDevice(), getCommandQueue(), vertexFormat))
     , m_displayBoundingBoxes(false)
+    , m_drawSettings()
+    , m_vertexFormat(vertexFormat)
 {
   m_examinerController.setTranslationVector(gims::f32v3(0, -0.25f, 1.5));
   createRootSignature();
@@ -77,6 +80,15 @@ void SceneGraphViewerApp::onDrawUI()
   ImGui::Text("Number of Meshes in Scene: %i", m_uiData.numberOfMeshes);
   ImGui::Text("Number of Materials loaded: %i", m_uiData.numberOfMaterials);
   ImGui::Text("Number of Textures loaded: %i", m_uiData.numberOfTextures);
+  ImGui::Text("Number of Mesh Instances drawn: %i of %i", m_uiData.numberOfDrawnInstances,
+              m_uiData.numberOfMeshInstances);
+  ImGui::Text("Number of Mesh Instances culled: %i", m_uiData.numberOfCulledInstances);
+  ImGui::Text("Number of Clusters drawn: %i of %i", m_uiData.numberOfDrawnClusters, m_uiData.numberOfClusters);
+  ImGui::Text("Number of Triangles drawn: %i of %i", m_uiData.numberOfDrawnTriangles, m_uiData.numberOfTriangles);
+  ImGui::Text("Number of Vertices after Welding: %i of %i", m_uiData.numberOfWeldedVertices,
+              m_uiData.numberOfImportedVertices);
+  ImGui::Text("Number of Redundant Triangles removed: %i", m_uiData.numberOfRemovedTriangles);
+  ImGui::Text("Vertex Size: %i bytes", m_uiData.numberOfBytesPerVertex);
   ImGui::Text("Scene AABB Lower Left: (%.5f, %.5f, %.5f)", m_uiData.sceneLowerleftAABBPosition.x,
               m_uiData.sceneLowerleftAABBPosition.y, m_uiData.sceneLowerleftAABBPosition.z);
   ImGui::Text("Scene AABB Top Right: (%.5f, %.5f, %.5f)", m_uiData.sceneTopRightAABBPosition.x,
@@ -92,6 +104,17 @@ void SceneGraphViewerApp::onDrawUI()
   // BoundingBoxes
   ImGui::Checkbox("Display Bounding Boxes", &m_displayBoundingBoxes);
 
+  // Mesh Instance Culling. Mesh instances whose bounding box is outside the view frustum are not drawn.
+  ImGui::Checkbox("Cull Mesh Instances", &m_drawSettings.cullMeshInstances);
+
+  // Cluster Culling. Back faces are rendered, so culling back-facing clusters is only correct for closed meshes.
+  ImGui::Checkbox("Cull Clusters", &m_drawSettings.cullClusters);
+  ImGui::Checkbox("Cull Back-Facing Clusters", &m_drawSettings.cullBackFacingClusters);
+
+  // Level of Detail. Meshes are drawn with the coarsest level whose error covers at most the given number of pixels.
+  ImGui::Checkbox("Select Level of Detail", &m_drawSettings.selectLevelOfDetail);
+  ImGui::SliderFloat("Max. Screen-Space Error", &m_drawSettings.maxScreenSpaceError, 0.1f, 16.0f, "%.1f px");
+
   // Number of Lights
   ImGui::SliderInt("Number of Lights", &m_numOfLights, 1, 8);
 
@@ -123,10 +146,11 @@ void SceneGraphViewerApp::createRootSignature()
   // Define root parameters for each of the constant buffers and descriptor table
   CD3DX12_ROOT_PARAMETER rootParameters[4] = {};
 
-  // Initialize as constant buffer views (cbv) for b0, b1, and b2
-  rootParameters[0].InitAsConstantBufferView(0); // PerFrameConstants (b0)
-  rootParameters[1].InitAsConstants(16, 1);      // PerMeshConstants (b1)
-  rootParameters[2].InitAsConstantBufferView(2); // Material (b2)
+  // Initialize as constant buffer views (cbv) for b0 and b2, and as root constants for b1
+  const gims::ui32 nPerMeshConstants = static_cast<gims::ui32>(sizeof(PerMeshConstantBuffer) / sizeof(gims::ui32));
+  rootParameters[0].InitAsConstantBufferView(0);          // PerFrameConstants (b0)
+  rootParameters[1].InitAsConstants(nPerMeshConstants, 1); // PerMeshConstants (b1)
+  rootParameters[2].InitAsConstantBufferView(2);          // Material (b2)
 
   // Descriptor table for the texture SRVs (t0-t4)
   CD3DX12_DESCRIPTOR_RANGE srvRange = {};
@@ -186,7 +210,10 @@ void SceneGraphViewerApp::createRootSignature()
 void SceneGraphViewerApp::createPipeline()
 {
   waitForGPU();
-  const std::vector<D3D12_INPUT_ELEMENT_DESC> inputElementDescs = TriangleMeshD3D12::getInputElementDescriptors();
+  const std::vector<D3D12_INPUT_ELEMENT_DESC> inputElementDescs =
+      TriangleMeshD3D12::getInputElementDescriptors(m_vertexFormat);
+  const std::vector<D3D12_INPUT_ELEMENT_DESC> inputElementDescsNormalMapped =
+      TriangleMeshD3D12::getInputElementDescriptors(SceneGraphFactory::getNormalMappedVertexFormat(m_vertexFormat));
 
   const std::vector<D3D12_INPUT_ELEMENT_DESC> inputElementDescsBB = BoundingBox::getInputElementDescriptors();
 
@@ -194,6 +221,10 @@ void SceneGraphViewerApp::createPipeline()
       compileShader(L"../../../Assignments/A1SceneGraphViewer/Shaders/TriangleMesh.hlsl", L"VS_main", L"vs_6_0");
   const ComPtr<IDxcBlob> pixelShader =
       compileShader(L"../../../Assignments/A1SceneGraphViewer/Shaders/TriangleMesh.hlsl", L"PS_main", L"ps_6_0");
+  const ComPtr<IDxcBlob> vertexShaderNormalMapped = compileShader(
+      L"../../../Assignments/A1SceneGraphViewer/Shaders/TriangleMesh.hlsl", L"VS_mainNormalMapped", L"vs_6_0");
+  const ComPtr<IDxcBlob> pixelShaderNormalMapped = compileShader(
+      L"../../../Assignments/A1SceneGraphViewer/Shaders/TriangleMesh.hlsl", L"PS_mainNormalMapped", L"ps_6_0");
   const ComPtr<IDxcBlob> vertexShaderBB =
       compileShader(L"../../../Assignments/A1SceneGraphViewer/Shaders/BoundingBox.hlsl", L"VS_main", L"vs_6_0");
   const ComPtr<IDxcBlob> pixelShaderBB =
@@ -220,6 +251,12 @@ void SceneGraphViewerApp::createPipeline()
   psoDesc.SampleDesc.Count                   = 1;
   throwIfFailed(getDevice()->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState)));
 
+  // Meshes with a normal map have an additional tangent stream.
+  psoDesc.InputLayout = {inputElementDescsNormalMapped.data(), (ui32)inputElementDescsNormalMapped.size()};
+  psoDesc.VS          = HLSLCompiler::convert(vertexShaderNormalMapped);
+  psoDesc.PS          = HLSLCompiler::convert(pixelShaderNormalMapped);
+  throwIfFailed(getDevice()->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineStateNormalMapped)));
+
   psoDesc.InputLayout                 = {inputElementDescsBB.data(), (ui32)inputElementDescsBB.size()};
   psoDesc.VS                          = HLSLCompiler::convert(vertexShaderBB);
   psoDesc.PS                          = HLSLCompiler::convert(pixelShaderBB);
@@ -246,7 +283,15 @@ void SceneGraphViewerApp::drawScene(const ComPtr<ID3D12GraphicsCommandList>& cmd
 
   gims::f32m4 transform = cameraMatrix * normalizedSceneTransform;
 
-  m_scene.addToCommandList(cmdLst, transform, 1, 2, 3);
+  m_drawSettings.projectionMatrix = getProjectionMatrix();
+  m_drawSettings.viewportHeight   = (gims::f32)getHeight();
+
+  const DrawStatistics statistics = m_scene.addToCommandList(cmdLst, transform, m_drawSettings, m_pipelineState,
+                                                             m_pipelineStateNormalMapped, 1, 2, 3);
+  m_uiData.numberOfDrawnInstances  = statistics.numberOfDrawnMeshInstances;
+  m_uiData.numberOfCulledInstances = statistics.numberOfCulledMeshInstances;
+  m_uiData.numberOfDrawnClusters   = statistics.numberOfDrawnClusters;
+  m_uiData.numberOfDrawnTriangles  = statistics.numberOfDrawnTriangles;
 
   if (m_displayBoundingBoxes)
   {
@@ -273,8 +318,7 @@ void SceneGraphViewerApp::createSceneConstantBuffer()
 void SceneGraphViewerApp::updateSceneConstantBuffer()
 {
   ConstantBuffer cb   = {};
-  cb.projectionMatrix = glm::perspectiveFovLH_ZO<gims::f32>(glm::radians(45.0f), (gims::f32)getWidth(),
-                                                            (gims::f32)getHeight(), 1.0f / 256.0f, 256.0f);
+  cb.projectionMatrix = getProjectionMatrix();
   cb.cameraPosition   = getCameraPosition();
   cb.numOfLights      = m_numOfLights;
   for (gims::ui8 i = 0; i < 8; i++)
@@ -284,6 +328,12 @@ void SceneGraphViewerApp::updateSceneConstantBuffer()
   m_constantBuffers[getFrameIndex()].upload(&cb);
 }
 
+gims::f32m4 SceneGraphViewerApp::getProjectionMatrix()
+{
+  return glm::perspectiveFovLH_ZO<gims::f32>(glm::radians(45.0f), (gims::f32)getWidth(), (gims::f32)getHeight(),
+                                             1.0f / 256.0f, 256.0f);
+}
+
 gims::f32v3 SceneGraphViewerApp::getCameraPosition()
 {
   gims::f32m4 invertedCameraMatrix = glm::inverse(m_examinerController.getTransformationMatrix());
@@ -297,6 +347,16 @@ void SceneGraphViewerApp::updateUiDataStruct()
   m_uiData.numberOfMeshes             = m_scene.getNumberOfMeshes();
   m_uiData.numberOfMaterials          = m_scene.getNumberOfMaterials();
   m_uiData.numberOfTextures           = m_scene.getNumberOfTextures() - 3;
+  m_uiData.numberOfMeshInstances      = m_scene.getNodeHierarchy().getNumberOfMeshInstances();
   m_uiData.sceneLowerleftAABBPosition = m_scene.getAABB().getLowerLeftBottom();
   m_uiData.sceneTopRightAABBPosition  = m_scene.getAABB().getUpperRightTop();
+  m_uiData.numberOfClusters           = m_scene.getNumberOfClusters();
+  m_uiData.numberOfTriangles          = m_scene.getNumberOfTriangles();
+  m_uiData.numberOfBytesPerVertex     = gims::VertexQuantization::getVertexLayout(m_vertexFormat).stride;
+
+  const gims::MeshWelder::WeldReport& weldReport = m_scene.getWeldReport();
+  m_uiData.numberOfWeldedVertices                = static_cast<gims::ui32>(weldReport.nVerticesAfter);
+  m_uiData.numberOfImportedVertices              = static_cast<gims::ui32>(weldReport.nVerticesBefore);
+  m_uiData.numberOfRemovedTriangles =
+      static_cast<gims::ui32>(weldReport.nDegenerateTriangles + weldReport.nDuplicateTriangles);
 }
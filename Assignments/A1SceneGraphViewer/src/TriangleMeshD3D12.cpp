@@ -2,51 +2,88 @@
 
 #include "TriangleMeshD3D12.hpp"
 #include "VertexStruct.h"
+#include <cstddef>
 #include <d3dx12/d3dx12.h>
 #include <gimslib/d3d/UploadHelper.hpp>
+#include <gimslib/d3d/VertexFormatD3D12.hpp>
+#include <gimslib/mesh/MeshSplitter.hpp>
 #include <stdexcept>
 
-const std::vector<D3D12_INPUT_ELEMENT_DESC> TriangleMeshD3D12::m_inputElementDescs = {
-    {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT,
-     D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-    {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT,
-     D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-    {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT,
-     D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}};
-
-TriangleMeshD3D12::TriangleMeshD3D12(gims::f32v3 const* const positions, gims::f32v3 const* const normals,
-                                     gims::f32v3 const* const textureCoordinates, gims::ui32 nVertices,
-                                     gims::ui32v3 const* const indexBuffer, gims::ui32 nIndices,
-                                     gims::ui32 materialIndex, const Microsoft::WRL::ComPtr<ID3D12Device>& device,
+TriangleMeshD3D12::TriangleMeshD3D12(Vertex const* const vertices, gims::ui32 nVertices,
+                                     gims::ui32 const* const indexBuffer, gims::ui32 nIndices,
+                                     gims::ui32                                        materialIndex,
+                                     const gims::VertexQuantization::VertexFormat&     vertexFormat,
+                                     gims::f32v4 const* const                          tangents,
+                                     const Microsoft::WRL::ComPtr<ID3D12Device>&       device,
                                      const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue)
     : m_nIndices(nIndices)
-    , m_vertexBufferSize(static_cast<gims::ui32>(nVertices * sizeof(Vertex)))
+    , m_vertexBufferSize(nVertices * gims::VertexQuantization::getVertexLayout(vertexFormat).stride)
     , m_indexBufferSize(static_cast<gims::ui32>(nIndices * sizeof(gims::ui32)))
-    , m_aabb(positions, nVertices)
+    , m_aabb(&vertices->position, nVertices, sizeof(Vertex))
     , m_materialIndex(materialIndex)
     , m_vertexBuffer()
     , m_vertexBufferView()
     , m_indexBuffer()
     , m_indexBufferView()
+    , m_vertexFormat(vertexFormat)
+    , m_positionDequantization(gims::VertexQuantization::getPositionDequantization(
+          vertexFormat.position, m_aabb.getLowerLeftBottom(), m_aabb.getUpperRightTop()))
 {
-  if (!positions || !normals || !textureCoordinates || !indexBuffer || !device || !commandQueue)
+  if (!vertices || !indexBuffer || !device || !commandQueue || (hasTangents() && !tangents))
   {
     throw std::invalid_argument("Invalid arguments passed to TriangleMeshD3D12 constructor.");
   }
 
-  // Create vertex data
-  std::vector<Vertex> vertexBufferCPU(nVertices);
+  // Clustering and simplification need the positions without the other attributes
+  std::vector<gims::f32v3> positions(nVertices);
   for (gims::ui32 i = 0; i < nVertices; ++i)
   {
-    vertexBufferCPU[i].position = positions[i];
-    vertexBufferCPU[i].normal   = normals[i];
-    vertexBufferCPU[i].texCoord = {textureCoordinates[i].x, textureCoordinates[i].y};
+    positions[i] = vertices[i].position;
   }
 
   // Convert index buffer to a CPU-side array
   std::vector<gims::ui32> indexBufferCPU(nIndices );
   memcpy(indexBufferCPU.data(), indexBuffer, m_indexBufferSize);
 
+  // Reorder the triangles into clusters for culling
+  m_meshlets = gims::Meshlets::buildMeshlets(indexBufferCPU.data(), indexBufferCPU.data(), nIndices,
+                                             reinterpret_cast<const gims::f32*>(positions.data()), nVertices);
+
+  // Simplify the clustered triangles into coarser levels of detail, which are appended to the index buffer. Normals
+  // and texture coordinates are compared, so that seams stay intact. Tangents are compared as well, as vertices on
+  // mirrored texture seams only differ in their tangents.
+  const gims::ui8* const vertexData = reinterpret_cast<const gims::ui8*>(vertices);
+
+  std::vector<gims::MeshSimplifier::VertexAttributes> attributes = {
+      {vertexData + offsetof(Vertex, normal), sizeof(gims::f32v3), sizeof(Vertex)},
+      {vertexData + offsetof(Vertex, texCoord), sizeof(gims::f32v2), sizeof(Vertex)}};
+  if (hasTangents())
+  {
+    attributes.push_back({tangents, sizeof(gims::f32v4), sizeof(gims::f32v4)});
+  }
+
+  std::vector<gims::ui32> lodIndexBufferCPU;
+  m_levelsOfDetail = gims::MeshSimplifier::buildLods(lodIndexBufferCPU, indexBufferCPU.data(), nIndices,
+                                                     reinterpret_cast<const gims::f32*>(positions.data()), nVertices,
+                                                     attributes);
+
+  // Meshes with few enough vertices use 16 bit indices, which halves the size of the index buffer
+  const bool              use16BitIndices = gims::MeshSplitter::fits16BitIndices(nVertices);
+  const size_t            indexSize       = use16BitIndices ? sizeof(gims::ui16) : sizeof(gims::ui32);
+  std::vector<gims::ui16> lodIndexBuffer16BitCPU;
+  if (use16BitIndices)
+  {
+    lodIndexBuffer16BitCPU = gims::MeshSplitter::convertTo16BitIndices(lodIndexBufferCPU);
+  }
+  m_indexBufferSize = static_cast<gims::ui32>(lodIndexBufferCPU.size() * indexSize);
+
+  // Encode the vertices into the format of the vertex buffer
+  std::vector<gims::ui8> vertexBufferCPU(m_vertexBufferSize);
+  gims::VertexQuantization::encodeVertices(vertexBufferCPU.data(), m_vertexFormat, &vertices->position.x,
+                                           &vertices->normal.x, &vertices->texCoord.x, sizeof(Vertex), nVertices,
+                                           m_positionDequantization, hasTangents() ? &tangents->x : nullptr,
+                                           sizeof(gims::f32v4));
+
   // Instantiate UploadHelper
   gims::UploadHelper uploadHelper(device, std::max(m_vertexBufferSize, m_indexBufferSize));
 
@@ -64,7 +101,7 @@ TriangleMeshD3D12::TriangleMeshD3D12(gims::f32v3 const* const positions, gims::f
   // Configure vertex buffer view
   m_vertexBufferView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
   m_vertexBufferView.SizeInBytes    = m_vertexBufferSize;
-  m_vertexBufferView.StrideInBytes  = sizeof(Vertex);
+  m_vertexBufferView.StrideInBytes  = gims::VertexQuantization::getVertexLayout(m_vertexFormat).stride;
 
   uploadHelper.uploadBuffer(vertexBufferCPU.data(), m_vertexBuffer, m_vertexBufferSize, commandQueue);
 
@@ -80,9 +117,11 @@ TriangleMeshD3D12::TriangleMeshD3D12(gims::f32v3 const* const positions, gims::f
   // Configure index buffer view
   m_indexBufferView.BufferLocation = m_indexBuffer->GetGPUVirtualAddress();
   m_indexBufferView.SizeInBytes    = m_indexBufferSize;
-  m_indexBufferView.Format         = DXGI_FORMAT_R32_UINT;
+  m_indexBufferView.Format         = use16BitIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 
-  uploadHelper.uploadBuffer(indexBufferCPU.data(), m_indexBuffer, m_indexBufferSize, commandQueue);
+  const void* const indexData =
+      use16BitIndices ? static_cast<const void*>(lodIndexBuffer16BitCPU.data()) : lodIndexBufferCPU.data();
+  uploadHelper.uploadBuffer(indexData, m_indexBuffer, m_indexBufferSize, commandQueue);
 }
 
 void TriangleMeshD3D12::addToCommandList(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList) const
@@ -101,6 +140,94 @@ void TriangleMeshD3D12::addToCommandList(const Microsoft::WRL::ComPtr<ID3D12Grap
   commandList->DrawIndexedInstanced(m_nIndices, 1, 0, 0, 0);
 }
 
+DrawStatistics TriangleMeshD3D12::addToCommandList(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList,
+                                                   const gims::f32m4& modelView, const DrawSettings& drawSettings) const
+{
+  if (!commandList)
+  {
+    throw std::invalid_argument("Command list is null.");
+  }
+  DrawStatistics statistics;
+  if (m_levelsOfDetail.empty())
+  {
+    return statistics;
+  }
+
+  // Select the coarsest level of detail whose error covers at most maxScreenSpaceError pixels
+  const gims::f32v3& lowerLeftBottom = m_aabb.getLowerLeftBottom();
+  const gims::f32v3& upperRightTop   = m_aabb.getUpperRightTop();
+  gims::ui32         lod             = 0;
+  if (drawSettings.selectLevelOfDetail)
+  {
+    const gims::f32 pixelsPerUnit = gims::MeshSimplifier::getPixelsPerUnit(
+        modelView, drawSettings.projectionMatrix, drawSettings.viewportHeight, lowerLeftBottom, upperRightTop);
+    lod = gims::MeshSimplifier::selectLod(m_levelsOfDetail.data(), static_cast<gims::ui32>(m_levelsOfDetail.size()),
+                                          pixelsPerUnit, drawSettings.maxScreenSpaceError);
+  }
+  const gims::Meshlets::DrawRange levelOfDetail = {m_levelsOfDetail[lod].firstIndex, m_levelsOfDetail[lod].nIndices};
+
+  // Visible clusters that are next to each other in the index buffer are merged into one range. Clusters only exist
+  // for the finest level of detail, coarser levels are culled with the bounding sphere of the mesh.
+  std::vector<gims::Meshlets::DrawRange> ranges;
+  if (!drawSettings.cullClusters)
+  {
+    ranges.push_back(levelOfDetail);
+    statistics.numberOfDrawnClusters = lod == 0 ? getNumberOfClusters() : 0;
+  }
+  else
+  {
+    const gims::Meshlets::CullingView cullingView = gims::Meshlets::createCullingView(
+        modelView, drawSettings.projectionMatrix, drawSettings.cullBackFacingClusters);
+    if (lod == 0)
+    {
+      statistics.numberOfDrawnClusters = gims::Meshlets::cullMeshlets(
+          ranges, m_meshlets.data(), static_cast<gims::ui32>(m_meshlets.size()), cullingView);
+    }
+    else
+    {
+      gims::Meshlets::Meshlet bounds;
+      bounds.center = (lowerLeftBottom + upperRightTop) * 0.5f;
+      bounds.radius = glm::length(upperRightTop - lowerLeftBottom) * 0.5f;
+      if (gims::Meshlets::isVisible(bounds, cullingView))
+      {
+        ranges.push_back(levelOfDetail);
+      }
+    }
+  }
+  if (ranges.empty())
+  {
+    return statistics;
+  }
+
+  // Set buffers and topology
+  commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
+  commandList->IASetIndexBuffer(&m_indexBufferView);
+  commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+  // Issue one draw command per range of visible clusters
+  for (const gims::Meshlets::DrawRange& range : ranges)
+  {
+    commandList->DrawIndexedInstanced(range.nIndices, 1, range.firstIndex, 0, 0);
+    statistics.numberOfDrawnTriangles += range.nIndices / 3;
+  }
+  return statistics;
+}
+
+const gims::ui32 TriangleMeshD3D12::getNumberOfClusters() const
+{
+  return static_cast<gims::ui32>(m_meshlets.size());
+}
+
+const gims::ui32 TriangleMeshD3D12::getNumberOfTriangles() const
+{
+  return m_nIndices / 3;
+}
+
+const gims::ui32 TriangleMeshD3D12::getNumberOfLevelsOfDetail() const
+{
+  return static_cast<gims::ui32>(m_levelsOfDetail.size());
+}
+
 const AABB TriangleMeshD3D12::getAABB() const
 {
   return m_aabb;
@@ -111,9 +238,25 @@ const gims::ui32 TriangleMeshD3D12::getMaterialIndex() const
   return m_materialIndex;
 }
 
-const std::vector<D3D12_INPUT_ELEMENT_DESC>& TriangleMeshD3D12::getInputElementDescriptors()
+const gims::VertexQuantization::PositionDequantization& TriangleMeshD3D12::getPositionDequantization() const
+{
+  return m_positionDequantization;
+}
+
+const gims::VertexQuantization::VertexFormat& TriangleMeshD3D12::getVertexFormat() const
+{
+  return m_vertexFormat;
+}
+
+const bool TriangleMeshD3D12::hasTangents() const
+{
+  return m_vertexFormat.tangent != gims::VertexQuantization::TANGENT_NONE;
+}
+
+std::vector<D3D12_INPUT_ELEMENT_DESC>
+TriangleMeshD3D12::getInputElementDescriptors(const gims::VertexQuantization::VertexFormat& vertexFormat)
 {
-  return m_inputElementDescs;
+  return gims::VertexQuantization::createInputElementDescs(vertexFormat);
 }
 
 TriangleMeshD3D12::TriangleMeshD3D12()
@@ -0,0 +1,56 @@
+// MeshConverter.hpp
+#ifndef MESH_CONVERTER_CLASS
+#define MESH_CONVERTER_CLASS
+
+#include <filesystem>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/types.hpp>
+#include <string>
+#include <vector>
+
+/// Settings of a conversion.
+struct ConversionOptions
+{
+  gims::CograBinaryMeshFile::FileVersion      version     = gims::CograBinaryMeshFile::VERSION_2;
+  gims::CograBinaryMeshFile::CompressionLevel compression = gims::CograBinaryMeshFile::COMPRESSION_NONE;
+  bool                                        optimize    = false;
+  bool                                        spatialSort = false;
+  bool                                        meshlets    = false;
+  bool                                        lods        = false;
+};
+
+/// Outcome of converting one file.
+struct ConversionResult
+{
+  std::filesystem::path input;
+  std::filesystem::path output;
+  gims::ui64            inputSize  = 0;
+  gims::ui64            outputSize = 0;
+  gims::ui32            nVertices  = 0;
+  gims::ui32            nTriangles = 0;
+  gims::f64             seconds    = 0.0;
+  bool                  optimized  = false;
+  gims::f32             acmrBefore = 0.0f;
+  gims::f32             acmrAfter  = 0.0f;
+  gims::ui32            nMeshlets  = 0;
+  gims::ui32            nLods      = 0;
+  gims::f32             lodError   = 0.0f;
+  std::string           error;
+};
+
+/// Converts mesh files to CBM files.
+class MeshConverter
+{
+public:
+  /// Collects the files that can be converted. Directories are searched recursively.
+  /// \param[in]  input A file or a directory.
+  static std::vector<std::filesystem::path> findInputs(const std::filesystem::path& input);
+
+  /// Converts one file. Errors are reported in the result instead of being thrown.
+  /// \param[in]  input CBM file or scene readable by the Asset Importer.
+  /// \param[in]  output The CBM file to write. Missing directories are created.
+  /// \param[in]  options Settings of the conversion.
+  static ConversionResult convert(const std::filesystem::path& input, const std::filesystem::path& output,
+                                  const ConversionOptions& options);
+};
+#endif // MESH_CONVERTER_CLASS
@@ -0,0 +1,27 @@
+// MeshImporter.hpp
+#ifndef MESH_IMPORTER_CLASS
+#define MESH_IMPORTER_CLASS
+
+#include <filesystem>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+
+struct aiScene;
+
+/// Converts scenes readable by the Asset Importer (glTF, OBJ, FBX, ...) to a single CBM mesh.
+class MeshImporter
+{
+public:
+  /// True, if the Asset Importer can read the file, judging from its extension.
+  static bool canImport(const std::filesystem::path& pathToScene);
+
+  /// Imports all triangle meshes of a scene and merges them into one mesh in world space.
+  /// The mesh has the attributes "Normals" (3 x f32) and "UVs" (2 x f32), as the meshes in the data directory.
+  /// Throws std::runtime_error, if the scene cannot be read.
+  /// \param[in]  pathToScene Path to the scene file.
+  /// \param[in]  optimize If true, identical vertices are joined and triangles are reordered for the vertex cache.
+  static gims::CograBinaryMeshFile importScene(const std::filesystem::path& pathToScene, bool optimize);
+
+private:
+  static gims::CograBinaryMeshFile merge(aiScene const* const inputScene);
+};
+#endif // MESH_IMPORTER_CLASS
@@ -0,0 +1,111 @@
+// MeshConverter.cpp
+
+#include "MeshConverter.hpp"
+#include "MeshImporter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <gimslib/mesh/MeshOptimizer.hpp>
+#include <gimslib/mesh/MeshSimplifier.hpp>
+#include <gimslib/mesh/MeshSpatialSort.hpp>
+#include <gimslib/mesh/Meshlets.hpp>
+
+namespace
+{
+bool isCbm(const std::filesystem::path& path)
+{
+  return path.extension() == ".cbm";
+}
+
+bool isConvertible(const std::filesystem::path& path)
+{
+  // glTF buffers and textures are part of a scene, but not scenes themselves.
+  const std::filesystem::path extension = path.extension();
+  if (extension == ".bin" || extension == ".png" || extension == ".jpg" || extension == ".jpeg")
+  {
+    return false;
+  }
+  return isCbm(path) || MeshImporter::canImport(path);
+}
+} // namespace
+
+std::vector<std::filesystem::path> MeshConverter::findInputs(const std::filesystem::path& input)
+{
+  std::vector<std::filesystem::path> result;
+  if (!std::filesystem::is_directory(input))
+  {
+    result.push_back(input);
+    return result;
+  }
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(input))
+  {
+    if (entry.is_regular_file() && isConvertible(entry.path()))
+    {
+      result.push_back(entry.path());
+    }
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+ConversionResult MeshConverter::convert(const std::filesystem::path& input, const std::filesystem::path& output,
+                                        const ConversionOptions& options)
+{
+  ConversionResult result;
+  result.input  = input;
+  result.output = output;
+
+  const auto start = std::chrono::steady_clock::now();
+  try
+  {
+    result.inputSize = std::filesystem::file_size(input);
+
+    gims::CograBinaryMeshFile cbm;
+    if (isCbm(input))
+    {
+      // Files are converted in parallel, so each file is read by a single thread.
+      cbm.load(input.string());
+    }
+    else
+    {
+      cbm = MeshImporter::importScene(input, options.optimize);
+    }
+    if (options.spatialSort)
+    {
+      // Like loading, sorting uses a single thread, as files are converted in parallel. It comes before the vertex cache
+      // optimization, which keeps the locality of the sorted triangles but would be undone by sorting afterwards.
+      gims::MeshSpatialSort::sortMesh(cbm, 1);
+    }
+    if (options.optimize)
+    {
+      const gims::MeshOptimizer::MeshOptimizationReport report = gims::MeshOptimizer::optimizeMesh(cbm);
+      result.optimized                                         = true;
+      result.acmrBefore                                        = report.before.acmr;
+      result.acmrAfter                                         = report.after.acmr;
+    }
+    if (options.meshlets)
+    {
+      result.nMeshlets = static_cast<gims::ui32>(gims::Meshlets::buildMeshlets(cbm).size());
+    }
+    if (options.lods)
+    {
+      const std::vector<gims::MeshSimplifier::LevelOfDetail> lods = gims::MeshSimplifier::buildLods(cbm);
+      result.nLods                                                = static_cast<gims::ui32>(lods.size());
+      result.lodError                                             = lods.back().error;
+    }
+    result.nVertices  = cbm.getNumVertices();
+    result.nTriangles = cbm.getNumTriangles();
+
+    if (output.has_parent_path())
+    {
+      std::filesystem::create_directories(output.parent_path());
+    }
+    cbm.save(output.string(), options.version, options.compression);
+    result.outputSize = std::filesystem::file_size(output);
+  }
+  catch (const std::exception& e)
+  {
+    result.error = e.what();
+  }
+  result.seconds = std::chrono::duration<gims::f64>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
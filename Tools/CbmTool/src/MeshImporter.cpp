@@ -0,0 +1,83 @@
+// MeshImporter.cpp
+
+#include "MeshImporter.hpp"
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+bool MeshImporter::canImport(const std::filesystem::path& pathToScene)
+{
+  const Assimp::Importer imp;
+  return imp.IsExtensionSupported(pathToScene.extension().string());
+}
+
+gims::CograBinaryMeshFile MeshImporter::importScene(const std::filesystem::path& pathToScene, bool optimize)
+{
+  // Pre-transforming the vertices flattens the node hierarchy, so all meshes end up in world space.
+  gims::ui32 arguments = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_GenUVCoords |
+                         aiProcess_PreTransformVertices | aiProcess_SortByPType | aiProcess_FindInvalidData |
+                         aiProcess_FindDegenerates;
+  if (optimize)
+  {
+    arguments |= aiProcess_JoinIdenticalVertices | aiProcess_OptimizeMeshes | aiProcess_ImproveCacheLocality;
+  }
+
+  Assimp::Importer imp;
+  imp.SetPropertyBool(AI_CONFIG_PP_FD_REMOVE, true);
+  imp.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);
+  const aiScene* inputScene = imp.ReadFile(pathToScene.string(), arguments);
+  if (!inputScene)
+  {
+    throw std::runtime_error(pathToScene.string() + " can't be loaded with Assimp: " + imp.GetErrorString());
+  }
+  return merge(inputScene);
+}
+
+gims::CograBinaryMeshFile MeshImporter::merge(aiScene const* const inputScene)
+{
+  std::vector<gims::f32v3>  positions;
+  std::vector<gims::f32v3>  normals;
+  std::vector<gims::f32v2>  texCoords;
+  std::vector<gims::ui32v3> indices;
+
+  for (unsigned int meshIdx = 0; meshIdx < inputScene->mNumMeshes; ++meshIdx)
+  {
+    const aiMesh* mesh = inputScene->mMeshes[meshIdx];
+    if (!mesh || mesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE)
+    {
+      continue; // Skip non-triangular meshes
+    }
+    const size_t baseVertex = positions.size();
+    if (baseVertex + mesh->mNumVertices > std::numeric_limits<gims::ui32>::max() / 3)
+    {
+      throw std::runtime_error("Scene has too many vertices for a CBM file.");
+    }
+
+    for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+    {
+      positions.emplace_back(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+      normals.push_back(mesh->HasNormals() ? gims::f32v3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z)
+                                           : gims::f32v3(0.0f, 0.0f, 1.0f));
+      texCoords.push_back(mesh->HasTextureCoords(0)
+                              ? gims::f32v2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y)
+                              : gims::f32v2(0.0f));
+    }
+    for (unsigned int i = 0; i < mesh->mNumFaces; ++i)
+    {
+      const aiFace& face = mesh->mFaces[i];
+      indices.emplace_back(face.mIndices[0], face.mIndices[1], face.mIndices[2]);
+      indices.back() += static_cast<gims::ui32>(baseVertex);
+    }
+  }
+
+  gims::CograBinaryMeshFile result;
+  result.setPositions(reinterpret_cast<const gims::f32*>(positions.data()), static_cast<gims::ui32>(positions.size()));
+  result.setTriangleIndices(reinterpret_cast<const gims::ui32*>(indices.data()),
+                            static_cast<gims::ui32>(indices.size()));
+  result.addAttribute(normals.data(), 3, sizeof(gims::f32), "Normals");
+  result.addAttribute(texCoords.data(), 2, sizeof(gims::f32), "UVs");
+  return result;
+}
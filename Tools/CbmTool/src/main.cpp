@@ -0,0 +1,219 @@
+// main.cpp
+
+#include "MeshConverter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+void printUsage()
+{
+  std::cerr << "Usage: cbmtool [options] <input> <output directory>\n"
+            << "Converts a mesh file, or all mesh files in a directory tree, to CBM files.\n"
+            << "Inputs are CBM files and scenes the Asset Importer can read, e.g., glTF or OBJ.\n\n"
+            << "Options:\n"
+            << "  --version <1|2>                      CBM file version to write (default: 2)\n"
+            << "  --compression <none|lossless|lossy>  Compression of version 2 files (default: none)\n"
+            << "  --optimize                           Join identical vertices of imported scenes and reorder "
+               "triangles\n"
+            << "                                       and vertices for the vertex cache and overdraw\n"
+            << "  --spatial-sort                       Sort triangles and vertices along a Morton curve for memory "
+               "locality,\n"
+            << "                                       before --optimize if both are given\n"
+            << "  --meshlets                           Split meshes into meshlets for cluster culling\n"
+            << "  --lods                               Add levels of detail simplified with quadric error metrics\n"
+            << "  --threads <n>                        Files converted concurrently, 0 for all cores (default: 0)\n";
+}
+
+gims::f64 toMegaBytes(gims::ui64 bytes)
+{
+  return static_cast<gims::f64>(bytes) / (1024.0 * 1024.0);
+}
+
+void printResult(const ConversionResult& r)
+{
+  char line[512];
+  if (!r.error.empty())
+  {
+    std::snprintf(line, sizeof(line), "FAILED  %s: %s", r.input.string().c_str(), r.error.c_str());
+  }
+  else
+  {
+    std::snprintf(line, sizeof(line), "%9.2f ms %9.2f MB -> %9.2f MB %9.2f MB/s %10u vertices %10u triangles  %s",
+                  r.seconds * 1000.0, toMegaBytes(r.inputSize), toMegaBytes(r.outputSize),
+                  toMegaBytes(r.inputSize) / std::max(r.seconds, 1e-9), r.nVertices, r.nTriangles,
+                  r.output.string().c_str());
+  }
+  std::cout << line;
+  if (r.error.empty() && r.optimized)
+  {
+    std::snprintf(line, sizeof(line), "  ACMR %.3f -> %.3f", r.acmrBefore, r.acmrAfter);
+    std::cout << line;
+  }
+  if (r.error.empty() && r.nMeshlets > 0)
+  {
+    std::cout << "  " << r.nMeshlets << " meshlets";
+  }
+  if (r.error.empty() && r.nLods > 0)
+  {
+    std::snprintf(line, sizeof(line), "  %u LODs, max. error %g", r.nLods, r.lodError);
+    std::cout << line;
+  }
+  std::cout << "\n";
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+  ConversionOptions     options;
+  gims::ui32            nThreads = 0;
+  std::filesystem::path input;
+  std::filesystem::path outputDirectory;
+  try
+  {
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++)
+    {
+      const std::string argument = argv[i];
+      const bool        hasValue = i + 1 < argc;
+      if (argument == "--version" && hasValue)
+      {
+        const std::string value = argv[++i];
+        if (value != "1" && value != "2")
+        {
+          throw std::invalid_argument("Unknown version " + value + ".");
+        }
+        options.version = value == "1" ? gims::CograBinaryMeshFile::VERSION_1 : gims::CograBinaryMeshFile::VERSION_2;
+      }
+      else if (argument == "--compression" && hasValue)
+      {
+        const std::string value = argv[++i];
+        if (value == "none")
+        {
+          options.compression = gims::CograBinaryMeshFile::COMPRESSION_NONE;
+        }
+        else if (value == "lossless")
+        {
+          options.compression = gims::CograBinaryMeshFile::COMPRESSION_LOSSLESS;
+        }
+        else if (value == "lossy")
+        {
+          options.compression = gims::CograBinaryMeshFile::COMPRESSION_LOSSY;
+        }
+        else
+        {
+          throw std::invalid_argument("Unknown compression " + value + ".");
+        }
+      }
+      else if (argument == "--optimize")
+      {
+        options.optimize = true;
+      }
+      else if (argument == "--spatial-sort")
+      {
+        options.spatialSort = true;
+      }
+      else if (argument == "--meshlets")
+      {
+        options.meshlets = true;
+      }
+      else if (argument == "--lods")
+      {
+        options.lods = true;
+      }
+      else if (argument == "--threads" && hasValue)
+      {
+        nThreads = static_cast<gims::ui32>(std::stoul(argv[++i]));
+      }
+      else if (argument.starts_with("--"))
+      {
+        throw std::invalid_argument("Unknown option " + argument + ".");
+      }
+      else
+      {
+        positional.push_back(argument);
+      }
+    }
+    if (positional.size() != 2)
+    {
+      throw std::invalid_argument("Expected an input and an output directory.");
+    }
+    if (options.version == gims::CograBinaryMeshFile::VERSION_1 &&
+        options.compression != gims::CograBinaryMeshFile::COMPRESSION_NONE)
+    {
+      throw std::invalid_argument("Compression requires version 2.");
+    }
+    input           = positional[0];
+    outputDirectory = positional[1];
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << "\n\n";
+    printUsage();
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::filesystem::path> inputs;
+  try
+  {
+    inputs = MeshConverter::findInputs(input);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // Outputs mirror the directory structure of the input.
+  const std::filesystem::path inputRoot = std::filesystem::is_directory(input) ? input : input.parent_path();
+  const auto                  start     = std::chrono::steady_clock::now();
+
+  std::mutex                     printMutex;
+  std::vector<ConversionResult>  results(inputs.size());
+  std::vector<std::future<void>> conversions;
+  {
+    gims::ThreadPool pool(nThreads);
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+      conversions.push_back(pool.submit(
+          [&, i]
+          {
+            std::filesystem::path output = outputDirectory / std::filesystem::relative(inputs[i], inputRoot);
+            output.replace_extension(".cbm");
+            results[i] = MeshConverter::convert(inputs[i], output, options);
+            const std::lock_guard<std::mutex> lock(printMutex);
+            printResult(results[i]);
+          }));
+    }
+    for (auto& c : conversions)
+    {
+      c.get();
+    }
+  }
+
+  const gims::f64 seconds    = std::chrono::duration<gims::f64>(std::chrono::steady_clock::now() - start).count();
+  gims::ui64      inputSize  = 0;
+  gims::ui64      outputSize = 0;
+  size_t          nFailed    = 0;
+  for (const auto& r : results)
+  {
+    inputSize += r.inputSize;
+    outputSize += r.outputSize;
+    nFailed += r.error.empty() ? 0 : 1;
+  }
+  char summary[256];
+  std::snprintf(summary, sizeof(summary), "%zu files, %zu failed, %.2f MB -> %.2f MB in %.3f s, %.2f MB/s\n",
+                inputs.size(), nFailed, toMegaBytes(inputSize), toMegaBytes(outputSize), seconds,
+                toMegaBytes(inputSize) / std::max(seconds, 1e-9));
+  std::cout << summary;
+  return nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
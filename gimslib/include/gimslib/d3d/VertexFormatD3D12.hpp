@@ -0,0 +1,20 @@
+#pragma once
+#include <d3d12.h>
+#include <gimslib/mesh/VertexQuantization.hpp>
+#include <vector>
+namespace gims
+{
+namespace VertexQuantization
+{
+//! \brief Returns the input layout of vertices encoded by encodeVertices with the given format.
+//!
+//! The semantics are POSITION, NORMAL, TEXCOORD, and TANGENT, if the format has tangents. The input assembler maps
+//! UNORM16 positions to [0, 1], so the vertex shader still has to apply the PositionDequantization, and has to unfold
+//! NORMAL_OCTAHEDRAL_SNORM16 normals. Normals in NORMAL_UNORM10_10_10_2 arrive in [0, 1] and are mapped to [-1, 1] by
+//! normal * 2 - 1. Tangents arrive as float4 in either format.
+//! \param[in]  format The encoding of each attribute.
+//! \param[in]  inputSlot The vertex buffer slot of all elements.
+//! \return One element per attribute. The semantic names are string literals, so the result can be copied freely.
+std::vector<D3D12_INPUT_ELEMENT_DESC> createInputElementDescs(const VertexFormat& format, ui32 inputSlot = 0);
+} // namespace VertexQuantization
+} // namespace gims
@@ -5,6 +5,7 @@
 #include <gimslib/types.hpp>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 //! Namespace for everything that is Computer Graphics related.
 namespace gims
@@ -16,6 +17,10 @@ namespace gims
 //! of arbitrary type.
 //! Moreover, values that are constant for the entire triangle mesh may be stored. Similar to attributes, an
 //! arbitrary number of constants of arbitrary type is supported.
+//!
+//! Attributes, constants, and their names share one block of memory, the arena. Every attribute and constant starts
+//! at a multiple of 64 bytes within the arena. Adding attributes or constants may move the arena, which invalidates
+//! pointers obtained by getAttributePtr and getConstant before.
 class CograBinaryMeshFile
 {
   //! Maximum number of characters used for attribute and constant names
@@ -24,6 +29,9 @@ class CograBinaryMeshFile
     N_CHARS = 256
   };
 
+  //! Alignment in bytes of attributes and constants within the arena.
+  static constexpr size_t ARENA_ALIGNMENT = 64;
+
 public:
   //! Type for numbers and sizes.
   typedef ui32 SizeType;
@@ -34,6 +42,79 @@ public:
   //! Floating point used for vertex positions.
   typedef f32 FloatType;
 
+  //! \brief Versions of the file format.
+  //!
+  //! Version 1 stores header and payloads back to back. Version 2 starts with a fixed size header followed by a table
+  //! of sections that stores offset and size of every payload. Payloads of version 2 files are aligned to 64 bytes,
+  //! so they can be mapped, skipped, or read in parallel.
+  enum FileVersion : ui32
+  {
+    VERSION_1 = 1,
+    VERSION_2 = 2
+  };
+
+  //! \brief Compression of the payloads of version 2 files.
+  //!
+  //! Compressed files are smaller, but they must be decoded on load and cannot be used with CograBinaryMeshView.
+  enum CompressionLevel : ui32
+  {
+    COMPRESSION_NONE     = 0, //! Payloads are stored as is.
+    COMPRESSION_LOSSLESS = 1, //! Triangle indices are delta coded, all payloads are entropy coded.
+    COMPRESSION_LOSSY    = 2  //! Additionally, positions are quantized to 16 bits and normals to 2x16 bits.
+  };
+
+  //! \brief Selects the parts of a file that are loaded.
+  //!
+  //! Positions and triangles are always loaded. Everything that is not selected is skipped without being read.
+  struct LoadOptions
+  {
+    //! If true, all attributes are loaded and attributeNames is ignored.
+    bool loadAllAttributes = true;
+
+    //! Names of the attributes to load, if loadAllAttributes is false. Names that are not in the file are ignored.
+    std::vector<std::string> attributeNames;
+
+    //! If false, no constants are loaded.
+    bool loadConstants = true;
+
+    //! Number of threads reading payloads concurrently, and generating normals. 0 uses one thread per hardware thread.
+    ui32 nThreads = 1;
+
+    //! If true, payloads are checked against the checksums stored in the file. Throws std::runtime_error on a
+    //! mismatch. Only version 2 files store checksums, the option has no effect on version 1 files.
+    bool verifyChecksums = false;
+
+    //! If true and no loaded attribute holds normals, i.e., has three floats and a name containing "normal" in any
+    //! case, an attribute "Normals" is generated with MeshNormals::generateNormals and appended after loading.
+    bool generateNormals = false;
+
+    //! If true, triangles and vertices are reordered for rendering with MeshOptimizer::optimizeMesh after loading.
+    bool optimize = false;
+  };
+
+  //! \brief Describes an attribute or a constant of a file.
+  struct ElementInfo
+  {
+    std::string name;              //! Name of the attribute or constant.
+    SizeType    components    = 0; //! Number of components.
+    SizeType    componentSize = 0; //! Size of one component in bytes.
+  };
+
+  //! \brief Everything that is known about a file from its header, see probe().
+  struct Info
+  {
+    FileVersion              version    = VERSION_1;   //! File format version.
+    SizeType                 nVertices  = 0;           //! Number of vertices.
+    SizeType                 nTriangles = 0;           //! Number of triangles.
+    std::vector<ElementInfo> attributes;               //! Attributes in the order they are stored.
+    std::vector<ElementInfo> constants;                //! Constants in the order they are stored.
+    bool                     compressed = false;       //! True, if any payload is compressed.
+    bool                     hasBounds  = false;       //! True, if the file stores a bounding box (version 2 only).
+    f32v3                    boundsMin  = f32v3(0.0f); //! Lower corner of the bounding box of the positions.
+    f32v3                    boundsMax  = f32v3(0.0f); //! Upper corner of the bounding box of the positions.
+    ui64                     fileSize   = 0;           //! Size of the file in bytes.
+  };
+
   //! \brief Default constructor.
   CograBinaryMeshFile() = default;
 
@@ -47,26 +128,47 @@ public:
   //! \param[in]  fileName Path to QMB file that should be opened.
   explicit CograBinaryMeshFile(const std::string& fileName);
 
+  //! \brief Loads parts of a file.
+  //! \param[in]  fileName Path to QMB file that should be opened.
+  //! \param[in]  options Selects the attributes and constants that are loaded.
+  CograBinaryMeshFile(const std::string& fileName, const LoadOptions& options);
+
   //! \brief Default destructor.
   virtual ~CograBinaryMeshFile();
 
   void swap(CograBinaryMeshFile& other);
 
   //! Assignment operator.
-  CograBinaryMeshFile& operator=(CograBinaryMeshFile other);
+  CograBinaryMeshFile& operator=(const CograBinaryMeshFile& other);
 
   //! Move operator.
   CograBinaryMeshFile& operator=(CograBinaryMeshFile&& other) noexcept;
 
-  //! \brief Loads a file.
+  //! \brief Loads a file. The file version is detected automatically.
   //!
   //! \param[in]  fileName Path to file name
   void load(const std::string& fileName);
 
+  //! \brief Loads parts of a file. The file version is detected automatically.
+  //!
+  //! \param[in]  fileName Path to file name
+  //! \param[in]  options Selects the attributes and constants that are loaded.
+  void load(const std::string& fileName, const LoadOptions& options);
+
+  //! \brief Reads the header of a file without loading any payload. Throws std::runtime_error on failure.
+  //!
+  //! Much faster than load, when only counts, names, or the bounding box are needed, e.g., to list many files.
+  //! \param[in]  fileName Path to file name
+  //! \return Counts, attribute and constant descriptions, and bounds of the file.
+  static Info probe(const std::string& fileName);
+
   //! \brief Saves a file.
   //!
   //! \param[in]  fileName Path to file name
-  void save(const std::string& fileName);
+  //! \param[in]  version File format version to write.
+  //! \param[in]  compression Compression of the payloads. Requires version 2.
+  void save(const std::string& fileName, FileVersion version = VERSION_1,
+            CompressionLevel compression = COMPRESSION_NONE);
 
   //! \brief Returns the number of vertices.
   SizeType getNumVertices() const;
@@ -100,6 +202,8 @@ public:
 
   //! \brief Adds an attribute. The number of attributes should match the number of vertices.
   //!
+  //! Pointers to attributes and constants obtained before become invalid.
+  //!
   //! \param[in]  attribute Pointer to the attribute array.
   //! \param[in]  nComponents Number of components of each attribute element. For example, a normal vector attribute has
   //! 3 components. So you would place a 3 here. \param[in]  componentSize Number of bytes each component has. For
@@ -111,6 +215,8 @@ public:
 
   //! \brief Adds a constant.
   //!
+  //! Pointers to attributes and constants obtained before become invalid.
+  //!
   //! \param[in]  constant Pointer to the constant.
   //! \param[in]  nComponents Number of components the constant. For example, a light direction vector has 3 components.
   //! So you would place a 3 here. \param[in]  componentSize Number of bytes each component has. For example, a light
@@ -136,6 +242,8 @@ public:
 
   //! \brief Replaces the attribute which index attributeIdx by a new array.
   //!
+  //! The new array is copied over the old one, so pointers to the attribute remain valid.
+  //!
   //! \param[in]  attributeIdx
   //! \param[in]  attribute Pointer to the new array.
   //! \return 0 on error, pointer to the array on success.
@@ -163,7 +271,15 @@ public:
   //!
   //! \param  attributeIdx Index of the attribute.
   //! \return Returns the size in bytes of an attribute.
-  SizeType getAttributeElementSize(SizeType attributeIdx) const;
+  ui64 getAttributeElementSize(SizeType attributeIdx) const;
+
+  //! \brief Returns the size in bytes of an attribute array.
+  //!
+  //! This is getAttributeElementSize(attributeIdx) * getNumVertices(), computed without overflow for arrays beyond
+  //! 4 GB.
+  //!
+  //! \param  attributeIdx Index of the attribute.
+  size_t getAttributeSizeInBytes(SizeType attributeIdx) const;
 
   //! \brief Returns the attribute name.
   //!
@@ -174,8 +290,13 @@ public:
   //! \brief Number of attributes.
   SizeType getNumAttributes() const;
 
+  //! \brief Returns the index of an attribute.
+  //! \param[in]  name Name of the attribute.
+  //! \return -1 if the attribute does not exist, otherwise the index of the first attribute with that name.
+  int getAttributeIdx(const char* name) const;
+
   //! \brief Total size in bytes of all attributes.
-  SizeType getTotalAttributeSize() const;
+  ui64 getTotalAttributeSize() const;
 
   //! \brief Returns the vertex position and its attributes of the vertex vIdx into result.
   //!
@@ -204,7 +325,7 @@ public:
   //!
   //! \param constantIdx  Index of the constant.
   //! \return Size in bytes of a constant.
-  SizeType getConstantElementSize(SizeType constantIdx) const;
+  ui64 getConstantElementSize(SizeType constantIdx) const;
 
   //! \brief Returns the constant name.
   //!
@@ -215,11 +336,11 @@ public:
   //! \brief Number of constants.
   SizeType getNumConstants() const;
 
-  //! \brief Reads the header.
+  //! \brief Reads the header of a version 1 file.
   //! \param[in,out]  inFile Reference to an opened file.
   void readHeader(std::ifstream& inFile);
 
-  //! \brief Writes the header.
+  //! \brief Writes the header of a version 1 file.
   //! \param[in,out]  outFile Reference to an opened file.
   void writeHeader(std::ofstream& outFile);
 
@@ -229,10 +350,17 @@ public:
   //! \brief Deletes all constants.
   void freeConstants();
 
+  //! \brief Deletes a constant. The indices of the constants after it decrease by one.
+  //!
+  //! \param[in]  constantIdx Index of the constant.
+  void removeConstant(SizeType constantIdx);
+
   //! \brief Adds another QMBinFile to this QMBinFile.
   //!
+  //! Throws std::runtime_error, if the merged mesh has too many vertices or triangles for 32 bit indices.
+  //!
   //! \param  src Bin file that should be appended to this file.
-  //! \return True on success, false otherwise.
+  //! \return True on success, false if the attributes do not match.
   bool add(const CograBinaryMeshFile& src);
 
   //! \brief Prints the information about constants to a stream.
@@ -260,14 +388,54 @@ public:
   int getConstantIdx(SizeType components, SizeType componentSize, const char* name) const;
 
 private:
+  //! Frees memory allocated with ARENA_ALIGNMENT.
+  struct ArenaDeleter
+  {
+    void operator()(ui8* arena) const;
+  };
+
+  //! \brief Reserves space in the arena for an attribute or a constant.
+  //!
+  //! Grows the arena if necessary, which moves its content.
+  //! \param[in]  sizeInBytes Size of the block.
+  //! \param[in]  alignment Alignment of the block within the arena.
+  //! \return Offset of the block within the arena.
+  size_t allocate(size_t sizeInBytes, size_t alignment = ARENA_ALIGNMENT);
+
+  //! \brief Copies data to a new block in the arena. The data may be part of the arena.
+  //! \return Offset of the block within the arena.
+  size_t store(const void* data, size_t sizeInBytes);
+
+  //! \brief Makes room for at least capacity bytes in the arena.
+  void reserveArena(size_t capacity);
+
+  //! \brief Stores a zero terminated name in the arena. Names longer than N_CHARS characters are chopped.
+  //! \return Offset of the name within the arena.
+  size_t createName(const std::string& name);
+
+  //! \brief Writes a name padded with zeros to N_CHARS characters, as required by version 1 files.
+  static void writeName(std::ostream& outFile, const char* name);
+
+  //! \brief Rebuilds the name to index maps of attributes and constants.
+  void updateIndices();
+
   //! Vertex positions.
   std::vector<FloatType> m_positions;
 
   //! Indexed face set of triangles.
   std::vector<IndexType> m_triangles;
 
-  //! All the attributes
-  std::vector<ui8*> m_attributes;
+  //! Holds attributes, constants, and names. Allocated with ARENA_ALIGNMENT.
+  std::unique_ptr<ui8[], ArenaDeleter> m_arena;
+
+  //! Number of bytes of the arena in use.
+  size_t m_arenaSize = 0;
+
+  //! Number of bytes allocated for the arena.
+  size_t m_arenaCapacity = 0;
+
+  //! Offsets of the attribute arrays within the arena.
+  std::vector<size_t> m_attributes;
 
   //! Stores the number of components an attribute element posses (e.g., a normal has three components).
   std::vector<SizeType> m_attributeComponents;
@@ -276,11 +444,14 @@ private:
   //! is a f32.
   std::vector<SizeType> m_attributeComponentSize;
 
-  //! The attribute names.
-  std::vector<char*> m_attributeNames;
+  //! Offsets of the attribute names within the arena.
+  std::vector<size_t> m_attributeNames;
+
+  //! Maps attribute names to the index of the first attribute with that name.
+  std::unordered_map<std::string, SizeType> m_attributeIndices;
 
-  //! Constants used for example for material properties.
-  std::vector<ui8*> m_constants;
+  //! Offsets of the constants within the arena. Constants are used for example for material properties.
+  std::vector<size_t> m_constants;
 
   //! Stores the number of components a constant posses (e.g., a light direction vector has three components).
   std::vector<SizeType> m_constantComponents;
@@ -289,7 +460,10 @@ private:
   //! if it is a f32.
   std::vector<SizeType> m_constantComponentSize;
 
-  //! The constant names.
-  std::vector<char*> m_constantNames;
+  //! Offsets of the constant names within the arena.
+  std::vector<size_t> m_constantNames;
+
+  //! Maps constant names to the index of the first constant with that name.
+  std::unordered_map<std::string, SizeType> m_constantIndices;
 };
 } // namespace gims
@@ -0,0 +1,141 @@
+#pragma once
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/io/MemoryMappedFile.hpp>
+#include <string>
+#include <vector>
+namespace gims
+{
+//! \brief Read-only, zero-copy view onto a CBM file.
+//!
+//! The file is memory mapped and all pointers returned point straight into the mapping. Nothing is copied on open,
+//! pages are brought in by the operating system when they are touched. The pointers are valid as long as the view is
+//! open. Compressed files and files written in chunks by CograBinaryMeshWriter cannot be viewed, as their payloads
+//! are not stored in one piece.
+//!
+//! Payloads of version 2 files are aligned to 64 bytes. Version 1 files store payloads back to back after the names, so
+//! a payload may start at an odd offset. Files with a payload that is not aligned to its components, or to 8 bytes for
+//! larger components, cannot be viewed either.
+class CograBinaryMeshView
+{
+public:
+  typedef CograBinaryMeshFile::SizeType  SizeType;
+  typedef CograBinaryMeshFile::IndexType IndexType;
+  typedef CograBinaryMeshFile::FloatType FloatType;
+
+  //! \brief Creates a closed view.
+  CograBinaryMeshView() = default;
+
+  //! \brief Opens a file.
+  //! \param[in]  fileName Path to the CBM file.
+  explicit CograBinaryMeshView(const std::string& fileName);
+
+  CograBinaryMeshView(const CograBinaryMeshView& other)                = delete;
+  CograBinaryMeshView& operator=(const CograBinaryMeshView& other)     = delete;
+  CograBinaryMeshView(CograBinaryMeshView&& other) noexcept            = default;
+  CograBinaryMeshView& operator=(CograBinaryMeshView&& other) noexcept = default;
+
+  //! \brief Maps a file and parses its header. Throws std::runtime_error on failure, in which case the view is closed.
+  //! \param[in]  fileName Path to the CBM file.
+  void open(const std::string& fileName);
+
+  //! \brief Unmaps the file. All pointers obtained from this view become invalid.
+  void close();
+
+  //! \brief True, if a file is open.
+  bool isOpen() const;
+
+  //! \brief Returns the number of vertices.
+  SizeType getNumVertices() const;
+
+  //! \brief Returns the number of triangles.
+  SizeType getNumTriangles() const;
+
+  //! \brief Returns a pointer to the vertex positions.
+  const FloatType* getPositionsPtr() const;
+
+  //! \brief Returns a pointer to the triangle index buffer.
+  const IndexType* getTriangleIndices() const;
+
+  //! \brief Number of attributes.
+  SizeType getNumAttributes() const;
+
+  //! \brief Returns a pointer to an attribute array.
+  //! \param[in]  attributeIdx Index of the attribute.
+  const void* getAttributePtr(SizeType attributeIdx) const;
+
+  //! \brief Returns the size of one component of an attribute.
+  //! \param[in]  attributeIdx Index of the attribute.
+  SizeType getAttributeComponentSize(SizeType attributeIdx) const;
+
+  //! \brief Returns the number of components an attribute element has.
+  //! \param[in]  attributeIdx Index of the attribute.
+  SizeType getAttributeComponents(SizeType attributeIdx) const;
+
+  //! \brief Returns the size in bytes of an attribute element.
+  //! \param[in]  attributeIdx Index of the attribute.
+  ui64 getAttributeElementSize(SizeType attributeIdx) const;
+
+  //! \brief Returns the attribute name.
+  //! \param[in]  attributeIdx Index of the attribute.
+  const char* getAttributeName(SizeType attributeIdx) const;
+
+  //! \brief Returns the index of an attribute.
+  //! \param[in]  name Name of the attribute.
+  //! \return -1 if the attribute does not exist, otherwise the index of the first attribute with that name.
+  int getAttributeIdx(const char* name) const;
+
+  //! \brief Number of constants.
+  SizeType getNumConstants() const;
+
+  //! \brief Returns a pointer to a constant.
+  //! \param[in]  constantIdx Index of the constant.
+  const void* getConstant(SizeType constantIdx) const;
+
+  //! \brief Returns the size of one component of a constant.
+  //! \param[in]  constantIdx Index of the constant.
+  SizeType getConstantComponentSize(SizeType constantIdx) const;
+
+  //! \brief Returns the number of components of a constant.
+  //! \param[in]  constantIdx Index of the constant.
+  SizeType getConstantComponents(SizeType constantIdx) const;
+
+  //! \brief Returns the size in bytes of a constant.
+  //! \param[in]  constantIdx Index of the constant.
+  ui64 getConstantElementSize(SizeType constantIdx) const;
+
+  //! \brief Returns the constant name.
+  //! \param[in]  constantIdx Index of the constant.
+  const char* getConstantName(SizeType constantIdx) const;
+
+private:
+  //! An attribute array or a constant inside the mapping.
+  struct Element
+  {
+    const ui8*  data          = nullptr;
+    SizeType    components    = 0;
+    SizeType    componentSize = 0;
+    std::string name;
+  };
+
+  //! The mapped file.
+  MemoryMappedFile m_file;
+
+  //! Number of vertices.
+  SizeType m_nVertices = 0;
+
+  //! Number of triangles.
+  SizeType m_nTriangles = 0;
+
+  //! Vertex positions inside the mapping.
+  const FloatType* m_positions = nullptr;
+
+  //! Triangle indices inside the mapping.
+  const IndexType* m_triangles = nullptr;
+
+  //! The attributes.
+  std::vector<Element> m_attributes;
+
+  //! The constants.
+  std::vector<Element> m_constants;
+};
+} // namespace gims
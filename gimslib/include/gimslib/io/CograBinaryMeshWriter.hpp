@@ -0,0 +1,162 @@
+#pragma once
+#include <fstream>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <string>
+#include <vector>
+namespace gims
+{
+namespace impl
+{
+struct CograBinaryMeshSectionEntryV2;
+} // namespace impl
+
+//! \brief Writes a CBM file piece by piece, without holding the mesh in memory.
+//!
+//! Vertices and triangles are appended in chunks of arbitrary size. They are collected in buffers of a few megabytes
+//! per array, which are written to disk as soon as they are full. The header is written when the file is closed. The
+//! result is a version 2 file that can be read with CograBinaryMeshFile.
+//!
+//! Attributes must be declared before the first vertices are added. Constants may be added at any time while a file
+//! is open. Adding anything to a closed writer throws std::runtime_error.
+class CograBinaryMeshWriter
+{
+public:
+  typedef CograBinaryMeshFile::SizeType  SizeType;
+  typedef CograBinaryMeshFile::IndexType IndexType;
+  typedef CograBinaryMeshFile::FloatType FloatType;
+
+  //! Default size in bytes of the buffer of each array. Full buffers are written as one chunk.
+  static constexpr ui64 DEFAULT_CHUNK_SIZE = 4 << 20;
+
+  //! \brief Creates a closed writer.
+  CograBinaryMeshWriter();
+
+  //! \brief Creates a file.
+  //! \param[in]  fileName Path to the CBM file.
+  //! \param[in]  chunkSize Size in bytes of the buffer of each array.
+  explicit CograBinaryMeshWriter(const std::string& fileName, ui64 chunkSize = DEFAULT_CHUNK_SIZE);
+
+  //! \brief Closes the file. Errors are ignored, call close() to be notified about them.
+  ~CograBinaryMeshWriter();
+
+  CograBinaryMeshWriter(const CograBinaryMeshWriter& other)            = delete;
+  CograBinaryMeshWriter& operator=(const CograBinaryMeshWriter& other) = delete;
+
+  //! \brief Creates a file. A previously opened file is closed first. Throws std::runtime_error on failure, and
+  //! std::invalid_argument if chunkSize is 0.
+  //! \param[in]  fileName Path to the CBM file.
+  //! \param[in]  chunkSize Size in bytes of the buffer of each array. Full buffers are written as one chunk.
+  void open(const std::string& fileName, ui64 chunkSize = DEFAULT_CHUNK_SIZE);
+
+  //! \brief Writes the buffered data and the header and closes the file. Throws std::runtime_error on failure.
+  void close();
+
+  //! \brief True, if a file is open.
+  bool isOpen() const;
+
+  //! \brief Declares an attribute. Must be called before the first call of addVertices.
+  //! \param[in]  nComponents Number of components of each attribute element.
+  //! \param[in]  componentSize Number of bytes each component has.
+  //! \param[in]  attributeName Name of the attribute.
+  //! \return Number of attributes.
+  SizeType addAttribute(SizeType nComponents, SizeType componentSize, const std::string& attributeName);
+
+  //! \brief Adds a constant.
+  //! \param[in]  constant Pointer to the constant.
+  //! \param[in]  nComponents Number of components of the constant.
+  //! \param[in]  componentSize Number of bytes each component has.
+  //! \param[in]  constantName Name of the constant.
+  //! \return Number of constants.
+  SizeType addConstant(const void* constant, SizeType nComponents, SizeType componentSize,
+                       const std::string& constantName);
+
+  //! \brief Appends vertices.
+  //! \param[in]  positions Three floats per vertex.
+  //! \param[in]  attributes One pointer per declared attribute to nVertices attribute elements. May be nullptr, if no
+  //! attributes were declared.
+  //! \param[in]  nVertices Number of vertices.
+  void addVertices(const FloatType* positions, const void* const* attributes, SizeType nVertices);
+
+  //! \brief Appends triangles.
+  //! \param[in]  triIdx Three indices per triangle.
+  //! \param[in]  nTriangles Number of triangles.
+  //! \param[in]  baseVertex Added to every index. Use getNumVertices() before adding the vertices of a mesh to
+  //! append the mesh to the ones already written. Throws std::runtime_error, if an index plus baseVertex does not fit
+  //! into 32 bits.
+  void addTriangles(const IndexType* triIdx, SizeType nTriangles, IndexType baseVertex = 0);
+
+  //! \brief Returns the number of vertices written so far.
+  SizeType getNumVertices() const;
+
+  //! \brief Returns the number of triangles written so far.
+  SizeType getNumTriangles() const;
+
+private:
+  //! An array that is written in chunks.
+  struct Stream
+  {
+    ui32             type          = 0;
+    ui32             elementIndex  = 0;
+    SizeType         components    = 0;
+    SizeType         componentSize = 0;
+    ui32             nameOffset    = 0;
+    ui32             nameLength    = 0;
+    ui32             nChunks       = 0;
+    std::vector<ui8> buffer;
+  };
+
+  //! \brief Throws std::runtime_error, if no file is open.
+  void checkOpen() const;
+
+  //! \brief Clears the streams, the section table, the names, the counts, and the bounds of the last file.
+  void reset();
+
+  //! \brief Appends data to a stream and writes the full chunks.
+  void append(Stream& stream, const void* data, ui64 sizeInBytes);
+
+  //! \brief Writes the buffer of a stream as a chunk.
+  void writeChunk(Stream& stream);
+
+  //! \brief Writes a payload at the next aligned offset and adds it to the section table.
+  void writeSection(const Stream& stream, const void* data, ui64 sizeInBytes);
+
+  //! \brief Adds the name of an attribute or constant to the names section.
+  void addName(Stream& stream, const std::string& name);
+
+  //! The file.
+  std::ofstream m_file;
+
+  //! Path of the file used in error messages.
+  std::string m_fileName;
+
+  //! Size in bytes of the buffer of each array.
+  ui64 m_chunkSize = DEFAULT_CHUNK_SIZE;
+
+  //! Positions, triangles, and the attributes.
+  std::vector<Stream> m_streams;
+
+  //! Entries of the section table of all chunks written so far.
+  std::vector<impl::CograBinaryMeshSectionEntryV2> m_sectionTable;
+
+  //! Zero terminated names of attributes and constants.
+  std::string m_names;
+
+  //! Number of constants.
+  SizeType m_nConstants = 0;
+
+  //! Number of vertices.
+  SizeType m_nVertices = 0;
+
+  //! Number of triangles.
+  SizeType m_nTriangles = 0;
+
+  //! Largest vertex index written so far.
+  IndexType m_maxIndex = 0;
+
+  //! Lower corner of the bounding box of the positions.
+  f32v3 m_boundsMin = f32v3(0.0f);
+
+  //! Upper corner of the bounding box of the positions.
+  f32v3 m_boundsMax = f32v3(0.0f);
+};
+} // namespace gims
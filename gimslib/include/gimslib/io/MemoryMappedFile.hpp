@@ -0,0 +1,68 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <string>
+namespace gims
+{
+//! \brief Read-only memory mapping of an entire file.
+//!
+//! The mapping stays valid until the object is closed or destroyed. Uses CreateFileMapping on Windows and mmap on
+//! POSIX systems.
+class MemoryMappedFile
+{
+public:
+  //! \brief Creates an empty mapping.
+  MemoryMappedFile() = default;
+
+  //! \brief Maps a file. Throws std::runtime_error on failure.
+  //! \param[in]  fileName Path to the file that should be mapped.
+  explicit MemoryMappedFile(const std::string& fileName);
+
+  //! \brief Unmaps the file.
+  ~MemoryMappedFile();
+
+  MemoryMappedFile(const MemoryMappedFile& other)            = delete;
+  MemoryMappedFile& operator=(const MemoryMappedFile& other) = delete;
+
+  //! Move construction.
+  MemoryMappedFile(MemoryMappedFile&& other) noexcept;
+
+  //! Move operator.
+  MemoryMappedFile& operator=(MemoryMappedFile&& other) noexcept;
+
+  //! \brief Maps a file. A previously mapped file is unmapped first. Throws std::runtime_error on failure.
+  //! \param[in]  fileName Path to the file that should be mapped.
+  void open(const std::string& fileName);
+
+  //! \brief Unmaps the file. Pointers returned by data() become invalid.
+  void close();
+
+  //! \brief True, if a file is mapped.
+  bool isOpen() const;
+
+  //! \brief Returns a pointer to the first byte of the mapping, nullptr for empty files.
+  const ui8* data() const;
+
+  //! \brief Returns the size of the mapped file in bytes.
+  size_t size() const;
+
+  void swap(MemoryMappedFile& other) noexcept;
+
+private:
+#ifdef _WIN32
+  //! File handle, nullptr if not open.
+  void* m_fileHandle = nullptr;
+
+  //! File mapping object, nullptr if not open.
+  void* m_mappingHandle = nullptr;
+#else
+  //! File descriptor, -1 if not open.
+  int m_fileDescriptor = -1;
+#endif
+
+  //! First byte of the mapping.
+  const ui8* m_data = nullptr;
+
+  //! Size of the mapping in bytes.
+  size_t m_size = 0;
+};
+} // namespace gims
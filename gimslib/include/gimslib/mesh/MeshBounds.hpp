@@ -0,0 +1,32 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <limits>
+namespace gims
+{
+//! \brief Axis-aligned bounding boxes of large position arrays.
+//!
+//! The minimum and maximum are reduced with SSE2, if available, and in parallel chunks for large arrays. Every path
+//! returns identical bits: NaN components are ignored, and -0 is treated as smaller than +0, so the sign of a zero
+//! bound does not depend on the order in which the positions are visited.
+namespace MeshBounds
+{
+//! Arrays with fewer positions are reduced by the calling thread only.
+constexpr ui64 MIN_POSITIONS_PER_THREAD = 1 << 18;
+
+//! \brief An axis-aligned bounding box.
+struct Bounds
+{
+  f32v3 lower = f32v3(std::numeric_limits<f32>::max());  //! Smallest coordinate on each axis.
+  f32v3 upper = f32v3(-std::numeric_limits<f32>::max()); //! Largest coordinate on each axis.
+};
+
+//! \brief Computes the bounding box of an array of positions.
+//! \param[in]  positions Three floats per position.
+//! \param[in]  nPositions Number of positions.
+//! \param[in]  strideInBytes Distance between two consecutive positions in bytes, at least 12.
+//! \param[in]  nThreads Maximum number of threads. 0 uses one thread per hardware thread.
+//! \return The bounding box, or the empty box of a default constructed Bounds if there are no positions.
+Bounds computeBounds(const f32* positions, ui64 nPositions, size_t strideInBytes = 3 * sizeof(f32),
+                     ui32 nThreads = 0);
+} // namespace MeshBounds
+} // namespace gims
@@ -0,0 +1,40 @@
+#pragma once
+#include <gimslib/types.hpp>
+namespace gims
+{
+//! \brief Smooth vertex normals for meshes that do not provide them.
+//!
+//! The normal of a vertex is the normalized, weighted sum of the normals of its triangles. Triangles are processed in
+//! parallel chunks. Each chunk bins the weighted normals of its corners by vertex range, and each thread then sums the
+//! bins of one vertex range, so no two threads write to the same normal and no atomics are needed. The contributions
+//! of a vertex are always summed in triangle order, so the results do not depend on the number of threads.
+//!
+//! G. Thürmer, C. A. Wüthrich: Computing Vertex Normals from Polygonal Facets, Journal of Graphics Tools 3(1), 1998.
+namespace MeshNormals
+{
+//! Meshes with fewer triangles are processed by the calling thread only.
+constexpr ui64 MIN_TRIANGLES_PER_THREAD = 1 << 15;
+
+//! Weight of the normal of a triangle in the normal of a vertex.
+enum Weighting : ui8
+{
+  WEIGHT_ANGLE, //! The angle of the triangle at the vertex. Independent of the tessellation of the surface.
+  WEIGHT_AREA   //! The area of the triangle. Small triangles, e.g., at fans around poles, contribute little.
+};
+
+//! \brief Computes the normal of each vertex.
+//!
+//! Vertices without a triangle of non-zero area receive the normal (0, 0, 1).
+//! \param[out]  normals Receives three floats per vertex, of length 1.
+//! \param[in]  normalsStride Distance between two normals in bytes, e.g., of an interleaved vertex.
+//! \param[in]  indices Three indices per triangle. Triangle (a, b, c) faces along cross(b - a, c - a).
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  positions Three floats per vertex.
+//! \param[in]  positionsStride Distance between two positions in bytes.
+//! \param[in]  nVertices Number of vertices.
+//! \param[in]  weighting Weight of the triangle normals.
+//! \param[in]  nThreads Maximum number of threads. 0 uses one thread per hardware thread.
+void generateNormals(f32* normals, size_t normalsStride, const ui32* indices, ui64 nIndices, const f32* positions,
+                     size_t positionsStride, ui32 nVertices, Weighting weighting = WEIGHT_ANGLE, ui32 nThreads = 0);
+} // namespace MeshNormals
+} // namespace gims
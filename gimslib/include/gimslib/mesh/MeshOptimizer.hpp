@@ -0,0 +1,107 @@
+#pragma once
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+//! \brief Reorders triangles and vertices of indexed triangle meshes for faster rendering.
+//!
+//! The passes are meant to run in the order optimizeVertexCache, optimizeOverdraw, optimizeVertexFetchRemap.
+//! optimizeMesh runs all of them on a CograBinaryMeshFile. All passes only change the order of triangles and vertices,
+//! the rendered image stays the same, except for the order in which overlapping triangles are drawn.
+namespace MeshOptimizer
+{
+//! Number of entries of the FIFO vertex cache that is assumed, if not given otherwise.
+constexpr ui32 DEFAULT_CACHE_SIZE = 16;
+
+//! \brief Efficiency of an index buffer with respect to a FIFO post-transform vertex cache.
+struct VertexCacheStatistics
+{
+  ui64 nTransformedVertices = 0;    //! Number of cache misses, i.e., vertex shader invocations.
+  f32  acmr                 = 0.0f; //! Average cache miss ratio: transformed vertices per triangle, 0.5 to 3.
+  f32  atvr                 = 0.0f; //! Average transform to vertex ratio: transformed per referenced vertex, 1 is best.
+};
+
+//! \brief Statistics before and after optimizeMesh.
+struct MeshOptimizationReport
+{
+  VertexCacheStatistics before;
+  VertexCacheStatistics after;
+};
+
+//! \brief Simulates a FIFO vertex cache.
+//! \param[in]  indices Three indices per triangle.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  nVertices Number of vertices, all indices must be smaller.
+//! \param[in]  cacheSize Number of cache entries.
+VertexCacheStatistics analyzeVertexCache(const ui32* indices, ui64 nIndices, ui32 nVertices,
+                                         ui32 cacheSize = DEFAULT_CACHE_SIZE);
+
+//! \brief Reorders triangles for the post-transform vertex cache with the Tipsify algorithm.
+//!
+//! Sander, Nehab, Barczak: Fast Triangle Reordering for Vertex Locality and Reduced Overdraw, SIGGRAPH 2007.
+//! \param[out]  destination Receives the reordered indices. May be equal to indices.
+//! \param[in]  indices Three indices per triangle.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  nVertices Number of vertices, all indices must be smaller.
+//! \param[in]  cacheSize Number of cache entries to optimize for.
+void optimizeVertexCache(ui32* destination, const ui32* indices, ui64 nIndices, ui32 nVertices,
+                         ui32 cacheSize = DEFAULT_CACHE_SIZE);
+
+//! \brief Reorders clusters of triangles, so that triangles facing outwards are drawn first.
+//!
+//! The index buffer should be optimized with optimizeVertexCache before. It is split into clusters, whose cache
+//! efficiency is at most threshold times worse than before, when drawn in any order. Clusters are then sorted by how
+//! much they face away from the center of the mesh, which draws occluders before occludees for most views.
+//! \param[out]  destination Receives the reordered indices. May be equal to indices.
+//! \param[in]  indices Three indices per triangle.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  positions Three floats per vertex.
+//! \param[in]  nVertices Number of vertices, all indices must be smaller.
+//! \param[in]  threshold Allowed increase of the ACMR, e.g., 1.05 for 5 percent.
+//! \param[in]  cacheSize Number of cache entries.
+void optimizeOverdraw(ui32* destination, const ui32* indices, ui64 nIndices, const f32* positions, ui32 nVertices,
+                      f32 threshold = 1.05f, ui32 cacheSize = DEFAULT_CACHE_SIZE);
+
+//! \brief Computes an order of the vertices in which they are first referenced by the index buffer.
+//!
+//! Vertices that are not referenced are placed at the end.
+//! \param[in]  indices Three indices per triangle.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  nVertices Number of vertices, all indices must be smaller.
+//! \return The new index of every vertex.
+std::vector<ui32> optimizeVertexFetchRemap(const ui32* indices, ui64 nIndices, ui32 nVertices);
+
+//! \brief Replaces every index by its entry in remap.
+void remapIndices(ui32* indices, ui64 nIndices, const std::vector<ui32>& remap);
+
+//! \brief Moves every vertex to the position given by remap.
+//! \param[out]  destination Receives the vertices. Must not overlap source.
+//! \param[in]  source The vertices.
+//! \param[in]  nVertices Number of vertices.
+//! \param[in]  elementSize Size of one vertex in bytes.
+//! \param[in]  remap The new index of every vertex.
+void remapVertices(void* destination, const void* source, ui32 nVertices, size_t elementSize,
+                   const std::vector<ui32>& remap);
+
+//! \brief Moves the positions and all attributes of a mesh to the vertices given by remap, and updates its indices.
+//!
+//! The indices of the levels of detail stored by MeshSimplifier::buildLods are updated alike.
+//! \param[in,out]  mesh The mesh.
+//! \param[in]  remap The new index of every vertex, a permutation.
+void remapMesh(CograBinaryMeshFile& mesh, const std::vector<ui32>& remap);
+
+//! \brief Removes the constants that refer to ranges of triangles, i.e., the meshlets stored by
+//! Meshlets::buildMeshlets. Functions that reorder the triangles of a mesh call it, as such ranges become invalid.
+void removeTriangleOrderConstants(CograBinaryMeshFile& mesh);
+
+//! \brief Optimizes the vertex cache efficiency, overdraw, and vertex fetch locality of a mesh.
+//!
+//! Positions and all attributes are reordered alike, and so are the level of detail indices, see remapMesh. The
+//! meshlets are removed, see removeTriangleOrderConstants, and have to be built again afterwards.
+//! \param[in,out]  mesh The mesh.
+//! \param[in]  overdrawThreshold Allowed increase of the ACMR for overdraw optimization, see optimizeOverdraw.
+//! \return Vertex cache statistics before and after the optimization.
+MeshOptimizationReport optimizeMesh(CograBinaryMeshFile& mesh, f32 overdrawThreshold = 1.05f);
+} // namespace MeshOptimizer
+} // namespace gims
@@ -0,0 +1,116 @@
+#pragma once
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+//! \brief Reduces the number of triangles of indexed triangle meshes with quadric error metrics.
+//!
+//! Garland, Heckbert: Surface Simplification Using Quadric Error Metrics, SIGGRAPH 1997. Edges are collapsed into one
+//! of their vertices, so simplified meshes only need a new index buffer and share the vertex buffer with the original.
+//!
+//! Vertices at the same position with different attributes, e.g., at texture or normal seams, are never moved, which
+//! keeps seams intact. Vertices on the open border of a mesh only move along the border.
+namespace MeshSimplifier
+{
+//! Maximum number of levels of detail built, including the original mesh, if not given otherwise.
+constexpr ui32 DEFAULT_MAX_LODS = 6;
+
+//! Name of the constant the level of detail table is stored in by buildLods.
+constexpr const char* LODS_CONSTANT_NAME = "Lods";
+
+//! Name of the constant the indices of all levels of detail except the original are stored in by buildLods.
+constexpr const char* LOD_INDICES_CONSTANT_NAME = "LodIndices";
+
+//! \brief A per-vertex attribute array that is compared to find seams.
+struct VertexAttributes
+{
+  const void* data          = nullptr; //! Attribute of the first vertex.
+  size_t      elementSize   = 0;       //! Size of the attribute of one vertex in bytes.
+  size_t      strideInBytes = 0;       //! Distance between the attributes of two consecutive vertices in bytes.
+};
+
+//! \brief A level of detail, which is a range of an index buffer holding all levels one after another.
+struct LevelOfDetail
+{
+  ui32 firstIndex = 0;    //! Position of the first index of the level.
+  ui32 nIndices   = 0;    //! Number of indices of the level.
+  f32  error      = 0.0f; //! Estimated distance to the original surface, in the units of the positions.
+};
+static_assert(sizeof(LevelOfDetail) == 12, "Levels of detail are stored as three four byte components.");
+
+//! \brief Simplifies a mesh until it has at most targetNIndices indices, or no edge can be collapsed with an error
+//! below maxError.
+//! \param[out]  destination Receives the indices of the simplified mesh. Must hold nIndices indices, may be equal to
+//! indices.
+//! \param[in]  indices Three indices per triangle.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  positions Three floats per vertex.
+//! \param[in]  nVertices Number of vertices, all indices must be smaller.
+//! \param[in]  targetNIndices Number of indices to reduce the mesh to.
+//! \param[in]  maxError Maximum distance to the input surface, in the units of the positions.
+//! \param[in]  attributes Attributes that must stay attached to their vertex, e.g., normals and texture coordinates.
+//! \param[out]  resultError Receives the estimated distance of the result to the input surface, if not nullptr.
+//! \return Number of indices of the simplified mesh.
+ui64 simplify(ui32* destination, const ui32* indices, ui64 nIndices, const f32* positions, ui32 nVertices,
+              ui64 targetNIndices, f32 maxError, const std::vector<VertexAttributes>& attributes = {},
+              f32* resultError = nullptr);
+
+//! \brief Builds a chain of levels of detail, each with about reduction times the triangles of the previous one.
+//!
+//! The chain ends early, once a level cannot be reduced noticeably. Levels other than the first are optimized for the
+//! vertex cache with MeshOptimizer::optimizeVertexCache.
+//! \param[out]  lodIndices Receives the indices of all levels, starting with the unchanged input.
+//! \param[in]  indices Three indices per triangle.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  positions Three floats per vertex.
+//! \param[in]  nVertices Number of vertices, all indices must be smaller.
+//! \param[in]  attributes Attributes that must stay attached to their vertex, see simplify.
+//! \param[in]  maxLods Maximum number of levels including the input.
+//! \param[in]  reduction Ratio of the number of triangles of two consecutive levels, between 0 and 1.
+//! \return The levels of detail, from finest to coarsest. The errors are measured against the input.
+std::vector<LevelOfDetail> buildLods(std::vector<ui32>& lodIndices, const ui32* indices, ui64 nIndices,
+                                     const f32* positions, ui32 nVertices,
+                                     const std::vector<VertexAttributes>& attributes = {},
+                                     ui32 maxLods = DEFAULT_MAX_LODS, f32 reduction = 0.5f);
+
+//! \brief Builds levels of detail of a mesh and stores them in the constants LODS_CONSTANT_NAME and
+//! LOD_INDICES_CONSTANT_NAME.
+//!
+//! The first level is the triangle index buffer of the mesh, which is not changed. All attributes are kept attached
+//! to their vertices. Existing level of detail constants are replaced.
+//! \param[in,out]  mesh The mesh.
+//! \param[in]  maxLods Maximum number of levels including the mesh itself.
+//! \param[in]  reduction Ratio of the number of triangles of two consecutive levels.
+//! \return The levels of detail. Index ranges refer to the triangle indices followed by the level of detail indices.
+std::vector<LevelOfDetail> buildLods(CograBinaryMeshFile& mesh, ui32 maxLods = DEFAULT_MAX_LODS,
+                                     f32 reduction = 0.5f);
+
+//! \brief Returns the levels of detail stored in a mesh by buildLods.
+//!
+//! If the mesh has none, the mesh itself is returned as the only level.
+//! \param[in]  mesh The mesh.
+//! \param[out]  lodIndices Receives the triangle indices of the mesh followed by the indices of all other levels.
+std::vector<LevelOfDetail> getLods(const CograBinaryMeshFile& mesh, std::vector<ui32>& lodIndices);
+
+//! \brief Selects the coarsest level of detail whose error, projected to the screen, is at most maxScreenSpaceError.
+//! \param[in]  lods The levels of detail, from finest to coarsest.
+//! \param[in]  nLods Number of levels.
+//! \param[in]  pixelsPerUnit Size in pixels of one unit of the positions at the distance of the mesh, see
+//! getPixelsPerUnit.
+//! \param[in]  maxScreenSpaceError Maximum error in pixels.
+//! \return Index of the level of detail.
+ui32 selectLod(const LevelOfDetail* lods, ui32 nLods, f32 pixelsPerUnit, f32 maxScreenSpaceError);
+
+//! \brief Computes how many pixels one unit of the positions of a mesh covers at its closest point to the camera.
+//!
+//! The projection must be a perspective projection.
+//! \param[in]  modelView Transforms from the coordinate system of the mesh to view space.
+//! \param[in]  projection Transforms from view space to clip space.
+//! \param[in]  viewportHeight Height of the viewport in pixels.
+//! \param[in]  boundsMin Lower corner of the axis aligned bounding box of the positions.
+//! \param[in]  boundsMax Upper corner of the axis aligned bounding box of the positions.
+f32 getPixelsPerUnit(const f32m4& modelView, const f32m4& projection, f32 viewportHeight, const f32v3& boundsMin,
+                     const f32v3& boundsMax);
+} // namespace MeshSimplifier
+} // namespace gims
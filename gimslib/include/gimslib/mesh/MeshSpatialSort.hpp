@@ -0,0 +1,64 @@
+#pragma once
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+//! \brief Reorders vertices and triangles along a Morton curve, so that elements close in space are close in memory.
+//!
+//! Positions are quantized to a grid of 2^10 cells per axis over the bounding box of the mesh, and the bits of the
+//! three cell coordinates are interleaved to a 30 bit Morton code. Vertices are sorted by their code, triangles by the
+//! code of their centroid. Sorting uses a parallel least significant digit radix sort, which is stable, so the result
+//! does not depend on the number of threads.
+//!
+//! The order improves the cache locality of passes that walk the vertices or triangles in order, e.g., bounding boxes,
+//! normal generation, or culling. It does not optimize for the post-transform vertex cache, see MeshOptimizer.
+namespace MeshSpatialSort
+{
+//! Arrays with fewer elements are processed by the calling thread only.
+constexpr ui32 MIN_ELEMENTS_PER_THREAD = 1 << 16;
+
+//! Number of bits of a Morton code per axis.
+constexpr ui32 MORTON_BITS_PER_AXIS = 10;
+
+//! \brief Interleaves the bits of three cell coordinates, x in the lowest bit.
+//! \param[in]  x Cell coordinate, smaller than 2^MORTON_BITS_PER_AXIS.
+//! \param[in]  y Cell coordinate, smaller than 2^MORTON_BITS_PER_AXIS.
+//! \param[in]  z Cell coordinate, smaller than 2^MORTON_BITS_PER_AXIS.
+//! \return The 30 bit Morton code.
+ui32 encodeMorton(ui32 x, ui32 y, ui32 z);
+
+//! \brief Sorts indices by their keys with a stable, parallel radix sort.
+//! \param[in]  keys One key per element.
+//! \param[in]  n Number of elements.
+//! \param[in]  nThreads Maximum number of threads. 0 uses one thread per hardware thread.
+//! \return The indices of the elements in ascending order of their keys.
+std::vector<ui32> sortByKey(const ui32* keys, ui32 n, ui32 nThreads = 0);
+
+//! \brief Computes an order of the vertices along the Morton curve.
+//! \param[in]  positions Three floats per vertex.
+//! \param[in]  positionsStride Distance between two positions in bytes.
+//! \param[in]  nVertices Number of vertices.
+//! \param[in]  nThreads Maximum number of threads. 0 uses one thread per hardware thread.
+//! \return The new index of every vertex, see MeshOptimizer::remapVertices.
+std::vector<ui32> computeVertexRemap(const f32* positions, size_t positionsStride, ui32 nVertices, ui32 nThreads = 0);
+
+//! \brief Sorts the triangles of an index buffer along the Morton curve of their centroids.
+//! \param[in,out]  indices Three indices per triangle. The winding of each triangle is kept.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  positions Three floats per vertex.
+//! \param[in]  positionsStride Distance between two positions in bytes.
+//! \param[in]  nVertices Number of vertices, all indices must be smaller.
+//! \param[in]  nThreads Maximum number of threads. 0 uses one thread per hardware thread.
+void sortTriangles(ui32* indices, ui64 nIndices, const f32* positions, size_t positionsStride, ui32 nVertices,
+                   ui32 nThreads = 0);
+
+//! \brief Sorts the triangles and the vertices of a mesh along the Morton curve.
+//!
+//! Positions and all attributes are reordered alike, and so are the level of detail indices, see
+//! MeshOptimizer::remapMesh. The meshlets are removed, see MeshOptimizer::removeTriangleOrderConstants.
+//! \param[in,out]  mesh The mesh.
+//! \param[in]  nThreads Maximum number of threads. 0 uses one thread per hardware thread.
+void sortMesh(CograBinaryMeshFile& mesh, ui32 nThreads = 0);
+} // namespace MeshSpatialSort
+} // namespace gims
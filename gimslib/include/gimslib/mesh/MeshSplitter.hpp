@@ -0,0 +1,58 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+//! \brief Prepares index buffers for 16 bit indices, which halve the index bandwidth and memory.
+//!
+//! Meshes with at most MAX_16_BIT_VERTICES vertices are converted directly. Larger meshes are split into sub-meshes
+//! that are small enough, each with its own vertices. Vertices shared by triangles of different sub-meshes are
+//! duplicated.
+namespace MeshSplitter
+{
+//! Number of vertices that 16 bit indices can address.
+constexpr ui32 MAX_16_BIT_VERTICES = 65536;
+
+//! \brief A part of a mesh with its own vertices.
+struct SubMesh
+{
+  std::vector<ui32> vertexIndices; //! Index of each vertex of the sub-mesh in the vertices of the original mesh.
+  std::vector<ui32> indices;       //! Three indices per triangle into vertexIndices.
+};
+
+//! \brief Returns true, if a mesh with nVertices vertices can be drawn with 16 bit indices.
+bool fits16BitIndices(ui32 nVertices);
+
+//! \brief Converts indices to 16 bits.
+//! \param[out]  destination Receives nIndices indices.
+//! \param[in]  indices The indices, all must be smaller than MAX_16_BIT_VERTICES.
+//! \param[in]  nIndices Number of indices.
+void convertTo16BitIndices(ui16* destination, const ui32* indices, ui64 nIndices);
+
+//! \brief Converts indices to 16 bits.
+//! \param[in]  indices The indices, all must be smaller than MAX_16_BIT_VERTICES.
+//! \return The converted indices.
+std::vector<ui16> convertTo16BitIndices(const std::vector<ui32>& indices);
+
+//! \brief Splits a mesh into sub-meshes with at most maxVertices vertices each.
+//!
+//! Triangles are assigned in their order, and a new sub-mesh is started when the next triangle does not fit anymore.
+//! So the order of the triangles is kept, and sub-meshes are only as compact as the triangle order. The index buffer
+//! should be optimized with MeshOptimizer before, which keeps the number of duplicated vertices low. Vertices are
+//! numbered in the order of their first use and unreferenced vertices are dropped.
+//! \param[in]  indices Three indices per triangle.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  nVertices Number of vertices, all indices must be smaller.
+//! \param[in]  maxVertices Maximum number of vertices per sub-mesh, at least three.
+//! \return The sub-meshes, none if there are no triangles.
+std::vector<SubMesh> splitMesh(const ui32* indices, ui64 nIndices, ui32 nVertices,
+                               ui32 maxVertices = MAX_16_BIT_VERTICES);
+
+//! \brief Copies the vertices of a sub-mesh out of an interleaved vertex buffer.
+//! \param[out]  destination Receives subMesh.vertexIndices.size() vertices.
+//! \param[in]  vertices The interleaved vertices of the original mesh.
+//! \param[in]  vertexSize Size of one vertex in bytes.
+//! \param[in]  subMesh The sub-mesh.
+void gatherVertices(void* destination, const void* vertices, size_t vertexSize, const SubMesh& subMesh);
+} // namespace MeshSplitter
+} // namespace gims
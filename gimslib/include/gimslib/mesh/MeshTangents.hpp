@@ -0,0 +1,63 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+//! \brief Per-vertex tangent frames for normal mapping, following MikkTSpace.
+//!
+//! M. Mikkelsen: Simulation of Wrinkled Surfaces Revisited, Master's thesis, University of Copenhagen, 2008.
+//!
+//! Each triangle contributes the derivative of its position with respect to the first texture coordinate, projected
+//! onto the tangent plane of the vertex normal and weighted by the angle of the triangle at the vertex. The tangent of
+//! a vertex is the normalized sum. Its fourth component is the handedness: the bitangent, the derivative with respect
+//! to the second texture coordinate, points along w * cross(normal, tangent). Shaders reconstruct it from the
+//! interpolated, unnormalized normal and tangent, as MikkTSpace requires.
+//!
+//! Triangles with mirrored texture coordinates have the opposite handedness. MikkTSpace does not average across
+//! such seams but splits the vertex, which splitMirroredVertices does before generateTangents. The handedness is
+//! taken from the positions and the vertex normal, so it stays correct for meshes that are mirrored on import, e.g.,
+//! when converting to a left-handed coordinate system.
+//!
+//! Triangles are processed in parallel, and each vertex gathers the contributions of its triangles, so the results do
+//! not depend on the number of threads.
+namespace MeshTangents
+{
+//! Meshes with fewer vertices are processed by the calling thread only.
+constexpr ui32 MIN_VERTICES_PER_THREAD = 1 << 14;
+
+//! \brief Duplicates vertices shared by triangles with mirrored texture coordinates, so that each vertex has one
+//! handedness. Vertices are split toward the handedness with the larger sum of angles, the triangles of the other
+//! handedness are changed to use the copy.
+//! \param[in,out]  indices Three indices per triangle. Indices of split vertices are changed to the copies.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  positions Three floats per vertex.
+//! \param[in]  normals Three floats per vertex.
+//! \param[in]  textureCoordinates Two floats per vertex.
+//! \param[in]  stride Distance between two vertices of the attribute arrays in bytes, e.g., of an interleaved vertex.
+//! \param[in]  nVertices Number of vertices.
+//! \param[in]  nThreads Maximum number of threads. 0 uses one thread per hardware thread.
+//! \return The original of each copy: vertex nVertices + i is a copy of vertex result[i], and has to be appended by
+//! the caller.
+std::vector<ui32> splitMirroredVertices(ui32* indices, ui64 nIndices, const f32* positions, const f32* normals,
+                                        const f32* textureCoordinates, size_t stride, ui32 nVertices,
+                                        ui32 nThreads = 0);
+
+//! \brief Computes the tangent of each vertex.
+//!
+//! Vertices without a triangle of non-zero area in texture space receive an arbitrary tangent perpendicular to the
+//! normal. If a vertex still has triangles of both handedness, the handedness with the larger sum of angles wins.
+//! \param[out]  tangents Receives four floats per vertex, the tangent of length 1 and the handedness, +1 or -1.
+//! \param[in]  tangentsStride Distance between two tangents in bytes.
+//! \param[in]  indices Three indices per triangle.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  positions Three floats per vertex.
+//! \param[in]  normals Three floats per vertex, of length 1.
+//! \param[in]  textureCoordinates Two floats per vertex.
+//! \param[in]  stride Distance between two vertices of the attribute arrays in bytes, e.g., of an interleaved vertex.
+//! \param[in]  nVertices Number of vertices.
+//! \param[in]  nThreads Maximum number of threads. 0 uses one thread per hardware thread.
+void generateTangents(f32* tangents, size_t tangentsStride, const ui32* indices, ui64 nIndices, const f32* positions,
+                      const f32* normals, const f32* textureCoordinates, size_t stride, ui32 nVertices,
+                      ui32 nThreads = 0);
+} // namespace MeshTangents
+} // namespace gims
@@ -0,0 +1,68 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+//! \brief Joins identical vertices of indexed triangle meshes and removes triangles that do not contribute to the image.
+//!
+//! Importers often emit three vertices per triangle, or split vertices per face. Welding finds vertices whose
+//! attributes are equal after quantization with an open-addressing hash table, so it runs in linear time and needs no
+//! sorting. Only the first vertex of a group of equal vertices is kept.
+namespace MeshWelder
+{
+//! \brief An attribute of the vertices that is compared when welding, e.g., the positions.
+struct VertexStream
+{
+  const f32* data             = nullptr; //! First component of the first vertex.
+  ui32       nComponents      = 0;       //! Number of floats per vertex.
+  size_t     strideInBytes    = 0;       //! Distance between the attributes of two consecutive vertices in bytes.
+  f32        quantizationStep = 0.0f;    //! Components are rounded to multiples of this, 0 compares them exactly.
+};
+
+//! \brief Sizes of a mesh before and after welding.
+struct WeldReport
+{
+  ui64 nVerticesBefore      = 0;
+  ui64 nVerticesAfter       = 0;
+  ui64 nTrianglesBefore     = 0;
+  ui64 nTrianglesAfter      = 0;
+  ui64 nDegenerateTriangles = 0; //! Triangles that referenced a vertex more than once after welding.
+  ui64 nDuplicateTriangles  = 0; //! Triangles that repeated an earlier triangle with the same winding.
+
+  //! \brief Adds the counts of another report, e.g., to sum up all meshes of a scene.
+  void add(const WeldReport& other);
+};
+
+//! \brief Assigns the same new index to all vertices whose streams are equal after quantization.
+//!
+//! New indices are assigned in the order in which the first vertex of each group appears, so remap[v] <= v.
+//! \param[out]  remap Receives the new index of every vertex.
+//! \param[in]  nVertices Number of vertices.
+//! \param[in]  streams The attributes that are compared. Vertices are equal, if all their streams are equal.
+//! \return Number of unique vertices.
+ui32 generateVertexRemap(std::vector<ui32>& remap, ui32 nVertices, const std::vector<VertexStream>& streams);
+
+//! \brief Removes triangles that reference a vertex more than once, and triangles that repeat an earlier triangle.
+//!
+//! Triangles are equal, if they reference the same vertices with the same winding, so both sides of two-sided geometry
+//! are kept. The order of the remaining triangles is not changed.
+//! \param[in,out]  indices Three indices per triangle. The remaining triangles are moved to the front.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[out]  nDegenerate Receives the number of triangles that referenced a vertex more than once, if not nullptr.
+//! \param[out]  nDuplicate Receives the number of repeated triangles, if not nullptr.
+//! \return Number of remaining indices.
+ui64 removeRedundantTriangles(ui32* indices, ui64 nIndices, ui64* nDegenerate = nullptr, ui64* nDuplicate = nullptr);
+
+//! \brief Welds the vertices of a mesh with an interleaved vertex buffer and removes redundant triangles.
+//!
+//! Vertices that are no longer referenced afterwards are removed as well. The vertex buffer is compacted in place.
+//! \param[in,out]  vertices The interleaved vertices.
+//! \param[in,out]  nVertices Number of vertices, receives the number of remaining vertices.
+//! \param[in]  vertexSize Size of one vertex in bytes.
+//! \param[in,out]  indices Three indices per triangle, all must be smaller than nVertices.
+//! \param[in]  streams The attributes that are compared, pointing into vertices.
+//! \return Sizes of the mesh before and after welding.
+WeldReport weldMesh(void* vertices, ui32& nVertices, size_t vertexSize, std::vector<ui32>& indices,
+                    const std::vector<VertexStream>& streams);
+} // namespace MeshWelder
+} // namespace gims
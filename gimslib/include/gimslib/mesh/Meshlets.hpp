@@ -0,0 +1,108 @@
+#pragma once
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+namespace gims
+{
+//! \brief Splits indexed triangle meshes into small clusters of triangles (meshlets) that can be culled individually.
+//!
+//! Each meshlet is a contiguous range of the index buffer, so visible meshlets can be drawn with one
+//! DrawIndexedInstanced per range of consecutive visible meshlets, without changing the vertex buffer or the shaders.
+//! Every meshlet stores a bounding sphere for frustum culling and a cone around the normals of its triangles for
+//! back-face culling.
+namespace Meshlets
+{
+//! Maximum number of unique vertices per meshlet, if not given otherwise.
+constexpr ui32 DEFAULT_MAX_VERTICES = 64;
+
+//! Maximum number of triangles per meshlet, if not given otherwise.
+constexpr ui32 DEFAULT_MAX_TRIANGLES = 124;
+
+//! Name of the constant meshlets are stored in by buildMeshlets.
+constexpr const char* CONSTANT_NAME = "Meshlets";
+
+//! \brief A cluster of triangles and its bounds, in the coordinate system of the positions.
+struct Meshlet
+{
+  ui32  firstIndex = 0;    //! Position of the first index of the meshlet in the index buffer.
+  ui32  nIndices   = 0;    //! Three times the number of triangles.
+  ui32  nVertices  = 0;    //! Number of unique vertices referenced by the triangles.
+  ui32  reserved   = 0;    //! Keeps the bounds 16 byte aligned.
+  f32v3 center;            //! Center of the bounding sphere.
+  f32   radius = 0.0f;     //! Radius of the bounding sphere.
+  f32v3 coneAxis;          //! Average direction of the triangle normals, zero if the normals are too diverse.
+  f32   coneCutoff = 1.0f; //! Sine of the opening angle of the normal cone, 1 if back-face culling is impossible.
+};
+static_assert(sizeof(Meshlet) == 48, "Meshlets are stored as 12 four byte components.");
+
+//! \brief A range of the index buffer that is drawn with one draw call.
+struct DrawRange
+{
+  ui32 firstIndex = 0; //! Position of the first index in the index buffer.
+  ui32 nIndices   = 0; //! Number of indices.
+};
+
+//! \brief Everything needed to cull the meshlets of one mesh instance, in the coordinate system of its positions.
+struct CullingView
+{
+  f32v4 planes[6];            //! Left, right, bottom, top, near, and far plane. Normals point inwards, length 1.
+  f32v3 cameraPosition;       //! Camera position.
+  bool  cullBackFaces = true; //! If false, only frustum culling is performed.
+};
+
+//! \brief Splits an index buffer into meshlets and reorders its triangles, so that every meshlet is a contiguous range.
+//!
+//! Meshlets are grown greedily from triangles that share vertices with the meshlet and whose normals point in a
+//! similar direction. The order of the input is kept as far as possible, so the index buffer should be optimized with
+//! MeshOptimizer before.
+//! \param[out]  destination Receives the reordered indices. May be equal to indices.
+//! \param[in]  indices Three indices per triangle.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  positions Three floats per vertex.
+//! \param[in]  nVertices Number of vertices, all indices must be smaller.
+//! \param[in]  maxVertices Maximum number of unique vertices per meshlet, at least three.
+//! \param[in]  maxTriangles Maximum number of triangles per meshlet, at least one.
+//! \return The meshlets in the order of the reordered index buffer.
+std::vector<Meshlet> buildMeshlets(ui32* destination, const ui32* indices, ui64 nIndices, const f32* positions,
+                                   ui32 nVertices, ui32 maxVertices = DEFAULT_MAX_VERTICES,
+                                   ui32 maxTriangles = DEFAULT_MAX_TRIANGLES);
+
+//! \brief Splits a mesh into meshlets and stores them in the constant CONSTANT_NAME.
+//!
+//! Reorders the triangles of the mesh. Functions that reorder triangles afterwards, e.g., MeshOptimizer::optimizeMesh,
+//! remove the meshlets, so this should be the last step. An existing meshlet constant is replaced.
+//! \param[in,out]  mesh The mesh.
+//! \param[in]  maxVertices Maximum number of unique vertices per meshlet.
+//! \param[in]  maxTriangles Maximum number of triangles per meshlet.
+//! \return The meshlets.
+std::vector<Meshlet> buildMeshlets(CograBinaryMeshFile& mesh, ui32 maxVertices = DEFAULT_MAX_VERTICES,
+                                   ui32 maxTriangles = DEFAULT_MAX_TRIANGLES);
+
+//! \brief Returns the meshlets stored in a mesh by buildMeshlets, or an empty vector if it has none.
+std::vector<Meshlet> getMeshlets(const CograBinaryMeshFile& mesh);
+
+//! \brief Creates the culling view for a mesh instance.
+//!
+//! The planes are extracted from projection * modelView, so they are expressed in the coordinate system of the mesh.
+//! The projection must be a perspective projection mapping depth to [0, 1], as used by Direct3D.
+//! \param[in]  modelView Transforms from the coordinate system of the mesh to view space.
+//! \param[in]  projection Transforms from view space to clip space.
+//! \param[in]  cullBackFaces If false, only frustum culling is performed. Must be false, if back faces are drawn.
+CullingView createCullingView(const f32m4& modelView, const f32m4& projection, bool cullBackFaces = true);
+
+//! \brief Tests whether a meshlet may be visible. Conservative, visible meshlets are never culled.
+//!
+//! A meshlet is culled, if its bounding sphere is outside the frustum, or if the camera is behind the planes of all its
+//! triangles. A triangle is back-facing, if the camera is on the side its normal cross(p1 - p0, p2 - p0) points away
+//! from.
+bool isVisible(const Meshlet& meshlet, const CullingView& view);
+
+//! \brief Culls meshlets and merges the remaining ones into as few draw ranges as possible.
+//! \param[out]  ranges Receives the ranges of the index buffer to draw. Cleared first.
+//! \param[in]  meshlets The meshlets in the order of the index buffer.
+//! \param[in]  nMeshlets Number of meshlets.
+//! \param[in]  view The culling view, see createCullingView.
+//! \return Number of visible meshlets.
+ui32 cullMeshlets(std::vector<DrawRange>& ranges, const Meshlet* meshlets, ui32 nMeshlets, const CullingView& view);
+} // namespace Meshlets
+} // namespace gims
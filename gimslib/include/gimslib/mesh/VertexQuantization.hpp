@@ -0,0 +1,172 @@
+#pragma once
+#include <gimslib/types.hpp>
+namespace gims
+{
+//! \brief Compact encodings of vertex attributes for GPU vertex buffers.
+//!
+//! All encodings can be decoded by the input assembler with a standard DXGI format. Only two steps are left to the
+//! vertex shader: positions are scaled from [0, 1] to the bounding box, and octahedral normals are unfolded.
+//!
+//! Attribute arrays are given with a stride, so interleaved vertex buffers can be read and written directly. Four
+//! vertices are converted at a time with SSE2, if available. The scalar path computes the same operations in the same
+//! order, so both produce identical bits.
+//!
+//! Error bounds, for inputs in range:
+//! - POSITION_UNORM16: at most 0.5 / 65535 of the extent of the bounding box per axis, plus float rounding.
+//! - NORMAL_OCTAHEDRAL_SNORM16: at most 0.0004 radians between the decoded and the input normal.
+//! - NORMAL_UNORM10_10_10_2: at most 0.5 / 1023 * 2 per component before renormalization, about 0.0017 radians.
+//! - TEXTURE_COORDINATE_HALF2: at most 2^-11 relative to the coordinate, e.g., 2^-12 for coordinates in [0.5, 1).
+//! - TANGENT_SNORM16: at most 0.5 / 32767 per component, about 0.00003 radians for tangents of length 1.
+namespace VertexQuantization
+{
+//! Encoding of the positions.
+enum PositionFormat : ui8
+{
+  POSITION_FLOAT3, //! Three floats, 12 bytes.
+  POSITION_UNORM16 //! Four 16 bit unsigned normalized integers relative to the bounding box, the fourth is 0. 8 bytes.
+};
+
+//! Encoding of the normals.
+enum NormalFormat : ui8
+{
+  NORMAL_FLOAT3,             //! Three floats, 12 bytes.
+  NORMAL_OCTAHEDRAL_SNORM16, //! Octahedral mapping to two 16 bit signed normalized integers, 4 bytes.
+  NORMAL_UNORM10_10_10_2     //! Components mapped to [0, 1] as three 10 bit unsigned normalized integers, 4 bytes.
+};
+
+//! Encoding of the texture coordinates.
+enum TextureCoordinateFormat : ui8
+{
+  TEXTURE_COORDINATE_FLOAT2, //! Two floats, 8 bytes.
+  TEXTURE_COORDINATE_HALF2   //! Two half floats, 4 bytes.
+};
+
+//! Encoding of the tangents. The fourth component is the handedness of the tangent frame, +1 or -1.
+enum TangentFormat : ui8
+{
+  TANGENT_NONE,   //! No tangent stream, 0 bytes.
+  TANGENT_FLOAT4, //! Four floats, 16 bytes.
+  TANGENT_SNORM16 //! Four 16 bit signed normalized integers, 8 bytes.
+};
+
+//! \brief The encoding of each attribute of an interleaved vertex with position, normal, texture coordinate, and an
+//! optional tangent. Tangents are only needed for normal mapping, so there is no tangent stream by default.
+struct VertexFormat
+{
+  PositionFormat          position          = POSITION_UNORM16;
+  NormalFormat            normal            = NORMAL_OCTAHEDRAL_SNORM16;
+  TextureCoordinateFormat textureCoordinate = TEXTURE_COORDINATE_HALF2;
+  TangentFormat           tangent           = TANGENT_NONE;
+};
+
+//! The format of uncompressed vertices, 32 bytes.
+constexpr VertexFormat UNCOMPRESSED_VERTEX_FORMAT = {POSITION_FLOAT3, NORMAL_FLOAT3, TEXTURE_COORDINATE_FLOAT2};
+
+//! \brief Byte offsets of the attributes inside an interleaved vertex.
+struct VertexLayout
+{
+  ui32 positionOffset          = 0;
+  ui32 normalOffset            = 0;
+  ui32 textureCoordinateOffset = 0;
+  ui32 tangentOffset           = 0; //! Behind the texture coordinate, equal to stride for TANGENT_NONE.
+  ui32 stride                  = 0; //! Size of one vertex in bytes, a multiple of four.
+};
+
+//! \brief Maps encoded positions in [0, 1] back to the bounding box: position = offset + scale * encoded.
+struct PositionDequantization
+{
+  f32v3 offset = f32v3(0.0f);
+  f32v3 scale  = f32v3(1.0f);
+};
+
+//! \brief Returns where each attribute of a vertex with the given format is stored.
+VertexLayout getVertexLayout(const VertexFormat& format);
+
+//! \brief Returns the dequantization of positions inside a bounding box, or the identity for POSITION_FLOAT3.
+PositionDequantization getPositionDequantization(PositionFormat format, const f32v3& boundsMin, const f32v3& boundsMax);
+
+//! \brief Encodes positions as POSITION_UNORM16.
+//! \param[out]  destination Receives four ui16 per vertex.
+//! \param[in]  destinationStride Distance between two encoded positions in bytes.
+//! \param[in]  positions Three floats per vertex, inside the bounding box of dequantization.
+//! \param[in]  positionsStride Distance between two positions in bytes.
+//! \param[in]  nVertices Number of vertices.
+//! \param[in]  dequantization The bounding box, see getPositionDequantization.
+void encodePositionsUnorm16(void* destination, size_t destinationStride, const f32* positions, size_t positionsStride,
+                            ui32 nVertices, const PositionDequantization& dequantization);
+
+//! \brief Decodes positions encoded by encodePositionsUnorm16.
+void decodePositionsUnorm16(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride,
+                            ui32 nVertices, const PositionDequantization& dequantization);
+
+//! \brief Encodes normals of length 1 as NORMAL_OCTAHEDRAL_SNORM16. Zero vectors are encoded as (0, 0, 1).
+//! \param[out]  destination Receives two i16 per vertex.
+//! \param[in]  destinationStride Distance between two encoded normals in bytes.
+//! \param[in]  normals Three floats per vertex.
+//! \param[in]  normalsStride Distance between two normals in bytes.
+//! \param[in]  nVertices Number of vertices.
+void encodeNormalsOctahedral(void* destination, size_t destinationStride, const f32* normals, size_t normalsStride,
+                             ui32 nVertices);
+
+//! \brief Decodes normals encoded by encodeNormalsOctahedral. The results have length 1.
+void decodeNormalsOctahedral(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride,
+                             ui32 nVertices);
+
+//! \brief Encodes normals with components in [-1, 1] as NORMAL_UNORM10_10_10_2. The two alpha bits are 0.
+//! \param[out]  destination Receives one ui32 per vertex.
+//! \param[in]  destinationStride Distance between two encoded normals in bytes.
+//! \param[in]  normals Three floats per vertex.
+//! \param[in]  normalsStride Distance between two normals in bytes.
+//! \param[in]  nVertices Number of vertices.
+void encodeNormalsUnorm10(void* destination, size_t destinationStride, const f32* normals, size_t normalsStride,
+                          ui32 nVertices);
+
+//! \brief Decodes normals encoded by encodeNormalsUnorm10. The results are not renormalized.
+void decodeNormalsUnorm10(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride,
+                          ui32 nVertices);
+
+//! \brief Encodes texture coordinates as TEXTURE_COORDINATE_HALF2, rounding to nearest even.
+//! \param[out]  destination Receives two IEEE 754 half floats per vertex.
+//! \param[in]  destinationStride Distance between two encoded texture coordinates in bytes.
+//! \param[in]  textureCoordinates Two floats per vertex.
+//! \param[in]  textureCoordinatesStride Distance between two texture coordinates in bytes.
+//! \param[in]  nVertices Number of vertices.
+void encodeTextureCoordinatesHalf(void* destination, size_t destinationStride, const f32* textureCoordinates,
+                                  size_t textureCoordinatesStride, ui32 nVertices);
+
+//! \brief Decodes texture coordinates encoded by encodeTextureCoordinatesHalf.
+void decodeTextureCoordinatesHalf(f32* destination, size_t destinationStride, const void* encoded,
+                                  size_t encodedStride, ui32 nVertices);
+
+//! \brief Encodes tangents with components in [-1, 1] as TANGENT_SNORM16, rounding half away from zero.
+//! \param[out]  destination Receives four i16 per vertex.
+//! \param[in]  destinationStride Distance between two encoded tangents in bytes.
+//! \param[in]  tangents Four floats per vertex, the direction and the handedness.
+//! \param[in]  tangentsStride Distance between two tangents in bytes.
+//! \param[in]  nVertices Number of vertices.
+void encodeTangentsSnorm16(void* destination, size_t destinationStride, const f32* tangents, size_t tangentsStride,
+                           ui32 nVertices);
+
+//! \brief Decodes tangents encoded by encodeTangentsSnorm16. The results are not renormalized.
+void decodeTangentsSnorm16(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride,
+                           ui32 nVertices);
+
+//! \brief Encodes vertices into an interleaved vertex buffer with the layout getVertexLayout(format).
+//! \param[out]  destination Receives nVertices * getVertexLayout(format).stride bytes.
+//! \param[in]  format The encoding of each attribute.
+//! \param[in]  positions Three floats per vertex.
+//! \param[in]  normals Three floats per vertex.
+//! \param[in]  textureCoordinates Two floats per vertex.
+//! \param[in]  sourceStride Distance between two vertices of the source arrays in bytes, e.g., of an interleaved
+//! vertex.
+//! \param[in]  nVertices Number of vertices.
+//! \param[in]  dequantization The bounding box of the positions, see getPositionDequantization.
+//! \param[in]  tangents Four floats per vertex, required unless format.tangent is TANGENT_NONE.
+//! \param[in]  tangentsStride Distance between two tangents in bytes. Tangents are usually kept in an array of their
+//! own, as only meshes with normal maps have them.
+void encodeVertices(void* destination, const VertexFormat& format, const f32* positions, const f32* normals,
+                    const f32* textureCoordinates, size_t sourceStride, ui32 nVertices,
+                    const PositionDequantization& dequantization, const f32* tangents = nullptr,
+                    size_t tangentsStride = 4 * sizeof(f32));
+} // namespace VertexQuantization
+} // namespace gims
@@ -0,0 +1,77 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+namespace gims
+{
+//! \brief Fixed number of worker threads with one task queue each.
+//!
+//! Tasks submitted from outside the pool are distributed round robin over the queues. Tasks submitted by a task are
+//! queued at the worker executing it. Workers execute the tasks of their own queue in submission order. A worker whose
+//! queue is empty steals tasks from the queues of the other workers, so no worker idles while tasks are waiting.
+class ThreadPool
+{
+public:
+  //! \brief Starts the worker threads.
+  //! \param[in]  nThreads Number of worker threads. 0 uses one thread per hardware thread.
+  explicit ThreadPool(ui32 nThreads = 0);
+
+  //! \brief Waits until all submitted tasks are finished and stops the worker threads.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool& other)            = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  //! \brief Queues a task.
+  //! \param[in]  task The task. Exceptions thrown by the task are stored in the returned future.
+  //! \return Future that becomes ready when the task is finished.
+  std::future<void> submit(std::function<void()> task);
+
+  //! \brief Returns the number of worker threads.
+  ui32 getNumThreads() const;
+
+private:
+  //! Task queue of one worker.
+  struct Queue
+  {
+    std::mutex                             mutex;
+    std::deque<std::packaged_task<void()>> tasks;
+  };
+
+  //! Executes tasks until the pool is stopped.
+  //! \param[in]  workerIdx Index of the worker, which is also the index of its queue.
+  void work(ui32 workerIdx);
+
+  //! \brief Takes the next task from the queue of a worker or steals one from the other queues.
+  //! \return False, if all queues are empty.
+  bool takeTask(ui32 workerIdx, std::packaged_task<void()>& task);
+
+  //! The worker threads.
+  std::vector<std::thread> m_threads;
+
+  //! One queue per worker thread.
+  std::vector<std::unique_ptr<Queue>> m_queues;
+
+  //! Queue that receives the next task submitted from outside the pool.
+  std::atomic<ui32> m_nextQueue = 0;
+
+  //! Number of tasks that are queued but not yet taken.
+  std::atomic<ui64> m_nPendingTasks = 0;
+
+  //! Protects sleeping and waking up of the workers.
+  std::mutex m_mutex;
+
+  //! Signals new tasks or stopping to the worker threads.
+  std::condition_variable m_condition;
+
+  //! True, if the worker threads should exit once all queues are empty.
+  bool m_stop = false;
+};
+} // namespace gims
@@ -0,0 +1,84 @@
+#include <gimslib/d3d/VertexFormatD3D12.hpp>
+#include <stdexcept>
+
+namespace
+{
+DXGI_FORMAT getDxgiFormat(gims::VertexQuantization::PositionFormat format)
+{
+  switch (format)
+  {
+  case gims::VertexQuantization::POSITION_FLOAT3:
+    return DXGI_FORMAT_R32G32B32_FLOAT;
+  case gims::VertexQuantization::POSITION_UNORM16:
+    return DXGI_FORMAT_R16G16B16A16_UNORM;
+  default:
+    throw std::runtime_error("Unknown position format.");
+  }
+}
+
+DXGI_FORMAT getDxgiFormat(gims::VertexQuantization::NormalFormat format)
+{
+  switch (format)
+  {
+  case gims::VertexQuantization::NORMAL_FLOAT3:
+    return DXGI_FORMAT_R32G32B32_FLOAT;
+  case gims::VertexQuantization::NORMAL_OCTAHEDRAL_SNORM16:
+    return DXGI_FORMAT_R16G16_SNORM;
+  case gims::VertexQuantization::NORMAL_UNORM10_10_10_2:
+    return DXGI_FORMAT_R10G10B10A2_UNORM;
+  default:
+    throw std::runtime_error("Unknown normal format.");
+  }
+}
+
+DXGI_FORMAT getDxgiFormat(gims::VertexQuantization::TextureCoordinateFormat format)
+{
+  switch (format)
+  {
+  case gims::VertexQuantization::TEXTURE_COORDINATE_FLOAT2:
+    return DXGI_FORMAT_R32G32_FLOAT;
+  case gims::VertexQuantization::TEXTURE_COORDINATE_HALF2:
+    return DXGI_FORMAT_R16G16_FLOAT;
+  default:
+    throw std::runtime_error("Unknown texture coordinate format.");
+  }
+}
+
+DXGI_FORMAT getDxgiFormat(gims::VertexQuantization::TangentFormat format)
+{
+  switch (format)
+  {
+  case gims::VertexQuantization::TANGENT_FLOAT4:
+    return DXGI_FORMAT_R32G32B32A32_FLOAT;
+  case gims::VertexQuantization::TANGENT_SNORM16:
+    return DXGI_FORMAT_R16G16B16A16_SNORM;
+  default:
+    throw std::runtime_error("Unknown tangent format.");
+  }
+}
+} // namespace
+
+namespace gims
+{
+namespace VertexQuantization
+{
+std::vector<D3D12_INPUT_ELEMENT_DESC> createInputElementDescs(const VertexFormat& format, ui32 inputSlot)
+{
+  const VertexLayout                    layout = getVertexLayout(format);
+  std::vector<D3D12_INPUT_ELEMENT_DESC> result = {
+      {"POSITION", 0, getDxgiFormat(format.position), inputSlot, layout.positionOffset,
+       D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+      {"NORMAL", 0, getDxgiFormat(format.normal), inputSlot, layout.normalOffset,
+       D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+      {"TEXCOORD", 0, getDxgiFormat(format.textureCoordinate), inputSlot, layout.textureCoordinateOffset,
+       D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+  };
+  if (format.tangent != TANGENT_NONE)
+  {
+    result.push_back({"TANGENT", 0, getDxgiFormat(format.tangent), inputSlot, layout.tangentOffset,
+                      D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0});
+  }
+  return result;
+}
+} // namespace VertexQuantization
+} // namespace gims
@@ -1,55 +1,284 @@
 /// Cogra --- Coburg Graphics Framework
 /// (C) 2017-2022 by Quirin Meyer
 /// quirin.meyer@hs-coburg.de
+#include "impl/CograBinaryMeshCodec.hpp"
+#include "impl/CograBinaryMeshLayout.hpp"
+#include "impl/Crc32.hpp"
+#include "impl/PositionalFileReader.hpp"
 #include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/mesh/MeshNormals.hpp>
+#include <gimslib/mesh/MeshOptimizer.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
 #include <istream>
+#include <limits>
+#include <new>
+#include <numeric>
 #include <ostream>
+#include <stdexcept>
+#include <utility>
 
-namespace gims
+namespace
+{
+//! A payload of a file and the memory it is read to.
+struct SectionRead
 {
+  gims::impl::CograBinaryMeshSection section;
+  void*                              data;
+};
 
-CograBinaryMeshFile::CograBinaryMeshFile(const CograBinaryMeshFile& other)
+//! Opens a file and reads its layout. Optionally returns the size of the file.
+gims::impl::CograBinaryMeshLayout readLayout(const std::string& fileName, gims::ui64* fileSize)
 {
-  m_positions              = other.m_positions;
-  m_triangles              = other.m_triangles;
-  m_attributeComponents    = other.m_attributeComponents;
-  m_attributeComponentSize = other.m_attributeComponentSize;
-  m_constantComponents     = other.m_constantComponents;
-  m_constantComponentSize  = other.m_constantComponentSize;
+  std::ifstream inFile;
+  inFile.open(fileName, std::ios::in | std::ios::binary | std::ios::ate);
+  if (!inFile.is_open())
+  {
+    throw std::runtime_error("Error opening file " + fileName + ".");
+  }
+  const auto size = static_cast<gims::ui64>(inFile.tellg());
+  inFile.seekg(0);
+  if (fileSize != nullptr)
+  {
+    *fileSize = size;
+  }
+  return gims::impl::readCograBinaryMeshLayout(inFile, size);
+}
 
-  for (size_t i = 0; i < other.m_attributes.size(); i++)
+//! Adds the reads of a payload, one per chunk if the payload is stored in several chunks.
+void addSectionReads(std::vector<SectionRead>& reads, const gims::impl::CograBinaryMeshSection& section, void* data)
+{
+  if (section.chunks.empty())
   {
-    const auto nBytes   = m_attributeComponents[i] * m_attributeComponentSize[i] * getNumVertices();
-    m_attributes[i]     = new ui8[nBytes];
-    m_attributeNames[i] = new char[N_CHARS];
-    std::copy(other.m_attributes[i], other.m_attributes[i] + nBytes, m_attributes[i]);
-    std::copy(other.m_attributeNames[i], other.m_attributeNames[i] + sizeof(char) * N_CHARS, m_attributeNames[i]);
+    reads.push_back({section, data});
+    return;
   }
+  auto* destination = static_cast<gims::ui8*>(data);
+  for (const auto& chunk : section.chunks)
+  {
+    reads.push_back({chunk, destination});
+    destination += chunk.sizeInBytes;
+  }
+}
 
-  for (SizeType i = 0; i < getNumConstants(); i++)
+//! \brief Reads payloads with positional reads, concurrently if nThreads is not 1.
+//!
+//! Each payload is read by a single task, which verifies its checksum and decodes it right after the read while the
+//! data is still in the cache.
+void readSections(const std::string& fileName, const std::vector<SectionRead>& reads,
+                  const gims::impl::CograBinaryMeshLayout& layout, gims::ui32 nThreads, bool verifyChecksums)
+{
+  const gims::impl::PositionalFileReader file(fileName);
+  const auto                             readSection = [&](const SectionRead& r)
+  {
+    std::vector<gims::ui8> encoded;
+    void*                  stored = r.data;
+    if (r.section.encoding != gims::impl::ENCODING_RAW)
+    {
+      encoded.resize(r.section.storedSizeInBytes);
+      stored = encoded.data();
+    }
+    file.read(r.section.offset, stored, r.section.storedSizeInBytes);
+    if (verifyChecksums && gims::impl::crc32(stored, r.section.storedSizeInBytes) != r.section.checksum)
+    {
+      throw std::runtime_error("Checksum mismatch in file " + fileName + ".");
+    }
+    if (r.section.encoding != gims::impl::ENCODING_RAW)
+    {
+      gims::impl::decodeCograBinaryMeshSection(r.section, encoded.data(), r.data, layout);
+    }
+  };
+
+  if (nThreads == 0)
   {
-    const auto nBytes  = m_constantComponents[i] * m_constantComponentSize[i];
-    m_constants[i]     = new ui8[nBytes];
-    m_constantNames[i] = new char[N_CHARS];
-    std::copy(other.m_constants[i], other.m_constants[i] + nBytes, m_constants[i]);
-    std::copy(other.m_constantNames[i], other.m_constantNames[i] + sizeof(char) * N_CHARS, m_constantNames[i]);
+    nThreads = std::max(1u, std::thread::hardware_concurrency());
   }
+  nThreads = std::min(nThreads, static_cast<gims::ui32>(reads.size()));
+  if (nThreads <= 1)
+  {
+    for (const auto& r : reads)
+    {
+      readSection(r);
+    }
+    return;
+  }
+
+  // Largest payloads first, so the small ones fill the gaps at the end.
+  std::vector<size_t> order(reads.size());
+  std::iota(order.begin(), order.end(), size_t(0));
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+            { return reads[a].section.storedSizeInBytes > reads[b].section.storedSizeInBytes; });
+
+  gims::ThreadPool               pool(nThreads);
+  std::vector<std::future<void>> futures;
+  for (const auto i : order)
+  {
+    futures.push_back(pool.submit([&, i] { readSection(reads[i]); }));
+  }
+  for (auto& f : futures)
+  {
+    f.wait();
+  }
+  for (auto& f : futures)
+  {
+    f.get();
+  }
+}
+
+void writeSection(std::ostream& outFile, const gims::impl::CograBinaryMeshSection& section, const void* data)
+{
+  gims::impl::writePadding(outFile, section.offset);
+  outFile.write(static_cast<const char*>(data), static_cast<std::streamsize>(section.storedSizeInBytes));
+}
+
+//! A payload of a file and the memory it is written from.
+struct SectionWrite
+{
+  gims::impl::CograBinaryMeshSection* section;
+  const void*                         data;
+  std::vector<gims::ui8>              encoded;
+};
+
+//! True, if an attribute looks like an array of unit normal vectors.
+bool isNormal(std::string name, gims::ui32 components, gims::ui32 componentSize)
+{
+  std::transform(name.begin(), name.end(), name.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+  return name.find("normal") != std::string::npos && components == 3 && componentSize == sizeof(gims::f32);
+}
+
+gims::impl::CograBinaryMeshLayout createLayout(const gims::CograBinaryMeshFile&               cbm,
+                                               gims::CograBinaryMeshFile::CompressionLevel compression)
+{
+  using namespace gims::impl;
+  const bool lossless = compression != gims::CograBinaryMeshFile::COMPRESSION_NONE;
+  const bool lossy    = compression == gims::CograBinaryMeshFile::COMPRESSION_LOSSY && cbm.getNumVertices() != 0;
+
+  CograBinaryMeshLayout result;
+  result.nVertices             = cbm.getNumVertices();
+  result.nTriangles            = cbm.getNumTriangles();
+  result.hasChecksums          = true;
+  result.positions.sizeInBytes = result.nVertices * 3 * sizeof(gims::CograBinaryMeshFile::FloatType);
+  result.triangles.sizeInBytes = result.nTriangles * 3 * sizeof(gims::CograBinaryMeshFile::IndexType);
+  if (lossy)
+  {
+    result.positions.encoding          = ENCODING_QUANTIZED_POSITIONS;
+    result.positions.encodingParameter = 16;
+  }
+  else if (lossless)
+  {
+    result.positions.encoding          = ENCODING_SHUFFLE_RANS;
+    result.positions.encodingParameter = sizeof(gims::CograBinaryMeshFile::FloatType);
+  }
+  if (lossless)
+  {
+    result.triangles.encoding = ENCODING_INDEX_DELTA_RANS;
+  }
+
+  for (gims::ui32 i = 0; i < cbm.getNumAttributes(); i++)
+  {
+    CograBinaryMeshElement a = {cbm.getAttributeComponents(i), cbm.getAttributeComponentSize(i),
+                                cbm.getAttributeName(i), {}};
+    a.section.sizeInBytes    = gims::ui64(cbm.getAttributeElementSize(i)) * result.nVertices;
+    if (lossy && isNormal(a.name, a.components, a.componentSize))
+    {
+      a.section.encoding = ENCODING_OCTAHEDRAL_NORMALS;
+    }
+    else if (lossless)
+    {
+      a.section.encoding          = ENCODING_SHUFFLE_RANS;
+      a.section.encodingParameter = a.componentSize;
+    }
+    result.attributes.push_back(a);
+  }
+  for (gims::ui32 i = 0; i < cbm.getNumConstants(); i++)
+  {
+    CograBinaryMeshElement c = {cbm.getConstantComponents(i), cbm.getConstantComponentSize(i),
+                                cbm.getConstantName(i), {}};
+    c.section.sizeInBytes    = cbm.getConstantElementSize(i);
+    if (lossless)
+    {
+      c.section.encoding          = ENCODING_SHUFFLE_RANS;
+      c.section.encodingParameter = c.componentSize;
+    }
+    result.constants.push_back(c);
+  }
+
+  const auto* const positions = cbm.getPositionsPtr();
+  for (gims::ui32 i = 0; i < cbm.getNumVertices(); i++)
+  {
+    const gims::f32v3 p(positions[i * 3 + 0], positions[i * 3 + 1], positions[i * 3 + 2]);
+    result.boundsMin = i == 0 ? p : glm::min(result.boundsMin, p);
+    result.boundsMax = i == 0 ? p : glm::max(result.boundsMax, p);
+  }
+  result.hasBounds = cbm.getNumVertices() != 0;
+  return result;
+}
+
+//! Encodes the payloads and computes their stored sizes and checksums.
+void encodeSections(std::vector<SectionWrite>& writes, const gims::impl::CograBinaryMeshLayout& layout)
+{
+  for (auto& w : writes)
+  {
+    if (w.section->encoding == gims::impl::ENCODING_RAW)
+    {
+      w.section->storedSizeInBytes = w.section->sizeInBytes;
+    }
+    else
+    {
+      w.encoded = gims::impl::encodeCograBinaryMeshSection(*w.section, w.data, layout);
+      w.data    = w.encoded.data();
+    }
+    w.section->checksum = gims::impl::crc32(w.data, w.section->storedSizeInBytes);
+  }
+}
+} // namespace
+
+namespace gims
+{
+
+CograBinaryMeshFile::CograBinaryMeshFile(const CograBinaryMeshFile& other)
+    : m_positions(other.m_positions)
+    , m_triangles(other.m_triangles)
+    , m_attributes(other.m_attributes)
+    , m_attributeComponents(other.m_attributeComponents)
+    , m_attributeComponentSize(other.m_attributeComponentSize)
+    , m_attributeNames(other.m_attributeNames)
+    , m_attributeIndices(other.m_attributeIndices)
+    , m_constants(other.m_constants)
+    , m_constantComponents(other.m_constantComponents)
+    , m_constantComponentSize(other.m_constantComponentSize)
+    , m_constantNames(other.m_constantNames)
+    , m_constantIndices(other.m_constantIndices)
+{
+  // All offsets stay valid, so the arena is copied as a whole.
+  reserveArena(other.m_arenaSize);
+  if (other.m_arenaSize != 0)
+  {
+    memcpy(m_arena.get(), other.m_arena.get(), other.m_arenaSize);
+  }
+  m_arenaSize = other.m_arenaSize;
 }
 
 CograBinaryMeshFile::CograBinaryMeshFile(CograBinaryMeshFile&& other) noexcept
     : m_positions(std::exchange(other.m_positions, {}))
     , m_triangles(std::exchange(other.m_triangles, {}))
+    , m_arena(std::move(other.m_arena))
+    , m_arenaSize(std::exchange(other.m_arenaSize, 0))
+    , m_arenaCapacity(std::exchange(other.m_arenaCapacity, 0))
     , m_attributes(std::exchange(other.m_attributes, {}))
     , m_attributeComponents(std::exchange(other.m_attributeComponents, {}))
     , m_attributeComponentSize(std::exchange(other.m_attributeComponentSize, {}))
-    , m_attributeNames(std::exchange(m_attributeNames, {}))
-    , m_constants(std::exchange(m_constants, {}))
-    , m_constantComponents(std::exchange(m_constantComponents, {}))
-    , m_constantComponentSize(std::exchange(m_constantComponentSize, {}))
-    , m_constantNames(std::exchange(m_constantNames, {}))
+    , m_attributeNames(std::exchange(other.m_attributeNames, {}))
+    , m_attributeIndices(std::exchange(other.m_attributeIndices, {}))
+    , m_constants(std::exchange(other.m_constants, {}))
+    , m_constantComponents(std::exchange(other.m_constantComponents, {}))
+    , m_constantComponentSize(std::exchange(other.m_constantComponentSize, {}))
+    , m_constantNames(std::exchange(other.m_constantNames, {}))
+    , m_constantIndices(std::exchange(other.m_constantIndices, {}))
 {
 }
 
@@ -58,15 +287,17 @@ CograBinaryMeshFile::CograBinaryMeshFile(const std::string& fileName)
   load(fileName);
 }
 
-CograBinaryMeshFile::~CograBinaryMeshFile()
+CograBinaryMeshFile::CograBinaryMeshFile(const std::string& fileName, const LoadOptions& options)
 {
-  freeAttributes();
-  freeConstants();
+  load(fileName, options);
 }
 
-CograBinaryMeshFile& CograBinaryMeshFile::operator=(CograBinaryMeshFile other)
+CograBinaryMeshFile::~CograBinaryMeshFile() = default;
+
+CograBinaryMeshFile& CograBinaryMeshFile::operator=(const CograBinaryMeshFile& other)
 {
-  other.swap(*this);
+  CograBinaryMeshFile copy(other);
+  copy.swap(*this);
   return *this;
 }
 
@@ -80,60 +311,203 @@ void CograBinaryMeshFile::swap(CograBinaryMeshFile& other)
 {
   m_positions.swap(other.m_positions);
   m_triangles.swap(other.m_triangles);
+  m_arena.swap(other.m_arena);
+  std::swap(m_arenaSize, other.m_arenaSize);
+  std::swap(m_arenaCapacity, other.m_arenaCapacity);
   m_attributes.swap(other.m_attributes);
   m_attributeComponents.swap(other.m_attributeComponents);
   m_attributeComponentSize.swap(other.m_attributeComponentSize);
   m_attributeNames.swap(other.m_attributeNames);
+  m_attributeIndices.swap(other.m_attributeIndices);
   m_constants.swap(other.m_constants);
   m_constantComponents.swap(other.m_constantComponents);
   m_constantComponentSize.swap(other.m_constantComponentSize);
   m_constantNames.swap(other.m_constantNames);
+  m_constantIndices.swap(other.m_constantIndices);
 }
 
 void CograBinaryMeshFile::load(const std::string& fileName)
 {
-  std::ifstream inFile;
+  load(fileName, LoadOptions());
+}
 
-  inFile.open(fileName, std::ios::in | std::ios::binary);
-  if (!inFile.is_open())
+void CograBinaryMeshFile::load(const std::string& fileName, const LoadOptions& options)
+{
+  const impl::CograBinaryMeshLayout layout = readLayout(fileName, nullptr);
+  if (layout.nVertices > std::numeric_limits<SizeType>::max() / 3 ||
+      layout.nTriangles > std::numeric_limits<SizeType>::max() / 3)
   {
-    throw std::runtime_error("Error opening file" + fileName + ".");
+    throw std::runtime_error("File " + fileName + " has too many vertices or triangles.");
   }
-  inFile.exceptions(std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
 
-  readHeader(inFile);
-  // read vertices
-  inFile.read((char*)&m_positions[0], sizeof(FloatType) * 3 * getNumVertices());
-  inFile.read((char*)&m_triangles[0], sizeof(IndexType) * 3 * getNumTriangles());
+  // Allocate everything first, then read all payloads in one go.
+  freeAttributes();
+  freeConstants();
+  m_positions.resize(layout.nVertices * 3);
+  m_triangles.resize(layout.nTriangles * 3);
 
-  for (SizeType i = 0; i < getNumAttributes(); i++)
+  std::vector<const impl::CograBinaryMeshElement*> attributes;
+  for (const auto& a : layout.attributes)
+  {
+    if (options.loadAllAttributes ||
+        std::find(options.attributeNames.begin(), options.attributeNames.end(), a.name) != options.attributeNames.end())
+    {
+      attributes.push_back(&a);
+    }
+  }
+  std::vector<const impl::CograBinaryMeshElement*> constants;
+  for (const auto& c : layout.constants)
+  {
+    if (options.loadConstants)
+    {
+      constants.push_back(&c);
+    }
+  }
+
+  // Reserving the arena up front avoids moving it while it is filled.
+  size_t arenaSize = 0;
+  for (const auto* e : attributes)
   {
-    inFile.read((char*)m_attributes[i], getAttributeElementSize(i) * getNumVertices());
+    arenaSize += e->section.sizeInBytes + ARENA_ALIGNMENT + e->name.size() + 1;
   }
+  for (const auto* e : constants)
+  {
+    arenaSize += e->section.sizeInBytes + ARENA_ALIGNMENT + e->name.size() + 1;
+  }
+  reserveArena(arenaSize);
+  for (const auto* a : attributes)
+  {
+    m_attributes.push_back(allocate(a->section.sizeInBytes));
+    m_attributeComponents.push_back(a->components);
+    m_attributeComponentSize.push_back(a->componentSize);
+    m_attributeNames.push_back(createName(a->name));
+  }
+  for (const auto* c : constants)
+  {
+    m_constants.push_back(allocate(c->section.sizeInBytes));
+    m_constantComponents.push_back(c->components);
+    m_constantComponentSize.push_back(c->componentSize);
+    m_constantNames.push_back(createName(c->name));
+  }
+  updateIndices();
 
+  std::vector<SectionRead> reads;
+  addSectionReads(reads, layout.positions, m_positions.data());
+  addSectionReads(reads, layout.triangles, m_triangles.data());
+  for (SizeType i = 0; i < getNumAttributes(); i++)
+  {
+    addSectionReads(reads, attributes[i]->section, getAttributePtr(i));
+  }
   for (SizeType i = 0; i < getNumConstants(); i++)
   {
-    inFile.read((char*)m_constants[i], getConstantElementSize(i));
+    addSectionReads(reads, constants[i]->section, getConstant(i));
+  }
+  readSections(fileName, reads, layout, options.nThreads, options.verifyChecksums && layout.hasChecksums);
+  const auto hasNormals = [](const impl::CograBinaryMeshElement* a)
+  { return isNormal(a->name, a->components, a->componentSize); };
+  if (options.generateNormals && std::none_of(attributes.begin(), attributes.end(), hasNormals))
+  {
+    std::vector<f32v3> normals(getNumVertices());
+    MeshNormals::generateNormals(&normals.data()->x, sizeof(f32v3), getTriangleIndices(), ui64(getNumTriangles()) * 3,
+                                 getPositionsPtr(), 3 * sizeof(FloatType), getNumVertices(), MeshNormals::WEIGHT_ANGLE,
+                                 options.nThreads);
+    addAttribute(normals.data(), 3, sizeof(f32), "Normals");
+  }
+  if (options.optimize)
+  {
+    MeshOptimizer::optimizeMesh(*this);
   }
 }
 
-void CograBinaryMeshFile::save(const std::string& fileName)
+CograBinaryMeshFile::Info CograBinaryMeshFile::probe(const std::string& fileName)
 {
-  std::ofstream outFile;
-  outFile.open(fileName, std::ios::out | std::ios::binary);
+  Info                              result;
+  const impl::CograBinaryMeshLayout layout = readLayout(fileName, &result.fileSize);
+  if (layout.nVertices > std::numeric_limits<SizeType>::max() ||
+      layout.nTriangles > std::numeric_limits<SizeType>::max())
+  {
+    throw std::runtime_error("File " + fileName + " has too many vertices or triangles.");
+  }
+  const auto toInfo = [](const impl::CograBinaryMeshElement& e)
+  { return ElementInfo {e.name, e.components, e.componentSize}; };
+  const auto isCompressed = [](const impl::CograBinaryMeshSection& s)
+  { return s.encoding != impl::ENCODING_RAW || s.storedSizeInBytes != s.sizeInBytes; };
+
+  result.version    = static_cast<FileVersion>(layout.version);
+  result.nVertices  = static_cast<SizeType>(layout.nVertices);
+  result.nTriangles = static_cast<SizeType>(layout.nTriangles);
+  result.compressed = isCompressed(layout.positions) || isCompressed(layout.triangles);
+  for (const auto& a : layout.attributes)
+  {
+    result.attributes.push_back(toInfo(a));
+    result.compressed = result.compressed || isCompressed(a.section);
+  }
+  for (const auto& c : layout.constants)
+  {
+    result.constants.push_back(toInfo(c));
+    result.compressed = result.compressed || isCompressed(c.section);
+  }
+  result.hasBounds = layout.hasBounds;
+  result.boundsMin = layout.boundsMin;
+  result.boundsMax = layout.boundsMax;
+  return result;
+}
+
+void CograBinaryMeshFile::save(const std::string& fileName, FileVersion version, CompressionLevel compression)
+{
+  // The arguments are validated and the sections are encoded before the file is opened, as opening truncates it.
+  if (version == VERSION_1 && compression != COMPRESSION_NONE)
+  {
+    throw std::runtime_error("Compression requires CBM version 2.");
+  }
+  const auto openFile = [&fileName]()
+  {
+    std::ofstream outFile;
+    outFile.open(fileName, std::ios::out | std::ios::binary);
+    if (!outFile.is_open())
+    {
+      throw std::runtime_error("Error opening file " + fileName + " for writing.");
+    }
+    return outFile;
+  };
+  if (version == VERSION_2)
+  {
+    impl::CograBinaryMeshLayout layout = createLayout(*this, compression);
+    std::vector<SectionWrite>   writes;
+    writes.push_back({&layout.positions, m_positions.data(), {}});
+    writes.push_back({&layout.triangles, m_triangles.data(), {}});
+    for (SizeType i = 0; i < getNumAttributes(); i++)
+    {
+      writes.push_back({&layout.attributes[i].section, getAttributePtr(i), {}});
+    }
+    for (SizeType i = 0; i < getNumConstants(); i++)
+    {
+      writes.push_back({&layout.constants[i].section, getConstant(i), {}});
+    }
+    encodeSections(writes, layout);
+
+    impl::computeCograBinaryMeshLayoutV2(layout);
+    std::ofstream outFile = openFile();
+    impl::writeCograBinaryMeshHeaderV2(outFile, layout);
+    for (const auto& w : writes)
+    {
+      writeSection(outFile, *w.section, w.data);
+    }
+    return;
+  }
+
+  std::ofstream outFile = openFile();
   writeHeader(outFile);
-  outFile.write((const char*)&m_positions[0], sizeof(FloatType) * 3 * getNumVertices());
-  outFile.write((const char*)&m_triangles[0], sizeof(IndexType) * 3 * getNumTriangles());
+  outFile.write((const char*)m_positions.data(), static_cast<std::streamsize>(sizeof(FloatType) * m_positions.size()));
+  outFile.write((const char*)m_triangles.data(), static_cast<std::streamsize>(sizeof(IndexType) * m_triangles.size()));
   for (SizeType i = 0; i < getNumAttributes(); i++)
   {
-    SizeType size = getAttributeElementSize(i) * getNumVertices();
-    outFile.write((const char*)m_attributes[i], size);
+    outFile.write((const char*)getAttributePtr(i), static_cast<std::streamsize>(getAttributeSizeInBytes(i)));
   }
 
   for (SizeType i = 0; i < getNumConstants(); i++)
   {
-    SizeType size = getConstantElementSize(i);
-    outFile.write((const char*)m_constants[i], size);
+    outFile.write((const char*)getConstant(i), static_cast<std::streamsize>(getConstantElementSize(i)));
   }
   outFile.close();
 }
@@ -160,30 +534,30 @@ CograBinaryMeshFile::FloatType* CograBinaryMeshFile::getPositionsPtr()
 
 const CograBinaryMeshFile::IndexType* CograBinaryMeshFile::getTriangleIndices() const
 {
-  return &m_triangles[0];
+  return m_triangles.data();
 }
 
 CograBinaryMeshFile::IndexType* CograBinaryMeshFile::getTriangleIndices()
 {
-  return &m_triangles[0];
+  return m_triangles.data();
 }
 
 void CograBinaryMeshFile::setPositions(const FloatType* vertices, const SizeType nVertices)
 {
-  m_positions.resize(nVertices * 3);
-  for (SizeType i = 0; i < nVertices * 3; i++)
+  if (nVertices > std::numeric_limits<SizeType>::max() / 3)
   {
-    m_positions[i] = vertices[i];
+    throw std::runtime_error("Too many vertices.");
   }
+  m_positions.assign(vertices, vertices + size_t(nVertices) * 3);
 }
 
 void CograBinaryMeshFile::setTriangleIndices(const IndexType* triIdx, const SizeType nTriangles)
 {
-  m_triangles.resize(nTriangles * 3);
-  for (SizeType i = 0; i < nTriangles * 3; i++)
+  if (nTriangles > std::numeric_limits<SizeType>::max() / 3)
   {
-    m_triangles[i] = triIdx[i];
+    throw std::runtime_error("Too many triangles.");
   }
+  m_triangles.assign(triIdx, triIdx + size_t(nTriangles) * 3);
 }
 
 void CograBinaryMeshFile::readHeader(std::ifstream& inFile)
@@ -193,10 +567,11 @@ void CograBinaryMeshFile::readHeader(std::ifstream& inFile)
   SizeType nA;
   SizeType nC;
   freeAttributes();
+  freeConstants();
   inFile.read((char*)&nV, sizeof(SizeType));
-  m_positions.resize(nV * 3);
+  m_positions.resize(size_t(nV) * 3);
   inFile.read((char*)&nT, sizeof(SizeType));
-  m_triangles.resize(nT * 3);
+  m_triangles.resize(size_t(nT) * 3);
   inFile.read((char*)&nA, sizeof(SizeType));
 
   m_attributeComponents.resize(nA);
@@ -204,6 +579,7 @@ void CograBinaryMeshFile::readHeader(std::ifstream& inFile)
   m_attributeNames.resize(nA);
   m_attributes.resize(nA);
 
+  char name[N_CHARS + 1] = {};
   if (nA != 0)
   {
     inFile.read((char*)&m_attributeComponents[0], nA * sizeof(SizeType));
@@ -211,10 +587,9 @@ void CograBinaryMeshFile::readHeader(std::ifstream& inFile)
 
     for (SizeType i = 0; i < getNumAttributes(); i++)
     {
-      m_attributes[i]     = new ui8[m_attributeComponents[i] * m_attributeComponentSize[i] * getNumVertices()];
-      m_attributeNames[i] = new char[N_CHARS];
-      std::memset(m_attributeNames[i], '\0', N_CHARS);
-      inFile.read((char*)(m_attributeNames[i]), sizeof(char) * N_CHARS);
+      m_attributes[i] = allocate(size_t(m_attributeComponents[i]) * m_attributeComponentSize[i] * getNumVertices());
+      inFile.read(name, sizeof(char) * N_CHARS);
+      m_attributeNames[i] = createName(name);
     }
   }
 
@@ -231,11 +606,12 @@ void CograBinaryMeshFile::readHeader(std::ifstream& inFile)
 
     for (SizeType i = 0; i < getNumConstants(); i++)
     {
-      m_constants[i]     = (new ui8[m_constantComponents[i] * m_constantComponentSize[i]]);
-      m_constantNames[i] = new char[N_CHARS];
-      inFile.read((char*)m_constantNames[i], sizeof(ui8) * N_CHARS);
+      m_constants[i] = allocate(size_t(m_constantComponents[i]) * m_constantComponentSize[i]);
+      inFile.read(name, sizeof(char) * N_CHARS);
+      m_constantNames[i] = createName(name);
     }
   }
+  updateIndices();
 }
 
 void CograBinaryMeshFile::writeHeader(std::ofstream& outFile)
@@ -253,7 +629,7 @@ void CograBinaryMeshFile::writeHeader(std::ofstream& outFile)
     outFile.write((const char*)&m_attributeComponentSize[0], nA * sizeof(SizeType));
     for (SizeType i = 0; i < nA; i++)
     {
-      outFile.write((const char*)(m_attributeNames[i]), sizeof(char) * N_CHARS);
+      writeName(outFile, getAttributeName(i));
     }
   }
   outFile.write((const char*)&nC, sizeof(SizeType));
@@ -263,7 +639,7 @@ void CograBinaryMeshFile::writeHeader(std::ofstream& outFile)
     outFile.write((const char*)&m_constantComponentSize[0], nC * sizeof(SizeType));
     for (SizeType i = 0; i < nC; i++)
     {
-      outFile.write((const char*)(m_constantNames[i]), sizeof(char) * N_CHARS);
+      writeName(outFile, getConstantName(i));
     }
   }
 }
@@ -290,45 +666,71 @@ bool CograBinaryMeshFile::add(const CograBinaryMeshFile& src)
     }
   }
 
-  // merge
-
-  auto* vertices = new FloatType[(this->getNumVertices() + src.getNumVertices()) * 3];
-  memcpy((void*)&vertices[0], (void*)this->getPositionsPtr(), this->getNumVertices() * 3 * sizeof(FloatType));
-  memcpy((void*)&vertices[this->getNumVertices() * 3], (void*)src.getPositionsPtr(),
-         src.getNumVertices() * 3 * sizeof(FloatType));
-
-  auto* idxBuffer = new IndexType[(this->getNumTriangles() + src.getNumTriangles()) * 3];
-  memcpy((void*)&idxBuffer[0], (void*)this->getTriangleIndices(), this->getNumTriangles() * 3 * sizeof(IndexType));
-  // translate index buffer
-  for (SizeType i = 0; i < src.getNumTriangles() * 3; i++)
+  // The merged counts must stay addressable with 32 bit indices, like in setPositions and setTriangleIndices.
+  const size_t nVertices  = size_t(getNumVertices()) + src.getNumVertices();
+  const size_t nTriangles = size_t(getNumTriangles()) + src.getNumTriangles();
+  if (nVertices > std::numeric_limits<SizeType>::max() / 3)
   {
-    idxBuffer[this->getNumTriangles() * 3 + i] = src.getTriangleIndices()[i] + getNumVertices();
+    throw std::runtime_error("Too many vertices.");
   }
-
-  std::vector<ui8*> attributes(nAttributes);
-  for (SizeType i = 0; i < nAttributes; i++)
+  if (nTriangles > std::numeric_limits<SizeType>::max() / 3)
   {
-    SizeType attribSize = src.getAttributeComponents(i) * src.getAttributeComponentSize(i);
-    auto     attr       = new ui8[(this->getNumVertices() + src.getNumVertices()) * attribSize];
-    memcpy((void*)&attr[0], this->getAttributePtr(i), this->getNumVertices() * attribSize);
-    memcpy((void*)&attr[this->getNumVertices() * attribSize], src.getAttributePtr(i),
-           src.getNumVertices() * attribSize);
-    attributes[i] = attr;
+    throw std::runtime_error("Too many triangles.");
   }
 
-  this->setPositions(vertices, this->getNumVertices() + src.getNumVertices());
-  this->setTriangleIndices(idxBuffer, this->getNumTriangles() + src.getNumTriangles());
+  // merge into a new arena, as all attributes grow
+  CograBinaryMeshFile merged;
+  merged.m_positions.reserve(nVertices * 3);
+  merged.m_positions.insert(merged.m_positions.end(), m_positions.begin(), m_positions.end());
+  merged.m_positions.insert(merged.m_positions.end(), src.m_positions.begin(), src.m_positions.end());
 
-  for (SizeType i = 0; i < nAttributes; i++)
+  // translate index buffer
+  merged.m_triangles.reserve(m_triangles.size() + src.m_triangles.size());
+  merged.m_triangles.insert(merged.m_triangles.end(), m_triangles.begin(), m_triangles.end());
+  for (const IndexType idx : src.m_triangles)
   {
-    this->replaceAttribute(i, attributes[i]);
+    // The sum is formed in 64 bits, so that an index out of range of src cannot wrap around to a valid one.
+    const ui64 translated = ui64(idx) + getNumVertices();
+    if (translated > std::numeric_limits<IndexType>::max())
+    {
+      throw std::runtime_error("Triangle index out of range.");
+    }
+    merged.m_triangles.push_back(static_cast<IndexType>(translated));
   }
 
-  // tidy up
+  merged.reserveArena(m_arenaSize + src.getNumVertices() * src.getTotalAttributeSize() +
+                      (size_t(nAttributes) + getNumConstants()) * ARENA_ALIGNMENT);
+  merged.m_attributes.reserve(nAttributes);
+  merged.m_attributeComponents.reserve(nAttributes);
+  merged.m_attributeComponentSize.reserve(nAttributes);
+  merged.m_attributeNames.reserve(nAttributes);
   for (SizeType i = 0; i < nAttributes; i++)
   {
-    delete[] attributes[i];
+    const size_t attribSize = getAttributeElementSize(i);
+    const size_t offset     = merged.allocate(nVertices * attribSize);
+    memcpy(merged.m_arena.get() + offset, getAttributePtr(i), getNumVertices() * attribSize);
+    memcpy(merged.m_arena.get() + offset + getNumVertices() * attribSize, src.getAttributePtr(i),
+           src.getNumVertices() * attribSize);
+    merged.m_attributes.push_back(offset);
+    merged.m_attributeComponents.push_back(getAttributeComponents(i));
+    merged.m_attributeComponentSize.push_back(getAttributeComponentSize(i));
+    merged.m_attributeNames.push_back(merged.createName(getAttributeName(i)));
   }
+  merged.m_constants.reserve(getNumConstants());
+  merged.m_constantComponents.reserve(getNumConstants());
+  merged.m_constantComponentSize.reserve(getNumConstants());
+  merged.m_constantNames.reserve(getNumConstants());
+  for (SizeType i = 0; i < getNumConstants(); i++)
+  {
+    merged.m_constants.push_back(merged.store(getConstant(i), getConstantElementSize(i)));
+    merged.m_constantComponents.push_back(getConstantComponents(i));
+    merged.m_constantComponentSize.push_back(getConstantComponentSize(i));
+    merged.m_constantNames.push_back(merged.createName(getConstantName(i)));
+  }
+  // names and their order are unchanged, so the name to index maps are kept
+  merged.m_attributeIndices.swap(m_attributeIndices);
+  merged.m_constantIndices.swap(m_constantIndices);
+  swap(merged);
   return true;
 }
 
@@ -341,29 +743,17 @@ CograBinaryMeshFile::SizeType CograBinaryMeshFile::addAttribute(const void* attr
                                                                 const SizeType     componentSize,
                                                                 const std::string& attributeName)
 {
-  SizeType size = getNumVertices() * nComponents * componentSize;
-  auto*    p    = new ui8[size];
-
-  memcpy((void*)p, attribute, size);
-  m_attributes.push_back(p);
+  m_attributes.push_back(store(attribute, size_t(getNumVertices()) * nComponents * componentSize));
   m_attributeComponentSize.push_back(componentSize);
   m_attributeComponents.push_back(nComponents);
-
-  auto* a = new char[N_CHARS];
-  memset((void*)a, '\0', N_CHARS);
-  SizeType l = std::min<SizeType>(static_cast<ui32>(N_CHARS), static_cast<ui32>(attributeName.length()));
-  for (SizeType i = 0; i < l; i++)
-  {
-    a[i] = attributeName[i];
-  }
-
-  m_attributeNames.push_back(a);
+  m_attributeNames.push_back(createName(attributeName));
+  m_attributeIndices.emplace(getAttributeName(getNumAttributes() - 1), getNumAttributes() - 1);
   return static_cast<ui32>(m_attributes.size());
 }
 
 void* CograBinaryMeshFile::getAttributePtr(SizeType attributeIdx) const
 {
-  return m_attributes[attributeIdx];
+  return m_arena.get() + m_attributes[attributeIdx];
 }
 
 void* CograBinaryMeshFile::replaceAttribute(SizeType attributeIdx, const void* attribute)
@@ -372,11 +762,8 @@ void* CograBinaryMeshFile::replaceAttribute(SizeType attributeIdx, const void* a
   {
     return nullptr;
   }
-  SizeType size = getNumVertices() * m_attributeComponentSize[attributeIdx] * m_attributeComponents[attributeIdx];
-  auto     p    = new ui8[size];
-  memcpy((void*)p, attribute, size);
-  delete[] m_attributes[attributeIdx];
-  m_attributes[attributeIdx] = p;
+  void* const p = getAttributePtr(attributeIdx);
+  memmove(p, attribute, getAttributeSizeInBytes(attributeIdx));
   return p;
 }
 
@@ -390,33 +777,33 @@ CograBinaryMeshFile::SizeType CograBinaryMeshFile::getAttributeComponents(SizeTy
   return m_attributeComponents[attributeIdx];
 }
 
-CograBinaryMeshFile::SizeType CograBinaryMeshFile::getAttributeElementSize(SizeType attributeIdx) const
+ui64 CograBinaryMeshFile::getAttributeElementSize(SizeType attributeIdx) const
 {
-  return m_attributeComponentSize[attributeIdx] * m_attributeComponents[attributeIdx];
+  return ui64(m_attributeComponentSize[attributeIdx]) * m_attributeComponents[attributeIdx];
+}
+
+size_t CograBinaryMeshFile::getAttributeSizeInBytes(SizeType attributeIdx) const
+{
+  return getAttributeElementSize(attributeIdx) * getNumVertices();
 }
 
 const char* CograBinaryMeshFile::getAttributeName(SizeType attributeIdx) const
 {
-  return m_attributeNames[attributeIdx];
+  return reinterpret_cast<const char*>(m_arena.get() + m_attributeNames[attributeIdx]);
 }
 
 void CograBinaryMeshFile::freeAttributes()
 {
-  for (SizeType i = 0; i < getNumAttributes(); i++)
+  // The space is reused once constants are freed as well.
+  if (m_constants.empty())
   {
-    if (m_attributes[i])
-    {
-      delete[] m_attributes[i];
-      m_attributes[i] = nullptr;
-    }
-    m_attributeComponents[i]    = 0;
-    m_attributeComponentSize[i] = 0;
-    if (m_attributeNames[i])
-    {
-      delete[] m_attributeNames[i];
-      m_attributeNames[i] = nullptr;
-    }
+    m_arenaSize = 0;
   }
+  m_attributes.clear();
+  m_attributeComponents.clear();
+  m_attributeComponentSize.clear();
+  m_attributeNames.clear();
+  m_attributeIndices.clear();
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::getConstantComponentSize(SizeType constantIdx) const
@@ -429,14 +816,14 @@ CograBinaryMeshFile::SizeType CograBinaryMeshFile::getConstantComponents(SizeTyp
   return m_constantComponents[constantIdx];
 }
 
-CograBinaryMeshFile::SizeType CograBinaryMeshFile::getConstantElementSize(SizeType constantIdx) const
+ui64 CograBinaryMeshFile::getConstantElementSize(SizeType constantIdx) const
 {
-  return getConstantComponentSize(constantIdx) * getConstantComponents(constantIdx);
+  return ui64(getConstantComponentSize(constantIdx)) * getConstantComponents(constantIdx);
 }
 
 const char* CograBinaryMeshFile::getConstantName(SizeType constantIdx) const
 {
-  return m_constantNames[constantIdx];
+  return reinterpret_cast<const char*>(m_arena.get() + m_constantNames[constantIdx]);
 }
 
 CograBinaryMeshFile::SizeType CograBinaryMeshFile::getNumConstants() const
@@ -446,14 +833,28 @@ CograBinaryMeshFile::SizeType CograBinaryMeshFile::getNumConstants() const
 
 void CograBinaryMeshFile::freeConstants()
 {
+  if (m_attributes.empty())
+  {
+    m_arenaSize = 0;
+  }
+  m_constants.clear();
+  m_constantComponents.clear();
+  m_constantComponentSize.clear();
+  m_constantNames.clear();
+  m_constantIndices.clear();
+}
+
+void CograBinaryMeshFile::removeConstant(SizeType constantIdx)
+{
+  // The space of the constant stays allocated in the arena until it is rebuilt, e.g., by add.
+  m_constants.erase(m_constants.begin() + constantIdx);
+  m_constantComponents.erase(m_constantComponents.begin() + constantIdx);
+  m_constantComponentSize.erase(m_constantComponentSize.begin() + constantIdx);
+  m_constantNames.erase(m_constantNames.begin() + constantIdx);
+  m_constantIndices.clear();
   for (SizeType i = 0; i < getNumConstants(); i++)
   {
-    delete[] m_constants[i];
-    m_constants[i]             = nullptr;
-    m_constantComponents[i]    = 0;
-    m_constantComponentSize[i] = 0;
-    delete[] m_constantNames[i];
-    m_constantNames[i] = nullptr;
+    m_constantIndices.emplace(getConstantName(i), i);
   }
 }
 
@@ -461,29 +862,17 @@ CograBinaryMeshFile::SizeType CograBinaryMeshFile::addConstant(const void* const
                                                                const SizeType     componentSize,
                                                                const std::string& constantName)
 {
-  SizeType size = nComponents * componentSize;
-  auto     p    = new ui8[size];
-
-  memcpy((void*)p, constant, size);
-  m_constants.push_back(p);
+  m_constants.push_back(store(constant, size_t(nComponents) * componentSize));
   m_constantComponentSize.push_back(componentSize);
   m_constantComponents.push_back(nComponents);
-
-  auto* a = new char[N_CHARS];
-  memset((void*)a, '\0', N_CHARS);
-  SizeType l = std::min<SizeType>((SizeType)N_CHARS, (SizeType)constantName.length());
-  for (SizeType i = 0; i < l; i++)
-  {
-    a[i] = constantName[i];
-  }
-
-  m_constantNames.push_back(a);
+  m_constantNames.push_back(createName(constantName));
+  m_constantIndices.emplace(getConstantName(getNumConstants() - 1), getNumConstants() - 1);
   return (SizeType)m_constants.size();
 }
 
 void* CograBinaryMeshFile::getConstant(SizeType constantIdx) const
 {
-  return m_constants[constantIdx];
+  return m_arena.get() + m_constants[constantIdx];
 }
 
 void CograBinaryMeshFile::overwriteConstants(const CograBinaryMeshFile& src)
@@ -498,12 +887,14 @@ void CograBinaryMeshFile::overwriteConstants(const CograBinaryMeshFile& src)
 
 int CograBinaryMeshFile::getConstantIdx(const char* name) const
 {
-  for (ui32 i = 0; i < getNumConstants(); i++)
-    if (strcmp(name, m_constantNames[i]) == 0)
-    {
-      return i;
-    }
-  return -1;
+  const auto it = m_constantIndices.find(name);
+  return it == m_constantIndices.end() ? -1 : static_cast<int>(it->second);
+}
+
+int CograBinaryMeshFile::getAttributeIdx(const char* name) const
+{
+  const auto it = m_attributeIndices.find(name);
+  return it == m_attributeIndices.end() ? -1 : static_cast<int>(it->second);
 }
 
 int CograBinaryMeshFile::getConstantIdx(const SizeType components, const SizeType componentSize, const char* name) const
@@ -553,17 +944,16 @@ int CograBinaryMeshFile::getIntegerConstant(const char* name, bool* ok /*= 0*/)
 void CograBinaryMeshFile::getAllVertexAttributes(void* const result, const SizeType vIdx) const
 {
   // Add the vertices
-  ((f32* const)result)[vIdx + 0] = m_positions[vIdx + 0];
-  ((f32* const)result)[vIdx + 1] = m_positions[vIdx + 1];
-  ((f32* const)result)[vIdx + 2] = m_positions[vIdx + 2];
-  SizeType offset                = 3 * 4;
+  auto* const destination = static_cast<ui8*>(result);
+  memcpy(destination, &m_positions[size_t(vIdx) * 3], 3 * sizeof(FloatType));
+  size_t offset = 3 * sizeof(FloatType);
   // Add the attributes.
   for (SizeType aIdx = 0; aIdx < getNumAttributes(); aIdx++)
-    for (SizeType cIdx = 0; cIdx < getAttributeElementSize(aIdx); cIdx++)
-    {
-      ((unsigned char* const)result)[offset++] =
-          ((unsigned char const*)getAttributePtr(aIdx))[vIdx * getAttributeElementSize(aIdx) + cIdx];
-    }
+  {
+    const size_t elementSize = getAttributeElementSize(aIdx);
+    memcpy(destination + offset, static_cast<const ui8*>(getAttributePtr(aIdx)) + vIdx * elementSize, elementSize);
+    offset += elementSize;
+  }
 }
 
 void CograBinaryMeshFile::printAttributes(std::ostream& stream) const
@@ -594,9 +984,83 @@ void CograBinaryMeshFile::printConstant(std::ostream& stream) const
   stream << "\n";
 }
 
-CograBinaryMeshFile::SizeType CograBinaryMeshFile::getTotalAttributeSize() const
+void CograBinaryMeshFile::updateIndices()
+{
+  m_attributeIndices.clear();
+  for (SizeType i = 0; i < getNumAttributes(); i++)
+  {
+    m_attributeIndices.emplace(getAttributeName(i), i);
+  }
+  m_constantIndices.clear();
+  for (SizeType i = 0; i < getNumConstants(); i++)
+  {
+    m_constantIndices.emplace(getConstantName(i), i);
+  }
+}
+
+void CograBinaryMeshFile::ArenaDeleter::operator()(ui8* arena) const
+{
+  ::operator delete[](arena, std::align_val_t(ARENA_ALIGNMENT));
+}
+
+size_t CograBinaryMeshFile::allocate(size_t sizeInBytes, size_t alignment)
+{
+  const size_t offset = (m_arenaSize + alignment - 1) / alignment * alignment;
+  if (offset + sizeInBytes > m_arenaCapacity)
+  {
+    reserveArena(std::max(offset + sizeInBytes, m_arenaCapacity * 2));
+  }
+  m_arenaSize = offset + sizeInBytes;
+  return offset;
+}
+
+void CograBinaryMeshFile::reserveArena(size_t capacity)
+{
+  if (capacity <= m_arenaCapacity)
+  {
+    return;
+  }
+  std::unique_ptr<ui8[], ArenaDeleter> arena(
+      static_cast<ui8*>(::operator new[](capacity, std::align_val_t(ARENA_ALIGNMENT))));
+  if (m_arenaSize != 0)
+  {
+    memcpy(arena.get(), m_arena.get(), m_arenaSize);
+  }
+  m_arena.swap(arena);
+  m_arenaCapacity = capacity;
+}
+
+size_t CograBinaryMeshFile::store(const void* data, size_t sizeInBytes)
+{
+  // The data may be part of the arena itself, e.g., when an attribute is duplicated. Its offset survives growing.
+  const auto*  source    = static_cast<const ui8*>(data);
+  const bool   inArena   = std::less_equal<const ui8*>()(m_arena.get(), source) &&
+                       std::less<const ui8*>()(source, m_arena.get() + m_arenaSize);
+  const size_t srcOffset = inArena ? static_cast<size_t>(source - m_arena.get()) : 0;
+  const size_t offset    = allocate(sizeInBytes);
+  memcpy(m_arena.get() + offset, inArena ? m_arena.get() + srcOffset : source, sizeInBytes);
+  return offset;
+}
+
+size_t CograBinaryMeshFile::createName(const std::string& name)
+{
+  const size_t length = std::min(name.size(), size_t(N_CHARS));
+  const size_t offset = allocate(length + 1, 1);
+  name.copy(reinterpret_cast<char*>(m_arena.get() + offset), length);
+  m_arena[offset + length] = '\0';
+  return offset;
+}
+
+void CograBinaryMeshFile::writeName(std::ostream& outFile, const char* name)
+{
+  char padded[N_CHARS] = {};
+  memcpy(padded, name, strnlen(name, N_CHARS));
+  outFile.write(padded, sizeof(char) * N_CHARS);
+}
+
+ui64 CograBinaryMeshFile::getTotalAttributeSize() const
 {
-  SizeType result = 0;
+  ui64 result = 0;
   for (SizeType i = 0; i < getNumAttributes(); i++)
   {
     result += getAttributeElementSize(i);
@@ -0,0 +1,215 @@
+#include "impl/CograBinaryMeshLayout.hpp"
+#include <gimslib/io/CograBinaryMeshView.hpp>
+#include <istream>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+//! True, if a payload starts at a multiple of the alignment of its components. The alignment is the largest power of
+//! two that divides the component size, at most 8. The mapping itself starts at a page boundary.
+bool isAligned(const gims::impl::CograBinaryMeshSection& section, gims::ui64 componentSize)
+{
+  gims::ui64 alignment = 1;
+  while (alignment < 8 && componentSize % (alignment * 2) == 0)
+  {
+    alignment *= 2;
+  }
+  return section.offset % alignment == 0;
+}
+} // namespace
+
+namespace gims
+{
+CograBinaryMeshView::CograBinaryMeshView(const std::string& fileName)
+{
+  open(fileName);
+}
+
+void CograBinaryMeshView::open(const std::string& fileName)
+{
+  close();
+  m_file.open(fileName);
+
+  impl::CograBinaryMeshLayout layout;
+  try
+  {
+    impl::MemoryStreamBuffer buffer(m_file.data(), m_file.size());
+    std::istream             inFile(&buffer);
+    layout = impl::readCograBinaryMeshLayout(inFile, m_file.size());
+  }
+  catch (...)
+  {
+    close();
+    throw;
+  }
+
+  // Only payloads that are stored as is in one piece can be pointed to.
+  const auto isContiguous = [](const impl::CograBinaryMeshSection& s)
+  { return s.encoding == impl::ENCODING_RAW && s.chunks.empty(); };
+  bool contiguous = isContiguous(layout.positions) && isContiguous(layout.triangles);
+  for (const auto& e : layout.attributes)
+  {
+    contiguous = contiguous && isContiguous(e.section);
+  }
+  for (const auto& e : layout.constants)
+  {
+    contiguous = contiguous && isContiguous(e.section);
+  }
+  if (!contiguous)
+  {
+    close();
+    throw std::runtime_error("File " + fileName + " is compressed or chunked and cannot be viewed. Use " +
+                             "CograBinaryMeshFile, or save it again without compression.");
+  }
+  if (layout.nVertices > std::numeric_limits<SizeType>::max() / 3 ||
+      layout.nTriangles > std::numeric_limits<SizeType>::max() / 3)
+  {
+    close();
+    throw std::runtime_error("File " + fileName + " has too many vertices or triangles to be viewed.");
+  }
+
+  // Version 1 payloads follow the names and the payloads before them without padding. Each payload has to be aligned
+  // to its components, as the pointers into the mapping are read as arrays of them.
+  bool aligned = isAligned(layout.positions, sizeof(FloatType)) && isAligned(layout.triangles, sizeof(IndexType));
+  for (const auto& e : layout.attributes)
+  {
+    aligned = aligned && isAligned(e.section, e.componentSize);
+  }
+  for (const auto& e : layout.constants)
+  {
+    aligned = aligned && isAligned(e.section, e.componentSize);
+  }
+  if (!aligned)
+  {
+    close();
+    throw std::runtime_error("File " + fileName + " has unaligned payloads and cannot be viewed. Use " +
+                             "CograBinaryMeshFile, or save it again as version 2.");
+  }
+
+  const ui8* const base = m_file.data();
+  m_nVertices           = static_cast<SizeType>(layout.nVertices);
+  m_nTriangles          = static_cast<SizeType>(layout.nTriangles);
+  m_positions           = reinterpret_cast<const FloatType*>(base + layout.positions.offset);
+  m_triangles           = reinterpret_cast<const IndexType*>(base + layout.triangles.offset);
+
+  const auto toElement = [base](const impl::CograBinaryMeshElement& e)
+  { return Element {base + e.section.offset, e.components, e.componentSize, e.name}; };
+  for (const auto& a : layout.attributes)
+  {
+    m_attributes.push_back(toElement(a));
+  }
+  for (const auto& c : layout.constants)
+  {
+    m_constants.push_back(toElement(c));
+  }
+}
+
+void CograBinaryMeshView::close()
+{
+  m_file.close();
+  m_nVertices  = 0;
+  m_nTriangles = 0;
+  m_positions  = nullptr;
+  m_triangles  = nullptr;
+  m_attributes.clear();
+  m_constants.clear();
+}
+
+bool CograBinaryMeshView::isOpen() const
+{
+  return m_file.isOpen();
+}
+
+CograBinaryMeshView::SizeType CograBinaryMeshView::getNumVertices() const
+{
+  return m_nVertices;
+}
+
+CograBinaryMeshView::SizeType CograBinaryMeshView::getNumTriangles() const
+{
+  return m_nTriangles;
+}
+
+const CograBinaryMeshView::FloatType* CograBinaryMeshView::getPositionsPtr() const
+{
+  return m_positions;
+}
+
+const CograBinaryMeshView::IndexType* CograBinaryMeshView::getTriangleIndices() const
+{
+  return m_triangles;
+}
+
+CograBinaryMeshView::SizeType CograBinaryMeshView::getNumAttributes() const
+{
+  return static_cast<SizeType>(m_attributes.size());
+}
+
+const void* CograBinaryMeshView::getAttributePtr(SizeType attributeIdx) const
+{
+  return m_attributes[attributeIdx].data;
+}
+
+CograBinaryMeshView::SizeType CograBinaryMeshView::getAttributeComponentSize(SizeType attributeIdx) const
+{
+  return m_attributes[attributeIdx].componentSize;
+}
+
+CograBinaryMeshView::SizeType CograBinaryMeshView::getAttributeComponents(SizeType attributeIdx) const
+{
+  return m_attributes[attributeIdx].components;
+}
+
+ui64 CograBinaryMeshView::getAttributeElementSize(SizeType attributeIdx) const
+{
+  return ui64(getAttributeComponentSize(attributeIdx)) * getAttributeComponents(attributeIdx);
+}
+
+const char* CograBinaryMeshView::getAttributeName(SizeType attributeIdx) const
+{
+  return m_attributes[attributeIdx].name.c_str();
+}
+
+int CograBinaryMeshView::getAttributeIdx(const char* name) const
+{
+  for (size_t i = 0; i < m_attributes.size(); i++)
+  {
+    if (m_attributes[i].name == name)
+    {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+CograBinaryMeshView::SizeType CograBinaryMeshView::getNumConstants() const
+{
+  return static_cast<SizeType>(m_constants.size());
+}
+
+const void* CograBinaryMeshView::getConstant(SizeType constantIdx) const
+{
+  return m_constants[constantIdx].data;
+}
+
+CograBinaryMeshView::SizeType CograBinaryMeshView::getConstantComponentSize(SizeType constantIdx) const
+{
+  return m_constants[constantIdx].componentSize;
+}
+
+CograBinaryMeshView::SizeType CograBinaryMeshView::getConstantComponents(SizeType constantIdx) const
+{
+  return m_constants[constantIdx].components;
+}
+
+ui64 CograBinaryMeshView::getConstantElementSize(SizeType constantIdx) const
+{
+  return ui64(getConstantComponentSize(constantIdx)) * getConstantComponents(constantIdx);
+}
+
+const char* CograBinaryMeshView::getConstantName(SizeType constantIdx) const
+{
+  return m_constants[constantIdx].name.c_str();
+}
+} // namespace gims
@@ -0,0 +1,296 @@
+#include "impl/CograBinaryMeshLayout.hpp"
+#include "impl/Crc32.hpp"
+#include <algorithm>
+#include <limits>
+#include <gimslib/io/CograBinaryMeshWriter.hpp>
+#include <stdexcept>
+
+namespace
+{
+constexpr size_t POSITIONS = 0;
+constexpr size_t TRIANGLES = 1;
+} // namespace
+
+namespace gims
+{
+CograBinaryMeshWriter::CograBinaryMeshWriter() = default;
+
+CograBinaryMeshWriter::CograBinaryMeshWriter(const std::string& fileName, ui64 chunkSize)
+{
+  open(fileName, chunkSize);
+}
+
+CograBinaryMeshWriter::~CograBinaryMeshWriter()
+{
+  try
+  {
+    close();
+  }
+  catch (const std::exception&)
+  {
+  }
+}
+
+void CograBinaryMeshWriter::open(const std::string& fileName, ui64 chunkSize)
+{
+  close();
+  reset();
+  if (chunkSize == 0)
+  {
+    throw std::invalid_argument("The chunk size must not be 0.");
+  }
+  m_chunkSize = chunkSize;
+  m_file.open(fileName, std::ios::out | std::ios::binary);
+  if (!m_file.is_open())
+  {
+    throw std::runtime_error("Error opening file " + fileName + " for writing.");
+  }
+  m_file.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+  m_fileName = fileName;
+
+  m_streams.resize(2);
+  m_streams[POSITIONS].type          = impl::SECTION_POSITIONS;
+  m_streams[POSITIONS].components    = 3;
+  m_streams[POSITIONS].componentSize = sizeof(FloatType);
+  m_streams[TRIANGLES].type          = impl::SECTION_TRIANGLES;
+  m_streams[TRIANGLES].components    = 3;
+  m_streams[TRIANGLES].componentSize = sizeof(IndexType);
+
+  // The header is written on close.
+  const impl::CograBinaryMeshHeaderV2 header = {};
+  m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void CograBinaryMeshWriter::close()
+{
+  if (!m_file.is_open())
+  {
+    return;
+  }
+  if (m_nTriangles != 0 && m_maxIndex >= m_nVertices)
+  {
+    m_file.close();
+    reset();
+    throw std::runtime_error("Triangle index out of range in file " + m_fileName + ".");
+  }
+
+  impl::CograBinaryMeshLayout layout;
+  layout.nVertices    = m_nVertices;
+  layout.nTriangles   = m_nTriangles;
+  layout.hasBounds    = m_nVertices != 0;
+  layout.hasChecksums = true;
+  layout.chunked      = true;
+  layout.boundsMin    = m_boundsMin;
+  layout.boundsMax    = m_boundsMax;
+
+  // Every array gets at least one, possibly empty, chunk, so that the reader learns about it.
+  for (auto& s : m_streams)
+  {
+    if (!s.buffer.empty() || s.nChunks == 0)
+    {
+      writeChunk(s);
+    }
+  }
+  Stream names;
+  names.type = impl::SECTION_NAMES;
+  writeSection(names, m_names.data(), m_names.size());
+
+  // Chunks of different arrays were written as their buffers filled up. The reader expects the first chunk of each
+  // attribute and constant in the order of their indices. A stable sort keeps the chunks of each array in order.
+  std::stable_sort(m_sectionTable.begin(), m_sectionTable.end(),
+                   [](const impl::CograBinaryMeshSectionEntryV2& a, const impl::CograBinaryMeshSectionEntryV2& b)
+                   { return a.type != b.type ? a.type < b.type : a.elementIndex < b.elementIndex; });
+  impl::writePadding(m_file, (static_cast<ui64>(m_file.tellp()) + impl::CBM_V2_ALIGNMENT - 1) &
+                                 ~(impl::CBM_V2_ALIGNMENT - 1));
+  const ui64 sectionTableOffset = static_cast<ui64>(m_file.tellp());
+  m_file.write(reinterpret_cast<const char*>(m_sectionTable.data()),
+               static_cast<std::streamsize>(m_sectionTable.size() * sizeof(impl::CograBinaryMeshSectionEntryV2)));
+
+  const impl::CograBinaryMeshHeaderV2 header =
+      impl::createCograBinaryMeshHeaderV2(layout, static_cast<ui32>(m_sectionTable.size()), sectionTableOffset);
+  m_file.seekp(0);
+  m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  m_file.close();
+  reset();
+}
+
+bool CograBinaryMeshWriter::isOpen() const
+{
+  return m_file.is_open();
+}
+
+CograBinaryMeshWriter::SizeType CograBinaryMeshWriter::addAttribute(SizeType nComponents, SizeType componentSize,
+                                                                    const std::string& attributeName)
+{
+  checkOpen();
+  if (m_nVertices != 0)
+  {
+    throw std::runtime_error("Attributes must be added before the first vertices.");
+  }
+  Stream s;
+  s.type          = impl::SECTION_ATTRIBUTE;
+  s.elementIndex  = static_cast<ui32>(m_streams.size() - 2);
+  s.components    = nComponents;
+  s.componentSize = componentSize;
+  addName(s, attributeName);
+  m_streams.push_back(std::move(s));
+  return static_cast<SizeType>(m_streams.size() - 2);
+}
+
+CograBinaryMeshWriter::SizeType CograBinaryMeshWriter::addConstant(const void* constant, SizeType nComponents,
+                                                                   SizeType           componentSize,
+                                                                   const std::string& constantName)
+{
+  checkOpen();
+  Stream s;
+  s.type          = impl::SECTION_CONSTANT;
+  s.elementIndex  = m_nConstants++;
+  s.components    = nComponents;
+  s.componentSize = componentSize;
+  addName(s, constantName);
+  writeSection(s, constant, ui64(nComponents) * componentSize);
+  return m_nConstants;
+}
+
+void CograBinaryMeshWriter::addVertices(const FloatType* positions, const void* const* attributes, SizeType nVertices)
+{
+  checkOpen();
+  if (nVertices == 0)
+  {
+    return;
+  }
+  // CograBinaryMeshFile addresses positions with 32 bit indices.
+  if (ui64(m_nVertices) + nVertices > std::numeric_limits<SizeType>::max() / 3)
+  {
+    throw std::runtime_error("Too many vertices in file " + m_fileName + ".");
+  }
+  for (SizeType i = 0; i < nVertices; i++)
+  {
+    const f32v3 p(positions[i * 3 + 0], positions[i * 3 + 1], positions[i * 3 + 2]);
+    m_boundsMin = m_nVertices == 0 && i == 0 ? p : glm::min(m_boundsMin, p);
+    m_boundsMax = m_nVertices == 0 && i == 0 ? p : glm::max(m_boundsMax, p);
+  }
+  append(m_streams[POSITIONS], positions, ui64(nVertices) * 3 * sizeof(FloatType));
+  for (size_t a = 2; a < m_streams.size(); a++)
+  {
+    const ui64 elementSize = ui64(m_streams[a].components) * m_streams[a].componentSize;
+    append(m_streams[a], attributes[a - 2], elementSize * nVertices);
+  }
+  m_nVertices += nVertices;
+}
+
+void CograBinaryMeshWriter::addTriangles(const IndexType* triIdx, SizeType nTriangles, IndexType baseVertex)
+{
+  checkOpen();
+  if (ui64(m_nTriangles) + nTriangles > std::numeric_limits<SizeType>::max() / 3)
+  {
+    throw std::runtime_error("Too many triangles in file " + m_fileName + ".");
+  }
+  const ui64 nIndices = ui64(nTriangles) * 3;
+  // The largest sum is checked in 64 bits before anything is written, as it would wrap around to a valid looking index
+  // in 32 bits, and a partially added batch of triangles would corrupt the file.
+  if (baseVertex != 0 && nIndices != 0)
+  {
+    const ui64 maxIndex = ui64(*std::max_element(triIdx, triIdx + nIndices)) + baseVertex;
+    if (maxIndex > std::numeric_limits<IndexType>::max())
+    {
+      throw std::runtime_error("Triangle index plus base vertex exceeds 32 bits in file " + m_fileName + ".");
+    }
+  }
+  // Indices are offset in small batches, so that no copy of the whole input is needed.
+  IndexType batch[3 * 1024];
+  for (ui64 i = 0; i < nIndices; i += std::size(batch))
+  {
+    const ui64 n = std::min<ui64>(std::size(batch), nIndices - i);
+    for (ui64 j = 0; j < n; j++)
+    {
+      batch[j]   = triIdx[i + j] + baseVertex;
+      m_maxIndex = std::max(m_maxIndex, batch[j]);
+    }
+    append(m_streams[TRIANGLES], batch, n * sizeof(IndexType));
+  }
+  m_nTriangles += nTriangles;
+}
+
+CograBinaryMeshWriter::SizeType CograBinaryMeshWriter::getNumVertices() const
+{
+  return m_nVertices;
+}
+
+CograBinaryMeshWriter::SizeType CograBinaryMeshWriter::getNumTriangles() const
+{
+  return m_nTriangles;
+}
+
+void CograBinaryMeshWriter::checkOpen() const
+{
+  if (!m_file.is_open())
+  {
+    throw std::runtime_error("No CBM file is open for writing.");
+  }
+}
+
+void CograBinaryMeshWriter::reset()
+{
+  m_streams.clear();
+  m_sectionTable.clear();
+  m_names.clear();
+  m_nConstants = 0;
+  m_nVertices  = 0;
+  m_nTriangles = 0;
+  m_maxIndex   = 0;
+  m_boundsMin  = f32v3(0.0f);
+  m_boundsMax  = f32v3(0.0f);
+}
+
+void CograBinaryMeshWriter::append(Stream& stream, const void* data, ui64 sizeInBytes)
+{
+  const auto* source = static_cast<const ui8*>(data);
+  while (sizeInBytes > 0)
+  {
+    const ui64 n = std::min(sizeInBytes, m_chunkSize - stream.buffer.size());
+    stream.buffer.insert(stream.buffer.end(), source, source + n);
+    source += n;
+    sizeInBytes -= n;
+    if (stream.buffer.size() == m_chunkSize)
+    {
+      writeChunk(stream);
+    }
+  }
+}
+
+void CograBinaryMeshWriter::writeChunk(Stream& stream)
+{
+  writeSection(stream, stream.buffer.data(), stream.buffer.size());
+  stream.buffer.clear();
+  stream.nChunks++;
+}
+
+void CograBinaryMeshWriter::writeSection(const Stream& stream, const void* data, ui64 sizeInBytes)
+{
+  impl::CograBinaryMeshSection section;
+  section.offset =
+      (static_cast<ui64>(m_file.tellp()) + impl::CBM_V2_ALIGNMENT - 1) & ~(impl::CBM_V2_ALIGNMENT - 1);
+  section.storedSizeInBytes = sizeInBytes;
+  section.sizeInBytes       = sizeInBytes;
+  section.checksum          = impl::crc32(data, sizeInBytes);
+
+  impl::CograBinaryMeshSectionEntryV2 entry = impl::createCograBinaryMeshSectionEntryV2(stream.type, section);
+  entry.components                          = stream.components;
+  entry.componentSize                       = stream.componentSize;
+  entry.nameOffset                          = stream.nameOffset;
+  entry.nameLength                          = stream.nameLength;
+  entry.elementIndex                        = stream.elementIndex;
+  m_sectionTable.push_back(entry);
+
+  impl::writePadding(m_file, section.offset);
+  m_file.write(static_cast<const char*>(data), static_cast<std::streamsize>(sizeInBytes));
+}
+
+void CograBinaryMeshWriter::addName(Stream& stream, const std::string& name)
+{
+  stream.nameOffset = static_cast<ui32>(m_names.size());
+  stream.nameLength = static_cast<ui32>(name.size());
+  m_names.append(name.c_str(), name.size() + 1);
+}
+} // namespace gims
@@ -0,0 +1,175 @@
+#include <gimslib/io/MemoryMappedFile.hpp>
+#include <stdexcept>
+#include <utility>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gims
+{
+MemoryMappedFile::MemoryMappedFile(const std::string& fileName)
+{
+  open(fileName);
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+  close();
+}
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept
+{
+  swap(other);
+}
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) noexcept
+{
+  MemoryMappedFile tmp(std::move(other));
+  swap(tmp);
+  return *this;
+}
+
+void MemoryMappedFile::swap(MemoryMappedFile& other) noexcept
+{
+#ifdef _WIN32
+  std::swap(m_fileHandle, other.m_fileHandle);
+  std::swap(m_mappingHandle, other.m_mappingHandle);
+#else
+  std::swap(m_fileDescriptor, other.m_fileDescriptor);
+#endif
+  std::swap(m_data, other.m_data);
+  std::swap(m_size, other.m_size);
+}
+
+#ifdef _WIN32
+void MemoryMappedFile::open(const std::string& fileName)
+{
+  close();
+  const HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    throw std::runtime_error("Error opening file " + fileName + ".");
+  }
+  m_fileHandle = file;
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize))
+  {
+    close();
+    throw std::runtime_error("Error querying the size of " + fileName + ".");
+  }
+  m_size = static_cast<size_t>(fileSize.QuadPart);
+  if (m_size == 0)
+  {
+    return;
+  }
+
+  m_mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mappingHandle == nullptr)
+  {
+    close();
+    throw std::runtime_error("Error mapping file " + fileName + ".");
+  }
+  m_data = static_cast<const ui8*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+  if (m_data == nullptr)
+  {
+    close();
+    throw std::runtime_error("Error mapping file " + fileName + ".");
+  }
+}
+
+void MemoryMappedFile::close()
+{
+  if (m_data != nullptr)
+  {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mappingHandle != nullptr)
+  {
+    CloseHandle(m_mappingHandle);
+  }
+  if (m_fileHandle != nullptr)
+  {
+    CloseHandle(m_fileHandle);
+  }
+  m_fileHandle    = nullptr;
+  m_mappingHandle = nullptr;
+  m_data          = nullptr;
+  m_size          = 0;
+}
+
+bool MemoryMappedFile::isOpen() const
+{
+  return m_fileHandle != nullptr;
+}
+#else
+void MemoryMappedFile::open(const std::string& fileName)
+{
+  close();
+  m_fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+  if (m_fileDescriptor < 0)
+  {
+    throw std::runtime_error("Error opening file " + fileName + ".");
+  }
+
+  struct stat fileStatus;
+  if (fstat(m_fileDescriptor, &fileStatus) != 0)
+  {
+    close();
+    throw std::runtime_error("Error querying the size of " + fileName + ".");
+  }
+  m_size = static_cast<size_t>(fileStatus.st_size);
+  if (m_size == 0)
+  {
+    return;
+  }
+
+  void* const mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+  if (mapping == MAP_FAILED)
+  {
+    close();
+    throw std::runtime_error("Error mapping file " + fileName + ".");
+  }
+  m_data = static_cast<const ui8*>(mapping);
+}
+
+void MemoryMappedFile::close()
+{
+  if (m_data != nullptr)
+  {
+    munmap(const_cast<ui8*>(m_data), m_size);
+  }
+  if (m_fileDescriptor >= 0)
+  {
+    ::close(m_fileDescriptor);
+  }
+  m_fileDescriptor = -1;
+  m_data           = nullptr;
+  m_size           = 0;
+}
+
+bool MemoryMappedFile::isOpen() const
+{
+  return m_fileDescriptor >= 0;
+}
+#endif
+
+const ui8* MemoryMappedFile::data() const
+{
+  return m_data;
+}
+
+size_t MemoryMappedFile::size() const
+{
+  return m_size;
+}
+} // namespace gims
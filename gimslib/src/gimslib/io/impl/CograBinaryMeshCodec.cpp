@@ -0,0 +1,241 @@
+#include "CograBinaryMeshCodec.hpp"
+#include "RansCoder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+using namespace gims;
+using namespace gims::impl;
+
+ui32 zigzag(i32 v)
+{
+  return (static_cast<ui32>(v) << 1) ^ static_cast<ui32>(v >> 31);
+}
+
+i32 unzigzag(ui32 v)
+{
+  return static_cast<i32>(v >> 1) ^ -static_cast<i32>(v & 1);
+}
+
+//! Shuffles and entropy codes the transformed payload.
+std::vector<ui8> pack(const std::vector<ui8>& transformed, ui32 stride)
+{
+  std::vector<ui8> shuffled(transformed.size());
+  shuffleBytes(transformed.data(), shuffled.data(), transformed.size(), stride);
+  std::vector<ui8> result;
+  ransEncode(shuffled.data(), shuffled.size(), result);
+  return result;
+}
+
+ui32 maxQuantized(ui32 bits)
+{
+  return (1u << bits) - 1;
+}
+
+f32 octahedralSign(f32 v)
+{
+  return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+std::vector<ui8> encodeIndices(const ui32* indices, ui64 n)
+{
+  std::vector<ui8> transformed(n * sizeof(ui32));
+  ui32             previous = 0;
+  for (ui64 i = 0; i < n; i++)
+  {
+    const ui32 delta = zigzag(static_cast<i32>(indices[i] - previous));
+    std::memcpy(transformed.data() + i * sizeof(ui32), &delta, sizeof(ui32));
+    previous = indices[i];
+  }
+  return pack(transformed, sizeof(ui32));
+}
+
+//! Reverts the delta coding in place.
+void decodeIndices(ui32* indices, ui64 n)
+{
+  ui32 previous = 0;
+  for (ui64 i = 0; i < n; i++)
+  {
+    previous   = previous + static_cast<ui32>(unzigzag(indices[i]));
+    indices[i] = previous;
+  }
+}
+
+//! Positions are quantized to the bounding box, neighbouring vertices are delta coded per component.
+std::vector<ui8> encodePositions(const f32* positions, ui64 nVertices, ui32 bits, const CograBinaryMeshLayout& layout)
+{
+  const f32v3      extent = layout.boundsMax - layout.boundsMin;
+  const f32        qMax   = static_cast<f32>(maxQuantized(bits));
+  std::vector<ui8> transformed(nVertices * 3 * sizeof(ui16));
+  ui16             previous[3] = {0, 0, 0};
+  for (ui64 i = 0; i < nVertices; i++)
+  {
+    for (ui32 c = 0; c < 3; c++)
+    {
+      const f32  t     = extent[c] > 0.0f ? (positions[i * 3 + c] - layout.boundsMin[c]) / extent[c] : 0.0f;
+      const auto q     = static_cast<ui16>(std::lround(std::clamp(t, 0.0f, 1.0f) * qMax));
+      const auto delta = static_cast<ui16>(zigzag(static_cast<i16>(q - previous[c])));
+      std::memcpy(transformed.data() + (i * 3 + c) * sizeof(ui16), &delta, sizeof(ui16));
+      previous[c] = q;
+    }
+  }
+  return pack(transformed, sizeof(ui16));
+}
+
+//! The quantized deltas may be stored in the second half of positions, as every vertex is read before it is written.
+void decodePositions(const ui8* quantized, f32* positions, ui64 nVertices, ui32 bits,
+                     const CograBinaryMeshLayout& layout)
+{
+  const f32v3 scale       = (layout.boundsMax - layout.boundsMin) / static_cast<f32>(maxQuantized(bits));
+  ui16        previous[3] = {0, 0, 0};
+  for (ui64 i = 0; i < nVertices; i++)
+  {
+    ui16 delta[3];
+    std::memcpy(delta, quantized + i * sizeof(delta), sizeof(delta));
+    for (ui32 c = 0; c < 3; c++)
+    {
+      previous[c]          = static_cast<ui16>(previous[c] + unzigzag(delta[c]));
+      positions[i * 3 + c] = layout.boundsMin[c] + static_cast<f32>(previous[c]) * scale[c];
+    }
+  }
+}
+
+//! Unit vectors are projected onto an octahedron, which is unfolded into a square.
+std::vector<ui8> encodeNormals(const f32* normals, ui64 n)
+{
+  std::vector<ui8> transformed(n * 2 * sizeof(i16));
+  for (ui64 i = 0; i < n; i++)
+  {
+    const f32v3 v(normals[i * 3 + 0], normals[i * 3 + 1], normals[i * 3 + 2]);
+    const f32   l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    f32v2       o  = l1 > 0.0f ? f32v2(v.x, v.y) / l1 : f32v2(0.0f);
+    if (v.z < 0.0f)
+    {
+      o = f32v2((1.0f - std::abs(o.y)) * octahedralSign(o.x), (1.0f - std::abs(o.x)) * octahedralSign(o.y));
+    }
+    for (ui32 c = 0; c < 2; c++)
+    {
+      const auto q = static_cast<i16>(std::lround(std::clamp(o[c], -1.0f, 1.0f) * 32767.0f));
+      std::memcpy(transformed.data() + (i * 2 + c) * sizeof(i16), &q, sizeof(i16));
+    }
+  }
+  return pack(transformed, sizeof(i16));
+}
+
+//! The quantized normals may be stored in the last third of normals, as every normal is read before it is written.
+void decodeNormals(const ui8* quantized, f32* normals, ui64 n)
+{
+  for (ui64 i = 0; i < n; i++)
+  {
+    i16 q[2];
+    std::memcpy(q, quantized + i * sizeof(q), sizeof(q));
+    const f32v2 o(static_cast<f32>(q[0]) / 32767.0f, static_cast<f32>(q[1]) / 32767.0f);
+    f32v3       v(o.x, o.y, 1.0f - std::abs(o.x) - std::abs(o.y));
+    if (v.z < 0.0f)
+    {
+      v.x = (1.0f - std::abs(o.y)) * octahedralSign(o.x);
+      v.y = (1.0f - std::abs(o.x)) * octahedralSign(o.y);
+    }
+    v                  = glm::normalize(v);
+    normals[i * 3 + 0] = v.x;
+    normals[i * 3 + 1] = v.y;
+    normals[i * 3 + 2] = v.z;
+  }
+}
+
+void checkElementSize(const CograBinaryMeshSection& section, ui64 elementSize)
+{
+  if (section.sizeInBytes % elementSize != 0)
+  {
+    throw std::runtime_error("CBM section size does not match its encoding.");
+  }
+}
+} // namespace
+
+namespace gims
+{
+namespace impl
+{
+std::vector<ui8> encodeCograBinaryMeshSection(CograBinaryMeshSection& section, const void* data,
+                                              const CograBinaryMeshLayout& layout)
+{
+  std::vector<ui8> result;
+  switch (section.encoding)
+  {
+  case ENCODING_RAW:
+    result.assign(static_cast<const ui8*>(data), static_cast<const ui8*>(data) + section.sizeInBytes);
+    break;
+  case ENCODING_SHUFFLE_RANS:
+    result = pack(std::vector<ui8>(static_cast<const ui8*>(data), static_cast<const ui8*>(data) + section.sizeInBytes),
+                  std::max(1u, section.encodingParameter));
+    break;
+  case ENCODING_INDEX_DELTA_RANS:
+    result = encodeIndices(static_cast<const ui32*>(data), section.sizeInBytes / sizeof(ui32));
+    break;
+  case ENCODING_QUANTIZED_POSITIONS:
+    result = encodePositions(static_cast<const f32*>(data), section.sizeInBytes / (3 * sizeof(f32)),
+                             section.encodingParameter, layout);
+    break;
+  case ENCODING_OCTAHEDRAL_NORMALS:
+    result = encodeNormals(static_cast<const f32*>(data), section.sizeInBytes / (3 * sizeof(f32)));
+    break;
+  default:
+    throw std::runtime_error("Unsupported CBM section encoding " + std::to_string(section.encoding) + ".");
+  }
+  section.storedSizeInBytes = result.size();
+  return result;
+}
+
+void decodeCograBinaryMeshSection(const CograBinaryMeshSection& section, const ui8* storedData, void* data,
+                                  const CograBinaryMeshLayout& layout)
+{
+  switch (section.encoding)
+  {
+  case ENCODING_RAW:
+    std::memcpy(data, storedData, section.sizeInBytes);
+    break;
+  case ENCODING_SHUFFLE_RANS:
+    ransDecode(storedData, section.storedSizeInBytes, static_cast<ui8*>(data), section.sizeInBytes,
+               std::max(1u, section.encodingParameter));
+    break;
+  case ENCODING_INDEX_DELTA_RANS:
+  {
+    checkElementSize(section, sizeof(ui32));
+    const ui64 n = section.sizeInBytes / sizeof(ui32);
+    ransDecode(storedData, section.storedSizeInBytes, static_cast<ui8*>(data), section.sizeInBytes, sizeof(ui32));
+    decodeIndices(static_cast<ui32*>(data), n);
+    break;
+  }
+  // The quantized values are smaller than the decoded ones, so they are decoded to the end of data and expanded in
+  // place from the front, without a temporary copy of the payload.
+  case ENCODING_QUANTIZED_POSITIONS:
+  {
+    checkElementSize(section, 3 * sizeof(f32));
+    if (section.encodingParameter == 0 || section.encodingParameter > 16 || !layout.hasBounds)
+    {
+      throw std::runtime_error("CBM positions are quantized without bounds or with an invalid number of bits.");
+    }
+    const ui64 n         = section.sizeInBytes / (3 * sizeof(f32));
+    ui8* const quantized = static_cast<ui8*>(data) + n * 3 * sizeof(ui16);
+    ransDecode(storedData, section.storedSizeInBytes, quantized, n * 3 * sizeof(ui16), sizeof(ui16));
+    decodePositions(quantized, static_cast<f32*>(data), n, section.encodingParameter, layout);
+    break;
+  }
+  case ENCODING_OCTAHEDRAL_NORMALS:
+  {
+    checkElementSize(section, 3 * sizeof(f32));
+    const ui64 n         = section.sizeInBytes / (3 * sizeof(f32));
+    ui8* const quantized = static_cast<ui8*>(data) + n * 2 * sizeof(f32);
+    ransDecode(storedData, section.storedSizeInBytes, quantized, n * 2 * sizeof(i16), sizeof(i16));
+    decodeNormals(quantized, static_cast<f32*>(data), n);
+    break;
+  }
+  default:
+    throw std::runtime_error("Unsupported CBM section encoding " + std::to_string(section.encoding) + ".");
+  }
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,28 @@
+#pragma once
+#include "CograBinaryMeshLayout.hpp"
+#include <vector>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Encodes a payload.
+//!
+//! section.encoding and section.encodingParameter select the encoding, section.sizeInBytes is the size of data.
+//! Sets section.storedSizeInBytes.
+//! \param[in,out]  section The section the payload belongs to.
+//! \param[in]  data The payload.
+//! \param[in]  layout Provides the bounds for ENCODING_QUANTIZED_POSITIONS.
+//! \return The encoded payload.
+std::vector<ui8> encodeCograBinaryMeshSection(CograBinaryMeshSection& section, const void* data,
+                                              const CograBinaryMeshLayout& layout);
+
+//! \brief Decodes a payload. Throws std::runtime_error on malformed input.
+//! \param[in]  section The section the payload belongs to.
+//! \param[in]  storedData The payload as stored in the file, section.storedSizeInBytes bytes.
+//! \param[out]  data Destination of section.sizeInBytes decoded bytes, also used as scratch space while decoding.
+//! \param[in]  layout Provides the bounds for ENCODING_QUANTIZED_POSITIONS.
+void decodeCograBinaryMeshSection(const CograBinaryMeshSection& section, const ui8* storedData, void* data,
+                                  const CograBinaryMeshLayout& layout);
+} // namespace impl
+} // namespace gims
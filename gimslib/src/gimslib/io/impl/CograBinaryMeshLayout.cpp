@@ -0,0 +1,417 @@
+#include "CograBinaryMeshLayout.hpp"
+#include "Crc32.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+//! Maximum number of characters used for attribute and constant names in version 1 files.
+constexpr gims::ui32 N_CHARS_V1 = 256;
+
+template<class T> T read(std::istream& inFile)
+{
+  T result {};
+  inFile.read(reinterpret_cast<char*>(&result), sizeof(T));
+  return result;
+}
+
+gims::ui64 alignUp(gims::ui64 offset)
+{
+  return (offset + gims::impl::CBM_V2_ALIGNMENT - 1) & ~(gims::impl::CBM_V2_ALIGNMENT - 1);
+}
+
+//! The count is checked against the rest of the file before anything is allocated, as each element takes
+//! 2 * sizeof(ui32) + N_CHARS_V1 bytes of the header.
+std::vector<gims::impl::CograBinaryMeshElement> readElementsV1(std::istream& inFile, gims::ui64 fileSize)
+{
+  const auto       n        = read<gims::ui32>(inFile);
+  const gims::ui64 position = static_cast<gims::ui64>(inFile.tellg());
+  if (position > fileSize || n > (fileSize - position) / (2 * sizeof(gims::ui32) + N_CHARS_V1))
+  {
+    throw std::runtime_error("CBM header has more attributes or constants than fit into the file.");
+  }
+  std::vector<gims::impl::CograBinaryMeshElement> result(n);
+  for (auto& e : result)
+  {
+    e.components = read<gims::ui32>(inFile);
+  }
+  for (auto& e : result)
+  {
+    e.componentSize = read<gims::ui32>(inFile);
+  }
+  for (auto& e : result)
+  {
+    char name[N_CHARS_V1 + 1] = {};
+    inFile.read(name, N_CHARS_V1);
+    e.name = name;
+  }
+  return result;
+}
+
+gims::ui64 place(gims::impl::CograBinaryMeshSection& section, gims::ui64 offset, gims::ui64 sizeInBytes)
+{
+  section.offset            = offset;
+  section.storedSizeInBytes = sizeInBytes;
+  section.sizeInBytes       = sizeInBytes;
+  return offset + sizeInBytes;
+}
+
+gims::ui64 placeAligned(gims::impl::CograBinaryMeshSection& section, gims::ui64 offset)
+{
+  section.offset = alignUp(offset);
+  return section.offset + section.storedSizeInBytes;
+}
+
+gims::impl::CograBinaryMeshLayout readLayoutV1(std::istream& inFile, gims::ui64 fileSize)
+{
+  gims::impl::CograBinaryMeshLayout result;
+  result.version    = 1;
+  result.nVertices  = read<gims::ui32>(inFile);
+  result.nTriangles = read<gims::ui32>(inFile);
+  result.attributes = readElementsV1(inFile, fileSize);
+  result.constants  = readElementsV1(inFile, fileSize);
+
+  // Version 1 stores the payloads back to back in the order positions, triangles, attributes, constants.
+  gims::ui64 offset = static_cast<gims::ui64>(inFile.tellg());
+  offset            = place(result.positions, offset, result.nVertices * 3 * sizeof(gims::f32));
+  offset            = place(result.triangles, offset, result.nTriangles * 3 * sizeof(gims::ui32));
+  for (auto& a : result.attributes)
+  {
+    offset = place(a.section, offset, gims::ui64(a.components) * a.componentSize * result.nVertices);
+  }
+  for (auto& c : result.constants)
+  {
+    offset = place(c.section, offset, gims::ui64(c.components) * c.componentSize);
+  }
+  return result;
+}
+
+//! Sets a section, or appends a chunk to it in chunked files.
+void addSection(gims::impl::CograBinaryMeshSection& section, const gims::impl::CograBinaryMeshSection& chunk,
+                bool chunked)
+{
+  if (!chunked)
+  {
+    section = chunk;
+    return;
+  }
+  section.chunks.push_back(chunk);
+  section.offset = section.chunks.front().offset;
+  section.storedSizeInBytes += chunk.storedSizeInBytes;
+  section.sizeInBytes += chunk.sizeInBytes;
+}
+
+gims::impl::CograBinaryMeshLayout readLayoutV2(std::istream& inFile, gims::ui64 fileSize)
+{
+  using namespace gims::impl;
+  const auto header = read<CograBinaryMeshHeaderV2>(inFile);
+  if (header.version != 2)
+  {
+    throw std::runtime_error("Unsupported CBM version " + std::to_string(header.version) + ".");
+  }
+  if (header.sectionTableOffset > fileSize ||
+      header.nSections > (fileSize - header.sectionTableOffset) / sizeof(CograBinaryMeshSectionEntryV2))
+  {
+    throw std::runtime_error("CBM section table is truncated.");
+  }
+
+  CograBinaryMeshLayout result;
+  result.version      = header.version;
+  result.nVertices    = header.nVertices;
+  result.nTriangles   = header.nTriangles;
+  result.hasBounds    = (header.flags & HEADER_HAS_BOUNDS) != 0;
+  result.hasChecksums = (header.flags & HEADER_HAS_CHECKSUMS) != 0;
+  result.chunked      = (header.flags & HEADER_CHUNKED) != 0;
+  result.boundsMin    = gims::f32v3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+  result.boundsMax    = gims::f32v3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+
+  std::vector<CograBinaryMeshSectionEntryV2> entries(header.nSections);
+  inFile.seekg(static_cast<std::streamoff>(header.sectionTableOffset));
+  inFile.read(reinterpret_cast<char*>(entries.data()),
+              static_cast<std::streamsize>(entries.size() * sizeof(CograBinaryMeshSectionEntryV2)));
+
+  std::string names;
+  for (const auto& e : entries)
+  {
+    if (e.type == SECTION_NAMES)
+    {
+      if (e.offset > fileSize || e.storedSizeInBytes > fileSize - e.offset)
+      {
+        throw std::runtime_error("CBM names section is truncated.");
+      }
+      names.resize(e.storedSizeInBytes);
+      inFile.seekg(static_cast<std::streamoff>(e.offset));
+      inFile.read(names.data(), static_cast<std::streamsize>(names.size()));
+      result.names.offset            = e.offset;
+      result.names.storedSizeInBytes = e.storedSizeInBytes;
+      result.names.sizeInBytes       = e.storedSizeInBytes;
+      result.names.checksum          = e.checksum;
+    }
+  }
+
+  for (const auto& e : entries)
+  {
+    if (e.encoding >= ENCODING_COUNT || (e.encoding == ENCODING_RAW && e.storedSizeInBytes != e.sizeInBytes))
+    {
+      throw std::runtime_error("Unsupported CBM section encoding " + std::to_string(e.encoding) + ".");
+    }
+    CograBinaryMeshSection section;
+    section.offset            = e.offset;
+    section.storedSizeInBytes = e.storedSizeInBytes;
+    section.sizeInBytes       = e.sizeInBytes;
+    section.checksum          = e.checksum;
+    section.encoding          = e.encoding;
+    section.encodingParameter = e.encodingParameter;
+    if (e.type == SECTION_POSITIONS)
+    {
+      addSection(result.positions, section, result.chunked);
+    }
+    else if (e.type == SECTION_TRIANGLES)
+    {
+      addSection(result.triangles, section, result.chunked);
+    }
+    else if (e.type == SECTION_ATTRIBUTE || e.type == SECTION_CONSTANT)
+    {
+      auto& elements = e.type == SECTION_ATTRIBUTE ? result.attributes : result.constants;
+      if (result.chunked && e.elementIndex < elements.size())
+      {
+        addSection(elements[e.elementIndex].section, section, true);
+        continue;
+      }
+      if (result.chunked && e.elementIndex != elements.size())
+      {
+        throw std::runtime_error("CBM chunks are out of order.");
+      }
+      if (e.nameOffset > names.size() || e.nameLength > names.size() - e.nameOffset)
+      {
+        throw std::runtime_error("CBM section name is out of range.");
+      }
+      elements.push_back({e.components, e.componentSize, names.substr(e.nameOffset, e.nameLength), {}});
+      addSection(elements.back().section, section, result.chunked);
+    }
+    // Unknown section types are skipped, so newer writers may add sections.
+  }
+
+  if (result.positions.sizeInBytes != result.nVertices * 3 * sizeof(gims::f32) ||
+      result.triangles.sizeInBytes != result.nTriangles * 3 * sizeof(gims::ui32))
+  {
+    throw std::runtime_error("CBM section sizes do not match the header.");
+  }
+  for (const auto& a : result.attributes)
+  {
+    if (a.section.sizeInBytes != gims::ui64(a.components) * a.componentSize * result.nVertices)
+    {
+      throw std::runtime_error("CBM attribute " + a.name + " does not match the number of vertices.");
+    }
+  }
+  for (const auto& c : result.constants)
+  {
+    if (c.section.sizeInBytes != gims::ui64(c.components) * c.componentSize)
+    {
+      throw std::runtime_error("CBM constant " + c.name + " does not match its number of components.");
+    }
+  }
+  return result;
+}
+
+void validate(const gims::impl::CograBinaryMeshSection& section, gims::ui64 fileSize)
+{
+  for (const auto& chunk : section.chunks)
+  {
+    validate(chunk, fileSize);
+  }
+  if (section.chunks.empty() && (section.offset > fileSize || section.storedSizeInBytes > fileSize - section.offset))
+  {
+    throw std::runtime_error("CBM file is truncated.");
+  }
+}
+} // namespace
+
+namespace gims
+{
+namespace impl
+{
+CograBinaryMeshLayout readCograBinaryMeshLayout(std::istream& inFile, ui64 fileSize)
+{
+  const auto oldExceptions = inFile.exceptions();
+  inFile.exceptions(std::istream::eofbit | std::istream::failbit | std::istream::badbit);
+  CograBinaryMeshLayout result;
+  try
+  {
+    ui8 magic[sizeof(CBM_MAGIC)] = {};
+    if (fileSize >= sizeof(CograBinaryMeshHeaderV2))
+    {
+      inFile.read(reinterpret_cast<char*>(magic), sizeof(magic));
+      inFile.seekg(-static_cast<std::streamoff>(sizeof(magic)), std::ios_base::cur);
+    }
+    if (std::memcmp(magic, CBM_MAGIC, sizeof(CBM_MAGIC)) == 0)
+    {
+      result = readLayoutV2(inFile, fileSize);
+    }
+    else
+    {
+      result = readLayoutV1(inFile, fileSize);
+    }
+  }
+  catch (const std::ios_base::failure&)
+  {
+    throw std::runtime_error("CBM header is truncated.");
+  }
+  inFile.exceptions(oldExceptions);
+
+  validate(result.positions, fileSize);
+  validate(result.triangles, fileSize);
+  for (const auto& a : result.attributes)
+  {
+    validate(a.section, fileSize);
+  }
+  for (const auto& c : result.constants)
+  {
+    validate(c.section, fileSize);
+  }
+  return result;
+}
+
+ui64 computeCograBinaryMeshLayoutV2(CograBinaryMeshLayout& layout)
+{
+  const ui64 nSections = 3 + layout.attributes.size() + layout.constants.size();
+  ui64       namesSize = 0;
+  for (const auto& a : layout.attributes)
+  {
+    namesSize += a.name.size() + 1;
+  }
+  for (const auto& c : layout.constants)
+  {
+    namesSize += c.name.size() + 1;
+  }
+
+  layout.version = 2;
+  ui64 offset    = sizeof(CograBinaryMeshHeaderV2) + nSections * sizeof(CograBinaryMeshSectionEntryV2);
+  offset         = place(layout.names, alignUp(offset), namesSize);
+  offset         = placeAligned(layout.positions, offset);
+  offset         = placeAligned(layout.triangles, offset);
+  for (auto& a : layout.attributes)
+  {
+    offset = placeAligned(a.section, offset);
+  }
+  for (auto& c : layout.constants)
+  {
+    offset = placeAligned(c.section, offset);
+  }
+  return offset;
+}
+
+CograBinaryMeshHeaderV2 createCograBinaryMeshHeaderV2(const CograBinaryMeshLayout& layout, ui32 nSections,
+                                                      ui64 sectionTableOffset)
+{
+  CograBinaryMeshHeaderV2 result = {};
+  std::memcpy(result.magic, CBM_MAGIC, sizeof(CBM_MAGIC));
+  result.version            = 2;
+  result.flags              = (layout.hasBounds ? ui32(HEADER_HAS_BOUNDS) : 0u) |
+                              (layout.hasChecksums ? ui32(HEADER_HAS_CHECKSUMS) : 0u) |
+                              (layout.chunked ? ui32(HEADER_CHUNKED) : 0u);
+  result.nSections          = nSections;
+  result.nVertices          = layout.nVertices;
+  result.nTriangles         = layout.nTriangles;
+  result.sectionTableOffset = sectionTableOffset;
+  for (int i = 0; i < 3; i++)
+  {
+    result.boundsMin[i] = layout.boundsMin[i];
+    result.boundsMax[i] = layout.boundsMax[i];
+  }
+  return result;
+}
+
+CograBinaryMeshSectionEntryV2 createCograBinaryMeshSectionEntryV2(ui32 type, const CograBinaryMeshSection& section)
+{
+  CograBinaryMeshSectionEntryV2 result = {};
+  result.type                          = type;
+  result.encoding                      = section.encoding;
+  result.encodingParameter             = section.encodingParameter;
+  result.offset                        = section.offset;
+  result.storedSizeInBytes             = section.storedSizeInBytes;
+  result.sizeInBytes                   = section.sizeInBytes;
+  result.checksum                      = section.checksum;
+  return result;
+}
+
+void writeCograBinaryMeshHeaderV2(std::ostream& outFile, const CograBinaryMeshLayout& layout)
+{
+  std::vector<CograBinaryMeshSectionEntryV2> entries;
+  entries.push_back(createCograBinaryMeshSectionEntryV2(SECTION_NAMES, layout.names));
+  entries.push_back(createCograBinaryMeshSectionEntryV2(SECTION_POSITIONS, layout.positions));
+  entries.push_back(createCograBinaryMeshSectionEntryV2(SECTION_TRIANGLES, layout.triangles));
+
+  std::string names;
+  const auto  addElements = [&](const std::vector<CograBinaryMeshElement>& elements, ui32 type)
+  {
+    for (const auto& e : elements)
+    {
+      CograBinaryMeshSectionEntryV2 entry = createCograBinaryMeshSectionEntryV2(type, e.section);
+      entry.components                    = e.components;
+      entry.componentSize                 = e.componentSize;
+      entry.nameOffset                    = static_cast<ui32>(names.size());
+      entry.nameLength                    = static_cast<ui32>(e.name.size());
+      names.append(e.name.c_str(), e.name.size() + 1);
+      entries.push_back(entry);
+    }
+  };
+  addElements(layout.attributes, SECTION_ATTRIBUTE);
+  addElements(layout.constants, SECTION_CONSTANT);
+  entries[0].checksum = crc32(names.data(), names.size());
+
+  const CograBinaryMeshHeaderV2 header =
+      createCograBinaryMeshHeaderV2(layout, static_cast<ui32>(entries.size()), sizeof(CograBinaryMeshHeaderV2));
+  outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  outFile.write(reinterpret_cast<const char*>(entries.data()),
+                static_cast<std::streamsize>(entries.size() * sizeof(CograBinaryMeshSectionEntryV2)));
+  writePadding(outFile, layout.names.offset);
+  outFile.write(names.data(), static_cast<std::streamsize>(names.size()));
+}
+
+void writePadding(std::ostream& outFile, ui64 offset)
+{
+  static const char zeros[CBM_V2_ALIGNMENT] = {};
+  ui64              position                = static_cast<ui64>(outFile.tellp());
+  while (position < offset)
+  {
+    const ui64 n = std::min<ui64>(offset - position, sizeof(zeros));
+    outFile.write(zeros, static_cast<std::streamsize>(n));
+    position += n;
+  }
+}
+
+MemoryStreamBuffer::MemoryStreamBuffer(const ui8* data, size_t size)
+{
+  char* const begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+  setg(begin, begin, begin + size);
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekoff(off_type off, std::ios_base::seekdir dir,
+                                                         std::ios_base::openmode which)
+{
+  if (dir == std::ios_base::cur)
+  {
+    off += gptr() - eback();
+  }
+  else if (dir == std::ios_base::end)
+  {
+    off += egptr() - eback();
+  }
+  return seekpos(off, which);
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+  const off_type off = pos;
+  if ((which & std::ios_base::in) == 0 || off < 0 || off > egptr() - eback())
+  {
+    return pos_type(off_type(-1));
+  }
+  setg(eback(), eback() + off, egptr());
+  return pos;
+}
+} // namespace impl
+} // namespace gims
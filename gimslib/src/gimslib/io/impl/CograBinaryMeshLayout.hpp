@@ -0,0 +1,171 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace gims
+{
+namespace impl
+{
+//! First four bytes of every CBM file of version 2 or later. Version 1 files start with the vertex count instead,
+//! which can never match, since a v1 file with that many vertices would exceed its 32 bit size arithmetic.
+constexpr ui8 CBM_MAGIC[4] = {0x89, 'C', 'B', 'M'};
+
+//! Alignment in bytes of every payload of a version 2 file. Covers 16 byte SIMD loads and cache lines.
+constexpr ui64 CBM_V2_ALIGNMENT = 64;
+
+//! Section types of version 2 files.
+enum CograBinaryMeshSectionType : ui32
+{
+  SECTION_NAMES     = 1,
+  SECTION_POSITIONS = 2,
+  SECTION_TRIANGLES = 3,
+  SECTION_ATTRIBUTE = 4,
+  SECTION_CONSTANT  = 5
+};
+
+//! \brief Encodings of version 2 payloads.
+//!
+//! All encodings except ENCODING_RAW end with a byte shuffle followed by an order-0 rANS entropy coder.
+enum CograBinaryMeshEncoding : ui32
+{
+  ENCODING_RAW                 = 0, //! Payload stored as is.
+  ENCODING_SHUFFLE_RANS        = 1, //! Lossless. Parameter: stride in bytes of the byte shuffle.
+  ENCODING_INDEX_DELTA_RANS    = 2, //! Lossless. ui32 indices as zigzag encoded deltas to the previous index.
+  ENCODING_QUANTIZED_POSITIONS = 3, //! Lossy. Parameter: bits per component, quantized to the bounds in the header.
+  ENCODING_OCTAHEDRAL_NORMALS  = 4, //! Lossy. Unit vectors as two 16 bit octahedral coordinates.
+  ENCODING_COUNT
+};
+
+//! Header flags of version 2 files.
+enum CograBinaryMeshHeaderFlags : ui32
+{
+  HEADER_HAS_BOUNDS    = 0x1,
+  HEADER_HAS_CHECKSUMS = 0x2,
+  HEADER_CHUNKED       = 0x4 //! Payloads may be split into several entries, see CograBinaryMeshSectionEntryV2.
+};
+
+//! \brief Fixed size header at offset 0 of a version 2 file.
+struct CograBinaryMeshHeaderV2
+{
+  ui8  magic[4];           //! CBM_MAGIC.
+  ui32 version;            //! File format version.
+  ui32 flags;              //! Combination of CograBinaryMeshHeaderFlags.
+  ui32 nSections;          //! Number of entries in the section table.
+  ui64 nVertices;          //! Number of vertices.
+  ui64 nTriangles;         //! Number of triangles.
+  ui64 sectionTableOffset; //! Offset of the section table in bytes.
+  f32  boundsMin[3];       //! Lower corner of the axis aligned bounding box of the positions.
+  f32  boundsMax[3];       //! Upper corner of the axis aligned bounding box of the positions.
+};
+static_assert(sizeof(CograBinaryMeshHeaderV2) == 64, "CBM v2 header must be 64 bytes.");
+
+//! \brief Entry of the section table of a version 2 file.
+struct CograBinaryMeshSectionEntryV2
+{
+  ui32 type;              //! One of CograBinaryMeshSectionType.
+  ui32 encoding;          //! One of CograBinaryMeshEncoding.
+  ui32 components;        //! Components per element (attributes and constants).
+  ui32 componentSize;     //! Bytes per component (attributes and constants).
+  ui64 offset;            //! Offset of the payload in bytes, a multiple of CBM_V2_ALIGNMENT.
+  ui64 storedSizeInBytes; //! Size of the payload as stored in the file.
+  ui64 sizeInBytes;       //! Size of the payload once decoded.
+  ui32 nameOffset;        //! Offset of the zero terminated name within the names section.
+  ui32 nameLength;        //! Length of the name without the terminating zero.
+  ui32 checksum;          //! CRC-32 of the stored payload, if HEADER_HAS_CHECKSUMS is set.
+  ui32 encodingParameter; //! Depends on the encoding.
+  ui32 elementIndex;      //! Index of the attribute or constant a chunk belongs to, if HEADER_CHUNKED is set.
+  ui32 reserved;
+};
+static_assert(sizeof(CograBinaryMeshSectionEntryV2) == 64, "CBM v2 section entries must be 64 bytes.");
+
+//! \brief Byte range of a payload within a CBM file and how it is encoded.
+//!
+//! Payloads written in pieces list them in chunks. Offset, stored size, checksum, and encoding then refer to the
+//! chunks, and sizeInBytes is the total size of the payload.
+struct CograBinaryMeshSection
+{
+  ui64                                offset            = 0;
+  ui64                                storedSizeInBytes = 0;
+  ui64                                sizeInBytes       = 0;
+  ui32                                checksum          = 0;
+  ui32                                encoding          = ENCODING_RAW;
+  ui32                                encodingParameter = 0;
+  std::vector<CograBinaryMeshSection> chunks;
+};
+
+//! Describes an attribute array or a constant stored in a CBM file.
+struct CograBinaryMeshElement
+{
+  ui32                   components    = 0;
+  ui32                   componentSize = 0;
+  std::string            name;
+  CograBinaryMeshSection section;
+};
+
+//! \brief Where everything lives inside a CBM file.
+//!
+//! Obtained by reading the header only, so payloads can be located without parsing the file sequentially.
+struct CograBinaryMeshLayout
+{
+  ui32                                version      = 1;
+  ui64                                nVertices    = 0;
+  ui64                                nTriangles   = 0;
+  bool                                hasBounds    = false;
+  bool                                hasChecksums = false;
+  bool                                chunked      = false;
+  f32v3                               boundsMin    = f32v3(0.0f);
+  f32v3                               boundsMax    = f32v3(0.0f);
+  CograBinaryMeshSection              names;
+  CograBinaryMeshSection              positions;
+  CograBinaryMeshSection              triangles;
+  std::vector<CograBinaryMeshElement> attributes;
+  std::vector<CograBinaryMeshElement> constants;
+};
+
+//! \brief Reads the header of a CBM file of any version and computes the location of all payloads.
+//!
+//! Throws std::runtime_error if the header is malformed or a payload extends beyond fileSize.
+//! \param[in,out]  inFile Stream positioned at the beginning of the file.
+//! \param[in]  fileSize Size of the file in bytes.
+CograBinaryMeshLayout readCograBinaryMeshLayout(std::istream& inFile, ui64 fileSize);
+
+//! \brief Assigns aligned offsets to all sections of a version 2 layout.
+//!
+//! The stored sizes of positions, triangles, attributes and constants must be set. The names section is sized here.
+//! \return The size of the file in bytes.
+ui64 computeCograBinaryMeshLayoutV2(CograBinaryMeshLayout& layout);
+
+//! \brief Creates the header of a version 2 file.
+//! \param[in]  layout Provides counts, bounds, and flags.
+//! \param[in]  nSections Number of entries in the section table.
+//! \param[in]  sectionTableOffset Offset of the section table in bytes.
+CograBinaryMeshHeaderV2 createCograBinaryMeshHeaderV2(const CograBinaryMeshLayout& layout, ui32 nSections,
+                                                      ui64 sectionTableOffset);
+
+//! \brief Creates the section table entry of a payload or a chunk of a payload.
+CograBinaryMeshSectionEntryV2 createCograBinaryMeshSectionEntryV2(ui32 type, const CograBinaryMeshSection& section);
+
+//! \brief Writes header, section table, and names section of a version 2 file.
+//! \param[in,out]  outFile Stream positioned at the beginning of the file.
+//! \param[in]  layout Layout with offsets from computeCograBinaryMeshLayoutV2.
+void writeCograBinaryMeshHeaderV2(std::ostream& outFile, const CograBinaryMeshLayout& layout);
+
+//! \brief Writes zeros until the stream reaches offset.
+void writePadding(std::ostream& outFile, ui64 offset);
+
+//! Read-only stream buffer over a block of memory, e.g., a memory mapped file.
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+  MemoryStreamBuffer(const ui8* data, size_t size);
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+};
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,60 @@
+#include "Crc32.hpp"
+#include <array>
+#include <cstring>
+
+namespace
+{
+//! Lookup tables for slicing-by-8, processes eight bytes per step.
+constexpr std::array<std::array<gims::ui32, 256>, 8> createTables()
+{
+  std::array<std::array<gims::ui32, 256>, 8> result = {};
+  for (gims::ui32 i = 0; i < 256; i++)
+  {
+    gims::ui32 c = i;
+    for (int k = 0; k < 8; k++)
+    {
+      c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    }
+    result[0][i] = c;
+  }
+  for (gims::ui32 i = 0; i < 256; i++)
+  {
+    for (size_t t = 1; t < 8; t++)
+    {
+      result[t][i] = (result[t - 1][i] >> 8) ^ result[0][result[t - 1][i] & 0xFF];
+    }
+  }
+  return result;
+}
+
+constexpr auto TABLES = createTables();
+} // namespace
+
+namespace gims
+{
+namespace impl
+{
+ui32 crc32(const void* data, ui64 sizeInBytes, ui32 crc)
+{
+  const auto* p = static_cast<const ui8*>(data);
+  crc           = ~crc;
+  while (sizeInBytes >= 8)
+  {
+    ui32 lo;
+    ui32 hi;
+    std::memcpy(&lo, p, 4);
+    std::memcpy(&hi, p + 4, 4);
+    lo ^= crc;
+    crc = TABLES[7][lo & 0xFF] ^ TABLES[6][(lo >> 8) & 0xFF] ^ TABLES[5][(lo >> 16) & 0xFF] ^ TABLES[4][lo >> 24] ^
+          TABLES[3][hi & 0xFF] ^ TABLES[2][(hi >> 8) & 0xFF] ^ TABLES[1][(hi >> 16) & 0xFF] ^ TABLES[0][hi >> 24];
+    p += 8;
+    sizeInBytes -= 8;
+  }
+  while (sizeInBytes-- > 0)
+  {
+    crc = TABLES[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+} // namespace impl
+} // namespace gims
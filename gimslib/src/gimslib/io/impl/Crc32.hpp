@@ -0,0 +1,14 @@
+#pragma once
+#include <gimslib/types.hpp>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Computes the CRC-32 (IEEE 802.3, as used by zlib) of a block of memory.
+//! \param[in]  data First byte of the block.
+//! \param[in]  sizeInBytes Size of the block in bytes.
+//! \param[in]  crc CRC of the preceding data, if the checksum is computed in pieces.
+ui32 crc32(const void* data, ui64 sizeInBytes, ui32 crc = 0);
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,89 @@
+#include "PositionalFileReader.hpp"
+#include <algorithm>
+#include <stdexcept>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace gims
+{
+namespace impl
+{
+#ifdef _WIN32
+PositionalFileReader::PositionalFileReader(const std::string& fileName)
+    : m_fileName(fileName)
+{
+  const HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    throw std::runtime_error("Error opening file " + fileName + ".");
+  }
+  m_fileHandle = file;
+}
+
+PositionalFileReader::~PositionalFileReader()
+{
+  CloseHandle(m_fileHandle);
+}
+
+void PositionalFileReader::read(ui64 offset, void* data, ui64 sizeInBytes) const
+{
+  auto* destination = static_cast<ui8*>(data);
+  while (sizeInBytes > 0)
+  {
+    OVERLAPPED overlapped = {};
+    overlapped.Offset     = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    const DWORD toRead    = static_cast<DWORD>(std::min<ui64>(sizeInBytes, 1u << 30));
+    DWORD       nRead     = 0;
+    if (!ReadFile(m_fileHandle, destination, toRead, &nRead, &overlapped) || nRead == 0)
+    {
+      throw std::runtime_error("Error reading file " + m_fileName + ".");
+    }
+    destination += nRead;
+    offset += nRead;
+    sizeInBytes -= nRead;
+  }
+}
+#else
+PositionalFileReader::PositionalFileReader(const std::string& fileName)
+    : m_fileName(fileName)
+{
+  m_fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+  if (m_fileDescriptor < 0)
+  {
+    throw std::runtime_error("Error opening file " + fileName + ".");
+  }
+}
+
+PositionalFileReader::~PositionalFileReader()
+{
+  ::close(m_fileDescriptor);
+}
+
+void PositionalFileReader::read(ui64 offset, void* data, ui64 sizeInBytes) const
+{
+  auto* destination = static_cast<ui8*>(data);
+  while (sizeInBytes > 0)
+  {
+    const size_t  toRead = static_cast<size_t>(std::min<ui64>(sizeInBytes, 1u << 30));
+    const ssize_t nRead  = pread(m_fileDescriptor, destination, toRead, static_cast<off_t>(offset));
+    if (nRead <= 0)
+    {
+      throw std::runtime_error("Error reading file " + m_fileName + ".");
+    }
+    destination += nRead;
+    offset += static_cast<ui64>(nRead);
+    sizeInBytes -= static_cast<ui64>(nRead);
+  }
+}
+#endif
+} // namespace impl
+} // namespace gims
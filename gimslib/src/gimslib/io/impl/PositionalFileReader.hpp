@@ -0,0 +1,45 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <string>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Read-only file that reads at explicit offsets.
+//!
+//! Reads do not depend on a shared file position, so several threads may read from the same object at the same time.
+//! Uses ReadFile with an OVERLAPPED offset on Windows and pread on POSIX systems.
+class PositionalFileReader
+{
+public:
+  //! \brief Opens a file. Throws std::runtime_error on failure.
+  //! \param[in]  fileName Path to the file.
+  explicit PositionalFileReader(const std::string& fileName);
+
+  //! \brief Closes the file.
+  ~PositionalFileReader();
+
+  PositionalFileReader(const PositionalFileReader& other)            = delete;
+  PositionalFileReader& operator=(const PositionalFileReader& other) = delete;
+
+  //! \brief Reads exactly sizeInBytes bytes. Throws std::runtime_error on failure or end of file.
+  //! \param[in]  offset Offset in bytes from the beginning of the file.
+  //! \param[out]  data Destination of the bytes.
+  //! \param[in]  sizeInBytes Number of bytes to read.
+  void read(ui64 offset, void* data, ui64 sizeInBytes) const;
+
+private:
+#ifdef _WIN32
+  //! File handle.
+  void* m_fileHandle = nullptr;
+#else
+  //! File descriptor.
+  int m_fileDescriptor = -1;
+#endif
+
+  //! Path of the file used in error messages.
+  std::string m_fileName;
+};
+} // namespace impl
+} // namespace gims
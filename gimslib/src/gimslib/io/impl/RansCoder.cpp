@@ -0,0 +1,328 @@
+#include "RansCoder.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+namespace
+{
+//! Probabilities are quantized to 1 / 2^SCALE_BITS.
+constexpr gims::ui32 SCALE_BITS = 12;
+constexpr gims::ui32 SCALE      = 1u << SCALE_BITS;
+
+//! Lower bound of the coder state. The state is kept in [RANS_L, RANS_L * 256).
+constexpr gims::ui32 RANS_L = 1u << 23;
+
+constexpr gims::ui64 BLOCK_SIZE = 1u << 20;
+
+//! Bytes of the frequency table at the beginning of a compressed block.
+constexpr gims::ui64 TABLE_SIZE = 256 * sizeof(gims::ui16);
+
+struct SymbolTable
+{
+  std::array<gims::ui32, 256> frequency = {};
+  std::array<gims::ui32, 257> start     = {};
+};
+
+void computeStarts(SymbolTable& table)
+{
+  table.start[0] = 0;
+  for (size_t s = 0; s < 256; s++)
+  {
+    table.start[s + 1] = table.start[s] + table.frequency[s];
+  }
+}
+
+//! Scales the histogram so that the frequencies sum up to SCALE. Every present symbol keeps a frequency of at least 1.
+SymbolTable createSymbolTable(const gims::ui8* data, gims::ui64 n)
+{
+  std::array<gims::ui64, 256> histogram = {};
+  for (gims::ui64 i = 0; i < n; i++)
+  {
+    histogram[data[i]]++;
+  }
+
+  SymbolTable result;
+  gims::ui32  sum = 0;
+  for (size_t s = 0; s < 256; s++)
+  {
+    if (histogram[s] != 0)
+    {
+      result.frequency[s] = std::max(1u, static_cast<gims::ui32>(histogram[s] * SCALE / n));
+      sum += result.frequency[s];
+    }
+  }
+  // Rounding leaves a small difference, which is given to or taken from the most frequent symbols.
+  while (sum != SCALE)
+  {
+    const auto largest = std::max_element(result.frequency.begin(), result.frequency.end());
+    if (sum < SCALE)
+    {
+      *largest += SCALE - sum;
+      sum = SCALE;
+    }
+    else
+    {
+      const gims::ui32 delta = std::min(sum - SCALE, *largest - 1);
+      *largest -= delta;
+      sum -= delta;
+    }
+  }
+  computeStarts(result);
+  return result;
+}
+
+//! Encodes one block. Returns false, if the compressed block would not be smaller than the input.
+bool encodeBlock(const gims::ui8* data, gims::ui64 n, std::vector<gims::ui8>& result)
+{
+  const SymbolTable table = createSymbolTable(data, n);
+
+  // rANS encodes in reverse, so the output is written back to front. Every symbol emits at most two bytes.
+  std::vector<gims::ui8> buffer(2 * n + 4 * sizeof(gims::ui32));
+  gims::ui8* const       end   = buffer.data() + buffer.size();
+  gims::ui8*             ptr   = end;
+  gims::ui32             x[4]  = {RANS_L, RANS_L, RANS_L, RANS_L};
+  for (gims::ui64 i = n; i-- > 0;)
+  {
+    const gims::ui32 s     = data[i];
+    const gims::ui32 f     = table.frequency[s];
+    gims::ui32&      state = x[i & 3];
+    const gims::ui32 xMax  = ((RANS_L >> SCALE_BITS) << 8) * f;
+    while (state >= xMax)
+    {
+      *--ptr = static_cast<gims::ui8>(state);
+      state >>= 8;
+    }
+    state = ((state / f) << SCALE_BITS) + (state % f) + table.start[s];
+  }
+  for (size_t k = 4; k-- > 0;)
+  {
+    ptr -= sizeof(gims::ui32);
+    std::memcpy(ptr, &x[k], sizeof(gims::ui32));
+  }
+
+  const gims::ui64 streamSize = static_cast<gims::ui64>(end - ptr);
+  if (TABLE_SIZE + streamSize >= n)
+  {
+    return false;
+  }
+  const gims::ui32 storedSize = static_cast<gims::ui32>(TABLE_SIZE + streamSize);
+  const size_t     base       = result.size();
+  result.resize(base + sizeof(storedSize) + storedSize);
+  gims::ui8* out = result.data() + base;
+  std::memcpy(out, &storedSize, sizeof(storedSize));
+  out += sizeof(storedSize);
+  for (size_t s = 0; s < 256; s++)
+  {
+    const gims::ui16 f = static_cast<gims::ui16>(table.frequency[s]);
+    std::memcpy(out + s * sizeof(f), &f, sizeof(f));
+  }
+  std::memcpy(out + TABLE_SIZE, ptr, streamSize);
+  return true;
+}
+
+//! Decodes the symbols of one block. Segments of the block can be written to different places, see ransDecode.
+class BlockDecoder
+{
+public:
+  BlockDecoder(const gims::ui8* data, gims::ui64 storedSize)
+      : m_ptr(data + TABLE_SIZE)
+      , m_end(data + storedSize)
+  {
+    if (storedSize < TABLE_SIZE + 4 * sizeof(gims::ui32))
+    {
+      throw std::runtime_error("Compressed CBM block is truncated.");
+    }
+    SymbolTable table;
+    for (size_t s = 0; s < 256; s++)
+    {
+      gims::ui16 f;
+      std::memcpy(&f, data + s * sizeof(f), sizeof(f));
+      table.frequency[s] = f;
+    }
+    computeStarts(table);
+    if (table.start[256] != SCALE)
+    {
+      throw std::runtime_error("Compressed CBM block has an invalid frequency table.");
+    }
+    // One lookup per symbol gives the symbol of a slot, its frequency, and the offset of the slot within the symbol.
+    for (gims::ui32 s = 0; s < 256; s++)
+    {
+      for (gims::ui32 slot = table.start[s]; slot < table.start[s + 1]; slot++)
+      {
+        m_slots[slot] = {static_cast<gims::ui16>(table.frequency[s]), static_cast<gims::ui16>(slot - table.start[s]),
+                         static_cast<gims::ui8>(s)};
+      }
+    }
+    std::memcpy(m_x, m_ptr, sizeof(m_x));
+    m_ptr += sizeof(m_x);
+  }
+
+  //! Decodes the next n symbols to result[0], result[stride], result[2 * stride] and so on.
+  void decode(gims::ui8* result, gims::ui64 n, gims::ui64 stride)
+  {
+    // The states and the read position are copied to locals, as the byte stores to result could alias the members.
+    // The states are interleaved by the index of the symbol in the block, so four consecutive symbols starting at a
+    // multiple of four use the states in order, which lets them live in registers.
+    const Slot* const slots = m_slots.data();
+    const gims::ui8*  ptr   = m_ptr;
+    gims::ui32        x[4];
+    std::memcpy(x, m_x, sizeof(x));
+    const gims::ui64 first = m_next;
+    gims::ui64       i     = 0;
+    for (; i < n && ((first + i) & 3) != 0; i++)
+    {
+      result[i * stride] = decodeSymbol(slots, x[(first + i) & 3], ptr, m_end);
+    }
+    for (; i + 4 <= n; i += 4)
+    {
+      result[(i + 0) * stride] = decodeSymbol(slots, x[0], ptr, m_end);
+      result[(i + 1) * stride] = decodeSymbol(slots, x[1], ptr, m_end);
+      result[(i + 2) * stride] = decodeSymbol(slots, x[2], ptr, m_end);
+      result[(i + 3) * stride] = decodeSymbol(slots, x[3], ptr, m_end);
+    }
+    for (; i < n; i++)
+    {
+      result[i * stride] = decodeSymbol(slots, x[(first + i) & 3], ptr, m_end);
+    }
+    std::memcpy(m_x, x, sizeof(x));
+    m_ptr  = ptr;
+    m_next = first + n;
+  }
+
+private:
+  struct Slot
+  {
+    gims::ui16 frequency;
+    gims::ui16 offset;
+    gims::ui8  symbol;
+  };
+
+  static gims::ui8 decodeSymbol(const Slot* slots, gims::ui32& state, const gims::ui8*& ptr, const gims::ui8* end)
+  {
+    const Slot slot = slots[state & (SCALE - 1)];
+    state           = slot.frequency * (state >> SCALE_BITS) + slot.offset;
+    while (state < RANS_L)
+    {
+      if (ptr == end)
+      {
+        throw std::runtime_error("Compressed CBM block is truncated.");
+      }
+      state = (state << 8) | *ptr++;
+    }
+    return slot.symbol;
+  }
+
+  std::array<Slot, SCALE> m_slots;
+  const gims::ui8*        m_ptr;
+  const gims::ui8* const  m_end;
+  gims::ui32              m_x[4];
+  gims::ui64              m_next = 0; //! Index of the next symbol in the block.
+};
+} // namespace
+
+namespace gims
+{
+namespace impl
+{
+void ransEncode(const ui8* data, ui64 sizeInBytes, std::vector<ui8>& result)
+{
+  for (ui64 offset = 0; offset < sizeInBytes; offset += BLOCK_SIZE)
+  {
+    const ui64 n = std::min(BLOCK_SIZE, sizeInBytes - offset);
+    if (!encodeBlock(data + offset, n, result))
+    {
+      // A stored size equal to the block size marks an uncompressed block.
+      const ui32   storedSize = static_cast<ui32>(n);
+      const size_t base       = result.size();
+      result.resize(base + sizeof(storedSize) + n);
+      std::memcpy(result.data() + base, &storedSize, sizeof(storedSize));
+      std::memcpy(result.data() + base + sizeof(storedSize), data + offset, n);
+    }
+  }
+}
+
+void ransDecode(const ui8* data, ui64 storedSizeInBytes, ui8* result, ui64 sizeInBytes, ui32 stride)
+{
+  // A byte at position p of the shuffled array belongs to byte p / nElements of element p % nElements. Each block is
+  // split into segments within one such plane, which are written with the stride of the elements.
+  const ui64       nElements = sizeInBytes / stride;
+  const ui64       planesEnd = nElements * stride;
+  const ui8* const end       = data + storedSizeInBytes;
+  for (ui64 offset = 0; offset < sizeInBytes; offset += BLOCK_SIZE)
+  {
+    const ui64 n = std::min(BLOCK_SIZE, sizeInBytes - offset);
+    ui32       storedSize;
+    if (static_cast<ui64>(end - data) < sizeof(storedSize))
+    {
+      throw std::runtime_error("Compressed CBM section is truncated.");
+    }
+    std::memcpy(&storedSize, data, sizeof(storedSize));
+    data += sizeof(storedSize);
+    if (static_cast<ui64>(end - data) < storedSize)
+    {
+      throw std::runtime_error("Compressed CBM section is truncated.");
+    }
+
+    // A stored size equal to the block size marks an uncompressed block.
+    std::optional<BlockDecoder> decoder;
+    if (storedSize != n)
+    {
+      decoder.emplace(data, storedSize);
+    }
+    for (ui64 p = offset; p < offset + n;)
+    {
+      ui8* destination   = result + p;
+      ui64 segmentEnd    = offset + n;
+      ui64 segmentStride = 1;
+      if (p < planesEnd)
+      {
+        destination   = result + (p % nElements) * stride + p / nElements;
+        segmentEnd    = std::min(segmentEnd, (p / nElements + 1) * nElements);
+        segmentStride = stride;
+      }
+      if (decoder)
+      {
+        decoder->decode(destination, segmentEnd - p, segmentStride);
+      }
+      else
+      {
+        for (ui64 i = 0; i < segmentEnd - p; i++)
+        {
+          destination[i * segmentStride] = data[p - offset + i];
+        }
+      }
+      p = segmentEnd;
+    }
+    data += storedSize;
+  }
+}
+
+void shuffleBytes(const ui8* data, ui8* result, ui64 sizeInBytes, ui32 stride)
+{
+  const ui64 nElements = sizeInBytes / stride;
+  for (ui32 b = 0; b < stride; b++)
+  {
+    for (ui64 i = 0; i < nElements; i++)
+    {
+      result[b * nElements + i] = data[i * stride + b];
+    }
+  }
+  std::memcpy(result + nElements * stride, data + nElements * stride, sizeInBytes - nElements * stride);
+}
+
+void unshuffleBytes(const ui8* data, ui8* result, ui64 sizeInBytes, ui32 stride)
+{
+  const ui64 nElements = sizeInBytes / stride;
+  for (ui32 b = 0; b < stride; b++)
+  {
+    for (ui64 i = 0; i < nElements; i++)
+    {
+      result[i * stride + b] = data[b * nElements + i];
+    }
+  }
+  std::memcpy(result + nElements * stride, data + nElements * stride, sizeInBytes - nElements * stride);
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,37 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Compresses bytes with an order-0 rANS entropy coder.
+//!
+//! The input is split into blocks of 1 MiB, each with its own frequency table. Blocks that do not compress are stored
+//! as is. Four interleaved coder states hide the latency of the decoder's dependency chain.
+//! \param[in]  data Bytes to compress.
+//! \param[in]  sizeInBytes Number of bytes.
+//! \param[in,out]  result The compressed bytes are appended.
+void ransEncode(const ui8* data, ui64 sizeInBytes, std::vector<ui8>& result);
+
+//! \brief Decompresses bytes produced by ransEncode. Throws std::runtime_error on malformed input.
+//!
+//! If the compressed bytes are the output of shuffleBytes, passing its stride unshuffles them while they are written,
+//! which saves a temporary copy of the payload.
+//! \param[in]  data Compressed bytes.
+//! \param[in]  storedSizeInBytes Number of compressed bytes.
+//! \param[out]  result Decompressed bytes.
+//! \param[in]  sizeInBytes Number of decompressed bytes.
+//! \param[in]  stride Stride of the shuffled elements, 1 if the bytes are not shuffled.
+void ransDecode(const ui8* data, ui64 storedSizeInBytes, ui8* result, ui64 sizeInBytes, ui32 stride = 1);
+
+//! \brief Transposes an array of elements of stride bytes, so that all first bytes come first, then all second bytes
+//! and so on. Bytes at the same position of neighbouring elements are often similar, which helps the entropy coder.
+//! Trailing bytes that do not make a full element are copied.
+void shuffleBytes(const ui8* data, ui8* result, ui64 sizeInBytes, ui32 stride);
+
+//! \brief Reverts shuffleBytes.
+void unshuffleBytes(const ui8* data, ui8* result, ui64 sizeInBytes, ui32 stride);
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <gimslib/mesh/MeshBounds.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <stdexcept>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define MESH_BOUNDS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+using gims::f32;
+using gims::ui64;
+using gims::ui8;
+using Bounds = gims::MeshBounds::Bounds;
+
+//! Minimum that ignores NaN values and prefers -0 over +0.
+f32 minimum(f32 current, f32 value)
+{
+  if (value < current || (value == current && std::signbit(value)))
+  {
+    return value;
+  }
+  return current;
+}
+
+//! Maximum that ignores NaN values and prefers +0 over -0.
+f32 maximum(f32 current, f32 value)
+{
+  if (value > current || (value == current && !std::signbit(value)))
+  {
+    return value;
+  }
+  return current;
+}
+
+void extend(Bounds& bounds, const f32* position)
+{
+  for (int c = 0; c < 3; c++)
+  {
+    bounds.lower[c] = minimum(bounds.lower[c], position[c]);
+    bounds.upper[c] = maximum(bounds.upper[c], position[c]);
+  }
+}
+
+void extend(Bounds& bounds, const Bounds& other)
+{
+  for (int c = 0; c < 3; c++)
+  {
+    bounds.lower[c] = minimum(bounds.lower[c], other.lower[c]);
+    bounds.upper[c] = maximum(bounds.upper[c], other.upper[c]);
+  }
+}
+
+#ifdef MESH_BOUNDS_SSE2
+//! SSE2 version of minimum, for the x, y, and z components in the lower three lanes.
+__m128 minimum(__m128 current, __m128 value)
+{
+  // _mm_min_ps returns its second operand for NaN values. Equal values only differ in the sign of zero.
+  const __m128 result = _mm_min_ps(value, current);
+  const __m128 equal  = _mm_cmpeq_ps(value, result);
+  return _mm_or_ps(result, _mm_and_ps(equal, _mm_and_ps(value, _mm_set1_ps(-0.0f))));
+}
+
+//! SSE2 version of maximum, for the x, y, and z components in the lower three lanes.
+__m128 maximum(__m128 current, __m128 value)
+{
+  const __m128 result   = _mm_max_ps(value, current);
+  const __m128 equal    = _mm_cmpeq_ps(value, result);
+  const __m128 positive = _mm_andnot_ps(value, _mm_set1_ps(-0.0f));
+  return _mm_andnot_ps(_mm_and_ps(equal, positive), result);
+}
+#endif
+
+//! Reduces the positions [begin, end).
+Bounds computeBoundsSerial(const ui8* positions, ui64 begin, ui64 end, size_t strideInBytes)
+{
+  Bounds result;
+  if (begin == end)
+  {
+    return result;
+  }
+  ui64 i = begin;
+#ifdef MESH_BOUNDS_SSE2
+  // Each position is loaded with the first component of the next one, so the last position is read by the scalar
+  // path. Two pairs of accumulators hide the latency of the comparisons.
+  __m128 lower[2] = {_mm_set1_ps(std::numeric_limits<f32>::max()), _mm_set1_ps(std::numeric_limits<f32>::max())};
+  __m128 upper[2] = {_mm_set1_ps(-std::numeric_limits<f32>::max()), _mm_set1_ps(-std::numeric_limits<f32>::max())};
+  for (; i + 2 < end; i += 2)
+  {
+    const __m128 a = _mm_loadu_ps(reinterpret_cast<const f32*>(positions + i * strideInBytes));
+    const __m128 b = _mm_loadu_ps(reinterpret_cast<const f32*>(positions + (i + 1) * strideInBytes));
+    lower[0]       = minimum(lower[0], a);
+    upper[0]       = maximum(upper[0], a);
+    lower[1]       = minimum(lower[1], b);
+    upper[1]       = maximum(upper[1], b);
+  }
+  f32 lanes[4];
+  for (int k = 0; k < 2; k++)
+  {
+    Bounds partial;
+    _mm_storeu_ps(lanes, lower[k]);
+    partial.lower = gims::f32v3(lanes[0], lanes[1], lanes[2]);
+    _mm_storeu_ps(lanes, upper[k]);
+    partial.upper = gims::f32v3(lanes[0], lanes[1], lanes[2]);
+    extend(result, partial);
+  }
+#endif
+  for (; i < end; i++)
+  {
+    f32 position[3];
+    memcpy(position, positions + i * strideInBytes, sizeof(position));
+    extend(result, position);
+  }
+  return result;
+}
+} // namespace
+
+namespace gims
+{
+namespace MeshBounds
+{
+Bounds computeBounds(const f32* positions, ui64 nPositions, size_t strideInBytes, ui32 nThreads)
+{
+  if (strideInBytes < 3 * sizeof(f32))
+  {
+    throw std::runtime_error("Positions must not overlap.");
+  }
+  const ui8* const bytes = reinterpret_cast<const ui8*>(positions);
+
+  if (nThreads == 0)
+  {
+    nThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  nThreads = static_cast<ui32>(std::min<ui64>(nThreads, nPositions / MIN_POSITIONS_PER_THREAD));
+  if (nThreads <= 1)
+  {
+    return computeBoundsSerial(bytes, 0, nPositions, strideInBytes);
+  }
+
+  // One chunk per thread. The reduction is exact and does not depend on the order, so the chunks can be merged in any
+  // order.
+  std::vector<Bounds>            chunks(nThreads);
+  gims::ThreadPool               pool(nThreads);
+  std::vector<std::future<void>> futures;
+  for (ui32 t = 0; t < nThreads; t++)
+  {
+    const ui64 begin = nPositions * t / nThreads;
+    const ui64 end   = nPositions * (t + 1) / nThreads;
+    futures.push_back(
+        pool.submit([&chunks, bytes, begin, end, strideInBytes, t]
+                    { chunks[t] = computeBoundsSerial(bytes, begin, end, strideInBytes); }));
+  }
+  for (auto& f : futures)
+  {
+    f.get();
+  }
+  Bounds result;
+  for (const Bounds& chunk : chunks)
+  {
+    extend(result, chunk);
+  }
+  return result;
+}
+} // namespace MeshBounds
+} // namespace gims
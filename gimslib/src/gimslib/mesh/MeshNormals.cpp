@@ -0,0 +1,191 @@
+#include "impl/MeshAdjacency.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <gimslib/mesh/MeshNormals.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <vector>
+
+namespace
+{
+using gims::f32;
+using gims::f32v3;
+using gims::ui32;
+using gims::ui64;
+using gims::ui8;
+
+//! Weighted normal of a triangle at one of its vertices.
+struct Corner
+{
+  f32v3 normal; //! Normal of the triangle times its weight.
+  ui32  vertex; //! Index of the vertex.
+};
+
+f32v3 normalizeOrZero(const f32v3& v)
+{
+  const f32 length = glm::length(v);
+  return length > 0.0f && std::isfinite(length) ? v / length : f32v3(0.0f);
+}
+
+//! Computes the weighted normals of the three corners of triangle t.
+void computeCorners(Corner* corners, ui64 t, const ui32* indices, const ui8* positions, size_t positionsStride,
+                    gims::MeshNormals::Weighting weighting)
+{
+  const ui32* const triangle = indices + 3 * t;
+  f32v3             p[3];
+  for (ui32 c = 0; c < 3; c++)
+  {
+    memcpy(&p[c], positions + triangle[c] * positionsStride, sizeof(f32v3));
+    corners[c].vertex = triangle[c];
+  }
+
+  // The length of the cross product is twice the area.
+  const f32v3 cross = glm::cross(p[1] - p[0], p[2] - p[0]);
+  if (weighting == gims::MeshNormals::WEIGHT_AREA)
+  {
+    const f32v3 normal = std::isfinite(glm::dot(cross, cross)) ? cross : f32v3(0.0f);
+    for (ui32 c = 0; c < 3; c++)
+    {
+      corners[c].normal = normal;
+    }
+    return;
+  }
+
+  const f32v3 normal = normalizeOrZero(cross);
+  for (ui32 c = 0; c < 3; c++)
+  {
+    const f32v3 e1      = p[(c + 1) % 3] - p[c];
+    const f32v3 e2      = p[(c + 2) % 3] - p[c];
+    const f32   lengths = glm::length(e1) * glm::length(e2);
+    const f32   cosine  = lengths > 0.0f ? glm::dot(e1, e2) / lengths : 1.0f;
+    corners[c].normal   = normal * std::acos(std::clamp(cosine, -1.0f, 1.0f));
+  }
+}
+
+//! Normalizes the sums of the vertices [begin, end) and writes them to the output.
+void writeNormals(ui8* normals, size_t normalsStride, const std::vector<f32v3>& sums, ui64 begin, ui64 end)
+{
+  for (ui64 v = begin; v < end; v++)
+  {
+    f32v3 normal = normalizeOrZero(sums[v]);
+    if (normal == f32v3(0.0f))
+    {
+      normal = f32v3(0.0f, 0.0f, 1.0f);
+    }
+    memcpy(normals + v * normalsStride, &normal, sizeof(normal));
+  }
+}
+
+//! Calls function(i) for i in [0, n) concurrently, one call per task.
+void forEachTask(gims::ThreadPool& pool, ui32 n, const std::function<void(ui32)>& function)
+{
+  std::vector<std::future<void>> futures;
+  for (ui32 i = 0; i < n; i++)
+  {
+    futures.push_back(pool.submit([&function, i] { function(i); }));
+  }
+  for (auto& f : futures)
+  {
+    f.get();
+  }
+}
+} // namespace
+
+namespace gims
+{
+namespace MeshNormals
+{
+void generateNormals(f32* normals, size_t normalsStride, const ui32* indices, ui64 nIndices, const f32* positions,
+                     size_t positionsStride, ui32 nVertices, Weighting weighting, ui32 nThreads)
+{
+  impl::validateIndices(indices, nIndices, nVertices);
+  const ui8* const   positionBytes = reinterpret_cast<const ui8*>(positions);
+  ui8* const         normalBytes   = reinterpret_cast<ui8*>(normals);
+  const ui64         nTriangles    = nIndices / 3;
+  std::vector<f32v3> sums(nVertices, f32v3(0.0f));
+
+  if (nThreads == 0)
+  {
+    nThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  nThreads = static_cast<ui32>(std::min<ui64>(nThreads, nTriangles / MIN_TRIANGLES_PER_THREAD));
+  if (nThreads <= 1)
+  {
+    Corner corners[3];
+    for (ui64 t = 0; t < nTriangles; t++)
+    {
+      computeCorners(corners, t, indices, positionBytes, positionsStride, weighting);
+      for (const Corner& c : corners)
+      {
+        sums[c.vertex] += c.normal;
+      }
+    }
+    writeNormals(normalBytes, normalsStride, sums, 0, nVertices);
+    return;
+  }
+
+  // Thread t processes the triangles of chunk t, and then sums the corners of the vertices in bin t.
+  const ui64 binSize    = (ui64(nVertices) + nThreads - 1) / nThreads;
+  const auto chunkBegin = [&](ui32 t) { return nTriangles * t / nThreads; };
+  const auto getBin     = [&](ui32 v) { return static_cast<ui32>(v / binSize); };
+  ThreadPool pool(nThreads);
+
+  // offsets[chunk * nThreads + bin] is the first corner of the chunk in the bin. Bins are stored one after another,
+  // and the chunks of a bin in order, so the corners of each vertex stay in triangle order.
+  std::vector<ui64> offsets(ui64(nThreads) * nThreads, 0);
+  forEachTask(pool, nThreads,
+              [&](ui32 chunk)
+              {
+                ui64* const counts = offsets.data() + ui64(chunk) * nThreads;
+                const ui64  end    = 3 * chunkBegin(chunk + 1);
+                for (ui64 i = 3 * chunkBegin(chunk); i < end; i++)
+                {
+                  counts[getBin(indices[i])]++;
+                }
+              });
+  ui64 nCorners = 0;
+  for (ui32 bin = 0; bin < nThreads; bin++)
+  {
+    for (ui32 chunk = 0; chunk < nThreads; chunk++)
+    {
+      const ui64 count                      = offsets[ui64(chunk) * nThreads + bin];
+      offsets[ui64(chunk) * nThreads + bin] = nCorners;
+      nCorners += count;
+    }
+  }
+
+  std::vector<Corner> binnedCorners(nCorners);
+  forEachTask(pool, nThreads,
+              [&](ui32 chunk)
+              {
+                std::vector<ui64> fill(offsets.begin() + ui64(chunk) * nThreads,
+                                       offsets.begin() + ui64(chunk + 1) * nThreads);
+                const ui64        end = chunkBegin(chunk + 1);
+                Corner            corners[3];
+                for (ui64 t = chunkBegin(chunk); t < end; t++)
+                {
+                  computeCorners(corners, t, indices, positionBytes, positionsStride, weighting);
+                  for (const Corner& c : corners)
+                  {
+                    binnedCorners[fill[getBin(c.vertex)]++] = c;
+                  }
+                }
+              });
+
+  forEachTask(pool, nThreads,
+              [&](ui32 bin)
+              {
+                const ui64 begin = offsets[bin];
+                const ui64 end   = bin + 1 < nThreads ? offsets[bin + 1] : nCorners;
+                for (ui64 i = begin; i < end; i++)
+                {
+                  sums[binnedCorners[i].vertex] += binnedCorners[i].normal;
+                }
+                writeNormals(normalBytes, normalsStride, sums, std::min<ui64>(bin * binSize, nVertices),
+                             std::min<ui64>((bin + 1) * binSize, nVertices));
+              });
+}
+} // namespace MeshNormals
+} // namespace gims
@@ -0,0 +1,381 @@
+#include "impl/MeshAdjacency.hpp"
+#include <algorithm>
+#include <cstring>
+#include <gimslib/mesh/MeshOptimizer.hpp>
+#include <gimslib/mesh/MeshSimplifier.hpp>
+#include <gimslib/mesh/Meshlets.hpp>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+//! Marks the absence of a vertex.
+constexpr gims::ui32 INVALID_VERTEX = std::numeric_limits<gims::ui32>::max();
+
+//! \brief FIFO vertex cache.
+//!
+//! Stores for every vertex the time it entered the cache. Each miss advances the time by one, so a vertex is cached,
+//! as long as fewer than size vertices entered after it.
+class FifoCache
+{
+public:
+  FifoCache(gims::ui32 nVertices, gims::ui32 size)
+      : m_entered(nVertices, 0)
+      , m_time(gims::ui64(size) + 1)
+      , m_size(size)
+  {
+  }
+
+  //! \brief Returns true on a miss, which loads the vertex into the cache.
+  bool access(gims::ui32 vertex)
+  {
+    if (m_time - m_entered[vertex] > m_size)
+    {
+      m_entered[vertex] = m_time++;
+      return true;
+    }
+    return false;
+  }
+
+  //! \brief Number of cache entries that are younger than the vertex, or more than size if it is not cached.
+  gims::ui64 age(gims::ui32 vertex) const
+  {
+    return m_time - m_entered[vertex];
+  }
+
+  //! \brief Evicts all vertices.
+  void clear()
+  {
+    m_time += m_size + 1;
+  }
+
+private:
+  std::vector<gims::ui64> m_entered;
+  gims::ui64              m_time;
+  gims::ui64              m_size;
+};
+
+//! Number of cache misses of a triangle.
+gims::ui32 accessTriangle(FifoCache& cache, const gims::ui32* triangle)
+{
+  return gims::ui32(cache.access(triangle[0])) + gims::ui32(cache.access(triangle[1])) +
+         gims::ui32(cache.access(triangle[2]));
+}
+} // namespace
+
+namespace gims
+{
+namespace MeshOptimizer
+{
+VertexCacheStatistics analyzeVertexCache(const ui32* indices, ui64 nIndices, ui32 nVertices, ui32 cacheSize)
+{
+  impl::validateIndices(indices, nIndices, nVertices);
+  VertexCacheStatistics result;
+  if (nIndices == 0)
+  {
+    return result;
+  }
+  FifoCache         cache(nVertices, cacheSize);
+  std::vector<bool> referenced(nVertices, false);
+  ui64              nReferenced = 0;
+  for (ui64 i = 0; i < nIndices; i++)
+  {
+    result.nTransformedVertices += cache.access(indices[i]) ? 1 : 0;
+    if (!referenced[indices[i]])
+    {
+      referenced[indices[i]] = true;
+      nReferenced++;
+    }
+  }
+  result.acmr = static_cast<f32>(f64(result.nTransformedVertices) / f64(nIndices / 3));
+  result.atvr = static_cast<f32>(f64(result.nTransformedVertices) / f64(nReferenced));
+  return result;
+}
+
+void optimizeVertexCache(ui32* destination, const ui32* indices, ui64 nIndices, ui32 nVertices, ui32 cacheSize)
+{
+  impl::validateIndices(indices, nIndices, nVertices);
+  const std::vector<ui32>       input(indices, indices + nIndices);
+  impl::VertexTriangleAdjacency adjacency = impl::createVertexTriangleAdjacency(input.data(), nIndices, nVertices);
+
+  std::vector<ui32>& liveTriangles = adjacency.counts;
+  std::vector<bool>  emitted(nIndices / 3, false);
+  std::vector<ui32>  deadEnds;
+  std::vector<ui32>  candidates;
+  FifoCache          cache(nVertices, cacheSize);
+  ui64               nEmitted = 0;
+  ui32               cursor   = 0;
+
+  const auto nextLiveVertex = [&]()
+  {
+    // Vertices touched recently are likely still in the cache, untouched ones are taken in input order.
+    while (!deadEnds.empty())
+    {
+      const ui32 v = deadEnds.back();
+      deadEnds.pop_back();
+      if (liveTriangles[v] > 0)
+      {
+        return v;
+      }
+    }
+    while (cursor < nVertices && liveTriangles[cursor] == 0)
+    {
+      cursor++;
+    }
+    return cursor < nVertices ? cursor : INVALID_VERTEX;
+  };
+
+  ui32 fanningVertex = nextLiveVertex();
+  while (fanningVertex != INVALID_VERTEX)
+  {
+    // Emit all remaining triangles around the fanning vertex.
+    candidates.clear();
+    for (ui64 a = adjacency.offsets[fanningVertex]; a < adjacency.offsets[fanningVertex + 1]; a++)
+    {
+      const ui64 t = adjacency.triangles[a];
+      if (emitted[t])
+      {
+        continue;
+      }
+      emitted[t] = true;
+      for (ui32 c = 0; c < 3; c++)
+      {
+        const ui32 v                  = input[t * 3 + c];
+        destination[nEmitted * 3 + c] = v;
+        deadEnds.push_back(v);
+        candidates.push_back(v);
+        liveTriangles[v]--;
+        cache.access(v);
+      }
+      nEmitted++;
+    }
+
+    // Continue with the vertex that stays in the cache while its remaining triangles are emitted and is oldest.
+    ui32 best         = INVALID_VERTEX;
+    i64  bestPriority = -1;
+    for (const ui32 v : candidates)
+    {
+      if (liveTriangles[v] == 0)
+      {
+        continue;
+      }
+      i64 priority = 0;
+      if (cache.age(v) + 2 * ui64(liveTriangles[v]) <= cacheSize)
+      {
+        priority = static_cast<i64>(cache.age(v));
+      }
+      if (priority > bestPriority)
+      {
+        best         = v;
+        bestPriority = priority;
+      }
+    }
+    fanningVertex = best != INVALID_VERTEX ? best : nextLiveVertex();
+  }
+}
+
+void optimizeOverdraw(ui32* destination, const ui32* indices, ui64 nIndices, const f32* positions, ui32 nVertices,
+                      f32 threshold, ui32 cacheSize)
+{
+  impl::validateIndices(indices, nIndices, nVertices);
+  const std::vector<ui32> input(indices, indices + nIndices);
+  const ui64              nTriangles = nIndices / 3;
+  if (nTriangles == 0)
+  {
+    return;
+  }
+
+  // Hard boundaries are where the vertex cache optimization started over, i.e., all vertices of a triangle miss. The
+  // first cluster always starts at triangle 0, even if that triangle is degenerate or hits the cache.
+  std::vector<ui64> hardBoundaries;
+  {
+    FifoCache cache(nVertices, cacheSize);
+    for (ui64 t = 0; t < nTriangles; t++)
+    {
+      if (accessTriangle(cache, &input[t * 3]) == 3 || t == 0)
+      {
+        hardBoundaries.push_back(t);
+      }
+    }
+    hardBoundaries.push_back(nTriangles);
+  }
+
+  // Soft boundaries split the hard clusters as soon as the ACMR of the part since the last boundary is low enough.
+  // Starting with an empty cache at every boundary accounts for the clusters being drawn in arbitrary order.
+  std::vector<ui64> clusters;
+  {
+    FifoCache cache(nVertices, cacheSize);
+    for (size_t h = 0; h + 1 < hardBoundaries.size(); h++)
+    {
+      const ui64 begin  = hardBoundaries[h];
+      const ui64 end    = hardBoundaries[h + 1];
+      ui64       misses = 0;
+      cache.clear();
+      for (ui64 t = begin; t < end; t++)
+      {
+        misses += accessTriangle(cache, &input[t * 3]);
+      }
+      const f64 limit = f64(threshold) * f64(misses) / f64(end - begin);
+
+      clusters.push_back(begin);
+      cache.clear();
+      ui64 clusterBegin = begin;
+      misses            = 0;
+      for (ui64 t = begin; t < end; t++)
+      {
+        misses += accessTriangle(cache, &input[t * 3]);
+        if (t + 1 < end && f64(misses) / f64(t + 1 - clusterBegin) <= limit)
+        {
+          clusters.push_back(t + 1);
+          clusterBegin = t + 1;
+          misses       = 0;
+          cache.clear();
+        }
+      }
+    }
+    clusters.push_back(nTriangles);
+  }
+
+  // Area weighted centroid and normal of each cluster.
+  const size_t       nClusters = clusters.size() - 1;
+  std::vector<f32v3> centroids(nClusters, f32v3(0.0f));
+  std::vector<f32v3> normals(nClusters, f32v3(0.0f));
+  f32v3              meshCentroid(0.0f);
+  f32                meshArea = 0.0f;
+  for (size_t c = 0; c < nClusters; c++)
+  {
+    f32 clusterArea = 0.0f;
+    for (ui64 t = clusters[c]; t < clusters[c + 1]; t++)
+    {
+      const f32v3 p0     = glm::make_vec3(&positions[ui64(input[t * 3 + 0]) * 3]);
+      const f32v3 p1     = glm::make_vec3(&positions[ui64(input[t * 3 + 1]) * 3]);
+      const f32v3 p2     = glm::make_vec3(&positions[ui64(input[t * 3 + 2]) * 3]);
+      const f32v3 normal = glm::cross(p1 - p0, p2 - p0);
+      const f32   area   = glm::length(normal);
+      centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+      normals[c] += normal;
+      clusterArea += area;
+    }
+    meshCentroid += centroids[c];
+    meshArea += clusterArea;
+    centroids[c] = clusterArea > 0.0f ? centroids[c] / clusterArea : centroids[c];
+  }
+  meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+  std::vector<f32> sortKeys(nClusters);
+  for (size_t c = 0; c < nClusters; c++)
+  {
+    const f32 length = glm::length(normals[c]);
+    sortKeys[c]      = length > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+  }
+  std::vector<size_t> order(nClusters);
+  std::iota(order.begin(), order.end(), size_t(0));
+  std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+  ui32* output = destination;
+  for (const size_t c : order)
+  {
+    output = std::copy(&input[clusters[c] * 3], &input[clusters[c + 1] * 3 - 1] + 1, output);
+  }
+}
+
+std::vector<ui32> optimizeVertexFetchRemap(const ui32* indices, ui64 nIndices, ui32 nVertices)
+{
+  impl::validateIndices(indices, nIndices, nVertices);
+  std::vector<ui32> remap(nVertices, INVALID_VERTEX);
+  ui32              next = 0;
+  for (ui64 i = 0; i < nIndices; i++)
+  {
+    if (remap[indices[i]] == INVALID_VERTEX)
+    {
+      remap[indices[i]] = next++;
+    }
+  }
+  for (auto& r : remap)
+  {
+    if (r == INVALID_VERTEX)
+    {
+      r = next++;
+    }
+  }
+  return remap;
+}
+
+void remapIndices(ui32* indices, ui64 nIndices, const std::vector<ui32>& remap)
+{
+  for (ui64 i = 0; i < nIndices; i++)
+  {
+    indices[i] = remap[indices[i]];
+  }
+}
+
+void remapVertices(void* destination, const void* source, ui32 nVertices, size_t elementSize,
+                   const std::vector<ui32>& remap)
+{
+  auto*       to   = static_cast<ui8*>(destination);
+  const auto* from = static_cast<const ui8*>(source);
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    memcpy(to + remap[v] * elementSize, from + v * elementSize, elementSize);
+  }
+}
+
+void remapMesh(CograBinaryMeshFile& mesh, const std::vector<ui32>& remap)
+{
+  const ui32 nVertices = mesh.getNumVertices();
+  remapIndices(mesh.getTriangleIndices(), ui64(mesh.getNumTriangles()) * 3, remap);
+  std::vector<ui8> vertices(ui64(nVertices) * 3 * sizeof(f32));
+  memcpy(vertices.data(), mesh.getPositionsPtr(), vertices.size());
+  remapVertices(mesh.getPositionsPtr(), vertices.data(), nVertices, 3 * sizeof(f32), remap);
+  for (ui32 a = 0; a < mesh.getNumAttributes(); a++)
+  {
+    vertices.resize(mesh.getAttributeSizeInBytes(a));
+    memcpy(vertices.data(), mesh.getAttributePtr(a), vertices.size());
+    remapVertices(mesh.getAttributePtr(a), vertices.data(), nVertices, mesh.getAttributeElementSize(a), remap);
+  }
+
+  // The levels of detail share the vertices of the mesh.
+  const int lodIndicesIdx = mesh.getConstantIdx(MeshSimplifier::LOD_INDICES_CONSTANT_NAME);
+  if (lodIndicesIdx >= 0)
+  {
+    if (mesh.getConstantComponentSize(lodIndicesIdx) != sizeof(ui32))
+    {
+      throw std::runtime_error("The level of detail indices must be 32 bit.");
+    }
+    ui32* const lodIndices  = static_cast<ui32*>(mesh.getConstant(lodIndicesIdx));
+    const ui64  nLodIndices = mesh.getConstantElementSize(lodIndicesIdx) / sizeof(ui32);
+    impl::validateIndices(lodIndices, nLodIndices, nVertices);
+    remapIndices(lodIndices, nLodIndices, remap);
+  }
+}
+
+void removeTriangleOrderConstants(CograBinaryMeshFile& mesh)
+{
+  // The levels of detail stay valid, as the first level is the whole index buffer and the others are separate.
+  const int meshletsIdx = mesh.getConstantIdx(Meshlets::CONSTANT_NAME);
+  if (meshletsIdx >= 0)
+  {
+    mesh.removeConstant(static_cast<CograBinaryMeshFile::SizeType>(meshletsIdx));
+  }
+}
+
+MeshOptimizationReport optimizeMesh(CograBinaryMeshFile& mesh, f32 overdrawThreshold)
+{
+  const ui32 nVertices = mesh.getNumVertices();
+  const ui64 nIndices  = ui64(mesh.getNumTriangles()) * 3;
+  ui32*      indices   = mesh.getTriangleIndices();
+
+  MeshOptimizationReport result;
+  result.before = analyzeVertexCache(indices, nIndices, nVertices);
+  optimizeVertexCache(indices, indices, nIndices, nVertices);
+  optimizeOverdraw(indices, indices, nIndices, mesh.getPositionsPtr(), nVertices, overdrawThreshold);
+
+  removeTriangleOrderConstants(mesh);
+
+  remapMesh(mesh, optimizeVertexFetchRemap(indices, nIndices, nVertices));
+  result.after = analyzeVertexCache(indices, nIndices, nVertices);
+  return result;
+}
+} // namespace MeshOptimizer
+} // namespace gims
@@ -0,0 +1,514 @@
+#include "impl/MeshAdjacency.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <gimslib/mesh/MeshOptimizer.hpp>
+#include <gimslib/mesh/MeshSimplifier.hpp>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+//! Weight of the planes keeping border vertices on the border, relative to the planes of the triangles.
+constexpr gims::f64 BORDER_WEIGHT = 10.0;
+
+//! Levels of detail with more than this fraction of the indices of the previous level end the chain.
+constexpr gims::f64 MIN_LOD_REDUCTION = 0.95;
+
+//! How a vertex may move during simplification.
+enum VertexKind : gims::ui8
+{
+  KIND_MANIFOLD, //! Surrounded by triangles, may collapse into any neighbour.
+  KIND_BORDER,   //! On the open border of the mesh, may only collapse along the border.
+  KIND_LOCKED    //! On a seam or on non-manifold geometry, never moves.
+};
+
+//! \brief Sum of squared distances to a set of weighted planes, as a symmetric 4x4 matrix.
+struct Quadric
+{
+  gims::f64 a00    = 0.0;
+  gims::f64 a01    = 0.0;
+  gims::f64 a02    = 0.0;
+  gims::f64 a11    = 0.0;
+  gims::f64 a12    = 0.0;
+  gims::f64 a22    = 0.0;
+  gims::f64 b0     = 0.0;
+  gims::f64 b1     = 0.0;
+  gims::f64 b2     = 0.0;
+  gims::f64 c      = 0.0;
+  gims::f64 weight = 0.0;
+
+  //! Adds the plane dot(normal, p) + d = 0. The normal must have length 1.
+  void addPlane(const gims::f64v3& normal, gims::f64 d, gims::f64 w)
+  {
+    a00 += w * normal.x * normal.x;
+    a01 += w * normal.x * normal.y;
+    a02 += w * normal.x * normal.z;
+    a11 += w * normal.y * normal.y;
+    a12 += w * normal.y * normal.z;
+    a22 += w * normal.z * normal.z;
+    b0 += w * normal.x * d;
+    b1 += w * normal.y * d;
+    b2 += w * normal.z * d;
+    c += w * d * d;
+    weight += w;
+  }
+
+  void add(const Quadric& other)
+  {
+    a00 += other.a00;
+    a01 += other.a01;
+    a02 += other.a02;
+    a11 += other.a11;
+    a12 += other.a12;
+    a22 += other.a22;
+    b0 += other.b0;
+    b1 += other.b1;
+    b2 += other.b2;
+    c += other.c;
+    weight += other.weight;
+  }
+
+  //! Weighted mean of the squared distances of p to the planes.
+  gims::f64 evaluate(const gims::f64v3& p) const
+  {
+    const gims::f64 result = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z +
+                             2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) +
+                             2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+    return weight > 0.0 ? std::max(result, 0.0) / weight : 0.0;
+  }
+};
+
+//! Merging vertex from into vertex to.
+struct Collapse
+{
+  gims::ui32 from;
+  gims::ui32 to;
+  gims::f64  cost;
+};
+
+gims::f64v3 getPosition(const gims::f32* positions, gims::ui32 vertex)
+{
+  return gims::f64v3(positions[3 * gims::ui64(vertex)], positions[3 * gims::ui64(vertex) + 1],
+                     positions[3 * gims::ui64(vertex) + 2]);
+}
+
+bool haveSameAttributes(const std::vector<gims::MeshSimplifier::VertexAttributes>& attributes, gims::ui32 a,
+                        gims::ui32 b)
+{
+  for (const auto& stream : attributes)
+  {
+    const gims::ui8* const data = static_cast<const gims::ui8*>(stream.data);
+    if (memcmp(data + a * stream.strideInBytes, data + b * stream.strideInBytes, stream.elementSize) != 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+gims::ui64 getEdgeKey(gims::ui32 from, gims::ui32 to)
+{
+  return (gims::ui64(from) << 32) | to;
+}
+
+//! Sorted keys of all directed edges of the triangles, with vertices replaced by the first vertex at their position.
+std::vector<gims::ui64> createSortedEdges(const std::vector<gims::ui32>& indices,
+                                          const std::vector<gims::ui32>& positionRoots)
+{
+  std::vector<gims::ui64> result(indices.size());
+  for (size_t i = 0; i < indices.size(); i++)
+  {
+    const size_t next = i % 3 == 2 ? i - 2 : i + 1;
+    result[i]         = getEdgeKey(positionRoots[indices[i]], positionRoots[indices[next]]);
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+bool hasEdge(const std::vector<gims::ui64>& sortedEdges, gims::ui32 from, gims::ui32 to)
+{
+  return std::binary_search(sortedEdges.begin(), sortedEdges.end(), getEdgeKey(from, to));
+}
+
+//! Drops triangles with two equal indices.
+void removeDegenerateTriangles(std::vector<gims::ui32>& indices)
+{
+  size_t nKept = 0;
+  for (size_t i = 0; i < indices.size(); i += 3)
+  {
+    const gims::ui32 a = indices[i];
+    const gims::ui32 b = indices[i + 1];
+    const gims::ui32 c = indices[i + 2];
+    if (a != b && b != c && c != a)
+    {
+      indices[nKept++] = a;
+      indices[nKept++] = b;
+      indices[nKept++] = c;
+    }
+  }
+  indices.resize(nKept);
+}
+} // namespace
+
+namespace gims
+{
+namespace MeshSimplifier
+{
+ui64 simplify(ui32* destination, const ui32* indices, ui64 nIndices, const f32* positions, ui32 nVertices,
+              ui64 targetNIndices, f32 maxError, const std::vector<VertexAttributes>& attributes, f32* resultError)
+{
+  impl::validateIndices(indices, nIndices, nVertices);
+
+  // Vertices at the same position either are identical and are merged, or differ in their attributes and form a seam.
+  std::vector<ui32> order(nVertices);
+  std::iota(order.begin(), order.end(), 0);
+  const auto positionLess = [positions](ui32 a, ui32 b)
+  { return memcmp(positions + 3 * ui64(a), positions + 3 * ui64(b), 3 * sizeof(f32)) < 0; };
+  std::stable_sort(order.begin(), order.end(), positionLess);
+
+  std::vector<ui32> positionRoots(nVertices);
+  std::vector<ui32> representatives(nVertices);
+  std::vector<ui8>  kinds(nVertices, KIND_MANIFOLD);
+  for (ui32 first = 0, last = 0; first < nVertices; first = last)
+  {
+    last = first + 1;
+    while (last < nVertices && !positionLess(order[first], order[last]))
+    {
+      last++;
+    }
+    ui32 nDistinct = 0;
+    for (ui32 i = first; i < last; i++)
+    {
+      const ui32 v       = order[i];
+      positionRoots[v]   = order[first];
+      representatives[v] = v;
+      for (ui32 j = first; j < i; j++)
+      {
+        if (representatives[order[j]] == order[j] && haveSameAttributes(attributes, order[j], v))
+        {
+          representatives[v] = order[j];
+          break;
+        }
+      }
+      nDistinct += ui32(representatives[v] == v);
+    }
+    if (nDistinct > 1)
+    {
+      kinds[order[first]] = KIND_LOCKED;
+    }
+  }
+
+  std::vector<ui32> current(nIndices);
+  for (ui64 i = 0; i < nIndices; i++)
+  {
+    current[i] = representatives[indices[i]];
+  }
+  removeDegenerateTriangles(current);
+
+  // Quadrics and kinds are stored for the first vertex at each position.
+  std::vector<Quadric>    quadrics(nVertices);
+  std::vector<ui32>       nBorderEdges(nVertices, 0);
+  const std::vector<ui64> edges = createSortedEdges(current, positionRoots);
+  for (size_t t = 0; t < current.size(); t += 3)
+  {
+    const f64v3 p[3] = {getPosition(positions, current[t]), getPosition(positions, current[t + 1]),
+                        getPosition(positions, current[t + 2])};
+    const f64v3 n    = glm::cross(p[1] - p[0], p[2] - p[0]);
+    const f64   area = glm::length(n) * 0.5;
+    if (area == 0.0)
+    {
+      continue;
+    }
+    const f64v3 normal = n / (2.0 * area);
+    for (ui32 c = 0; c < 3; c++)
+    {
+      const ui32 from = positionRoots[current[t + c]];
+      const ui32 to   = positionRoots[current[t + (c + 1) % 3]];
+      quadrics[from].addPlane(normal, -glm::dot(normal, p[c]), area);
+
+      const auto range = std::equal_range(edges.begin(), edges.end(), getEdgeKey(from, to));
+      if (range.second - range.first > 1)
+      {
+        kinds[from] = KIND_LOCKED;
+        kinds[to]   = KIND_LOCKED;
+      }
+      else if (!hasEdge(edges, to, from))
+      {
+        // A plane through the border edge, perpendicular to the triangle, keeps the border in place.
+        const f64v3 edge       = p[(c + 1) % 3] - p[c];
+        const f64v3 edgeNormal = glm::normalize(glm::cross(edge, normal));
+        const f64   w          = glm::dot(edge, edge) * BORDER_WEIGHT;
+        quadrics[from].addPlane(edgeNormal, -glm::dot(edgeNormal, p[c]), w);
+        quadrics[to].addPlane(edgeNormal, -glm::dot(edgeNormal, p[c]), w);
+        kinds[from] = std::max<ui8>(kinds[from], KIND_BORDER);
+        kinds[to]   = std::max<ui8>(kinds[to], KIND_BORDER);
+        nBorderEdges[from]++;
+        nBorderEdges[to]++;
+      }
+    }
+  }
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    // Vertices where several borders meet cannot move along a single border.
+    if (nBorderEdges[v] > 2)
+    {
+      kinds[v] = KIND_LOCKED;
+    }
+  }
+
+  const f64             maxCost       = f64(maxError) * f64(maxError);
+  f64                   maxResultCost = 0.0;
+  std::vector<ui32>     remap(nVertices);
+  std::vector<bool>     touched(nVertices);
+  std::vector<Collapse> collapses;
+  std::iota(remap.begin(), remap.end(), 0);
+  while (current.size() > targetNIndices)
+  {
+    const std::vector<ui64>             currentEdges = createSortedEdges(current, positionRoots);
+    const impl::VertexTriangleAdjacency adjacency =
+        impl::createVertexTriangleAdjacency(current.data(), current.size(), nVertices);
+
+    const auto canCollapse = [&](ui32 from, ui32 to)
+    {
+      const ui32 rootFrom = positionRoots[from];
+      const ui32 rootTo   = positionRoots[to];
+      if (kinds[rootFrom] == KIND_MANIFOLD)
+      {
+        return true;
+      }
+      return kinds[rootFrom] == KIND_BORDER &&
+             (!hasEdge(currentEdges, rootFrom, rootTo) || !hasEdge(currentEdges, rootTo, rootFrom));
+    };
+    const auto addCollapse = [&](ui32 from, ui32 to)
+    {
+      if (!canCollapse(from, to))
+      {
+        return;
+      }
+      Quadric merged = quadrics[positionRoots[from]];
+      merged.add(quadrics[positionRoots[to]]);
+      const f64 cost = merged.evaluate(getPosition(positions, to));
+      if (cost <= maxCost)
+      {
+        collapses.push_back({from, to, cost});
+      }
+    };
+
+    // Every interior edge is seen once in each direction, border edges only once.
+    collapses.clear();
+    for (size_t i = 0; i < current.size(); i++)
+    {
+      const ui32 from = current[i];
+      const ui32 to   = current[i % 3 == 2 ? i - 2 : i + 1];
+      addCollapse(from, to);
+      if (!hasEdge(currentEdges, positionRoots[to], positionRoots[from]))
+      {
+        addCollapse(to, from);
+      }
+    }
+    std::sort(collapses.begin(), collapses.end(),
+              [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+    // Each collapse removes about two triangles. Collapses of one pass must not share triangles, so that each one
+    // can be checked against the unchanged mesh.
+    const ui64 nWanted    = std::max<ui64>((current.size() - targetNIndices) / 6, 1);
+    ui64       nCollapsed = 0;
+    std::fill(touched.begin(), touched.end(), false);
+    for (const Collapse& collapse : collapses)
+    {
+      if (nCollapsed == nWanted)
+      {
+        break;
+      }
+      const ui64* const triangles = adjacency.triangles.data() + adjacency.offsets[collapse.from];
+      const ui32        nAdjacent = adjacency.counts[collapse.from];
+      bool              valid     = !touched[collapse.from] && !touched[collapse.to];
+      for (ui32 i = 0; i < nAdjacent && valid; i++)
+      {
+        const ui32* const triangle = &current[triangles[i] * 3];
+        valid = !touched[triangle[0]] && !touched[triangle[1]] && !touched[triangle[2]];
+        if (!valid || triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+        {
+          continue;
+        }
+        // Reject collapses that flip a triangle around.
+        f64v3 p[3];
+        f64v3 q[3];
+        for (ui32 c = 0; c < 3; c++)
+        {
+          p[c] = getPosition(positions, triangle[c]);
+          q[c] = getPosition(positions, triangle[c] == collapse.from ? collapse.to : triangle[c]);
+        }
+        valid = glm::dot(glm::cross(p[1] - p[0], p[2] - p[0]), glm::cross(q[1] - q[0], q[2] - q[0])) > 0.0;
+      }
+      if (!valid)
+      {
+        continue;
+      }
+      for (ui32 i = 0; i < nAdjacent; i++)
+      {
+        const ui32* const triangle = &current[triangles[i] * 3];
+        touched[triangle[0]]       = true;
+        touched[triangle[1]]       = true;
+        touched[triangle[2]]       = true;
+      }
+      touched[collapse.to] = true;
+      remap[collapse.from] = collapse.to;
+      quadrics[positionRoots[collapse.to]].add(quadrics[positionRoots[collapse.from]]);
+      maxResultCost = std::max(maxResultCost, collapse.cost);
+      nCollapsed++;
+    }
+    if (nCollapsed == 0)
+    {
+      break;
+    }
+    for (ui32& index : current)
+    {
+      index = remap[index];
+    }
+    std::iota(remap.begin(), remap.end(), 0);
+    removeDegenerateTriangles(current);
+  }
+
+  memcpy(destination, current.data(), current.size() * sizeof(ui32));
+  if (resultError != nullptr)
+  {
+    *resultError = static_cast<f32>(std::sqrt(maxResultCost));
+  }
+  return current.size();
+}
+
+std::vector<LevelOfDetail> buildLods(std::vector<ui32>& lodIndices, const ui32* indices, ui64 nIndices,
+                                     const f32* positions, ui32 nVertices,
+                                     const std::vector<VertexAttributes>& attributes, ui32 maxLods, f32 reduction)
+{
+  if (!(reduction > 0.0f && reduction < 1.0f))
+  {
+    throw std::runtime_error("The reduction of levels of detail must be between 0 and 1.");
+  }
+  lodIndices.assign(indices, indices + nIndices);
+  std::vector<LevelOfDetail> result = {{0, static_cast<ui32>(nIndices), 0.0f}};
+
+  std::vector<ui32> level(indices, indices + nIndices);
+  std::vector<ui32> simplified(nIndices);
+  f32               error = 0.0f;
+  while (result.size() < maxLods && level.size() > 3)
+  {
+    const ui64 target     = ui64(f64(level.size() / 3) * reduction) * 3;
+    f32        levelError = 0.0f;
+    const ui64 nSimplified =
+        simplify(simplified.data(), level.data(), level.size(), positions, nVertices, target,
+                 std::numeric_limits<f32>::max(), attributes, &levelError);
+    if (f64(nSimplified) > f64(level.size()) * MIN_LOD_REDUCTION)
+    {
+      break;
+    }
+    MeshOptimizer::optimizeVertexCache(simplified.data(), simplified.data(), nSimplified, nVertices);
+
+    // Errors of consecutive levels add up at most, as each level is simplified from the previous one.
+    error += levelError;
+    if (lodIndices.size() + nSimplified > std::numeric_limits<ui32>::max())
+    {
+      throw std::runtime_error("Levels of detail address the index buffer with 32 bit offsets.");
+    }
+    result.push_back({static_cast<ui32>(lodIndices.size()), static_cast<ui32>(nSimplified), error});
+    lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.begin() + nSimplified);
+    level.assign(simplified.begin(), simplified.begin() + nSimplified);
+  }
+  return result;
+}
+
+std::vector<LevelOfDetail> buildLods(CograBinaryMeshFile& mesh, ui32 maxLods, f32 reduction)
+{
+  std::vector<VertexAttributes> attributes;
+  for (CograBinaryMeshFile::SizeType a = 0; a < mesh.getNumAttributes(); a++)
+  {
+    const size_t elementSize = mesh.getAttributeElementSize(a);
+    attributes.push_back({mesh.getAttributePtr(a), elementSize, elementSize});
+  }
+  const ui64                       nIndices = ui64(mesh.getNumTriangles()) * 3;
+  std::vector<ui32>                lodIndices;
+  const std::vector<LevelOfDetail> result = buildLods(lodIndices, mesh.getTriangleIndices(), nIndices,
+                                                      mesh.getPositionsPtr(), mesh.getNumVertices(), attributes,
+                                                      maxLods, reduction);
+
+  for (const char* name : {LODS_CONSTANT_NAME, LOD_INDICES_CONSTANT_NAME})
+  {
+    const int existing = mesh.getConstantIdx(name);
+    if (existing >= 0)
+    {
+      mesh.removeConstant(existing);
+    }
+  }
+  if (result.size() > 1)
+  {
+    mesh.addConstant(result.data(), static_cast<CograBinaryMeshFile::SizeType>(result.size() * 3), 4,
+                     LODS_CONSTANT_NAME);
+    mesh.addConstant(lodIndices.data() + nIndices,
+                     static_cast<CograBinaryMeshFile::SizeType>(lodIndices.size() - nIndices), sizeof(ui32),
+                     LOD_INDICES_CONSTANT_NAME);
+  }
+  return result;
+}
+
+std::vector<LevelOfDetail> getLods(const CograBinaryMeshFile& mesh, std::vector<ui32>& lodIndices)
+{
+  const ui32* const indices  = mesh.getTriangleIndices();
+  const ui64        nIndices = ui64(mesh.getNumTriangles()) * 3;
+  lodIndices.assign(indices, indices + nIndices);
+
+  const int lodsIdx    = mesh.getConstantIdx(LODS_CONSTANT_NAME);
+  const int indicesIdx = mesh.getConstantIdx(LOD_INDICES_CONSTANT_NAME);
+  if (lodsIdx < 0 || indicesIdx < 0)
+  {
+    return {{0, static_cast<ui32>(nIndices), 0.0f}};
+  }
+  const size_t lodsSize    = mesh.getConstantElementSize(lodsIdx);
+  const size_t indicesSize = mesh.getConstantElementSize(indicesIdx);
+  if (mesh.getConstantComponentSize(lodsIdx) != 4 || lodsSize % sizeof(LevelOfDetail) != 0 ||
+      mesh.getConstantComponentSize(indicesIdx) != sizeof(ui32))
+  {
+    throw std::runtime_error("The level of detail constants have an unexpected size.");
+  }
+  std::vector<LevelOfDetail> result(lodsSize / sizeof(LevelOfDetail));
+  memcpy(result.data(), mesh.getConstant(lodsIdx), lodsSize);
+  lodIndices.resize(nIndices + indicesSize / sizeof(ui32));
+  memcpy(lodIndices.data() + nIndices, mesh.getConstant(indicesIdx), indicesSize);
+  for (const LevelOfDetail& lod : result)
+  {
+    if (ui64(lod.firstIndex) + lod.nIndices > lodIndices.size())
+    {
+      throw std::runtime_error("A level of detail exceeds the level of detail indices.");
+    }
+  }
+  return result;
+}
+
+ui32 selectLod(const LevelOfDetail* lods, ui32 nLods, f32 pixelsPerUnit, f32 maxScreenSpaceError)
+{
+  for (ui32 l = nLods; l > 1; l--)
+  {
+    if (lods[l - 1].error * pixelsPerUnit <= maxScreenSpaceError)
+    {
+      return l - 1;
+    }
+  }
+  return 0;
+}
+
+f32 getPixelsPerUnit(const f32m4& modelView, const f32m4& projection, f32 viewportHeight, const f32v3& boundsMin,
+                     const f32v3& boundsMax)
+{
+  // Errors grow with the largest scale of the model view matrix. The distance is that of the closest point of the
+  // bounding sphere, so the error is never underestimated.
+  const f32   scale    = std::max({glm::length(f32v3(modelView[0])), glm::length(f32v3(modelView[1])),
+                                   glm::length(f32v3(modelView[2]))});
+  const f32v3 center   = f32v3(modelView * f32v4((boundsMin + boundsMax) * 0.5f, 1.0f));
+  const f32   radius   = glm::length(boundsMax - boundsMin) * 0.5f * scale;
+  const f32   distance = std::max(glm::length(center) - radius, std::numeric_limits<f32>::epsilon());
+  return scale * projection[1][1] * viewportHeight * 0.5f / distance;
+}
+} // namespace MeshSimplifier
+} // namespace gims
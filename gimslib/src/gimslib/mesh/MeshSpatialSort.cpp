@@ -0,0 +1,296 @@
+#include "impl/MeshAdjacency.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <gimslib/mesh/MeshBounds.hpp>
+#include <gimslib/mesh/MeshOptimizer.hpp>
+#include <gimslib/mesh/MeshSpatialSort.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+using gims::f32;
+using gims::f32v3;
+using gims::ui32;
+using gims::ui64;
+using gims::ui8;
+
+//! Number of bits sorted per pass of the radix sort. Three passes cover 32 bit keys.
+constexpr ui32 RADIX_BITS = 11;
+
+//! Number of buckets of a radix sort pass.
+constexpr ui32 RADIX_SIZE = 1 << RADIX_BITS;
+
+ui32 getNumThreads(ui32 nThreads, ui64 nElements)
+{
+  if (nThreads == 0)
+  {
+    nThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  return static_cast<ui32>(std::min<ui64>(nThreads, nElements / gims::MeshSpatialSort::MIN_ELEMENTS_PER_THREAD));
+}
+
+//! Runs tasks on a pool, or on the calling thread for a single thread.
+class Tasks
+{
+public:
+  explicit Tasks(ui32 nThreads)
+      : m_nThreads(std::max(nThreads, 1u))
+      , m_pool(nThreads > 1 ? std::make_unique<gims::ThreadPool>(nThreads) : nullptr)
+  {
+  }
+
+  ui32 getNumThreads() const
+  {
+    return m_nThreads;
+  }
+
+  //! Calls function(t, begin, end) for the chunk [begin, end) of [0, n) of each thread t.
+  void forEachChunk(ui64 n, const std::function<void(ui32, ui64, ui64)>& function)
+  {
+    if (!m_pool)
+    {
+      function(0, 0, n);
+      return;
+    }
+    std::vector<std::future<void>> futures;
+    for (ui32 t = 0; t < m_nThreads; t++)
+    {
+      const ui64 begin = n * t / m_nThreads;
+      const ui64 end   = n * (t + 1) / m_nThreads;
+      futures.push_back(m_pool->submit([&function, t, begin, end] { function(t, begin, end); }));
+    }
+    for (auto& f : futures)
+    {
+      f.get();
+    }
+  }
+
+private:
+  ui32                              m_nThreads;
+  std::unique_ptr<gims::ThreadPool> m_pool;
+};
+
+//! Stable radix sort of the indices in order by keys. Both arrays are permuted alike.
+void radixSort(std::vector<ui32>& keys, std::vector<ui32>& order, Tasks& tasks)
+{
+  const ui32        nThreads = tasks.getNumThreads();
+  const ui64        n        = keys.size();
+  std::vector<ui32> keysTemp(n);
+  std::vector<ui32> orderTemp(n);
+
+  // offsets[t * RADIX_SIZE + b] counts, and then receives the first destination of, the keys of thread t in bucket b.
+  std::vector<ui64> offsets(ui64(nThreads) * RADIX_SIZE);
+  for (ui32 shift = 0; shift < 32; shift += RADIX_BITS)
+  {
+    const auto getBucket = [shift](ui32 key) { return (key >> shift) & (RADIX_SIZE - 1); };
+    std::fill(offsets.begin(), offsets.end(), 0);
+    tasks.forEachChunk(n,
+                       [&](ui32 t, ui64 begin, ui64 end)
+                       {
+                         ui64* const counts = offsets.data() + ui64(t) * RADIX_SIZE;
+                         for (ui64 i = begin; i < end; i++)
+                         {
+                           counts[getBucket(keys[i])]++;
+                         }
+                       });
+
+    // Buckets are stored one after another, and the keys of a bucket in the order of the threads, which keeps the
+    // sort stable. A pass in which all keys fall into one bucket would not change the order.
+    ui64 sum          = 0;
+    bool singleBucket = false;
+    for (ui32 b = 0; b < RADIX_SIZE; b++)
+    {
+      ui64 bucketSize = 0;
+      for (ui32 t = 0; t < nThreads; t++)
+      {
+        const ui64 count                  = offsets[ui64(t) * RADIX_SIZE + b];
+        offsets[ui64(t) * RADIX_SIZE + b] = sum;
+        sum += count;
+        bucketSize += count;
+      }
+      singleBucket = singleBucket || bucketSize == n;
+    }
+    if (singleBucket)
+    {
+      continue;
+    }
+
+    tasks.forEachChunk(n,
+                       [&](ui32 t, ui64 begin, ui64 end)
+                       {
+                         ui64* const next = offsets.data() + ui64(t) * RADIX_SIZE;
+                         for (ui64 i = begin; i < end; i++)
+                         {
+                           const ui64 destination = next[getBucket(keys[i])]++;
+                           keysTemp[destination]  = keys[i];
+                           orderTemp[destination] = order[i];
+                         }
+                       });
+    keys.swap(keysTemp);
+    order.swap(orderTemp);
+  }
+}
+
+//! Inserts two zero bits after each of the lowest ten bits of x.
+ui32 spreadBits(ui32 x)
+{
+  x &= 0x000003ff;
+  x = (x | (x << 16)) & 0x030000ff;
+  x = (x | (x << 8)) & 0x0300f00f;
+  x = (x | (x << 4)) & 0x030c30c3;
+  x = (x | (x << 2)) & 0x09249249;
+  return x;
+}
+
+//! Maps positions to Morton codes on a grid of cubic cells over a bounding box.
+struct MortonGrid
+{
+  f32v3 origin;
+  f32   scale;
+
+  explicit MortonGrid(const gims::MeshBounds::Bounds& bounds)
+      : origin(bounds.lower)
+      , scale(0.0f)
+  {
+    const f32v3 extent    = bounds.upper - bounds.lower;
+    const f32   maxExtent = std::max({extent.x, extent.y, extent.z});
+    if (maxExtent > 0.0f)
+    {
+      scale = f32(1 << gims::MeshSpatialSort::MORTON_BITS_PER_AXIS) / maxExtent;
+    }
+  }
+
+  ui32 getCell(f32 coordinate) const
+  {
+    // NaN coordinates are mapped to cell 0.
+    constexpr f32 lastCell = f32((1 << gims::MeshSpatialSort::MORTON_BITS_PER_AXIS) - 1);
+    return coordinate > 0.0f ? static_cast<ui32>(std::min(coordinate * scale, lastCell)) : 0;
+  }
+
+  ui32 getCode(const f32v3& position) const
+  {
+    const f32v3 p = position - origin;
+    return gims::MeshSpatialSort::encodeMorton(getCell(p.x), getCell(p.y), getCell(p.z));
+  }
+};
+
+f32v3 getPosition(const ui8* positions, size_t positionsStride, ui32 v)
+{
+  f32v3 result;
+  memcpy(&result, positions + v * positionsStride, sizeof(result));
+  return result;
+}
+
+f32v3 getCentroid(const ui8* positions, size_t positionsStride, const ui32* triangle)
+{
+  return (getPosition(positions, positionsStride, triangle[0]) + getPosition(positions, positionsStride, triangle[1]) +
+          getPosition(positions, positionsStride, triangle[2])) /
+         3.0f;
+}
+} // namespace
+
+namespace gims
+{
+namespace MeshSpatialSort
+{
+ui32 encodeMorton(ui32 x, ui32 y, ui32 z)
+{
+  return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+}
+
+std::vector<ui32> sortByKey(const ui32* keys, ui32 n, ui32 nThreads)
+{
+  Tasks             tasks(getNumThreads(nThreads, n));
+  std::vector<ui32> sortedKeys(keys, keys + n);
+  std::vector<ui32> result(n);
+  std::iota(result.begin(), result.end(), 0);
+  radixSort(sortedKeys, result, tasks);
+  return result;
+}
+
+std::vector<ui32> computeVertexRemap(const f32* positions, size_t positionsStride, ui32 nVertices, ui32 nThreads)
+{
+  Tasks            tasks(getNumThreads(nThreads, nVertices));
+  const MortonGrid grid(MeshBounds::computeBounds(positions, nVertices, positionsStride, tasks.getNumThreads()));
+
+  const ui8* const  bytes = reinterpret_cast<const ui8*>(positions);
+  std::vector<ui32> codes(nVertices);
+  std::vector<ui32> order(nVertices);
+  tasks.forEachChunk(nVertices,
+                     [&](ui32, ui64 begin, ui64 end)
+                     {
+                       for (ui32 v = static_cast<ui32>(begin); v < end; v++)
+                       {
+                         codes[v] = grid.getCode(getPosition(bytes, positionsStride, v));
+                         order[v] = v;
+                       }
+                     });
+  radixSort(codes, order, tasks);
+
+  std::vector<ui32> result(nVertices);
+  tasks.forEachChunk(nVertices,
+                     [&](ui32, ui64 begin, ui64 end)
+                     {
+                       for (ui32 i = static_cast<ui32>(begin); i < end; i++)
+                       {
+                         result[order[i]] = i;
+                       }
+                     });
+  return result;
+}
+
+void sortTriangles(ui32* indices, ui64 nIndices, const f32* positions, size_t positionsStride, ui32 nVertices,
+                   ui32 nThreads)
+{
+  impl::validateIndices(indices, nIndices, nVertices);
+  const ui64 nTriangles = nIndices / 3;
+  if (nTriangles > std::numeric_limits<ui32>::max())
+  {
+    throw std::runtime_error("Too many triangles to sort.");
+  }
+  Tasks            tasks(getNumThreads(nThreads, nTriangles));
+  const MortonGrid grid(MeshBounds::computeBounds(positions, nVertices, positionsStride, tasks.getNumThreads()));
+
+  const ui8* const  bytes = reinterpret_cast<const ui8*>(positions);
+  std::vector<ui32> codes(nTriangles);
+  std::vector<ui32> order(nTriangles);
+  tasks.forEachChunk(nTriangles,
+                     [&](ui32, ui64 begin, ui64 end)
+                     {
+                       for (ui64 t = begin; t < end; t++)
+                       {
+                         const f32v3 centroid = getCentroid(bytes, positionsStride, indices + 3 * t);
+                         codes[t]             = grid.getCode(centroid);
+                         order[t]             = static_cast<ui32>(t);
+                       }
+                     });
+  radixSort(codes, order, tasks);
+
+  const std::vector<ui32> source(indices, indices + nIndices);
+  tasks.forEachChunk(nTriangles,
+                     [&](ui32, ui64 begin, ui64 end)
+                     {
+                       for (ui64 t = begin; t < end; t++)
+                       {
+                         memcpy(indices + 3 * t, source.data() + 3 * ui64(order[t]), 3 * sizeof(ui32));
+                       }
+                     });
+}
+
+void sortMesh(CograBinaryMeshFile& mesh, ui32 nThreads)
+{
+  const ui32 nVertices = mesh.getNumVertices();
+  sortTriangles(mesh.getTriangleIndices(), ui64(mesh.getNumTriangles()) * 3, mesh.getPositionsPtr(),
+                3 * sizeof(f32), nVertices, nThreads);
+  MeshOptimizer::removeTriangleOrderConstants(mesh);
+  MeshOptimizer::remapMesh(mesh, computeVertexRemap(mesh.getPositionsPtr(), 3 * sizeof(f32), nVertices, nThreads));
+}
+} // namespace MeshSpatialSort
+} // namespace gims
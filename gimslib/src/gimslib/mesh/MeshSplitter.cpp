@@ -0,0 +1,105 @@
+#include "impl/MeshAdjacency.hpp"
+#include <cstring>
+#include <gimslib/mesh/MeshSplitter.hpp>
+#include <stdexcept>
+
+namespace
+{
+//! Marks a vertex that is not part of the current sub-mesh.
+constexpr gims::ui32 NO_VERTEX = ~gims::ui32(0);
+} // namespace
+
+namespace gims
+{
+namespace MeshSplitter
+{
+bool fits16BitIndices(ui32 nVertices)
+{
+  return nVertices <= MAX_16_BIT_VERTICES;
+}
+
+void convertTo16BitIndices(ui16* destination, const ui32* indices, ui64 nIndices)
+{
+  for (ui64 i = 0; i < nIndices; i++)
+  {
+    if (indices[i] >= MAX_16_BIT_VERTICES)
+    {
+      throw std::runtime_error("An index does not fit into 16 bits.");
+    }
+    destination[i] = static_cast<ui16>(indices[i]);
+  }
+}
+
+std::vector<ui16> convertTo16BitIndices(const std::vector<ui32>& indices)
+{
+  std::vector<ui16> result(indices.size());
+  convertTo16BitIndices(result.data(), indices.data(), indices.size());
+  return result;
+}
+
+std::vector<SubMesh> splitMesh(const ui32* indices, ui64 nIndices, ui32 nVertices, ui32 maxVertices)
+{
+  if (nIndices % 3 != 0)
+  {
+    throw std::runtime_error("The number of indices is not a multiple of three.");
+  }
+  if (maxVertices < 3)
+  {
+    throw std::runtime_error("A sub-mesh must be able to hold at least one triangle.");
+  }
+  impl::validateIndices(indices, nIndices, nVertices);
+
+  // Index of each original vertex in the current sub-mesh. Only the entries of the current sub-mesh are reset when a
+  // new one is started, so splitting stays linear in the size of the mesh.
+  std::vector<ui32>    localIndices(nVertices, NO_VERTEX);
+  std::vector<SubMesh> result;
+  for (ui64 i = 0; i < nIndices; i += 3)
+  {
+    ui32 nNewVertices = 0;
+    for (ui32 c = 0; c < 3; c++)
+    {
+      const ui32 v         = indices[i + c];
+      const bool duplicate = (c > 0 && indices[i] == v) || (c > 1 && indices[i + 1] == v);
+      if (localIndices[v] == NO_VERTEX && !duplicate)
+      {
+        nNewVertices++;
+      }
+    }
+    if (result.empty() || result.back().vertexIndices.size() + nNewVertices > maxVertices)
+    {
+      if (!result.empty())
+      {
+        for (const ui32 v : result.back().vertexIndices)
+        {
+          localIndices[v] = NO_VERTEX;
+        }
+      }
+      result.emplace_back();
+    }
+
+    SubMesh& subMesh = result.back();
+    for (ui32 c = 0; c < 3; c++)
+    {
+      const ui32 v = indices[i + c];
+      if (localIndices[v] == NO_VERTEX)
+      {
+        localIndices[v] = static_cast<ui32>(subMesh.vertexIndices.size());
+        subMesh.vertexIndices.push_back(v);
+      }
+      subMesh.indices.push_back(localIndices[v]);
+    }
+  }
+  return result;
+}
+
+void gatherVertices(void* destination, const void* vertices, size_t vertexSize, const SubMesh& subMesh)
+{
+  ui8* const       target = static_cast<ui8*>(destination);
+  const ui8* const source = static_cast<const ui8*>(vertices);
+  for (size_t v = 0; v < subMesh.vertexIndices.size(); v++)
+  {
+    memcpy(target + v * vertexSize, source + subMesh.vertexIndices[v] * vertexSize, vertexSize);
+  }
+}
+} // namespace MeshSplitter
+} // namespace gims
@@ -0,0 +1,312 @@
+#include "impl/MeshAdjacency.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <gimslib/mesh/MeshTangents.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <vector>
+
+namespace
+{
+using gims::f32;
+using gims::f32v2;
+using gims::f32v3;
+using gims::i8;
+using gims::ui32;
+using gims::ui64;
+using gims::ui8;
+
+//! Strided vertex attributes.
+struct Attributes
+{
+  const ui8* positions;
+  const ui8* normals;
+  const ui8* textureCoordinates;
+  size_t     stride;
+
+  f32v3 position(ui32 v) const
+  {
+    f32v3 result;
+    memcpy(&result, positions + v * stride, sizeof(result));
+    return result;
+  }
+
+  f32v3 normal(ui32 v) const
+  {
+    f32v3 result;
+    memcpy(&result, normals + v * stride, sizeof(result));
+    return result;
+  }
+
+  f32v2 textureCoordinate(ui32 v) const
+  {
+    f32v2 result;
+    memcpy(&result, textureCoordinates + v * stride, sizeof(result));
+    return result;
+  }
+};
+
+//! Contribution of a triangle to the tangent of one of its vertices.
+struct Corners
+{
+  std::vector<f32v3> tangents;   //! Tangent of the triangle in the tangent plane of the vertex, of length 1.
+  std::vector<f32>   angles;     //! Angle of the triangle at the vertex, the weight of the tangent.
+  std::vector<i8>    handedness; //! +1 or -1, 0 if the triangle does not contribute.
+};
+
+f32v3 normalizeOrZero(const f32v3& v)
+{
+  const f32 length = glm::length(v);
+  return length > 0.0f ? v / length : f32v3(0.0f);
+}
+
+f32v3 projectOntoPlane(const f32v3& v, const f32v3& normal)
+{
+  return v - normal * glm::dot(normal, v);
+}
+
+//! Calls function(begin, end) for chunks of [0, n), one per thread.
+void forEachChunk(ui64 n, ui32 nThreads, const std::function<void(ui64, ui64)>& function)
+{
+  if (nThreads <= 1)
+  {
+    function(0, n);
+    return;
+  }
+  gims::ThreadPool               pool(nThreads);
+  std::vector<std::future<void>> futures;
+  for (ui32 t = 0; t < nThreads; t++)
+  {
+    const ui64 begin = n * t / nThreads;
+    const ui64 end   = n * (t + 1) / nThreads;
+    futures.push_back(pool.submit([&function, begin, end] { function(begin, end); }));
+  }
+  for (auto& f : futures)
+  {
+    f.get();
+  }
+}
+
+ui32 getNumThreads(ui32 nThreads, ui32 nVertices)
+{
+  if (nThreads == 0)
+  {
+    nThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  return std::min(nThreads, nVertices / gims::MeshTangents::MIN_VERTICES_PER_THREAD);
+}
+
+//! Computes the contribution of each triangle to its three vertices, as in MikkTSpace.
+Corners computeCorners(const Attributes& attributes, const ui32* indices, ui64 nIndices, ui32 nThreads)
+{
+  Corners corners;
+  corners.tangents.resize(nIndices);
+  corners.angles.resize(nIndices);
+  corners.handedness.resize(nIndices);
+
+  forEachChunk(
+      nIndices / 3, nThreads,
+      [&](ui64 begin, ui64 end)
+      {
+        for (ui64 t = begin; t < end; t++)
+        {
+          const ui32* const triangle = indices + 3 * t;
+          const f32v3       p[3]     = {attributes.position(triangle[0]), attributes.position(triangle[1]),
+                                        attributes.position(triangle[2])};
+          const f32v2       uv0      = attributes.textureCoordinate(triangle[0]);
+          const f32v3       d1       = p[1] - p[0];
+          const f32v3       d2       = p[2] - p[0];
+          const f32v2       t1       = attributes.textureCoordinate(triangle[1]) - uv0;
+          const f32v2       t2       = attributes.textureCoordinate(triangle[2]) - uv0;
+
+          // Derivatives of the position with respect to the texture coordinates, up to the factor 1 / area.
+          const f32   area      = t1.x * t2.y - t1.y * t2.x;
+          const f32   sign      = area > 0.0f ? 1.0f : -1.0f;
+          const f32v3 tangent   = normalizeOrZero((d1 * t2.y - d2 * t1.y) * sign);
+          const f32v3 bitangent = normalizeOrZero((d2 * t1.x - d1 * t2.x) * sign);
+          const bool  valid     = area != 0.0f && std::isfinite(area) && tangent != f32v3(0.0f);
+
+          for (ui32 c = 0; c < 3; c++)
+          {
+            const ui64 i = 3 * t + c;
+            corners.tangents[i]   = f32v3(0.0f);
+            corners.angles[i]     = 0.0f;
+            corners.handedness[i] = 0;
+            if (!valid)
+            {
+              continue;
+            }
+            const f32v3 normal    = attributes.normal(triangle[c]);
+            const f32v3 projected = normalizeOrZero(projectOntoPlane(tangent, normal));
+            if (projected == f32v3(0.0f))
+            {
+              continue;
+            }
+
+            // The angle is measured in the tangent plane, too. Edges of length 0 count as perpendicular.
+            const f32v3 e1      = projectOntoPlane(p[(c + 1) % 3] - p[c], normal);
+            const f32v3 e2      = projectOntoPlane(p[(c + 2) % 3] - p[c], normal);
+            const f32   lengths = glm::length(e1) * glm::length(e2);
+            const f32   cosine  = lengths > 0.0f ? glm::dot(e1, e2) / lengths : 0.0f;
+
+            corners.tangents[i]   = projected;
+            corners.angles[i]     = std::acos(std::clamp(cosine, -1.0f, 1.0f));
+            corners.handedness[i] = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? -1 : 1;
+          }
+        }
+      });
+  return corners;
+}
+
+//! Sums the angles of the right-handed and the left-handed triangles at vertex v, and calls visit(i) for each
+//! contributing corner i.
+template<class Visit>
+void sumAngles(f32& rightHanded, f32& leftHanded, ui32 v, const Corners& corners, const ui32* indices,
+               const gims::impl::VertexTriangleAdjacency& adjacency, const Visit& visit)
+{
+  rightHanded = 0.0f;
+  leftHanded  = 0.0f;
+  for (ui64 k = adjacency.offsets[v]; k < adjacency.offsets[v + 1]; k++)
+  {
+    // A triangle is listed once per corner at v, the corners are visited with its first entry.
+    const ui64 t = adjacency.triangles[k];
+    if (k > adjacency.offsets[v] && adjacency.triangles[k - 1] == t)
+    {
+      continue;
+    }
+    for (ui64 i = 3 * t; i < 3 * t + 3; i++)
+    {
+      if (indices[i] != v || corners.handedness[i] == 0)
+      {
+        continue;
+      }
+      (corners.handedness[i] > 0 ? rightHanded : leftHanded) += corners.angles[i];
+      visit(i);
+    }
+  }
+}
+
+//! Handedness of the triangles that keep vertex v, the one with the larger sum of angles.
+i8 getMajorityHandedness(f32 rightHanded, f32 leftHanded)
+{
+  return leftHanded > rightHanded ? -1 : 1;
+}
+
+//! A tangent of length 1 perpendicular to the normal, for vertices without contributions.
+f32v3 getAnyTangent(const f32v3& normal)
+{
+  const f32v3 axis = std::abs(normal.x) < 0.9f ? f32v3(1.0f, 0.0f, 0.0f) : f32v3(0.0f, 1.0f, 0.0f);
+  const f32v3 t    = normalizeOrZero(projectOntoPlane(axis, normal));
+  return t != f32v3(0.0f) ? t : axis;
+}
+} // namespace
+
+namespace gims
+{
+namespace MeshTangents
+{
+std::vector<ui32> splitMirroredVertices(ui32* indices, ui64 nIndices, const f32* positions, const f32* normals,
+                                        const f32* textureCoordinates, size_t stride, ui32 nVertices, ui32 nThreads)
+{
+  impl::validateIndices(indices, nIndices, nVertices);
+  const Attributes attributes = {reinterpret_cast<const ui8*>(positions), reinterpret_cast<const ui8*>(normals),
+                                 reinterpret_cast<const ui8*>(textureCoordinates), stride};
+  nThreads                    = getNumThreads(nThreads, nVertices);
+
+  const Corners                       corners   = computeCorners(attributes, indices, nIndices, nThreads);
+  const impl::VertexTriangleAdjacency adjacency = impl::createVertexTriangleAdjacency(indices, nIndices, nVertices);
+
+  // Handedness of the corners that move to the copy of each vertex, 0 if the vertex is not split.
+  std::vector<i8> moved(nVertices, 0);
+  forEachChunk(nVertices, nThreads,
+               [&](ui64 begin, ui64 end)
+               {
+                 for (ui32 v = static_cast<ui32>(begin); v < end; v++)
+                 {
+                   bool hasRightHanded = false;
+                   bool hasLeftHanded  = false;
+                   f32  rightHanded;
+                   f32  leftHanded;
+                   sumAngles(rightHanded, leftHanded, v, corners, indices, adjacency,
+                             [&](ui64 i)
+                             {
+                               hasRightHanded |= corners.handedness[i] > 0;
+                               hasLeftHanded |= corners.handedness[i] < 0;
+                             });
+                   if (hasRightHanded && hasLeftHanded)
+                   {
+                     moved[v] = -getMajorityHandedness(rightHanded, leftHanded);
+                   }
+                 }
+               });
+
+  std::vector<ui32> result;
+  std::vector<ui32> copies(nVertices, 0);
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    if (moved[v] != 0)
+    {
+      copies[v] = nVertices + static_cast<ui32>(result.size());
+      result.push_back(v);
+    }
+  }
+
+  // Each index is read and written by one chunk only.
+  forEachChunk(nIndices, nThreads,
+               [&](ui64 begin, ui64 end)
+               {
+                 for (ui64 i = begin; i < end; i++)
+                 {
+                   const ui32 v = indices[i];
+                   if (moved[v] != 0 && corners.handedness[i] == moved[v])
+                   {
+                     indices[i] = copies[v];
+                   }
+                 }
+               });
+  return result;
+}
+
+void generateTangents(f32* tangents, size_t tangentsStride, const ui32* indices, ui64 nIndices, const f32* positions,
+                      const f32* normals, const f32* textureCoordinates, size_t stride, ui32 nVertices, ui32 nThreads)
+{
+  impl::validateIndices(indices, nIndices, nVertices);
+  const Attributes attributes = {reinterpret_cast<const ui8*>(positions), reinterpret_cast<const ui8*>(normals),
+                                 reinterpret_cast<const ui8*>(textureCoordinates), stride};
+  nThreads                    = getNumThreads(nThreads, nVertices);
+
+  const Corners                       corners   = computeCorners(attributes, indices, nIndices, nThreads);
+  const impl::VertexTriangleAdjacency adjacency = impl::createVertexTriangleAdjacency(indices, nIndices, nVertices);
+
+  // Each vertex gathers the contributions of its triangles, so no two threads write to the same tangent.
+  ui8* const bytes = reinterpret_cast<ui8*>(tangents);
+  forEachChunk(nVertices, nThreads,
+               [&](ui64 begin, ui64 end)
+               {
+                 for (ui32 v = static_cast<ui32>(begin); v < end; v++)
+                 {
+                   f32   rightHanded;
+                   f32   leftHanded;
+                   f32v3 rightHandedSum(0.0f);
+                   f32v3 leftHandedSum(0.0f);
+                   sumAngles(rightHanded, leftHanded, v, corners, indices, adjacency,
+                             [&](ui64 i)
+                             {
+                               (corners.handedness[i] > 0 ? rightHandedSum : leftHandedSum) +=
+                                   corners.tangents[i] * corners.angles[i];
+                             });
+                   const i8 handedness = getMajorityHandedness(rightHanded, leftHanded);
+                   f32v3    tangent    = normalizeOrZero(handedness > 0 ? rightHandedSum : leftHandedSum);
+                   if (tangent == f32v3(0.0f))
+                   {
+                     tangent = getAnyTangent(attributes.normal(v));
+                   }
+                   const f32 result[4] = {tangent.x, tangent.y, tangent.z, f32(handedness)};
+                   memcpy(bytes + v * tangentsStride, result, sizeof(result));
+                 }
+               });
+}
+} // namespace MeshTangents
+} // namespace gims
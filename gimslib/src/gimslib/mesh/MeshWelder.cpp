@@ -0,0 +1,240 @@
+#include "impl/MeshAdjacency.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <gimslib/mesh/MeshWelder.hpp>
+#include <stdexcept>
+
+namespace
+{
+//! Marks an empty slot of a hash table.
+constexpr gims::ui64 EMPTY_SLOT = ~gims::ui64(0);
+
+//! Quantized values beyond this magnitude are compared by their bits instead, so rounding cannot overflow.
+constexpr gims::f64 MAX_QUANTIZED = 4.0e18;
+
+//! Finalizer of MurmurHash3, spreads every input bit over the whole hash.
+gims::ui64 mix(gims::ui64 h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+gims::ui64 combine(gims::ui64 seed, gims::ui64 value)
+{
+  return mix(seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)));
+}
+
+//! Maps a component to an integer that is equal for all components that are equal after quantization.
+gims::ui64 quantize(gims::f32 value, gims::f32 step)
+{
+  if (step > 0.0f)
+  {
+    const gims::f64 scaled = std::round(gims::f64(value) / step);
+    if (std::abs(scaled) < MAX_QUANTIZED)
+    {
+      return static_cast<gims::ui64>(static_cast<gims::i64>(scaled));
+    }
+  }
+  // +0 and -0 are equal.
+  return value == 0.0f ? 0 : std::bit_cast<gims::ui32>(value);
+}
+
+//! Table with at least twice as many slots as entries, so probe sequences stay short.
+std::vector<gims::ui64> createTable(gims::ui64 nEntries)
+{
+  return std::vector<gims::ui64>(std::bit_ceil(std::max<gims::ui64>(2 * nEntries, 16)), EMPTY_SLOT);
+}
+
+gims::f32 getComponent(const gims::MeshWelder::VertexStream& stream, gims::ui32 vertex, gims::ui32 component)
+{
+  const gims::ui8* const bytes = reinterpret_cast<const gims::ui8*>(stream.data);
+  gims::f32              result;
+  memcpy(&result, bytes + vertex * stream.strideInBytes + component * sizeof(gims::f32), sizeof(gims::f32));
+  return result;
+}
+
+gims::ui64 hashVertex(const std::vector<gims::MeshWelder::VertexStream>& streams, gims::ui32 vertex)
+{
+  gims::ui64 result = 0;
+  for (const auto& stream : streams)
+  {
+    for (gims::ui32 c = 0; c < stream.nComponents; c++)
+    {
+      result = combine(result, quantize(getComponent(stream, vertex, c), stream.quantizationStep));
+    }
+  }
+  return result;
+}
+
+bool areVerticesEqual(const std::vector<gims::MeshWelder::VertexStream>& streams, gims::ui32 a, gims::ui32 b)
+{
+  for (const auto& stream : streams)
+  {
+    for (gims::ui32 c = 0; c < stream.nComponents; c++)
+    {
+      if (quantize(getComponent(stream, a, c), stream.quantizationStep) !=
+          quantize(getComponent(stream, b, c), stream.quantizationStep))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+} // namespace
+
+namespace gims
+{
+namespace MeshWelder
+{
+void WeldReport::add(const WeldReport& other)
+{
+  nVerticesBefore += other.nVerticesBefore;
+  nVerticesAfter += other.nVerticesAfter;
+  nTrianglesBefore += other.nTrianglesBefore;
+  nTrianglesAfter += other.nTrianglesAfter;
+  nDegenerateTriangles += other.nDegenerateTriangles;
+  nDuplicateTriangles += other.nDuplicateTriangles;
+}
+
+ui32 generateVertexRemap(std::vector<ui32>& remap, ui32 nVertices, const std::vector<VertexStream>& streams)
+{
+  remap.resize(nVertices);
+  std::vector<ui64> table   = createTable(nVertices);
+  const ui64        mask    = table.size() - 1;
+  ui32              nUnique = 0;
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    // Linear probing until the vertex or an empty slot is found.
+    ui64 slot = hashVertex(streams, v) & mask;
+    while (table[slot] != EMPTY_SLOT && !areVerticesEqual(streams, static_cast<ui32>(table[slot]), v))
+    {
+      slot = (slot + 1) & mask;
+    }
+    if (table[slot] == EMPTY_SLOT)
+    {
+      table[slot] = v;
+      remap[v]    = nUnique++;
+    }
+    else
+    {
+      remap[v] = remap[table[slot]];
+    }
+  }
+  return nUnique;
+}
+
+ui64 removeRedundantTriangles(ui32* indices, ui64 nIndices, ui64* nDegenerate, ui64* nDuplicate)
+{
+  if (nIndices % 3 != 0)
+  {
+    throw std::runtime_error("The number of indices is not a multiple of three.");
+  }
+  std::vector<ui64> table        = createTable(nIndices / 3);
+  const ui64        mask         = table.size() - 1;
+  ui64              nKept        = 0;
+  ui64              nDegenerates = 0;
+  ui64              nDuplicates  = 0;
+  for (ui64 i = 0; i < nIndices; i += 3)
+  {
+    // Rotating the smallest index to the front makes equal triangles equal element-wise, but keeps the winding.
+    ui32 triangle[3] = {indices[i], indices[i + 1], indices[i + 2]};
+    if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0])
+    {
+      nDegenerates++;
+      continue;
+    }
+    while (triangle[0] > triangle[1] || triangle[0] > triangle[2])
+    {
+      const ui32 first = triangle[0];
+      triangle[0]      = triangle[1];
+      triangle[1]      = triangle[2];
+      triangle[2]      = first;
+    }
+
+    ui64 slot = combine(combine(combine(0, triangle[0]), triangle[1]), triangle[2]) & mask;
+    while (table[slot] != EMPTY_SLOT && memcmp(&indices[table[slot]], triangle, sizeof(triangle)) != 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+    if (table[slot] != EMPTY_SLOT)
+    {
+      nDuplicates++;
+      continue;
+    }
+    // Kept triangles are stored rotated, so the table can compare them directly. Rotation does not change a triangle.
+    table[slot] = nKept;
+    memcpy(&indices[nKept], triangle, sizeof(triangle));
+    nKept += 3;
+  }
+  if (nDegenerate != nullptr)
+  {
+    *nDegenerate = nDegenerates;
+  }
+  if (nDuplicate != nullptr)
+  {
+    *nDuplicate = nDuplicates;
+  }
+  return nKept;
+}
+
+WeldReport weldMesh(void* vertices, ui32& nVertices, size_t vertexSize, std::vector<ui32>& indices,
+                    const std::vector<VertexStream>& streams)
+{
+  impl::validateIndices(indices.data(), indices.size(), nVertices);
+  WeldReport result;
+  result.nVerticesBefore  = nVertices;
+  result.nTrianglesBefore = indices.size() / 3;
+
+  std::vector<ui32> remap;
+  const ui32        nUnique = generateVertexRemap(remap, nVertices, streams);
+  for (ui32& index : indices)
+  {
+    index = remap[index];
+  }
+  indices.resize(removeRedundantTriangles(indices.data(), indices.size(), &result.nDegenerateTriangles,
+                                          &result.nDuplicateTriangles));
+
+  // Vertices only referenced by removed triangles are dropped. Unique vertices keep their order, so every vertex moves
+  // to the front and the buffer can be compacted in place.
+  std::vector<ui32> compacted(nUnique, 0);
+  for (const ui32 index : indices)
+  {
+    compacted[index] = 1;
+  }
+  ui32 nKept = 0;
+  for (ui32& id : compacted)
+  {
+    id = id != 0 ? nKept++ : ~ui32(0);
+  }
+  ui8* const data      = static_cast<ui8*>(vertices);
+  ui32       nextFirst = 0;
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    if (remap[v] == nextFirst)
+    {
+      if (compacted[nextFirst] != ~ui32(0))
+      {
+        memmove(data + compacted[nextFirst] * vertexSize, data + v * vertexSize, vertexSize);
+      }
+      nextFirst++;
+    }
+  }
+  for (ui32& index : indices)
+  {
+    index = compacted[index];
+  }
+
+  nVertices              = nKept;
+  result.nVerticesAfter  = nKept;
+  result.nTrianglesAfter = indices.size() / 3;
+  return result;
+}
+} // namespace MeshWelder
+} // namespace gims
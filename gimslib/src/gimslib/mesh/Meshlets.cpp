@@ -0,0 +1,362 @@
+#include "impl/MeshAdjacency.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <gimslib/mesh/Meshlets.hpp>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+//! Marks vertices that are not part of the meshlet being built.
+constexpr gims::ui32 INVALID_MESHLET = std::numeric_limits<gims::ui32>::max();
+
+//! Meshlets whose normals deviate more from the cone axis than this cosine are never back-face culled.
+constexpr gims::f32 MIN_CONE_COSINE = 0.1f;
+
+gims::f32v3 getPosition(const gims::f32* positions, gims::ui32 vertex)
+{
+  return gims::f32v3(positions[3 * gims::ui64(vertex)], positions[3 * gims::ui64(vertex) + 1],
+                     positions[3 * gims::ui64(vertex) + 2]);
+}
+
+//! Unit normal of a triangle, zero if it is degenerate.
+gims::f32v3 getTriangleNormal(const gims::f32* positions, const gims::ui32* triangle)
+{
+  const gims::f32v3 p0     = getPosition(positions, triangle[0]);
+  const gims::f32v3 p1     = getPosition(positions, triangle[1]);
+  const gims::f32v3 p2     = getPosition(positions, triangle[2]);
+  const gims::f32v3 normal = glm::cross(p1 - p0, p2 - p0);
+  const gims::f32   length = glm::length(normal);
+  return length > 0.0f ? normal / length : gims::f32v3(0.0f);
+}
+
+//! Removes a triangle from the live triangles of a vertex, which are the first counts[vertex] adjacent triangles.
+void removeTriangle(gims::impl::VertexTriangleAdjacency& adjacency, gims::ui32 vertex, gims::ui64 triangle)
+{
+  gims::ui64* const first = adjacency.triangles.data() + adjacency.offsets[vertex];
+  gims::ui64* const last  = first + adjacency.counts[vertex];
+  gims::ui64* const it    = std::find(first, last, triangle);
+  if (it != last)
+  {
+    *it = *(last - 1);
+    adjacency.counts[vertex]--;
+  }
+}
+
+//! Computes bounding sphere and normal cone of the triangles of a meshlet.
+void computeBounds(gims::Meshlets::Meshlet& meshlet, const gims::ui32* indices, const gims::f32* positions,
+                   const std::vector<gims::ui32>& vertices)
+{
+  gims::f32v3 lower(std::numeric_limits<gims::f32>::max());
+  gims::f32v3 upper(-std::numeric_limits<gims::f32>::max());
+  for (const gims::ui32 v : vertices)
+  {
+    lower = glm::min(lower, getPosition(positions, v));
+    upper = glm::max(upper, getPosition(positions, v));
+  }
+  meshlet.center = (lower + upper) * 0.5f;
+  meshlet.radius = 0.0f;
+  for (const gims::ui32 v : vertices)
+  {
+    meshlet.radius = std::max(meshlet.radius, glm::length(getPosition(positions, v) - meshlet.center));
+  }
+
+  gims::f32v3 normalSum(0.0f);
+  for (gims::ui32 i = 0; i < meshlet.nIndices; i += 3)
+  {
+    normalSum += getTriangleNormal(positions, indices + i);
+  }
+  const gims::f32 sumLength = glm::length(normalSum);
+  gims::f32       minCosine = -1.0f;
+  if (sumLength > 0.0f)
+  {
+    const gims::f32v3 axis = normalSum / sumLength;
+    minCosine              = 1.0f;
+    for (gims::ui32 i = 0; i < meshlet.nIndices; i += 3)
+    {
+      const gims::f32v3 normal = getTriangleNormal(positions, indices + i);
+      if (normal != gims::f32v3(0.0f))
+      {
+        minCosine = std::min(minCosine, glm::dot(normal, axis));
+      }
+    }
+    meshlet.coneAxis = axis;
+  }
+  if (minCosine <= MIN_CONE_COSINE)
+  {
+    meshlet.coneAxis   = gims::f32v3(0.0f);
+    meshlet.coneCutoff = 1.0f;
+  }
+  else
+  {
+    // The cone of all view directions from which every triangle is back-facing has the opening angle 90 degrees minus
+    // the opening angle of the normal cone. Its cosine is the sine of the latter.
+    meshlet.coneCutoff = std::sqrt(1.0f - minCosine * minCosine);
+  }
+}
+
+//! Row of a matrix, glm matrices are stored column by column.
+gims::f32v4 getRow(const gims::f32m4& matrix, gims::ui32 row)
+{
+  return gims::f32v4(matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row]);
+}
+
+gims::f32v4 normalizePlane(const gims::f32v4& plane)
+{
+  const gims::f32 length = glm::length(gims::f32v3(plane));
+  return length > 0.0f ? plane / length : plane;
+}
+} // namespace
+
+namespace gims
+{
+namespace Meshlets
+{
+std::vector<Meshlet> buildMeshlets(ui32* destination, const ui32* indices, ui64 nIndices, const f32* positions,
+                                   ui32 nVertices, ui32 maxVertices, ui32 maxTriangles)
+{
+  impl::validateIndices(indices, nIndices, nVertices);
+  if (maxVertices < 3 || maxTriangles == 0)
+  {
+    throw std::runtime_error("Meshlets must be able to hold at least one triangle.");
+  }
+  if (nIndices > std::numeric_limits<ui32>::max())
+  {
+    throw std::runtime_error("Meshlets address the index buffer with 32 bit offsets.");
+  }
+
+  const ui64                    nTriangles = nIndices / 3;
+  const std::vector<ui32>       input(indices, indices + nIndices);
+  impl::VertexTriangleAdjacency adjacency = impl::createVertexTriangleAdjacency(input.data(), nIndices, nVertices);
+
+  std::vector<f32v3> normals(nTriangles);
+  for (ui64 t = 0; t < nTriangles; t++)
+  {
+    normals[t] = getTriangleNormal(positions, &input[t * 3]);
+  }
+
+  std::vector<Meshlet> result;
+  std::vector<ui32>    meshletOfVertex(nVertices, INVALID_MESHLET);
+  std::vector<ui32>    vertices;
+  std::vector<bool>    emitted(nTriangles, false);
+  ui64                 nEmitted = 0;
+  ui64                 cursor   = 0;
+  f32v3                normalSum(0.0f);
+
+  const auto emit = [&](ui64 triangle)
+  {
+    const ui32 meshletIdx = static_cast<ui32>(result.size());
+    for (ui32 c = 0; c < 3; c++)
+    {
+      const ui32 v = input[triangle * 3 + c];
+      if (meshletOfVertex[v] != meshletIdx)
+      {
+        meshletOfVertex[v] = meshletIdx;
+        vertices.push_back(v);
+      }
+      removeTriangle(adjacency, v, triangle);
+      destination[nEmitted * 3 + c] = v;
+    }
+    normalSum += normals[triangle];
+    emitted[triangle] = true;
+    nEmitted++;
+  };
+
+  // Triangles whose vertices have few triangles left are at the border of the remaining surface. Taking them first
+  // avoids leaving behind small islands of triangles, which would end up in tiny meshlets.
+  const auto countLiveNeighbours = [&](ui64 triangle)
+  {
+    return adjacency.counts[input[triangle * 3]] + adjacency.counts[input[triangle * 3 + 1]] +
+           adjacency.counts[input[triangle * 3 + 2]];
+  };
+
+  while (nEmitted < nTriangles)
+  {
+    // Each meshlet is seeded next to the previous one, or with the first triangle of the input that is left.
+    ui64 seed          = nTriangles;
+    ui32 seedLiveCount = std::numeric_limits<ui32>::max();
+    for (const ui32 v : vertices)
+    {
+      const ui64* const triangles = adjacency.triangles.data() + adjacency.offsets[v];
+      for (ui32 i = 0; i < adjacency.counts[v]; i++)
+      {
+        const ui32 liveCount = countLiveNeighbours(triangles[i]);
+        if (liveCount < seedLiveCount)
+        {
+          seed          = triangles[i];
+          seedLiveCount = liveCount;
+        }
+      }
+    }
+    if (seed == nTriangles)
+    {
+      while (emitted[cursor])
+      {
+        cursor++;
+      }
+      seed = cursor;
+    }
+    const ui64 first      = nEmitted;
+    const ui32 meshletIdx = static_cast<ui32>(result.size());
+    vertices.clear();
+    normalSum = f32v3(0.0f);
+    emit(seed);
+
+    while (nEmitted - first < maxTriangles)
+    {
+      // Grow by the triangle adding the fewest vertices. Ties go to the triangle with the fewest live neighbours, then
+      // to the one facing most like the meshlet, which keeps normal cones narrow.
+      ui64 best          = nTriangles;
+      ui32 bestShared    = 0;
+      ui32 bestLiveCount = 0;
+      f32  bestAlignment = 0.0f;
+      for (const ui32 v : vertices)
+      {
+        const ui64* const triangles = adjacency.triangles.data() + adjacency.offsets[v];
+        for (ui32 i = 0; i < adjacency.counts[v]; i++)
+        {
+          const ui64 t      = triangles[i];
+          ui32       shared = 0;
+          for (ui32 c = 0; c < 3; c++)
+          {
+            shared += ui32(meshletOfVertex[input[t * 3 + c]] == meshletIdx);
+          }
+          if (vertices.size() + 3 - shared > maxVertices)
+          {
+            continue;
+          }
+          const ui32 liveCount = countLiveNeighbours(t);
+          const f32  alignment = glm::dot(normals[t], normalSum);
+          if (best == nTriangles || shared > bestShared || (shared == bestShared && liveCount < bestLiveCount) ||
+              (shared == bestShared && liveCount == bestLiveCount && alignment > bestAlignment))
+          {
+            best          = t;
+            bestShared    = shared;
+            bestLiveCount = liveCount;
+            bestAlignment = alignment;
+          }
+        }
+      }
+      if (best == nTriangles)
+      {
+        break;
+      }
+      emit(best);
+    }
+
+    Meshlet meshlet;
+    meshlet.firstIndex = static_cast<ui32>(first * 3);
+    meshlet.nIndices   = static_cast<ui32>((nEmitted - first) * 3);
+    meshlet.nVertices  = static_cast<ui32>(vertices.size());
+    computeBounds(meshlet, destination + first * 3, positions, vertices);
+    result.push_back(meshlet);
+  }
+  return result;
+}
+
+std::vector<Meshlet> buildMeshlets(CograBinaryMeshFile& mesh, ui32 maxVertices, ui32 maxTriangles)
+{
+  ui32* const                indices = mesh.getTriangleIndices();
+  const std::vector<Meshlet> result  = buildMeshlets(indices, indices, ui64(mesh.getNumTriangles()) * 3,
+                                                     mesh.getPositionsPtr(), mesh.getNumVertices(), maxVertices,
+                                                     maxTriangles);
+
+  const int existing = mesh.getConstantIdx(CONSTANT_NAME);
+  if (existing >= 0)
+  {
+    mesh.removeConstant(existing);
+  }
+  if (!result.empty())
+  {
+    mesh.addConstant(result.data(), static_cast<CograBinaryMeshFile::SizeType>(result.size() * sizeof(Meshlet) / 4), 4,
+                     CONSTANT_NAME);
+  }
+  return result;
+}
+
+std::vector<Meshlet> getMeshlets(const CograBinaryMeshFile& mesh)
+{
+  const int constantIdx = mesh.getConstantIdx(CONSTANT_NAME);
+  if (constantIdx < 0)
+  {
+    return {};
+  }
+  const size_t sizeInBytes = size_t(mesh.getConstantElementSize(constantIdx));
+  if (mesh.getConstantComponentSize(constantIdx) != 4 || sizeInBytes % sizeof(Meshlet) != 0)
+  {
+    throw std::runtime_error("Constant " + std::string(CONSTANT_NAME) + " does not contain meshlets.");
+  }
+  std::vector<Meshlet> result(sizeInBytes / sizeof(Meshlet));
+  memcpy(result.data(), mesh.getConstant(constantIdx), sizeInBytes);
+  return result;
+}
+
+CullingView createCullingView(const f32m4& modelView, const f32m4& projection, bool cullBackFaces)
+{
+  // Gribb and Hartmann: a point p is inside, if -w <= x <= w, -w <= y <= w, and 0 <= z <= w in clip space.
+  const f32m4 modelViewProjection = projection * modelView;
+  const f32v4 x                   = getRow(modelViewProjection, 0);
+  const f32v4 y                   = getRow(modelViewProjection, 1);
+  const f32v4 z                   = getRow(modelViewProjection, 2);
+  const f32v4 w                   = getRow(modelViewProjection, 3);
+
+  CullingView result;
+  result.planes[0]      = normalizePlane(w + x);
+  result.planes[1]      = normalizePlane(w - x);
+  result.planes[2]      = normalizePlane(w + y);
+  result.planes[3]      = normalizePlane(w - y);
+  result.planes[4]      = normalizePlane(z);
+  result.planes[5]      = normalizePlane(w - z);
+  result.cameraPosition = f32v3(glm::inverse(modelView)[3]);
+  result.cullBackFaces  = cullBackFaces;
+  return result;
+}
+
+bool isVisible(const Meshlet& meshlet, const CullingView& view)
+{
+  for (const f32v4& plane : view.planes)
+  {
+    if (glm::dot(f32v3(plane), meshlet.center) + plane.w < -meshlet.radius)
+    {
+      return false;
+    }
+  }
+  if (view.cullBackFaces)
+  {
+    // Every triangle is back-facing, if the camera sees the whole bounding sphere from within the cone of view
+    // directions that are at more than 90 degrees to all normals.
+    const f32v3 direction = meshlet.center - view.cameraPosition;
+    if (glm::dot(direction, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(direction) + meshlet.radius)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+ui32 cullMeshlets(std::vector<DrawRange>& ranges, const Meshlet* meshlets, ui32 nMeshlets, const CullingView& view)
+{
+  ranges.clear();
+  ui32 nVisible = 0;
+  for (ui32 i = 0; i < nMeshlets; i++)
+  {
+    const Meshlet& meshlet = meshlets[i];
+    if (!isVisible(meshlet, view))
+    {
+      continue;
+    }
+    nVisible++;
+    if (!ranges.empty() && ranges.back().firstIndex + ranges.back().nIndices == meshlet.firstIndex)
+    {
+      ranges.back().nIndices += meshlet.nIndices;
+    }
+    else
+    {
+      ranges.push_back({meshlet.firstIndex, meshlet.nIndices});
+    }
+  }
+  return nVisible;
+}
+} // namespace Meshlets
+} // namespace gims
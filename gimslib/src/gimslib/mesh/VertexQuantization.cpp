@@ -0,0 +1,752 @@
+#include <cmath>
+#include <cstring>
+#include <gimslib/mesh/VertexQuantization.hpp>
+#include <stdexcept>
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define VERTEX_QUANTIZATION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+using gims::f32;
+using gims::i16;
+using gims::i32;
+using gims::ui16;
+using gims::ui32;
+using gims::ui8;
+
+//! Largest values of the normalized integer encodings.
+constexpr f32 UNORM16_MAX = 65535.0f;
+constexpr f32 SNORM16_MAX = 32767.0f;
+constexpr f32 UNORM10_MAX = 1023.0f;
+
+// Helpers with the exact semantics of the SSE2 instructions, so both paths round alike.
+
+//! _mm_max_ps: the second operand, unless the first one is greater.
+f32 maxOf(f32 a, f32 b)
+{
+  return a > b ? a : b;
+}
+
+//! _mm_min_ps: the second operand, unless the first one is smaller.
+f32 minOf(f32 a, f32 b)
+{
+  return a < b ? a : b;
+}
+
+//! _mm_cvttps_epi32 for values in range.
+i32 truncate(f32 value)
+{
+  return static_cast<i32>(value);
+}
+
+//! Rounds a value in [0, 1] to an unsigned normalized integer with maximum maxValue.
+i32 toUnorm(f32 value, f32 maxValue)
+{
+  return truncate(minOf(maxOf(value, 0.0f), 1.0f) * maxValue + 0.5f);
+}
+
+//! Rounds a value in [-1, 1] to a signed normalized integer, half away from zero.
+i32 toSnorm16(f32 value)
+{
+  const f32 clamped = minOf(maxOf(value, -1.0f), 1.0f);
+  return truncate(clamped * SNORM16_MAX + std::copysign(0.5f, clamped));
+}
+
+//! Converts a float to a half float, rounding to nearest even. NaNs become quiet NaNs, overflows infinity.
+//!
+//! F. Giesen: float->half variants, https://gist.github.com/rygorous/2156668.
+ui16 toHalf(f32 value)
+{
+  constexpr ui32 F32_INFINITY = 255u << 23;
+  constexpr ui32 F16_MAX      = (127u + 16u) << 23;
+  constexpr ui32 MIN_NORMAL   = (127u - 14u) << 23;
+  constexpr ui32 DENORM_MAGIC = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+  ui32 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  const ui32 sign = bits & 0x80000000u;
+  bits ^= sign;
+  ui32 result;
+  if (bits >= F16_MAX)
+  {
+    result = bits > F32_INFINITY ? 0x7e00u : 0x7c00u;
+  }
+  else if (bits < MIN_NORMAL)
+  {
+    // Adding a float with a suitable exponent shifts the mantissa into place and rounds it.
+    f32 magic;
+    f32 absolute;
+    memcpy(&magic, &DENORM_MAGIC, sizeof(magic));
+    memcpy(&absolute, &bits, sizeof(absolute));
+    absolute += magic;
+    memcpy(&result, &absolute, sizeof(result));
+    result -= DENORM_MAGIC;
+  }
+  else
+  {
+    const ui32 mantissaOdd = (bits >> 13) & 1u;
+    result                 = (bits + (0xfffu - ((127u - 15u) << 23)) + mantissaOdd) >> 13;
+  }
+  return static_cast<ui16>(result | (sign >> 16));
+}
+
+//! Converts a half float to a float, exactly.
+f32 fromHalf(ui16 value)
+{
+  // Multiplying by 2^112 moves the exponent from the half to the float bias, and normalizes denormals.
+  constexpr ui32 MAGIC = (254u - 15u) << 23;
+  const ui32     bits  = (value & 0x7fffu) << 13;
+  f32            magic;
+  f32            scaled;
+  memcpy(&magic, &MAGIC, sizeof(magic));
+  memcpy(&scaled, &bits, sizeof(scaled));
+  scaled *= magic;
+  ui32 result;
+  memcpy(&result, &scaled, sizeof(result));
+  if ((value & 0x7fffu) > 0x7bffu)
+  {
+    result |= 255u << 23;
+  }
+  result |= ui32(value & 0x8000u) << 16;
+  f32 resultFloat;
+  memcpy(&resultFloat, &result, sizeof(resultFloat));
+  return resultFloat;
+}
+
+//! Reads component c of vertex v from a strided array.
+template<class T> T load(const void* data, size_t stride, size_t v, size_t c)
+{
+  T result;
+  memcpy(&result, static_cast<const ui8*>(data) + v * stride + c * sizeof(T), sizeof(T));
+  return result;
+}
+
+//! Writes component c of vertex v to a strided array.
+template<class T> void store(void* data, size_t stride, size_t v, size_t c, T value)
+{
+  memcpy(static_cast<ui8*>(data) + v * stride + c * sizeof(T), &value, sizeof(T));
+}
+
+// Scalar kernels, converting vertex v.
+
+void encodePosition(void* destination, size_t destinationStride, const f32* positions, size_t positionsStride,
+                    ui32 v, const gims::f32v3& offset, const gims::f32v3& inverseScale)
+{
+  for (ui32 c = 0; c < 3; c++)
+  {
+    const f32 relative = (load<f32>(positions, positionsStride, v, c) - offset[c]) * inverseScale[c];
+    store<ui16>(destination, destinationStride, v, c, static_cast<ui16>(toUnorm(relative, UNORM16_MAX)));
+  }
+  store<ui16>(destination, destinationStride, v, 3, 0);
+}
+
+void decodePosition(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride, ui32 v,
+                    const gims::f32v3& offset, const gims::f32v3& scale)
+{
+  for (ui32 c = 0; c < 3; c++)
+  {
+    const f32 unorm = f32(load<ui16>(encoded, encodedStride, v, c)) / UNORM16_MAX;
+    store<f32>(destination, destinationStride, v, c, offset[c] + scale[c] * unorm);
+  }
+}
+
+void encodeOctahedral(void* destination, size_t destinationStride, const f32* normals, size_t normalsStride, ui32 v)
+{
+  const f32 x       = load<f32>(normals, normalsStride, v, 0);
+  const f32 y       = load<f32>(normals, normalsStride, v, 1);
+  const f32 z       = load<f32>(normals, normalsStride, v, 2);
+  const f32 l1      = std::abs(x) + std::abs(y) + std::abs(z);
+  const f32 inverse = l1 > 0.0f ? 1.0f / l1 : 0.0f;
+  f32       u       = x * inverse;
+  f32       w       = y * inverse;
+  if (z < 0.0f)
+  {
+    // The lower hemisphere is folded over the diagonals.
+    const f32 foldedU = (1.0f - std::abs(w)) * std::copysign(1.0f, u);
+    const f32 foldedW = (1.0f - std::abs(u)) * std::copysign(1.0f, w);
+    u                 = foldedU;
+    w                 = foldedW;
+  }
+  store<i16>(destination, destinationStride, v, 0, static_cast<i16>(toSnorm16(u)));
+  store<i16>(destination, destinationStride, v, 1, static_cast<i16>(toSnorm16(w)));
+}
+
+void decodeOctahedral(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride, ui32 v)
+{
+  f32       x = maxOf(f32(load<i16>(encoded, encodedStride, v, 0)) / SNORM16_MAX, -1.0f);
+  f32       y = maxOf(f32(load<i16>(encoded, encodedStride, v, 1)) / SNORM16_MAX, -1.0f);
+  const f32 z = 1.0f - std::abs(x) - std::abs(y);
+  const f32 t = maxOf(-z, 0.0f);
+  x           = x >= 0.0f ? x - t : x + t;
+  y           = y >= 0.0f ? y - t : y + t;
+
+  const f32 length = std::sqrt(x * x + y * y + z * z);
+  store<f32>(destination, destinationStride, v, 0, x / length);
+  store<f32>(destination, destinationStride, v, 1, y / length);
+  store<f32>(destination, destinationStride, v, 2, z / length);
+}
+
+void encodeUnorm10(void* destination, size_t destinationStride, const f32* normals, size_t normalsStride, ui32 v)
+{
+  ui32 result = 0;
+  for (ui32 c = 0; c < 3; c++)
+  {
+    const f32 unorm = load<f32>(normals, normalsStride, v, c) * 0.5f + 0.5f;
+    result |= ui32(toUnorm(unorm, UNORM10_MAX)) << (10 * c);
+  }
+  store<ui32>(destination, destinationStride, v, 0, result);
+}
+
+void decodeUnorm10(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride, ui32 v)
+{
+  const ui32 bits = load<ui32>(encoded, encodedStride, v, 0);
+  for (ui32 c = 0; c < 3; c++)
+  {
+    const f32 unorm = f32((bits >> (10 * c)) & 1023u) / UNORM10_MAX;
+    store<f32>(destination, destinationStride, v, c, unorm * 2.0f - 1.0f);
+  }
+}
+
+void encodeHalf2(void* destination, size_t destinationStride, const f32* source, size_t sourceStride, ui32 v)
+{
+  for (ui32 c = 0; c < 2; c++)
+  {
+    store<ui16>(destination, destinationStride, v, c, toHalf(load<f32>(source, sourceStride, v, c)));
+  }
+}
+
+void decodeHalf2(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride, ui32 v)
+{
+  for (ui32 c = 0; c < 2; c++)
+  {
+    store<f32>(destination, destinationStride, v, c, fromHalf(load<ui16>(encoded, encodedStride, v, c)));
+  }
+}
+
+void encodeSnorm16x4(void* destination, size_t destinationStride, const f32* source, size_t sourceStride, ui32 v)
+{
+  for (ui32 c = 0; c < 4; c++)
+  {
+    const f32 value = load<f32>(source, sourceStride, v, c);
+    store<i16>(destination, destinationStride, v, c, static_cast<i16>(toSnorm16(value)));
+  }
+}
+
+void decodeSnorm16x4(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride, ui32 v)
+{
+  for (ui32 c = 0; c < 4; c++)
+  {
+    store<f32>(destination, destinationStride, v, c,
+               maxOf(f32(load<i16>(encoded, encodedStride, v, c)) / SNORM16_MAX, -1.0f));
+  }
+}
+
+#ifdef VERTEX_QUANTIZATION_SSE2
+// SSE2 kernels, converting vertices v to v + 3. Each register holds one component of four vertices.
+
+template<class T> __m128 gather(const void* data, size_t stride, ui32 v, ui32 c)
+{
+  return _mm_setr_ps(f32(load<T>(data, stride, v, c)), f32(load<T>(data, stride, v + 1, c)),
+                     f32(load<T>(data, stride, v + 2, c)), f32(load<T>(data, stride, v + 3, c)));
+}
+
+template<class T> __m128i gatherBits(const void* data, size_t stride, ui32 v, ui32 c)
+{
+  return _mm_setr_epi32(
+      static_cast<i32>(load<T>(data, stride, v, c)), static_cast<i32>(load<T>(data, stride, v + 1, c)),
+      static_cast<i32>(load<T>(data, stride, v + 2, c)), static_cast<i32>(load<T>(data, stride, v + 3, c)));
+}
+
+template<class T> void scatter(void* data, size_t stride, ui32 v, ui32 c, __m128i values)
+{
+  i32 lanes[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), values);
+  for (ui32 i = 0; i < 4; i++)
+  {
+    store<T>(data, stride, v + i, c, static_cast<T>(lanes[i]));
+  }
+}
+
+void scatter(f32* data, size_t stride, ui32 v, ui32 c, __m128 values)
+{
+  f32 lanes[4];
+  _mm_storeu_ps(lanes, values);
+  for (ui32 i = 0; i < 4; i++)
+  {
+    store<f32>(data, stride, v + i, c, lanes[i]);
+  }
+}
+
+__m128 select(__m128 mask, __m128 ifTrue, __m128 ifFalse)
+{
+  return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+}
+
+__m128 absolute(__m128 value)
+{
+  return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+}
+
+__m128 copySign(__m128 magnitude, __m128 sign)
+{
+  return _mm_or_ps(absolute(magnitude), _mm_and_ps(_mm_set1_ps(-0.0f), sign));
+}
+
+__m128i toUnorm4(__m128 value, f32 maxValue)
+{
+  const __m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+  return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(maxValue)), _mm_set1_ps(0.5f)));
+}
+
+__m128i toSnorm16x4(__m128 value)
+{
+  const __m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+  return _mm_cvttps_epi32(
+      _mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(SNORM16_MAX)), copySign(_mm_set1_ps(0.5f), clamped)));
+}
+
+__m128i toHalf4(__m128 value)
+{
+  const __m128i f16Max      = _mm_set1_epi32((127 + 16) << 23);
+  const __m128i minNormal   = _mm_set1_epi32((127 - 14) << 23);
+  const __m128i denormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+  const __m128i normalBias  = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+  const __m128  sign      = _mm_and_ps(_mm_set1_ps(-0.0f), value);
+  const __m128  magnitude = _mm_xor_ps(value, sign);
+  const __m128i bits      = _mm_castps_si128(magnitude);
+  const __m128  isNan     = _mm_cmpunord_ps(magnitude, magnitude);
+  const __m128i isRegular = _mm_cmpgt_epi32(f16Max, bits);
+  const __m128i special   = _mm_or_si128(_mm_and_si128(_mm_castps_si128(isNan), _mm_set1_epi32(0x200)),
+                                         _mm_set1_epi32(0x7c00));
+
+  // Denormal results, rounded by adding a float with a suitable exponent.
+  const __m128i isDenormal = _mm_cmpgt_epi32(minNormal, bits);
+  const __m128i denormal =
+      _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(magnitude, _mm_castsi128_ps(denormMagic))), denormMagic);
+
+  // Normal results, rounded to nearest even by adding the bias and the lowest bit of the result mantissa.
+  const __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31);
+  const __m128i normal      = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(bits, normalBias), mantissaOdd), 13);
+
+  const __m128i regular = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+  const __m128i result  = _mm_or_si128(_mm_and_si128(isRegular, regular), _mm_andnot_si128(isRegular, special));
+  return _mm_or_si128(result, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+}
+
+__m128 fromHalf4(__m128i value)
+{
+  const __m128i magnitude = _mm_and_si128(value, _mm_set1_epi32(0x7fff));
+  const __m128  scaled =
+      _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(magnitude, 13)), _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+  const __m128i isInfOrNan = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7bff));
+  const __m128i exponent   = _mm_and_si128(isInfOrNan, _mm_set1_epi32(255 << 23));
+  const __m128i sign       = _mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0x8000)), 16);
+  return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(exponent, sign)));
+}
+
+void encodePosition4(void* destination, size_t destinationStride, const f32* positions, size_t positionsStride,
+                     ui32 v, const gims::f32v3& offset, const gims::f32v3& inverseScale)
+{
+  for (ui32 c = 0; c < 3; c++)
+  {
+    const __m128 position = gather<f32>(positions, positionsStride, v, c);
+    const __m128 relative = _mm_mul_ps(_mm_sub_ps(position, _mm_set1_ps(offset[c])), _mm_set1_ps(inverseScale[c]));
+    scatter<ui16>(destination, destinationStride, v, c, toUnorm4(relative, UNORM16_MAX));
+  }
+  scatter<ui16>(destination, destinationStride, v, 3, _mm_setzero_si128());
+}
+
+void decodePosition4(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride, ui32 v,
+                     const gims::f32v3& offset, const gims::f32v3& scale)
+{
+  for (ui32 c = 0; c < 3; c++)
+  {
+    const __m128 unorm = _mm_div_ps(gather<ui16>(encoded, encodedStride, v, c), _mm_set1_ps(UNORM16_MAX));
+    scatter(destination, destinationStride, v, c,
+            _mm_add_ps(_mm_set1_ps(offset[c]), _mm_mul_ps(_mm_set1_ps(scale[c]), unorm)));
+  }
+}
+
+void encodeOctahedral4(void* destination, size_t destinationStride, const f32* normals, size_t normalsStride, ui32 v)
+{
+  const __m128 x       = gather<f32>(normals, normalsStride, v, 0);
+  const __m128 y       = gather<f32>(normals, normalsStride, v, 1);
+  const __m128 z       = gather<f32>(normals, normalsStride, v, 2);
+  const __m128 l1      = _mm_add_ps(_mm_add_ps(absolute(x), absolute(y)), absolute(z));
+  const __m128 inverse = _mm_and_ps(_mm_cmpgt_ps(l1, _mm_setzero_ps()), _mm_div_ps(_mm_set1_ps(1.0f), l1));
+  const __m128 u       = _mm_mul_ps(x, inverse);
+  const __m128 w       = _mm_mul_ps(y, inverse);
+
+  // The lower hemisphere is folded over the diagonals.
+  const __m128 one     = _mm_set1_ps(1.0f);
+  const __m128 lower   = _mm_cmplt_ps(z, _mm_setzero_ps());
+  const __m128 foldedU = _mm_mul_ps(_mm_sub_ps(one, absolute(w)), copySign(one, u));
+  const __m128 foldedW = _mm_mul_ps(_mm_sub_ps(one, absolute(u)), copySign(one, w));
+  scatter<i16>(destination, destinationStride, v, 0, toSnorm16x4(select(lower, foldedU, u)));
+  scatter<i16>(destination, destinationStride, v, 1, toSnorm16x4(select(lower, foldedW, w)));
+}
+
+void decodeOctahedral4(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride, ui32 v)
+{
+  const __m128 minusOne = _mm_set1_ps(-1.0f);
+  const __m128 snormMax = _mm_set1_ps(SNORM16_MAX);
+  __m128       x        = _mm_max_ps(_mm_div_ps(gather<i16>(encoded, encodedStride, v, 0), snormMax), minusOne);
+  __m128       y        = _mm_max_ps(_mm_div_ps(gather<i16>(encoded, encodedStride, v, 1), snormMax), minusOne);
+  const __m128 z        = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), absolute(x)), absolute(y));
+  const __m128 t        = _mm_max_ps(_mm_xor_ps(z, _mm_set1_ps(-0.0f)), _mm_setzero_ps());
+  x = select(_mm_cmpge_ps(x, _mm_setzero_ps()), _mm_sub_ps(x, t), _mm_add_ps(x, t));
+  y = select(_mm_cmpge_ps(y, _mm_setzero_ps()), _mm_sub_ps(y, t), _mm_add_ps(y, t));
+
+  const __m128 length =
+      _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+  scatter(destination, destinationStride, v, 0, _mm_div_ps(x, length));
+  scatter(destination, destinationStride, v, 1, _mm_div_ps(y, length));
+  scatter(destination, destinationStride, v, 2, _mm_div_ps(z, length));
+}
+
+void encodeUnorm10x4(void* destination, size_t destinationStride, const f32* normals, size_t normalsStride, ui32 v)
+{
+  const __m128 half   = _mm_set1_ps(0.5f);
+  __m128i      result = _mm_setzero_si128();
+  for (ui32 c = 0; c < 3; c++)
+  {
+    const __m128 unorm = _mm_add_ps(_mm_mul_ps(gather<f32>(normals, normalsStride, v, c), half), half);
+    result = _mm_or_si128(result, _mm_sll_epi32(toUnorm4(unorm, UNORM10_MAX), _mm_cvtsi32_si128(i32(10 * c))));
+  }
+  scatter<ui32>(destination, destinationStride, v, 0, result);
+}
+
+void decodeUnorm10x4(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride, ui32 v)
+{
+  const __m128i bits = gatherBits<ui32>(encoded, encodedStride, v, 0);
+  const __m128i mask = _mm_set1_epi32(1023);
+  for (ui32 c = 0; c < 3; c++)
+  {
+    const __m128i component = _mm_and_si128(_mm_srl_epi32(bits, _mm_cvtsi32_si128(i32(10 * c))), mask);
+    const __m128  unorm     = _mm_div_ps(_mm_cvtepi32_ps(component), _mm_set1_ps(UNORM10_MAX));
+    scatter(destination, destinationStride, v, c, _mm_sub_ps(_mm_mul_ps(unorm, _mm_set1_ps(2.0f)), _mm_set1_ps(1.0f)));
+  }
+}
+
+void encodeHalf2x4(void* destination, size_t destinationStride, const f32* source, size_t sourceStride, ui32 v)
+{
+  for (ui32 c = 0; c < 2; c++)
+  {
+    scatter<ui16>(destination, destinationStride, v, c, toHalf4(gather<f32>(source, sourceStride, v, c)));
+  }
+}
+
+void decodeHalf2x4(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride, ui32 v)
+{
+  for (ui32 c = 0; c < 2; c++)
+  {
+    scatter(destination, destinationStride, v, c, fromHalf4(gatherBits<ui16>(encoded, encodedStride, v, c)));
+  }
+}
+
+void encodeSnorm16x4x4(void* destination, size_t destinationStride, const f32* source, size_t sourceStride, ui32 v)
+{
+  for (ui32 c = 0; c < 4; c++)
+  {
+    scatter<i16>(destination, destinationStride, v, c, toSnorm16x4(gather<f32>(source, sourceStride, v, c)));
+  }
+}
+
+void decodeSnorm16x4x4(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride, ui32 v)
+{
+  for (ui32 c = 0; c < 4; c++)
+  {
+    const __m128 snorm = _mm_div_ps(gather<i16>(encoded, encodedStride, v, c), _mm_set1_ps(SNORM16_MAX));
+    scatter(destination, destinationStride, v, c, _mm_max_ps(snorm, _mm_set1_ps(-1.0f)));
+  }
+}
+#endif
+
+//! Inverse of the scale of each axis, 0 for flat axes, so that all positions of a flat axis map to 0.
+gims::f32v3 getInverseScale(const gims::VertexQuantization::PositionDequantization& dequantization)
+{
+  gims::f32v3 result;
+  for (ui32 c = 0; c < 3; c++)
+  {
+    result[c] = dequantization.scale[c] != 0.0f ? 1.0f / dequantization.scale[c] : 0.0f;
+  }
+  return result;
+}
+} // namespace
+
+namespace gims
+{
+namespace VertexQuantization
+{
+VertexLayout getVertexLayout(const VertexFormat& format)
+{
+  const ui32 positionSize          = format.position == POSITION_FLOAT3 ? 12 : 8;
+  const ui32 normalSize            = format.normal == NORMAL_FLOAT3 ? 12 : 4;
+  const ui32 textureCoordinateSize = format.textureCoordinate == TEXTURE_COORDINATE_FLOAT2 ? 8 : 4;
+  const ui32 tangentSize           = format.tangent == TANGENT_FLOAT4 ? 16 : format.tangent == TANGENT_SNORM16 ? 8 : 0;
+
+  VertexLayout result;
+  result.positionOffset          = 0;
+  result.normalOffset            = positionSize;
+  result.textureCoordinateOffset = positionSize + normalSize;
+  result.tangentOffset           = positionSize + normalSize + textureCoordinateSize;
+  result.stride                  = positionSize + normalSize + textureCoordinateSize + tangentSize;
+  return result;
+}
+
+PositionDequantization getPositionDequantization(PositionFormat format, const f32v3& boundsMin, const f32v3& boundsMax)
+{
+  PositionDequantization result;
+  if (format == POSITION_UNORM16)
+  {
+    result.offset = boundsMin;
+    result.scale  = glm::max(boundsMax - boundsMin, f32v3(0.0f));
+  }
+  return result;
+}
+
+void encodePositionsUnorm16(void* destination, size_t destinationStride, const f32* positions, size_t positionsStride,
+                            ui32 nVertices, const PositionDequantization& dequantization)
+{
+  const f32v3 inverseScale = getInverseScale(dequantization);
+  ui32        v            = 0;
+#ifdef VERTEX_QUANTIZATION_SSE2
+  for (; v + 4 <= nVertices; v += 4)
+  {
+    encodePosition4(destination, destinationStride, positions, positionsStride, v, dequantization.offset,
+                    inverseScale);
+  }
+#endif
+  for (; v < nVertices; v++)
+  {
+    encodePosition(destination, destinationStride, positions, positionsStride, v, dequantization.offset, inverseScale);
+  }
+}
+
+void decodePositionsUnorm16(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride,
+                            ui32 nVertices, const PositionDequantization& dequantization)
+{
+  ui32 v = 0;
+#ifdef VERTEX_QUANTIZATION_SSE2
+  for (; v + 4 <= nVertices; v += 4)
+  {
+    decodePosition4(destination, destinationStride, encoded, encodedStride, v, dequantization.offset,
+                    dequantization.scale);
+  }
+#endif
+  for (; v < nVertices; v++)
+  {
+    decodePosition(destination, destinationStride, encoded, encodedStride, v, dequantization.offset,
+                   dequantization.scale);
+  }
+}
+
+void encodeNormalsOctahedral(void* destination, size_t destinationStride, const f32* normals, size_t normalsStride,
+                             ui32 nVertices)
+{
+  ui32 v = 0;
+#ifdef VERTEX_QUANTIZATION_SSE2
+  for (; v + 4 <= nVertices; v += 4)
+  {
+    encodeOctahedral4(destination, destinationStride, normals, normalsStride, v);
+  }
+#endif
+  for (; v < nVertices; v++)
+  {
+    encodeOctahedral(destination, destinationStride, normals, normalsStride, v);
+  }
+}
+
+void decodeNormalsOctahedral(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride,
+                             ui32 nVertices)
+{
+  ui32 v = 0;
+#ifdef VERTEX_QUANTIZATION_SSE2
+  for (; v + 4 <= nVertices; v += 4)
+  {
+    decodeOctahedral4(destination, destinationStride, encoded, encodedStride, v);
+  }
+#endif
+  for (; v < nVertices; v++)
+  {
+    decodeOctahedral(destination, destinationStride, encoded, encodedStride, v);
+  }
+}
+
+void encodeNormalsUnorm10(void* destination, size_t destinationStride, const f32* normals, size_t normalsStride,
+                          ui32 nVertices)
+{
+  ui32 v = 0;
+#ifdef VERTEX_QUANTIZATION_SSE2
+  for (; v + 4 <= nVertices; v += 4)
+  {
+    encodeUnorm10x4(destination, destinationStride, normals, normalsStride, v);
+  }
+#endif
+  for (; v < nVertices; v++)
+  {
+    encodeUnorm10(destination, destinationStride, normals, normalsStride, v);
+  }
+}
+
+void decodeNormalsUnorm10(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride,
+                          ui32 nVertices)
+{
+  ui32 v = 0;
+#ifdef VERTEX_QUANTIZATION_SSE2
+  for (; v + 4 <= nVertices; v += 4)
+  {
+    decodeUnorm10x4(destination, destinationStride, encoded, encodedStride, v);
+  }
+#endif
+  for (; v < nVertices; v++)
+  {
+    decodeUnorm10(destination, destinationStride, encoded, encodedStride, v);
+  }
+}
+
+void encodeTextureCoordinatesHalf(void* destination, size_t destinationStride, const f32* textureCoordinates,
+                                  size_t textureCoordinatesStride, ui32 nVertices)
+{
+  ui32 v = 0;
+#ifdef VERTEX_QUANTIZATION_SSE2
+  for (; v + 4 <= nVertices; v += 4)
+  {
+    encodeHalf2x4(destination, destinationStride, textureCoordinates, textureCoordinatesStride, v);
+  }
+#endif
+  for (; v < nVertices; v++)
+  {
+    encodeHalf2(destination, destinationStride, textureCoordinates, textureCoordinatesStride, v);
+  }
+}
+
+void decodeTextureCoordinatesHalf(f32* destination, size_t destinationStride, const void* encoded,
+                                  size_t encodedStride, ui32 nVertices)
+{
+  ui32 v = 0;
+#ifdef VERTEX_QUANTIZATION_SSE2
+  for (; v + 4 <= nVertices; v += 4)
+  {
+    decodeHalf2x4(destination, destinationStride, encoded, encodedStride, v);
+  }
+#endif
+  for (; v < nVertices; v++)
+  {
+    decodeHalf2(destination, destinationStride, encoded, encodedStride, v);
+  }
+}
+
+void encodeTangentsSnorm16(void* destination, size_t destinationStride, const f32* tangents, size_t tangentsStride,
+                           ui32 nVertices)
+{
+  ui32 v = 0;
+#ifdef VERTEX_QUANTIZATION_SSE2
+  for (; v + 4 <= nVertices; v += 4)
+  {
+    encodeSnorm16x4x4(destination, destinationStride, tangents, tangentsStride, v);
+  }
+#endif
+  for (; v < nVertices; v++)
+  {
+    encodeSnorm16x4(destination, destinationStride, tangents, tangentsStride, v);
+  }
+}
+
+void decodeTangentsSnorm16(f32* destination, size_t destinationStride, const void* encoded, size_t encodedStride,
+                           ui32 nVertices)
+{
+  ui32 v = 0;
+#ifdef VERTEX_QUANTIZATION_SSE2
+  for (; v + 4 <= nVertices; v += 4)
+  {
+    decodeSnorm16x4x4(destination, destinationStride, encoded, encodedStride, v);
+  }
+#endif
+  for (; v < nVertices; v++)
+  {
+    decodeSnorm16x4(destination, destinationStride, encoded, encodedStride, v);
+  }
+}
+
+void encodeVertices(void* destination, const VertexFormat& format, const f32* positions, const f32* normals,
+                    const f32* textureCoordinates, size_t sourceStride, ui32 nVertices,
+                    const PositionDequantization& dequantization, const f32* tangents, size_t tangentsStride)
+{
+  const VertexLayout layout = getVertexLayout(format);
+  ui8* const         bytes  = static_cast<ui8*>(destination);
+  if (format.tangent != TANGENT_NONE && !tangents)
+  {
+    throw std::runtime_error("The vertex format requires tangents.");
+  }
+
+  if (format.position == POSITION_FLOAT3)
+  {
+    for (ui32 v = 0; v < nVertices; v++)
+    {
+      memcpy(bytes + v * layout.stride + layout.positionOffset,
+             reinterpret_cast<const ui8*>(positions) + v * sourceStride, 3 * sizeof(f32));
+    }
+  }
+  else
+  {
+    encodePositionsUnorm16(bytes + layout.positionOffset, layout.stride, positions, sourceStride, nVertices,
+                           dequantization);
+  }
+
+  switch (format.normal)
+  {
+  case NORMAL_FLOAT3:
+    for (ui32 v = 0; v < nVertices; v++)
+    {
+      memcpy(bytes + v * layout.stride + layout.normalOffset, reinterpret_cast<const ui8*>(normals) + v * sourceStride,
+             3 * sizeof(f32));
+    }
+    break;
+  case NORMAL_OCTAHEDRAL_SNORM16:
+    encodeNormalsOctahedral(bytes + layout.normalOffset, layout.stride, normals, sourceStride, nVertices);
+    break;
+  case NORMAL_UNORM10_10_10_2:
+    encodeNormalsUnorm10(bytes + layout.normalOffset, layout.stride, normals, sourceStride, nVertices);
+    break;
+  default:
+    throw std::runtime_error("Unknown normal format.");
+  }
+
+  if (format.textureCoordinate == TEXTURE_COORDINATE_FLOAT2)
+  {
+    for (ui32 v = 0; v < nVertices; v++)
+    {
+      memcpy(bytes + v * layout.stride + layout.textureCoordinateOffset,
+             reinterpret_cast<const ui8*>(textureCoordinates) + v * sourceStride, 2 * sizeof(f32));
+    }
+  }
+  else
+  {
+    encodeTextureCoordinatesHalf(bytes + layout.textureCoordinateOffset, layout.stride, textureCoordinates,
+                                 sourceStride, nVertices);
+  }
+
+  switch (format.tangent)
+  {
+  case TANGENT_NONE:
+    break;
+  case TANGENT_FLOAT4:
+    for (ui32 v = 0; v < nVertices; v++)
+    {
+      memcpy(bytes + v * layout.stride + layout.tangentOffset,
+             reinterpret_cast<const ui8*>(tangents) + v * tangentsStride, 4 * sizeof(f32));
+    }
+    break;
+  case TANGENT_SNORM16:
+    encodeTangentsSnorm16(bytes + layout.tangentOffset, layout.stride, tangents, tangentsStride, nVertices);
+    break;
+  default:
+    throw std::runtime_error("Unknown tangent format.");
+  }
+}
+} // namespace VertexQuantization
+} // namespace gims
@@ -0,0 +1,43 @@
+#include "MeshAdjacency.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace gims
+{
+namespace impl
+{
+void validateIndices(const ui32* indices, ui64 nIndices, ui32 nVertices)
+{
+  if (nIndices % 3 != 0)
+  {
+    throw std::runtime_error("The number of indices must be a multiple of three.");
+  }
+  if (std::any_of(indices, indices + nIndices, [nVertices](ui32 i) { return i >= nVertices; }))
+  {
+    throw std::runtime_error("Vertex index out of range.");
+  }
+}
+
+VertexTriangleAdjacency createVertexTriangleAdjacency(const ui32* indices, ui64 nIndices, ui32 nVertices)
+{
+  VertexTriangleAdjacency result;
+  result.counts.assign(nVertices, 0);
+  for (ui64 i = 0; i < nIndices; i++)
+  {
+    result.counts[indices[i]]++;
+  }
+  result.offsets.assign(ui64(nVertices) + 1, 0);
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    result.offsets[v + 1] = result.offsets[v] + result.counts[v];
+  }
+  result.triangles.resize(nIndices);
+  std::vector<ui64> fill(result.offsets.begin(), result.offsets.end() - 1);
+  for (ui64 i = 0; i < nIndices; i++)
+  {
+    result.triangles[fill[indices[i]]++] = i / 3;
+  }
+  return result;
+}
+} // namespace impl
+} // namespace gims
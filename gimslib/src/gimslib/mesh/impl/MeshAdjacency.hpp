@@ -0,0 +1,26 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Throws std::runtime_error if an index is out of range or the number of indices is not a multiple of three.
+void validateIndices(const ui32* indices, ui64 nIndices, ui32 nVertices);
+
+//! Triangles adjacent to each vertex in compressed row storage.
+struct VertexTriangleAdjacency
+{
+  std::vector<ui64> offsets;   //! Triangles of vertex v are triangles[offsets[v]] to triangles[offsets[v+1]-1].
+  std::vector<ui64> triangles; //! Triangle indices.
+  std::vector<ui32> counts;    //! Number of adjacent triangles of each vertex.
+};
+
+//! \brief Lists the triangles adjacent to each vertex.
+//! \param[in]  indices Three indices per triangle.
+//! \param[in]  nIndices Number of indices, a multiple of three.
+//! \param[in]  nVertices Number of vertices, all indices must be smaller.
+VertexTriangleAdjacency createVertexTriangleAdjacency(const ui32* indices, ui64 nIndices, ui32 nVertices);
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <gimslib/sys/ThreadPool.hpp>
+
+namespace
+{
+//! The pool the calling thread is a worker of, or nullptr.
+thread_local const gims::ThreadPool* currentPool = nullptr;
+
+//! Index of the calling thread within currentPool.
+thread_local gims::ui32 currentWorkerIdx = 0;
+} // namespace
+
+namespace gims
+{
+ThreadPool::ThreadPool(ui32 nThreads)
+{
+  if (nThreads == 0)
+  {
+    nThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (ui32 i = 0; i < nThreads; i++)
+  {
+    m_queues.push_back(std::make_unique<Queue>());
+  }
+  for (ui32 i = 0; i < nThreads; i++)
+  {
+    m_threads.emplace_back(&ThreadPool::work, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_condition.notify_all();
+  for (auto& t : m_threads)
+  {
+    t.join();
+  }
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task)
+{
+  std::packaged_task<void()> packagedTask(std::move(task));
+  std::future<void>          result = packagedTask.get_future();
+
+  {
+    // Counting the task first, and under the lock, ensures that no worker goes to sleep while it is queued.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nPendingTasks++;
+  }
+  const ui32 queueIdx = currentPool == this ? currentWorkerIdx : m_nextQueue++ % getNumThreads();
+  {
+    std::lock_guard<std::mutex> lock(m_queues[queueIdx]->mutex);
+    m_queues[queueIdx]->tasks.push_back(std::move(packagedTask));
+  }
+  m_condition.notify_one();
+  return result;
+}
+
+ui32 ThreadPool::getNumThreads() const
+{
+  return static_cast<ui32>(m_threads.size());
+}
+
+void ThreadPool::work(ui32 workerIdx)
+{
+  currentPool      = this;
+  currentWorkerIdx = workerIdx;
+  while (true)
+  {
+    std::packaged_task<void()> task;
+    if (takeTask(workerIdx, task))
+    {
+      task();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this] { return m_stop || m_nPendingTasks != 0; });
+    if (m_stop && m_nPendingTasks == 0)
+    {
+      return;
+    }
+  }
+}
+
+bool ThreadPool::takeTask(ui32 workerIdx, std::packaged_task<void()>& task)
+{
+  const ui32 nQueues = static_cast<ui32>(m_queues.size());
+  for (ui32 i = 0; i < nQueues; i++)
+  {
+    Queue&                      queue = *m_queues[(workerIdx + i) % nQueues];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty())
+    {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      m_nPendingTasks--;
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace gims
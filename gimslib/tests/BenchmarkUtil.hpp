@@ -0,0 +1,53 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <thread>
+#include <vector>
+//! \brief Minimal support for the benchmarks of gimslib.
+//!
+//! Benchmarks are executables like the tests, but they are not run by ctest. They print their measurements and should
+//! be built with optimizations, e.g., in the Release configuration.
+namespace gims
+{
+namespace test
+{
+//! \brief Runs a function nRepetitions times and returns the shortest run in seconds.
+template<class Function> f64 measure(const Function& function, ui32 nRepetitions = 5)
+{
+  f64 result = std::numeric_limits<f64>::max();
+  for (ui32 r = 0; r < nRepetitions; r++)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    const std::chrono::duration<f64> duration = std::chrono::steady_clock::now() - start;
+    result                                    = std::min(result, duration.count());
+  }
+  return result;
+}
+
+//! \brief Returns 1, 2, 4, ... up to maxThreads, and maxThreads itself. 0 uses one thread per hardware thread.
+inline std::vector<ui32> getThreadCounts(ui32 maxThreads = 0)
+{
+  if (maxThreads == 0)
+  {
+    maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  std::vector<ui32> result;
+  for (ui32 nThreads = 1; nThreads < maxThreads; nThreads *= 2)
+  {
+    result.push_back(nThreads);
+  }
+  result.push_back(maxThreads);
+  return result;
+}
+
+//! \brief Returns the command line argument argIdx as a number, or defaultValue if there are fewer arguments.
+inline ui32 getArgument(int argc, char** argv, int argIdx, ui32 defaultValue)
+{
+  return argIdx < argc ? static_cast<ui32>(std::strtoul(argv[argIdx], nullptr, 10)) : defaultValue;
+}
+} // namespace test
+} // namespace gims
@@ -0,0 +1,230 @@
+#include "BenchmarkUtil.hpp"
+#include "TestMeshes.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+//! Number of calls of any operator new of the program, and the bytes requested by them.
+std::atomic<ui64> g_nAllocations = 0;
+std::atomic<ui64> g_nBytes       = 0;
+
+void* allocate(std::size_t size, std::size_t alignment)
+{
+  g_nAllocations.fetch_add(1, std::memory_order_relaxed);
+  g_nBytes.fetch_add(size, std::memory_order_relaxed);
+  // The block starts with the pointer returned by malloc, so every alignment is freed the same way.
+  void* const block = std::malloc(size + alignment + sizeof(void*));
+  if (block == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  const std::uintptr_t start  = reinterpret_cast<std::uintptr_t>(block) + sizeof(void*);
+  void* const          result = reinterpret_cast<void*>((start + alignment - 1) & ~(alignment - 1));
+  static_cast<void**>(result)[-1] = block;
+  return result;
+}
+
+void deallocate(void* pointer) noexcept
+{
+  if (pointer != nullptr)
+  {
+    std::free(static_cast<void**>(pointer)[-1]);
+  }
+}
+
+//! Allocations and bytes of one operation.
+struct AllocationCount
+{
+  ui64 nAllocations = 0;
+  ui64 nBytes       = 0;
+};
+
+template<class Function> AllocationCount countAllocations(const Function& function)
+{
+  const ui64 nAllocations = g_nAllocations.load();
+  const ui64 nBytes       = g_nBytes.load();
+  function();
+  return {g_nAllocations.load() - nAllocations, g_nBytes.load() - nBytes};
+}
+
+//! Writes a version 2 file of a sphere with four attributes and nConstants constants, like a mesh with a material.
+std::string createBenchmarkFile(ui32 nConstants)
+{
+  const test::TestMesh mesh      = test::createCubeSphere(200);
+  const ui32           nVertices = mesh.getNumVertices();
+  std::vector<f32>     textureCoordinates(nVertices * 2);
+  std::vector<f32>     tangents(nVertices * 4);
+  std::vector<ui8>     colors(nVertices * 4);
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    textureCoordinates[v * 2 + 0] = mesh.positions[v * 3 + 0] * 0.5f + 0.5f;
+    textureCoordinates[v * 2 + 1] = mesh.positions[v * 3 + 1] * 0.5f + 0.5f;
+    tangents[v * 4 + 0]           = -mesh.positions[v * 3 + 2];
+    tangents[v * 4 + 2]           = mesh.positions[v * 3 + 0];
+    tangents[v * 4 + 3]           = 1.0f;
+    colors[v * 4 + 0]             = static_cast<ui8>(v);
+    colors[v * 4 + 3]             = 255;
+  }
+  CograBinaryMeshFile file;
+  file.setPositions(mesh.positions.data(), nVertices);
+  file.setTriangleIndices(mesh.indices.data(), mesh.getNumTriangles());
+  file.addAttribute(mesh.positions.data(), 3, sizeof(f32), "Normals");
+  file.addAttribute(textureCoordinates.data(), 2, sizeof(f32), "TextureCoordinates");
+  file.addAttribute(tangents.data(), 4, sizeof(f32), "Tangents");
+  file.addAttribute(colors.data(), 4, sizeof(ui8), "Colors");
+  for (ui32 c = 0; c < nConstants; c++)
+  {
+    const f32 value[4] = {static_cast<f32>(c), 0.5f, 0.25f, 1.0f};
+    file.addConstant(value, 4, sizeof(f32), "Material" + std::to_string(c));
+  }
+
+  const std::string fileName = (std::filesystem::temp_directory_path() / "gimslib_allocation_benchmark.cbm").string();
+  file.save(fileName, CograBinaryMeshFile::VERSION_2);
+  return fileName;
+}
+
+//! Prints allocations, allocated MB and the shortest time of loading, copying, moving and adding the mesh of a file.
+void benchmark(const std::string& fileName)
+{
+  CograBinaryMeshFile mesh(fileName);
+  std::printf("%s: %u vertices, %u triangles, %u attributes, %u constants\n", fileName.c_str(),
+              mesh.getNumVertices(), mesh.getNumTriangles(), mesh.getNumAttributes(), mesh.getNumConstants());
+  std::printf("operation  allocations       MB       ms\n");
+
+  const auto print = [](const char* operation, const AllocationCount& count, f64 seconds)
+  {
+    std::printf("%-9s  %11llu  %7.2f  %7.3f\n", operation, static_cast<unsigned long long>(count.nAllocations),
+                static_cast<f64>(count.nBytes) / (1 << 20), seconds * 1000.0);
+  };
+
+  const auto load = [&] { CograBinaryMeshFile loaded(fileName); };
+  print("load", countAllocations(load), test::measure(load));
+
+  // The destruction of the copies is part of the time, but not of the allocations.
+  const auto copy = [&] { CograBinaryMeshFile copied(mesh); };
+  print("copy", countAllocations(copy), test::measure(copy));
+
+  CograBinaryMeshFile target;
+  const auto          assign = [&] { target = mesh; };
+  print("assign", countAllocations(assign), test::measure(assign));
+
+  // Moves the mesh out of target and swaps it back, since the move assignment was ambiguous before the arena.
+  const auto move = [&]
+  {
+    CograBinaryMeshFile moved(std::move(target));
+    target.swap(moved);
+  };
+  print("move", countAllocations(move), test::measure(move));
+
+  // Each repetition appends the mesh to a fresh copy, so the copy is measured separately and subtracted.
+  const auto add = [&]
+  {
+    CograBinaryMeshFile merged(mesh);
+    merged.add(mesh);
+  };
+  const AllocationCount copyCount = countAllocations(copy);
+  AllocationCount       addCount  = countAllocations(add);
+  addCount.nAllocations -= copyCount.nAllocations;
+  addCount.nBytes -= copyCount.nBytes;
+  print("add", addCount, test::measure(add) - test::measure(copy));
+}
+} // namespace
+
+void* operator new(std::size_t size)
+{
+  return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](std::size_t size)
+{
+  return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept
+{
+  deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+  deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+  deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+  deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+  deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+  deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+  deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+  deallocate(pointer);
+}
+
+//! Usage: CograBinaryMeshAllocationBenchmark [nConstants [file.cbm]]. Counts the calls of operator new while loading,
+//! copying, moving and adding meshes, with a replaced global operator new. Without a file, data/bunny.cbm and a
+//! generated sphere with four attributes and nConstants constants, 32 by default, are used.
+int main(int argc, char** argv)
+{
+  try
+  {
+    const ui32 nConstants = test::getArgument(argc, argv, 1, 32);
+    if (argc > 2)
+    {
+      benchmark(argv[2]);
+    }
+    else
+    {
+      benchmark(std::string(GIMS_DATA_DIRECTORY) + "/bunny.cbm");
+      std::printf("\n");
+      benchmark(createBenchmarkFile(nConstants));
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,203 @@
+#include "BenchmarkUtil.hpp"
+#include "TestMeshes.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/io/CograBinaryMeshView.hpp>
+#include <gimslib/io/impl/CograBinaryMeshLayout.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+//! Writes a version 2 file of a sphere with normals and texture coordinates, about 120 MB.
+std::string createBenchmarkFile()
+{
+  const test::TestMesh mesh      = test::createCubeSphere(600);
+  const ui32           nVertices = mesh.getNumVertices();
+  std::vector<f32>     textureCoordinates(nVertices * 2);
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    textureCoordinates[v * 2 + 0] = mesh.positions[v * 3 + 0] * 0.5f + 0.5f;
+    textureCoordinates[v * 2 + 1] = mesh.positions[v * 3 + 1] * 0.5f + 0.5f;
+  }
+  CograBinaryMeshFile file;
+  file.setPositions(mesh.positions.data(), nVertices);
+  file.setTriangleIndices(mesh.indices.data(), mesh.getNumTriangles());
+  file.addAttribute(mesh.positions.data(), 3, sizeof(f32), "Normals");
+  file.addAttribute(textureCoordinates.data(), 2, sizeof(f32), "TextureCoordinates");
+
+  const std::string fileName = (std::filesystem::temp_directory_path() / "gimslib_benchmark.cbm").string();
+  file.save(fileName, CograBinaryMeshFile::VERSION_2);
+  return fileName;
+}
+
+//! Loads the file with 1 to maxThreads threads, with and without checksums, and prints the throughput.
+void benchmarkLoad(const std::string& fileName, ui32 maxThreads)
+{
+  const f64 megaBytes = static_cast<f64>(std::filesystem::file_size(fileName)) / (1 << 20);
+  std::printf("Loading %s, %.1f MB. The file is in the page cache after the first run.\n", fileName.c_str(),
+              megaBytes);
+  std::printf("threads    MB/s  MB/s with checksums\n");
+  for (const ui32 nThreads : test::getThreadCounts(maxThreads))
+  {
+    f64 throughput[2];
+    for (ui32 verifyChecksums = 0; verifyChecksums < 2; verifyChecksums++)
+    {
+      CograBinaryMeshFile::LoadOptions options;
+      options.nThreads        = nThreads;
+      options.verifyChecksums = verifyChecksums != 0;
+      throughput[verifyChecksums] = megaBytes / test::measure([&] { CograBinaryMeshFile mesh(fileName, options); });
+    }
+    std::printf("%7u %7.0f %20.0f\n", nThreads, throughput[0], throughput[1]);
+  }
+}
+
+//! Saves the mesh of the file with each compression level, and prints the compression ratio relative to uncompressed
+//! version 2 files, and the throughput of saving and loading in GB of decoded data per second.
+void benchmarkCompression(const std::string& fileName)
+{
+  CograBinaryMeshFile mesh(fileName);
+  const std::string   compressedFileName = (std::filesystem::temp_directory_path() / "gimslib_compressed.cbm").string();
+  const char* const   names[]            = {"none", "lossless", "lossy"};
+  f64                 uncompressedSize   = 0.0;
+  std::printf("compression     MB  ratio  encode GB/s  decode GB/s\n");
+  for (const auto compression : {CograBinaryMeshFile::COMPRESSION_NONE, CograBinaryMeshFile::COMPRESSION_LOSSLESS,
+                                 CograBinaryMeshFile::COMPRESSION_LOSSY})
+  {
+    const f64 encodeSeconds =
+        test::measure([&] { mesh.save(compressedFileName, CograBinaryMeshFile::VERSION_2, compression); }, 3);
+    const f64 fileSize      = static_cast<f64>(std::filesystem::file_size(compressedFileName));
+    const f64 decodeSeconds = test::measure([&] { CograBinaryMeshFile decoded(compressedFileName); });
+    if (compression == CograBinaryMeshFile::COMPRESSION_NONE)
+    {
+      uncompressedSize = fileSize;
+    }
+    std::printf("%-11s %6.1f %6.2f %12.2f %12.2f\n", names[compression], fileSize / (1 << 20),
+                uncompressedSize / fileSize, uncompressedSize / encodeSeconds / (1 << 30),
+                uncompressedSize / decodeSeconds / (1 << 30));
+  }
+  std::filesystem::remove(compressedFileName);
+}
+
+//! Writes a version 2 file of about gigaBytes GB with positions and two triangles per vertex. The payloads are
+//! generated and written in pieces, so the mesh is never held in memory. Like files saved by CograBinaryMeshFile, the
+//! payloads are stored as is in one piece each and can be viewed.
+std::string createLargeFile(ui32 gigaBytes)
+{
+  impl::CograBinaryMeshLayout layout;
+  layout.nVertices                   = (ui64(gigaBytes) << 30) / (3 * sizeof(f32) + 2 * 3 * sizeof(ui32));
+  layout.nTriangles                  = layout.nVertices * 2;
+  layout.positions.storedSizeInBytes = layout.nVertices * 3 * sizeof(f32);
+  layout.positions.sizeInBytes       = layout.positions.storedSizeInBytes;
+  layout.triangles.storedSizeInBytes = layout.nTriangles * 3 * sizeof(ui32);
+  layout.triangles.sizeInBytes       = layout.triangles.storedSizeInBytes;
+  impl::computeCograBinaryMeshLayoutV2(layout);
+
+  const std::string fileName = (std::filesystem::temp_directory_path() / "gimslib_large.cbm").string();
+  std::ofstream     outFile(fileName, std::ios::binary);
+  impl::writeCograBinaryMeshHeaderV2(outFile, layout);
+  std::vector<ui32> buffer(1 << 20);
+  const auto        writeArray = [&](ui64 offset, ui64 nValues, const auto& getValue)
+  {
+    outFile.seekp(static_cast<std::streamoff>(offset));
+    for (ui64 first = 0; first < nValues; first += buffer.size())
+    {
+      const ui64 n = std::min<ui64>(buffer.size(), nValues - first);
+      for (ui64 i = 0; i < n; i++)
+      {
+        buffer[i] = getValue(first + i);
+      }
+      outFile.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(n * sizeof(ui32)));
+    }
+  };
+  const ui64 nVertices = layout.nVertices;
+  writeArray(layout.positions.offset, nVertices * 3,
+             [](ui64 i) { return std::bit_cast<ui32>(static_cast<f32>(i % 3 == 0 ? i / 3 % 4096 : i / 3 / 4096)); });
+  writeArray(layout.triangles.offset, layout.nTriangles * 3,
+             [nVertices](ui64 i) { return static_cast<ui32>((i / 3 / 2 + i % 3) % nVertices); });
+  if (!outFile.good())
+  {
+    throw std::runtime_error("Error writing file " + fileName + ".");
+  }
+  return fileName;
+}
+
+//! Reads every position and index, so that the pages of a view are actually mapped in.
+template<class Mesh> f64 touchAll(const Mesh& mesh)
+{
+  f64              sum       = 0.0;
+  const f32* const positions = mesh.getPositionsPtr();
+  for (ui64 i = 0; i < ui64(mesh.getNumVertices()) * 3; i++)
+  {
+    sum += positions[i];
+  }
+  const ui32* const indices = mesh.getTriangleIndices();
+  for (ui64 i = 0; i < ui64(mesh.getNumTriangles()) * 3; i++)
+  {
+    sum += indices[i];
+  }
+  return sum;
+}
+
+//! Compares opening a file with CograBinaryMeshView to loading it with CograBinaryMeshFile, on its own, and together
+//! with a pass over all positions and indices, which makes the view map in every page.
+void benchmarkView(const std::string& fileName, ui32 maxThreads, ui32 nRepetitions)
+{
+  const f64 megaBytes = static_cast<f64>(std::filesystem::file_size(fileName)) / (1 << 20);
+  std::printf("%s, %.1f MB, in the page cache after the first run\n", fileName.c_str(), megaBytes);
+
+  CograBinaryMeshFile::LoadOptions options;
+  options.nThreads = test::getThreadCounts(maxThreads).back();
+
+  // The sums are compared, so the compiler cannot drop the passes over the data.
+  f64       sums[2]  = {0.0, 0.0};
+  const f64 loadTime = test::measure([&] { CograBinaryMeshFile mesh(fileName, options); }, nRepetitions);
+  const f64 viewTime = test::measure([&] { CograBinaryMeshView view(fileName); }, nRepetitions);
+  const f64 loadAndReadTime =
+      test::measure([&] { sums[0] = touchAll(CograBinaryMeshFile(fileName, options)); }, nRepetitions);
+  const f64 viewAndReadTime = test::measure([&] { sums[1] = touchAll(CograBinaryMeshView(fileName)); }, nRepetitions);
+  std::printf("                     open ms  open and read all ms\n");
+  std::printf("load, %2u thread%s %11.3f %21.3f\n", options.nThreads, options.nThreads == 1 ? " " : "s",
+              loadTime * 1000.0, loadAndReadTime * 1000.0);
+  std::printf("view             %11.3f %21.3f%s\n", viewTime * 1000.0, viewAndReadTime * 1000.0,
+              sums[0] == sums[1] ? "" : " (results differ)");
+}
+} // namespace
+
+//! Usage: CograBinaryMeshFileBenchmark [maxThreads [file.cbm [gigaBytes]]]. Without a file, a synthetic mesh is
+//! written to the temporary directory and removed afterwards. Viewing is compared to loading on data/bunny.cbm and on
+//! a synthetic file of gigaBytes GB (default 2), which is removed afterwards as well.
+int main(int argc, char** argv)
+{
+  try
+  {
+    const ui32        maxThreads = test::getArgument(argc, argv, 1, 0);
+    const std::string fileName   = argc > 2 ? argv[2] : createBenchmarkFile();
+    benchmarkLoad(fileName, maxThreads);
+    benchmarkCompression(fileName);
+    if (argc <= 2)
+    {
+      std::filesystem::remove(fileName);
+    }
+
+    const ui32 gigaBytes = test::getArgument(argc, argv, 3, 2);
+    benchmarkView(std::string(GIMS_DATA_DIRECTORY) + "/bunny.cbm", maxThreads, 5);
+    const std::string largeFileName = createLargeFile(gigaBytes);
+    benchmarkView(largeFileName, maxThreads, 3);
+    std::filesystem::remove(largeFileName);
+  }
+  catch (const std::exception& e)
+  {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
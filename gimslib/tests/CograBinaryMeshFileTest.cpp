@@ -0,0 +1,425 @@
+#include "TestMeshes.hpp"
+#include "TestUtil.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/io/CograBinaryMeshView.hpp>
+#include <gimslib/io/CograBinaryMeshWriter.hpp>
+#include <gimslib/io/impl/CograBinaryMeshLayout.hpp>
+#include <gimslib/io/impl/RansCoder.hpp>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+std::string getTempFileName(const char* name)
+{
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+//! Writes a mesh in batches of different sizes with a chunk size that is not a multiple of any element size, so that
+//! elements are split between chunks. Reading the file must reassemble the arrays exactly.
+void testWriterChunkBoundaries()
+{
+  constexpr ui32 nVertices  = 1000;
+  constexpr ui32 nTriangles = 1500;
+  constexpr ui64 chunkSize  = 100;
+
+  std::vector<f32>  positions(nVertices * 3);
+  std::vector<f32>  normals(nVertices * 3);
+  std::vector<ui16> ids(nVertices);
+  std::vector<ui8>  flags(nVertices);
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    for (ui32 c = 0; c < 3; c++)
+    {
+      positions[v * 3 + c] = static_cast<f32>(v) + 0.25f * static_cast<f32>(c);
+      normals[v * 3 + c]   = c == v % 3 ? 1.0f : 0.0f;
+    }
+    ids[v]   = static_cast<ui16>(v * 7);
+    flags[v] = static_cast<ui8>(v);
+  }
+  constexpr ui32    baseVertex = 10;
+  std::vector<ui32> indices(nTriangles * 3);
+  for (ui32 i = 0; i < nTriangles * 3; i++)
+  {
+    indices[i] = baseVertex + (i * 31) % (nVertices - baseVertex);
+  }
+  const f64 constant[2] = {3.5, -1.25};
+
+  const std::string     fileName = getTempFileName("gimslib_chunks.cbm");
+  CograBinaryMeshWriter writer(fileName, chunkSize);
+  writer.addAttribute(3, sizeof(f32), "Normals");
+  writer.addAttribute(1, sizeof(ui16), "Ids");
+  writer.addAttribute(1, sizeof(ui8), "Flags");
+  writer.addConstant(&constant[0], 1, sizeof(f64), "First");
+
+  const ui32 batchSizes[] = {1, 7, 50, 3, 200, 13};
+  for (ui32 v = 0, b = 0; v < nVertices; b++)
+  {
+    const ui32        n             = std::min(batchSizes[b % std::size(batchSizes)], nVertices - v);
+    const void* const attributes[3] = {&normals[v * 3], &ids[v], &flags[v]};
+    writer.addVertices(&positions[v * 3], attributes, n);
+    v += n;
+  }
+  writer.addConstant(&constant[1], 1, sizeof(f64), "Second");
+
+  // The second half of the triangles is written relative to a base vertex, one triangle at a time.
+  const ui32 half = nTriangles / 2;
+  writer.addTriangles(indices.data(), half);
+  for (ui32 t = half; t < nTriangles; t++)
+  {
+    const ui32 relative[3] = {indices[t * 3] - baseVertex, indices[t * 3 + 1] - baseVertex,
+                              indices[t * 3 + 2] - baseVertex};
+    writer.addTriangles(relative, 1, baseVertex);
+  }
+  writer.close();
+
+  const CograBinaryMeshFile::Info info = CograBinaryMeshFile::probe(fileName);
+  GIMS_CHECK(info.version == CograBinaryMeshFile::VERSION_2);
+  GIMS_CHECK(info.nVertices == nVertices);
+  GIMS_CHECK(info.nTriangles == nTriangles);
+  GIMS_CHECK(info.attributes.size() == 3);
+  GIMS_CHECK(info.constants.size() == 2);
+
+  for (ui32 nThreads : {1u, 4u})
+  {
+    CograBinaryMeshFile::LoadOptions options;
+    options.nThreads        = nThreads;
+    options.verifyChecksums = true;
+    const CograBinaryMeshFile mesh(fileName, options);
+    GIMS_CHECK(mesh.getNumVertices() == nVertices);
+    GIMS_CHECK(mesh.getNumTriangles() == nTriangles);
+    GIMS_CHECK(std::memcmp(mesh.getPositionsPtr(), positions.data(), positions.size() * sizeof(f32)) == 0);
+    GIMS_CHECK(std::memcmp(mesh.getTriangleIndices(), indices.data(), indices.size() * sizeof(ui32)) == 0);
+    GIMS_CHECK(mesh.getNumAttributes() == 3);
+    GIMS_CHECK(std::memcmp(mesh.getAttributePtr(mesh.getAttributeIdx("Normals")), normals.data(),
+                           normals.size() * sizeof(f32)) == 0);
+    GIMS_CHECK(std::memcmp(mesh.getAttributePtr(mesh.getAttributeIdx("Ids")), ids.data(), ids.size() * 2) == 0);
+    GIMS_CHECK(std::memcmp(mesh.getAttributePtr(mesh.getAttributeIdx("Flags")), flags.data(), flags.size()) == 0);
+    GIMS_CHECK(mesh.getNumConstants() == 2);
+    GIMS_CHECK(*static_cast<const f64*>(mesh.getConstant(0)) == constant[0]);
+    GIMS_CHECK(*static_cast<const f64*>(mesh.getConstant(1)) == constant[1]);
+  }
+
+  // Chunked payloads are not contiguous and cannot be viewed.
+  CograBinaryMeshView view;
+  GIMS_CHECK_THROWS(view.open(fileName), std::runtime_error);
+  GIMS_CHECK(!view.isOpen());
+  std::filesystem::remove(fileName);
+}
+
+//! An index out of range fails the file, and must not leak into the next file of the same writer.
+void testWriterReuseAfterError()
+{
+  const std::string     fileName      = getTempFileName("gimslib_reuse.cbm");
+  const f32             positions[9]  = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+  const ui32            badIndices[3] = {0, 1, 3};
+  const ui32            indices[3]    = {0, 1, 2};
+  const f32             constant      = 1.0f;
+  const f32             attribute[3]  = {1.0f, 2.0f, 3.0f};
+  const void* const     attributes[1] = {attribute};
+  CograBinaryMeshWriter writer(fileName);
+  writer.addAttribute(1, sizeof(f32), "Attribute");
+  writer.addConstant(&constant, 1, sizeof(f32), "Constant");
+  writer.addVertices(positions, attributes, 3);
+  writer.addTriangles(badIndices, 1);
+  GIMS_CHECK_THROWS(writer.close(), std::runtime_error);
+
+  writer.open(fileName);
+  writer.addVertices(positions, nullptr, 3);
+  writer.addTriangles(indices, 1);
+  writer.close();
+  const CograBinaryMeshFile mesh(fileName);
+  GIMS_CHECK(mesh.getNumVertices() == 3);
+  GIMS_CHECK(mesh.getNumTriangles() == 1);
+  GIMS_CHECK(mesh.getNumAttributes() == 0);
+  GIMS_CHECK(mesh.getNumConstants() == 0);
+  std::filesystem::remove(fileName);
+}
+
+//! Decoding unshuffles while it writes. Covered are several blocks, both compressed and stored ones, planes that
+//! start within a block, and trailing bytes that do not make a full element.
+void testRansUnshuffle()
+{
+  std::vector<ui8> data(((ui64(1) << 20) * 5) / 2 + 5);
+  ui32             random = 12345;
+  for (ui64 i = 0; i < data.size(); i++)
+  {
+    random  = random * 1664525u + 1013904223u;
+    data[i] = i < data.size() / 2 ? static_cast<ui8>(i % 7) : static_cast<ui8>(random >> 24);
+  }
+  for (const ui32 stride : {1u, 2u, 3u, 4u, 12u})
+  {
+    std::vector<ui8> shuffled(data.size());
+    impl::shuffleBytes(data.data(), shuffled.data(), data.size(), stride);
+    std::vector<ui8> encoded;
+    impl::ransEncode(shuffled.data(), shuffled.size(), encoded);
+    std::vector<ui8> decoded(data.size());
+    impl::ransDecode(encoded.data(), encoded.size(), decoded.data(), decoded.size(), stride);
+    GIMS_CHECK(decoded == data);
+  }
+}
+
+//! Lossless files decode exactly, lossy ones within the quantization error. The sections span several blocks of the
+//! entropy coder and the quantized payloads are expanded in place.
+void testCompressionRoundTrip()
+{
+  const test::TestMesh mesh     = test::createCubeSphere(120);
+  const ui32           nVertices = mesh.getNumVertices();
+  CograBinaryMeshFile  file;
+  file.setPositions(mesh.positions.data(), nVertices);
+  file.setTriangleIndices(mesh.indices.data(), mesh.getNumTriangles());
+  file.addAttribute(mesh.positions.data(), 3, sizeof(f32), "Normals");
+
+  const std::string fileName = getTempFileName("gimslib_compression.cbm");
+  file.save(fileName, CograBinaryMeshFile::VERSION_2, CograBinaryMeshFile::COMPRESSION_LOSSLESS);
+  {
+    const CograBinaryMeshFile decoded(fileName);
+    GIMS_CHECK(std::memcmp(decoded.getPositionsPtr(), mesh.positions.data(), mesh.positions.size() * 4) == 0);
+    GIMS_CHECK(std::memcmp(decoded.getTriangleIndices(), mesh.indices.data(), mesh.indices.size() * 4) == 0);
+    GIMS_CHECK(std::memcmp(decoded.getAttributePtr(0), mesh.positions.data(), mesh.positions.size() * 4) == 0);
+  }
+
+  file.save(fileName, CograBinaryMeshFile::VERSION_2, CograBinaryMeshFile::COMPRESSION_LOSSY);
+  {
+    const CograBinaryMeshFile decoded(fileName);
+    const f32* const          positions   = decoded.getPositionsPtr();
+    const f32* const          normals     = static_cast<const f32*>(decoded.getAttributePtr(0));
+    f32                       maxError[2] = {0.0f, 0.0f};
+    for (size_t i = 0; i < mesh.positions.size(); i++)
+    {
+      maxError[0] = std::max(maxError[0], std::abs(positions[i] - mesh.positions[i]));
+      maxError[1] = std::max(maxError[1], std::abs(normals[i] - mesh.positions[i]));
+    }
+    GIMS_CHECK(maxError[0] < 2.0f / 65535.0f);
+    GIMS_CHECK(maxError[1] < 1e-3f);
+    GIMS_CHECK(std::memcmp(decoded.getTriangleIndices(), mesh.indices.data(), mesh.indices.size() * 4) == 0);
+  }
+  std::filesystem::remove(fileName);
+}
+
+//! Adding to a writer that was never opened, or that has been closed, throws instead of touching its empty streams.
+void testWriterNotOpen()
+{
+  const f32             positions[9] = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+  const ui32            indices[3]   = {0, 1, 2};
+  const f32             constant     = 1.0f;
+  CograBinaryMeshWriter writer;
+  for (ui32 closed = 0; closed < 2; closed++)
+  {
+    GIMS_CHECK(!writer.isOpen());
+    GIMS_CHECK_THROWS(writer.addAttribute(1, sizeof(f32), "Attribute"), std::runtime_error);
+    GIMS_CHECK_THROWS(writer.addConstant(&constant, 1, sizeof(f32), "Constant"), std::runtime_error);
+    GIMS_CHECK_THROWS(writer.addVertices(positions, nullptr, 3), std::runtime_error);
+    GIMS_CHECK_THROWS(writer.addTriangles(indices, 1), std::runtime_error);
+    writer.open(getTempFileName("gimslib_closed.cbm"));
+    writer.close();
+  }
+  std::filesystem::remove(getTempFileName("gimslib_closed.cbm"));
+}
+
+//! An index plus the base vertex that exceeds 32 bits is rejected before any of the triangles is added, instead of
+//! wrapping around to a small index.
+void testWriterBaseVertexOverflow()
+{
+  const std::string     fileName     = getTempFileName("gimslib_overflow.cbm");
+  const f32             positions[9] = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+  const ui32            indices[6]   = {0, 1, 2, 0, 1, 3};
+  CograBinaryMeshWriter writer(fileName);
+  writer.addVertices(positions, nullptr, 3);
+  GIMS_CHECK_THROWS(writer.addTriangles(indices, 2, 0xfffffffdu), std::runtime_error);
+  GIMS_CHECK(writer.getNumTriangles() == 0);
+  writer.addTriangles(indices, 1);
+  writer.close();
+  const CograBinaryMeshFile mesh(fileName);
+  GIMS_CHECK(mesh.getNumTriangles() == 1);
+  GIMS_CHECK(std::memcmp(mesh.getTriangleIndices(), indices, sizeof(ui32) * 3) == 0);
+  std::filesystem::remove(fileName);
+}
+
+//! A version 1 header that claims more attributes than the file could hold is rejected before they are allocated.
+void testV1ElementCountBeyondFile()
+{
+  const std::string fileName = getTempFileName("gimslib_v1_count.cbm");
+  {
+    const ui32    header[3] = {0, 0, 0xffffffffu};
+    std::ofstream outFile(fileName, std::ios::binary);
+    outFile.write(reinterpret_cast<const char*>(header), sizeof(header));
+  }
+  GIMS_CHECK_THROWS(CograBinaryMeshFile::probe(fileName), std::runtime_error);
+  GIMS_CHECK_THROWS(CograBinaryMeshFile mesh(fileName), std::runtime_error);
+  std::filesystem::remove(fileName);
+}
+
+//! Merging translates the indices of the appended mesh in 64 bits, so an index out of range of that mesh cannot wrap
+//! around to a valid one, and a failed merge leaves the mesh unchanged. Element sizes of 4 GB and more do not wrap.
+void testAddAndElementSizesIn64Bits()
+{
+  const f32           positions[9]  = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+  const ui32          indices[3]    = {0, 1, 2};
+  const ui32          badIndices[3] = {0, 1, 0xfffffffdu};
+  CograBinaryMeshFile mesh;
+  mesh.setPositions(positions, 3);
+  mesh.setTriangleIndices(indices, 1);
+  CograBinaryMeshFile other;
+  other.setPositions(positions, 3);
+  other.setTriangleIndices(badIndices, 1);
+  GIMS_CHECK_THROWS(mesh.add(other), std::runtime_error);
+  GIMS_CHECK(mesh.getNumVertices() == 3);
+  GIMS_CHECK(mesh.getNumTriangles() == 1);
+  other.setTriangleIndices(indices, 1);
+  GIMS_CHECK(mesh.add(other));
+  GIMS_CHECK(mesh.getNumTriangles() == 2);
+  GIMS_CHECK(mesh.getTriangleIndices()[5] == 5);
+
+  CograBinaryMeshFile empty;
+  const ui8           attribute = 0;
+  empty.addAttribute(&attribute, 1u << 16, 1u << 16, "Huge");
+  GIMS_CHECK(empty.getAttributeElementSize(0) == ui64(1) << 32);
+  GIMS_CHECK(empty.getTotalAttributeSize() == ui64(1) << 32);
+  GIMS_CHECK(empty.getAttributeSizeInBytes(0) == 0);
+}
+
+//! Merging appends the attributes of the other mesh, and keeps the constants and the lookup of all elements by name.
+void testAddKeepsNamedElements()
+{
+  const f32           positions[9] = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+  const ui32          indices[3]   = {0, 1, 2};
+  const ui8           colors[3]    = {1, 2, 3};
+  const ui8           others[3]    = {4, 5, 6};
+  const f32           roughness    = 0.25f;
+  const f32           albedo[3]    = {0.5f, 0.5f, 1.0f};
+  CograBinaryMeshFile mesh;
+  mesh.setPositions(positions, 3);
+  mesh.setTriangleIndices(indices, 1);
+  mesh.addAttribute(colors, 1, sizeof(ui8), "Colors");
+  mesh.addConstant(&roughness, 1, sizeof(f32), "Roughness");
+  mesh.addConstant(albedo, 3, sizeof(f32), "Albedo");
+  CograBinaryMeshFile other;
+  other.setPositions(positions, 3);
+  other.setTriangleIndices(indices, 1);
+  other.addAttribute(others, 1, sizeof(ui8), "OtherColors");
+
+  GIMS_CHECK(mesh.add(other));
+  const ui8* merged = static_cast<const ui8*>(mesh.getAttributePtr(0));
+  GIMS_CHECK(merged[2] == 3 && merged[3] == 4 && merged[5] == 6);
+  GIMS_CHECK(mesh.getAttributeIdx("Colors") == 0);
+  GIMS_CHECK(std::string(mesh.getAttributeName(0)) == "Colors");
+  GIMS_CHECK(mesh.getNumConstants() == 2);
+  GIMS_CHECK(mesh.getConstantIdx("Roughness") == 0);
+  GIMS_CHECK(mesh.getConstantIdx("Albedo") == 1);
+  GIMS_CHECK(*static_cast<const f32*>(mesh.getConstant(0)) == roughness);
+  GIMS_CHECK(static_cast<const f32*>(mesh.getConstant(1))[2] == albedo[2]);
+  GIMS_CHECK(std::string(mesh.getConstantName(1)) == "Albedo");
+}
+
+//! Saving with invalid arguments throws before the file is opened, so an existing file is not truncated.
+void testSaveInvalidArgumentsKeepsFile()
+{
+  const std::string   fileName     = getTempFileName("gimslib_save.cbm");
+  const f32           positions[9] = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+  const ui32          indices[3]   = {0, 1, 2};
+  CograBinaryMeshFile mesh;
+  mesh.setPositions(positions, 3);
+  mesh.setTriangleIndices(indices, 1);
+  mesh.save(fileName);
+  const ui64 fileSize = std::filesystem::file_size(fileName);
+
+  GIMS_CHECK_THROWS(mesh.save(fileName, CograBinaryMeshFile::VERSION_1, CograBinaryMeshFile::COMPRESSION_LOSSLESS),
+                    std::runtime_error);
+  GIMS_CHECK(std::filesystem::file_size(fileName) == fileSize);
+  GIMS_CHECK(CograBinaryMeshFile(fileName).getNumTriangles() == 1);
+  std::filesystem::remove(fileName);
+}
+
+//! Creates a version 2 file, whose positions alone exceed 4 GB, as a sparse file: Only the header, the last vertex,
+//! the triangle, the last attribute element, and a constant behind all of them are written. The payloads are read
+//! through a memory mapped view, so the test needs neither the disk space nor the memory of the full mesh.
+void testSparseFileBeyond4GB()
+{
+#if defined(__linux__)
+  constexpr ui64 nVertices       = (ui64(1) << 32) / (3 * sizeof(f32)) + 1024;
+  const f32      lastPosition[3] = {1.0f, 2.0f, 3.0f};
+  const ui32     triangle[3]     = {0, static_cast<ui32>(nVertices / 2), static_cast<ui32>(nVertices - 1)};
+  const ui32     lastId          = 0xabcdef01;
+  const f64      constant        = 42.5;
+
+  impl::CograBinaryMeshLayout layout;
+  layout.nVertices                   = nVertices;
+  layout.nTriangles                  = 1;
+  layout.positions.storedSizeInBytes = nVertices * 3 * sizeof(f32);
+  layout.positions.sizeInBytes       = layout.positions.storedSizeInBytes;
+  layout.triangles.storedSizeInBytes = sizeof(triangle);
+  layout.triangles.sizeInBytes       = sizeof(triangle);
+  layout.attributes.push_back({1, sizeof(ui32), "Ids", {}});
+  layout.attributes[0].section.storedSizeInBytes = nVertices * sizeof(ui32);
+  layout.attributes[0].section.sizeInBytes       = nVertices * sizeof(ui32);
+  layout.constants.push_back({1, sizeof(f64), "Answer", {}});
+  layout.constants[0].section.storedSizeInBytes = sizeof(f64);
+  layout.constants[0].section.sizeInBytes       = sizeof(f64);
+  const ui64 fileSize = impl::computeCograBinaryMeshLayoutV2(layout);
+  GIMS_CHECK(layout.constants[0].section.offset > (ui64(1) << 32));
+
+  const std::string fileName = getTempFileName("gimslib_sparse.cbm");
+  {
+    std::ofstream outFile(fileName, std::ios::binary);
+    impl::writeCograBinaryMeshHeaderV2(outFile, layout);
+    const auto writeAt = [&outFile](ui64 offset, const void* data, size_t sizeInBytes)
+    {
+      outFile.seekp(static_cast<std::streamoff>(offset));
+      outFile.write(static_cast<const char*>(data), static_cast<std::streamsize>(sizeInBytes));
+    };
+    writeAt(layout.positions.offset + (nVertices - 1) * sizeof(lastPosition), lastPosition, sizeof(lastPosition));
+    writeAt(layout.triangles.offset, triangle, sizeof(triangle));
+    writeAt(layout.attributes[0].section.offset + (nVertices - 1) * sizeof(ui32), &lastId, sizeof(lastId));
+    writeAt(layout.constants[0].section.offset, &constant, sizeof(constant));
+    GIMS_CHECK(outFile.good());
+  }
+  GIMS_CHECK(std::filesystem::file_size(fileName) == fileSize);
+
+  const CograBinaryMeshFile::Info info = CograBinaryMeshFile::probe(fileName);
+  GIMS_CHECK(info.nVertices == nVertices);
+  GIMS_CHECK(info.fileSize == fileSize);
+
+  {
+    const CograBinaryMeshView view(fileName);
+    GIMS_CHECK(view.getNumVertices() == nVertices);
+    GIMS_CHECK(view.getNumTriangles() == 1);
+    GIMS_CHECK(view.getPositionsPtr()[0] == 0.0f);
+    GIMS_CHECK(std::memcmp(view.getPositionsPtr() + (nVertices - 1) * 3, lastPosition, sizeof(lastPosition)) == 0);
+    GIMS_CHECK(std::memcmp(view.getTriangleIndices(), triangle, sizeof(triangle)) == 0);
+    GIMS_CHECK(static_cast<const ui32*>(view.getAttributePtr(0))[nVertices - 1] == lastId);
+    GIMS_CHECK(view.getConstantElementSize(0) == sizeof(f64));
+    GIMS_CHECK(*static_cast<const f64*>(view.getConstant(0)) == constant);
+  }
+  std::filesystem::remove(fileName);
+#else
+  std::printf("Sparse files are only created on Linux, skipped.\n");
+#endif
+}
+} // namespace
+
+int main()
+{
+  GIMS_RUN_TEST(testWriterChunkBoundaries);
+  GIMS_RUN_TEST(testWriterReuseAfterError);
+  GIMS_RUN_TEST(testWriterNotOpen);
+  GIMS_RUN_TEST(testWriterBaseVertexOverflow);
+  GIMS_RUN_TEST(testSaveInvalidArgumentsKeepsFile);
+  GIMS_RUN_TEST(testV1ElementCountBeyondFile);
+  GIMS_RUN_TEST(testAddAndElementSizesIn64Bits);
+  GIMS_RUN_TEST(testAddKeepsNamedElements);
+  GIMS_RUN_TEST(testRansUnshuffle);
+  GIMS_RUN_TEST(testCompressionRoundTrip);
+  GIMS_RUN_TEST(testSparseFileBeyond4GB);
+  return test::getResult();
+}
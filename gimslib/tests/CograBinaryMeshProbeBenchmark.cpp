@@ -0,0 +1,127 @@
+#include "BenchmarkUtil.hpp"
+#include "TestMeshes.hpp"
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+//! Bytes read by the baseline, which covers the header, the section table and the names of the generated files.
+constexpr size_t HEADER_BYTES = 4096;
+
+//! Writes nFiles spheres with normals and texture coordinates to a new directory, alternating version 1 and 2 files.
+std::filesystem::path createBenchmarkDirectory(ui32 nFiles)
+{
+  const test::TestMesh mesh      = test::createCubeSphere(64);
+  const ui32           nVertices = mesh.getNumVertices();
+  std::vector<f32>     textureCoordinates(nVertices * 2);
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    textureCoordinates[v * 2 + 0] = mesh.positions[v * 3 + 0] * 0.5f + 0.5f;
+    textureCoordinates[v * 2 + 1] = mesh.positions[v * 3 + 1] * 0.5f + 0.5f;
+  }
+  CograBinaryMeshFile file;
+  file.setPositions(mesh.positions.data(), nVertices);
+  file.setTriangleIndices(mesh.indices.data(), mesh.getNumTriangles());
+  file.addAttribute(mesh.positions.data(), 3, sizeof(f32), "Normals");
+  file.addAttribute(textureCoordinates.data(), 2, sizeof(f32), "TextureCoordinates");
+
+  const std::filesystem::path directory = std::filesystem::temp_directory_path() / "gimslib_probe_benchmark";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  for (ui32 i = 0; i < nFiles; i++)
+  {
+    const auto version = i % 2 == 0 ? CograBinaryMeshFile::VERSION_1 : CograBinaryMeshFile::VERSION_2;
+    file.save((directory / ("mesh" + std::to_string(i) + ".cbm")).string(), version);
+  }
+  return directory;
+}
+
+//! All .cbm files in the directory and its subdirectories.
+std::vector<std::string> findFiles(const std::filesystem::path& directory)
+{
+  std::vector<std::string> result;
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+  {
+    if (entry.is_regular_file() && entry.path().extension() == ".cbm")
+    {
+      result.push_back(entry.path().string());
+    }
+  }
+  return result;
+}
+
+//! Opens the file and reads its first bytes, what any header parser has to do at least.
+ui64 readHeaderBytes(const std::string& fileName)
+{
+  std::ifstream inFile(fileName, std::ios::in | std::ios::binary);
+  if (!inFile.is_open())
+  {
+    throw std::runtime_error("Error opening file " + fileName + ".");
+  }
+  char buffer[HEADER_BYTES];
+  inFile.read(buffer, sizeof(buffer));
+  return static_cast<ui64>(inFile.gcount());
+}
+} // namespace
+
+//! Usage: CograBinaryMeshProbeBenchmark [nFiles [directory]]. Lists the vertex and triangle counts of all .cbm files of
+//! a directory with probe and with load, and compares both to opening each file and reading its first 4 KB. Without a
+//! directory, nFiles spheres, 256 by default, are written to a temporary directory.
+int main(int argc, char** argv)
+{
+  try
+  {
+    const ui32                  nFiles = test::getArgument(argc, argv, 1, 256);
+    const std::filesystem::path directory =
+        argc > 2 ? std::filesystem::path(argv[2]) : createBenchmarkDirectory(nFiles);
+    const std::vector<std::string> fileNames = findFiles(directory);
+    if (fileNames.empty())
+    {
+      throw std::runtime_error("No .cbm files in " + directory.string() + ".");
+    }
+    f64 megaBytes = 0.0;
+    for (const std::string& fileName : fileNames)
+    {
+      megaBytes += static_cast<f64>(std::filesystem::file_size(fileName)) / (1 << 20);
+    }
+    std::printf("%zu files in %s, %.1f MB. The files are in the page cache after the first run.\n", fileNames.size(),
+                directory.string().c_str(), megaBytes);
+
+    ui64       checksum = 0;
+    const f64  n        = static_cast<f64>(fileNames.size());
+    const auto scan     = [&](const char* method, const auto& function)
+    {
+      const f64 seconds = test::measure(
+          [&]
+          {
+            for (const std::string& fileName : fileNames)
+            {
+              checksum += function(fileName);
+            }
+          });
+      std::printf("%-22s %10.1f %12.0f\n", method, seconds / n * 1e6, n / seconds);
+    };
+    std::printf("method                 us per file  files per s\n");
+    scan("read first 4 KB", readHeaderBytes);
+    scan("probe", [](const std::string& fileName)
+         { return static_cast<ui64>(CograBinaryMeshFile::probe(fileName).nTriangles); });
+    scan("load", [](const std::string& fileName)
+         { return static_cast<ui64>(CograBinaryMeshFile(fileName).getNumTriangles()); });
+    // Keeps the compiler from dropping the scans.
+    std::printf("checksum %llu\n", static_cast<unsigned long long>(checksum));
+  }
+  catch (const std::exception& e)
+  {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,66 @@
+#include "BenchmarkUtil.hpp"
+#include <cstdio>
+#include <cstring>
+#include <gimslib/mesh/MeshBounds.hpp>
+#include <random>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+//! The reduction computeBounds replaced: glm::min and glm::max per position.
+MeshBounds::Bounds computeBoundsGlm(const f32* positions, ui64 nPositions, size_t strideInBytes)
+{
+  MeshBounds::Bounds result;
+  const ui8* const   bytes = reinterpret_cast<const ui8*>(positions);
+  for (ui64 i = 0; i < nPositions; i++)
+  {
+    f32v3 p;
+    std::memcpy(&p, bytes + i * strideInBytes, sizeof(p));
+    result.lower = glm::min(result.lower, p);
+    result.upper = glm::max(result.upper, p);
+  }
+  return result;
+}
+
+//! Reduces nPositions random positions with the given stride, and prints the throughput in GB/s of the array.
+void benchmarkStride(ui64 nPositions, size_t strideInBytes, ui32 maxThreads)
+{
+  std::vector<f32>                    data(nPositions * strideInBytes / sizeof(f32));
+  std::mt19937                        random(1);
+  std::uniform_real_distribution<f32> uniform(-100.0f, 100.0f);
+  for (f32& value : data)
+  {
+    value = uniform(random);
+  }
+
+  const f64 gigaBytes = static_cast<f64>(nPositions * strideInBytes) / (1 << 30);
+
+  // The results are compared, so the compiler cannot drop the reductions.
+  MeshBounds::Bounds expected;
+  MeshBounds::Bounds bounds;
+  const f64          glmTime =
+      test::measure([&] { expected = computeBoundsGlm(data.data(), nPositions, strideInBytes); });
+  std::printf("stride %2zu bytes, %.2f GB: glm loop %.2f GB/s", strideInBytes, gigaBytes, gigaBytes / glmTime);
+  for (const ui32 nThreads : test::getThreadCounts(maxThreads))
+  {
+    const f64 seconds =
+        test::measure([&] { bounds = MeshBounds::computeBounds(data.data(), nPositions, strideInBytes, nThreads); });
+    std::printf(", %u thread%s %.2f GB/s%s", nThreads, nThreads == 1 ? "" : "s", gigaBytes / seconds,
+                bounds.lower == expected.lower && bounds.upper == expected.upper ? "" : " (results differ)");
+  }
+  std::printf("\n");
+}
+} // namespace
+
+//! Usage: MeshBoundsBenchmark [maxThreads [nPositions]].
+int main(int argc, char** argv)
+{
+  const ui32 maxThreads = test::getArgument(argc, argv, 1, 0);
+  const ui64 nPositions = test::getArgument(argc, argv, 2, 1 << 24);
+  // Tightly packed positions, and positions in an interleaved vertex with normal and texture coordinate.
+  benchmarkStride(nPositions, 3 * sizeof(f32), maxThreads);
+  benchmarkStride(nPositions, 8 * sizeof(f32), maxThreads);
+  return 0;
+}
@@ -0,0 +1,133 @@
+#include "TestMeshes.hpp"
+#include "TestUtil.hpp"
+#include <algorithm>
+#include <array>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/mesh/MeshOptimizer.hpp>
+#include <gimslib/mesh/MeshSimplifier.hpp>
+#include <gimslib/mesh/MeshSpatialSort.hpp>
+#include <gimslib/mesh/Meshlets.hpp>
+#include <stdexcept>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+using Triangle = std::array<f32, 9>;
+
+//! The triangles as positions, sorted, so reorderings of triangles and vertices compare equal.
+std::vector<Triangle> getSortedTriangles(const f32* positions, const ui32* indices, ui64 nIndices)
+{
+  std::vector<Triangle> result(nIndices / 3);
+  for (ui64 i = 0; i < nIndices; i++)
+  {
+    std::copy_n(&positions[ui64(indices[i]) * 3], 3, &result[i / 3][(i % 3) * 3]);
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+//! A degenerate triangle and a triangle that hits the cache come before the first triangle whose vertices all miss.
+//! They belong to the first cluster and must not be dropped.
+void testLeadingCacheHits()
+{
+  const std::vector<ui32> indices = {0, 0, 1, 0, 1, 2, 2, 3, 4, 5, 6, 7};
+  std::vector<f32>        positions;
+  for (ui32 v = 0; v < 8; v++)
+  {
+    positions.insert(positions.end(), {f32(v), f32(v * v % 5), f32(v % 3)});
+  }
+
+  std::vector<ui32> reordered(indices.size());
+  MeshOptimizer::optimizeOverdraw(reordered.data(), indices.data(), indices.size(), positions.data(), 8);
+  std::vector<ui32> sorted = reordered;
+  std::sort(sorted.begin(), sorted.end());
+  std::vector<ui32> expected = indices;
+  std::sort(expected.begin(), expected.end());
+  GIMS_CHECK(sorted == expected);
+  GIMS_CHECK(getSortedTriangles(positions.data(), reordered.data(), reordered.size()) ==
+             getSortedTriangles(positions.data(), indices.data(), indices.size()));
+
+  CograBinaryMeshFile mesh;
+  mesh.setPositions(positions.data(), 8);
+  mesh.setTriangleIndices(indices.data(), 4);
+  MeshOptimizer::optimizeMesh(mesh);
+  GIMS_CHECK(mesh.getNumTriangles() == 4);
+  GIMS_CHECK(getSortedTriangles(mesh.getPositionsPtr(), mesh.getTriangleIndices(), 12) ==
+             getSortedTriangles(positions.data(), indices.data(), indices.size()));
+}
+
+//! All passes together keep every triangle of a larger mesh, and improve its vertex cache efficiency.
+void testOptimizeMesh()
+{
+  const test::TestMesh mesh = test::createCubeSphere(20);
+  CograBinaryMeshFile  file;
+  file.setPositions(mesh.positions.data(), mesh.getNumVertices());
+  file.setTriangleIndices(mesh.indices.data(), mesh.getNumTriangles());
+  const MeshOptimizer::MeshOptimizationReport report = MeshOptimizer::optimizeMesh(file);
+  GIMS_CHECK(report.after.acmr <= report.before.acmr);
+  GIMS_CHECK(getSortedTriangles(file.getPositionsPtr(), file.getTriangleIndices(), mesh.indices.size()) ==
+             getSortedTriangles(mesh.positions.data(), mesh.indices.data(), mesh.indices.size()));
+}
+
+//! Every index is validated, including a trailing partial triangle, which is rejected like by the other passes.
+void testVertexFetchRemapValidation()
+{
+  const std::vector<ui32> indices = {2, 1, 0, 1, 2, 3, 7};
+  const std::vector<ui32> remap   = MeshOptimizer::optimizeVertexFetchRemap(indices.data(), 6, 4);
+  GIMS_CHECK((remap == std::vector<ui32>{2, 1, 0, 3}));
+  GIMS_CHECK_THROWS(MeshOptimizer::optimizeVertexFetchRemap(indices.data(), 7, 4), std::runtime_error);
+  GIMS_CHECK_THROWS(MeshOptimizer::optimizeVertexFetchRemap(indices.data(), 7, 8), std::runtime_error);
+  GIMS_CHECK_THROWS(MeshOptimizer::optimizeVertexFetchRemap(indices.data(), 6, 3), std::runtime_error);
+}
+
+//! The triangles of all levels of detail but the first, as positions.
+std::vector<Triangle> getSortedLodTriangles(const CograBinaryMeshFile& mesh)
+{
+  std::vector<ui32>                                lodIndices;
+  const std::vector<MeshSimplifier::LevelOfDetail> lods = MeshSimplifier::getLods(mesh, lodIndices);
+  const ui64                                       nIndices = ui64(mesh.getNumTriangles()) * 3;
+  return getSortedTriangles(mesh.getPositionsPtr(), lodIndices.data() + nIndices, lodIndices.size() - nIndices);
+}
+
+//! Reordering the vertices remaps the indices of the levels of detail, and reordering the triangles removes the
+//! meshlets, whose triangle ranges become invalid. Tested for both functions that do so.
+void testConstantsAfterReordering()
+{
+  const test::TestMesh mesh = test::createCubeSphere(20);
+  for (const bool spatialSort : {false, true})
+  {
+    CograBinaryMeshFile file;
+    file.setPositions(mesh.positions.data(), mesh.getNumVertices());
+    file.setTriangleIndices(mesh.indices.data(), mesh.getNumTriangles());
+    Meshlets::buildMeshlets(file);
+    const std::vector<MeshSimplifier::LevelOfDetail> lods         = MeshSimplifier::buildLods(file);
+    const std::vector<Triangle>                      lodTriangles = getSortedLodTriangles(file);
+    GIMS_CHECK(lods.size() > 1);
+    GIMS_CHECK(!Meshlets::getMeshlets(file).empty());
+
+    if (spatialSort)
+    {
+      MeshSpatialSort::sortMesh(file, 1);
+    }
+    else
+    {
+      MeshOptimizer::optimizeMesh(file);
+    }
+    std::vector<ui32> lodIndices;
+    GIMS_CHECK(MeshSimplifier::getLods(file, lodIndices).size() == lods.size());
+    GIMS_CHECK(getSortedLodTriangles(file) == lodTriangles);
+    GIMS_CHECK(Meshlets::getMeshlets(file).empty());
+  }
+}
+} // namespace
+
+int main()
+{
+  GIMS_RUN_TEST(testLeadingCacheHits);
+  GIMS_RUN_TEST(testOptimizeMesh);
+  GIMS_RUN_TEST(testVertexFetchRemapValidation);
+  GIMS_RUN_TEST(testConstantsAfterReordering);
+  return test::getResult();
+}
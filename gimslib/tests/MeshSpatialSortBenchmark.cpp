@@ -0,0 +1,128 @@
+#include "BenchmarkUtil.hpp"
+#include "TestMeshes.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/mesh/MeshBounds.hpp>
+#include <gimslib/mesh/MeshNormals.hpp>
+#include <gimslib/mesh/MeshOptimizer.hpp>
+#include <gimslib/mesh/MeshSpatialSort.hpp>
+#include <gimslib/mesh/Meshlets.hpp>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+//! A sphere of about 2M vertices, whose vertices and triangles are shuffled, as a stand-in for an unordered scan.
+CograBinaryMeshFile createShuffledMesh()
+{
+  const test::TestMesh mesh      = test::createCubeSphere(580);
+  const ui32           nVertices = mesh.getNumVertices();
+  std::mt19937         random(1);
+
+  std::vector<ui32> triangleOrder(mesh.getNumTriangles());
+  std::iota(triangleOrder.begin(), triangleOrder.end(), 0u);
+  std::shuffle(triangleOrder.begin(), triangleOrder.end(), random);
+  std::vector<ui32> indices(mesh.indices.size());
+  for (ui32 t = 0; t < mesh.getNumTriangles(); t++)
+  {
+    std::copy_n(&mesh.indices[triangleOrder[t] * 3], 3, &indices[t * 3]);
+  }
+
+  CograBinaryMeshFile result;
+  result.setPositions(mesh.positions.data(), nVertices);
+  result.setTriangleIndices(indices.data(), mesh.getNumTriangles());
+  result.addAttribute(mesh.positions.data(), 3, sizeof(f32), "Normals");
+  std::vector<ui32> remap(nVertices);
+  std::iota(remap.begin(), remap.end(), 0u);
+  std::shuffle(remap.begin(), remap.end(), random);
+  MeshOptimizer::remapMesh(result, remap);
+  return result;
+}
+
+//! Timings of the downstream passes in seconds, and the locality of the index buffer.
+struct PassResults
+{
+  f64  boundsTime        = 0.0;
+  f64  normalsTime       = 0.0;
+  f64  meshletsTime      = 0.0;
+  ui64 nMeshlets         = 0;
+  f64  meanMeshletRadius = 0.0;
+  f64  meanIndexJump     = 0.0;
+  f32  acmr              = 0.0f;
+};
+
+//! Runs the passes, which walk the mesh in storage order, on a single thread.
+PassResults runPasses(const CograBinaryMeshFile& mesh)
+{
+  const ui32                     nVertices = mesh.getNumVertices();
+  const ui64                     nIndices  = ui64(mesh.getNumTriangles()) * 3;
+  const ui32* const              indices   = mesh.getTriangleIndices();
+  const f32* const               positions = mesh.getPositionsPtr();
+  std::vector<f32>               normals(ui64(nVertices) * 3);
+  std::vector<ui32>              reordered(nIndices);
+  std::vector<Meshlets::Meshlet> meshlets;
+
+  PassResults result;
+  result.boundsTime  = test::measure([&] { MeshBounds::computeBounds(positions, nVertices, 3 * sizeof(f32), 1); });
+  result.normalsTime = test::measure(
+      [&]
+      {
+        MeshNormals::generateNormals(normals.data(), 3 * sizeof(f32), indices, nIndices, positions, 3 * sizeof(f32),
+                                     nVertices, MeshNormals::WEIGHT_ANGLE, 1);
+      });
+  result.meshletsTime = test::measure(
+      [&] { meshlets = Meshlets::buildMeshlets(reordered.data(), indices, nIndices, positions, nVertices); }, 3);
+
+  result.nMeshlets = meshlets.size();
+  for (const Meshlets::Meshlet& meshlet : meshlets)
+  {
+    result.meanMeshletRadius += meshlet.radius;
+  }
+  result.meanMeshletRadius /= static_cast<f64>(meshlets.size());
+  for (ui64 i = 1; i < nIndices; i++)
+  {
+    result.meanIndexJump += std::abs(static_cast<f64>(indices[i]) - static_cast<f64>(indices[i - 1]));
+  }
+  result.meanIndexJump /= static_cast<f64>(nIndices - 1);
+  result.acmr = MeshOptimizer::analyzeVertexCache(indices, nIndices, nVertices).acmr;
+  return result;
+}
+} // namespace
+
+//! Usage: MeshSpatialSortBenchmark [file.cbm]. Without a file, a shuffled synthetic mesh is used.
+int main(int argc, char** argv)
+{
+  try
+  {
+    CograBinaryMeshFile mesh = argc > 1 ? CograBinaryMeshFile(argv[1]) : createShuffledMesh();
+    std::printf("%u vertices, %u triangles, single thread\n", mesh.getNumVertices(), mesh.getNumTriangles());
+
+    const PassResults before   = runPasses(mesh);
+    const f64         sortTime = test::measure([&] { MeshSpatialSort::sortMesh(mesh, 1); }, 1);
+    const PassResults after    = runPasses(mesh);
+
+    std::printf("sortMesh, ms               %10.1f\n", sortTime * 1000.0);
+    std::printf("                               before      after\n");
+    std::printf("computeBounds, ms          %10.2f %10.2f\n", before.boundsTime * 1000.0, after.boundsTime * 1000.0);
+    std::printf("generateNormals, ms        %10.2f %10.2f\n", before.normalsTime * 1000.0, after.normalsTime * 1000.0);
+    std::printf("buildMeshlets, ms          %10.2f %10.2f\n", before.meshletsTime * 1000.0,
+                after.meshletsTime * 1000.0);
+    std::printf("meshlets                   %10llu %10llu\n", static_cast<unsigned long long>(before.nMeshlets),
+                static_cast<unsigned long long>(after.nMeshlets));
+    std::printf("mean meshlet radius        %10.5f %10.5f\n", before.meanMeshletRadius, after.meanMeshletRadius);
+    std::printf("mean index jump            %10.0f %10.0f\n", before.meanIndexJump, after.meanIndexJump);
+    std::printf("ACMR, FIFO of 16           %10.3f %10.3f\n", before.acmr, after.acmr);
+  }
+  catch (const std::exception& e)
+  {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,171 @@
+#include "TestMeshes.hpp"
+#include "TestUtil.hpp"
+#include <algorithm>
+#include <gimslib/mesh/MeshSplitter.hpp>
+#include <stdexcept>
+#include <vector>
+
+using namespace gims;
+using namespace gims::MeshSplitter;
+
+namespace
+{
+//! Checks that the sub-meshes reproduce the triangles of the mesh in their order, that no sub-mesh has more than
+//! maxVertices vertices, and that the vertices of each sub-mesh are distinct, used, and numbered in the order of their
+//! first use.
+bool isValidSplit(const std::vector<ui32>& indices, ui32 maxVertices, const std::vector<SubMesh>& subMeshes)
+{
+  size_t i = 0;
+  for (const SubMesh& subMesh : subMeshes)
+  {
+    const ui32 nSubMeshVertices = static_cast<ui32>(subMesh.vertexIndices.size());
+    if (nSubMeshVertices > maxVertices || subMesh.indices.empty() || subMesh.indices.size() % 3 != 0)
+    {
+      return false;
+    }
+    ui32 nUsedVertices = 0;
+    for (const ui32 localIdx : subMesh.indices)
+    {
+      if (localIdx > nUsedVertices || localIdx >= nSubMeshVertices || i >= indices.size() ||
+          subMesh.vertexIndices[localIdx] != indices[i])
+      {
+        return false;
+      }
+      nUsedVertices += localIdx == nUsedVertices ? 1 : 0;
+      i++;
+    }
+    std::vector<ui32> sorted = subMesh.vertexIndices;
+    std::sort(sorted.begin(), sorted.end());
+    if (nUsedVertices != nSubMeshVertices || std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+    {
+      return false;
+    }
+  }
+  return i == indices.size();
+}
+
+//! A grid with more vertices than 16 bit indices can address is split into sub-meshes, that can each be converted.
+void testSplitLargeMesh()
+{
+  const test::TestMesh mesh = test::createGrid(300);
+  GIMS_CHECK(!fits16BitIndices(mesh.getNumVertices()));
+
+  const std::vector<SubMesh> subMeshes = splitMesh(mesh.indices.data(), mesh.indices.size(), mesh.getNumVertices());
+  GIMS_CHECK(subMeshes.size() >= 2);
+  GIMS_CHECK(isValidSplit(mesh.indices, MAX_16_BIT_VERTICES, subMeshes));
+  for (const SubMesh& subMesh : subMeshes)
+  {
+    const std::vector<ui16> indices16 = convertTo16BitIndices(subMesh.indices);
+    GIMS_CHECK(std::equal(indices16.begin(), indices16.end(), subMesh.indices.begin()));
+  }
+
+  const test::TestMesh small = test::createGrid(10);
+  GIMS_CHECK(fits16BitIndices(small.getNumVertices()));
+  const std::vector<SubMesh> single = splitMesh(small.indices.data(), small.indices.size(), small.getNumVertices());
+  GIMS_CHECK(single.size() == 1);
+  GIMS_CHECK(isValidSplit(small.indices, MAX_16_BIT_VERTICES, single));
+}
+
+//! Small limits down to a single triangle per sub-mesh. Vertices shared with the previous sub-mesh are duplicated.
+void testMaxVertices()
+{
+  const test::TestMesh mesh = test::createGrid(10);
+  for (const ui32 maxVertices : {3u, 4u, 5u, 17u, 64u})
+  {
+    const std::vector<SubMesh> subMeshes =
+        splitMesh(mesh.indices.data(), mesh.indices.size(), mesh.getNumVertices(), maxVertices);
+    GIMS_CHECK(isValidSplit(mesh.indices, maxVertices, subMeshes));
+    if (maxVertices == 3)
+    {
+      GIMS_CHECK(subMeshes.size() == mesh.getNumTriangles());
+    }
+  }
+
+  // A sub-mesh is only started when the next triangle does not fit anymore, so exactly full sub-meshes are kept.
+  const std::vector<ui32>    quads     = {0, 1, 2, 2, 1, 3, 4, 5, 6, 6, 5, 7};
+  const std::vector<SubMesh> subMeshes = splitMesh(quads.data(), quads.size(), 8, 4);
+  GIMS_CHECK(subMeshes.size() == 2);
+  GIMS_CHECK(isValidSplit(quads, 4, subMeshes));
+  GIMS_CHECK((subMeshes[0].vertexIndices == std::vector<ui32>{0, 1, 2, 3}));
+  GIMS_CHECK((subMeshes[1].vertexIndices == std::vector<ui32>{4, 5, 6, 7}));
+  GIMS_CHECK((subMeshes[1].indices == std::vector<ui32>{0, 1, 2, 2, 1, 3}));
+}
+
+//! Degenerate triangles reference a vertex several times, which must be counted and stored once.
+void testDegenerateTriangles()
+{
+  // With four vertices per sub-mesh, the second triangle adds a single vertex and still fits.
+  const std::vector<ui32>    fits   = {0, 1, 2, 3, 3, 2};
+  const std::vector<SubMesh> merged = splitMesh(fits.data(), fits.size(), 4, 4);
+  GIMS_CHECK(merged.size() == 1);
+  GIMS_CHECK(isValidSplit(fits, 4, merged));
+  GIMS_CHECK((merged[0].indices == std::vector<ui32>{0, 1, 2, 3, 3, 2}));
+
+  const std::vector<ui32>    indices   = {0, 1, 2, 3, 3, 4, 5, 5, 5, 4, 3, 3, 6, 7, 8};
+  const std::vector<SubMesh> subMeshes = splitMesh(indices.data(), indices.size(), 9, 3);
+  GIMS_CHECK(subMeshes.size() == 3);
+  GIMS_CHECK(isValidSplit(indices, 3, subMeshes));
+  GIMS_CHECK((subMeshes[1].vertexIndices == std::vector<ui32>{3, 4, 5}));
+  GIMS_CHECK((subMeshes[1].indices == std::vector<ui32>{0, 0, 1, 2, 2, 2, 1, 0, 0}));
+}
+
+//! No triangles give no sub-meshes. A partial triangle, an index out of range, and fewer than three vertices per
+//! sub-mesh are rejected.
+void testInvalidInput()
+{
+  const std::vector<ui32> indices = {0, 1, 2, 2, 1, 3};
+  GIMS_CHECK(splitMesh(indices.data(), 0, 4).empty());
+  GIMS_CHECK_THROWS(splitMesh(indices.data(), 5, 4), std::runtime_error);
+  GIMS_CHECK_THROWS(splitMesh(indices.data(), indices.size(), 3), std::runtime_error);
+  GIMS_CHECK_THROWS(splitMesh(indices.data(), indices.size(), 4, 2), std::runtime_error);
+}
+
+//! Indices up to 65535 are converted, larger ones are rejected.
+void testConvertTo16BitIndices()
+{
+  GIMS_CHECK(fits16BitIndices(MAX_16_BIT_VERTICES));
+  GIMS_CHECK(!fits16BitIndices(MAX_16_BIT_VERTICES + 1));
+
+  const std::vector<ui32> indices   = {0, 1, 65534, 65535, 300};
+  const std::vector<ui16> indices16 = convertTo16BitIndices(indices);
+  GIMS_CHECK((indices16 == std::vector<ui16>{0, 1, 65534, 65535, 300}));
+
+  GIMS_CHECK_THROWS(convertTo16BitIndices(std::vector<ui32>{0, 1, 65536}), std::runtime_error);
+  GIMS_CHECK_THROWS(convertTo16BitIndices(std::vector<ui32>{0xffffffffu}), std::runtime_error);
+  ui16       destination[3] = {};
+  const ui32 tooLarge[3]    = {1, 70000, 2};
+  GIMS_CHECK_THROWS(convertTo16BitIndices(destination, tooLarge, 3), std::runtime_error);
+}
+
+//! Whole interleaved vertices are copied in the order of the vertex indices of the sub-mesh.
+void testGatherVertices()
+{
+  struct Vertex
+  {
+    f32  position[3];
+    ui32 id;
+  };
+  std::vector<Vertex> vertices(10);
+  for (ui32 v = 0; v < 10; v++)
+  {
+    vertices[v] = {{static_cast<f32>(v), 0.0f, 1.0f}, v * 3};
+  }
+  SubMesh subMesh;
+  subMesh.vertexIndices = {7, 2, 9};
+  std::vector<Vertex> gathered(3);
+  gatherVertices(gathered.data(), vertices.data(), sizeof(Vertex), subMesh);
+  GIMS_CHECK(gathered[0].id == 21 && gathered[1].id == 6 && gathered[2].id == 27);
+  GIMS_CHECK(gathered[2].position[0] == 9.0f);
+}
+} // namespace
+
+int main()
+{
+  GIMS_RUN_TEST(testSplitLargeMesh);
+  GIMS_RUN_TEST(testMaxVertices);
+  GIMS_RUN_TEST(testDegenerateTriangles);
+  GIMS_RUN_TEST(testInvalidInput);
+  GIMS_RUN_TEST(testConvertTo16BitIndices);
+  GIMS_RUN_TEST(testGatherVertices);
+  return test::getResult();
+}
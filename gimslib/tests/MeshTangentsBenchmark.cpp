@@ -0,0 +1,131 @@
+#include "BenchmarkUtil.hpp"
+#include "TestMeshes.hpp"
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <gimslib/mesh/MeshTangents.hpp>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+//! Normal-mapped primitives of data/sponza_scene/scene.gltf, counted from its accessors. The geometry itself is in
+//! scene.bin, which is not part of the repository, so the benchmark uses spheres of the same size.
+constexpr ui32 SPONZA_PRIMITIVES = 103;
+constexpr ui32 SPONZA_TRIANGLES  = 262248;
+
+//! An interleaved vertex, as the importer passes it to MeshTangents.
+struct Vertex
+{
+  f32v3 position;
+  f32v3 normal;
+  f32v2 textureCoordinate;
+};
+
+//! A unit sphere, whose texture coordinates are mirrored at the z = 0 plane, like a symmetric model that reuses one
+//! half of its texture. The triangles along the mirror have vertices of both handedness.
+struct SphereMesh
+{
+  std::vector<Vertex> vertices;
+  std::vector<ui32>   indices;
+};
+
+SphereMesh createSphere(ui32 n)
+{
+  const test::TestMesh mesh = test::createCubeSphere(n);
+  const f32            pi   = 3.14159265f;
+  SphereMesh           result;
+  result.indices = mesh.indices;
+  result.vertices.resize(mesh.getNumVertices());
+  for (ui32 v = 0; v < mesh.getNumVertices(); v++)
+  {
+    const f32v3 p      = mesh.getPosition(v);
+    const f32v2 uv     = f32v2(std::abs(std::atan2(p.z, p.x)) / pi, std::asin(p.y) / pi + 0.5f);
+    result.vertices[v] = {p, p, uv};
+  }
+  return result;
+}
+
+//! Splits the vertices at mirrored texture coordinates and generates the tangents of all meshes, like the import of a
+//! scene. Returns the time of each step in seconds, without copying the original indices.
+f64v2 measureTangents(const std::vector<SphereMesh>& meshes, ui32 nThreads)
+{
+  std::vector<std::vector<ui32>> indices(meshes.size());
+  std::vector<std::vector<f32>>  tangents(meshes.size());
+  const auto                     copy = [&]
+  {
+    for (size_t m = 0; m < meshes.size(); m++)
+    {
+      indices[m] = meshes[m].indices;
+    }
+  };
+  const auto split = [&]
+  {
+    copy();
+    for (size_t m = 0; m < meshes.size(); m++)
+    {
+      const std::vector<Vertex>& vertices = meshes[m].vertices;
+      MeshTangents::splitMirroredVertices(indices[m].data(), indices[m].size(), &vertices[0].position.x,
+                                          &vertices[0].normal.x, &vertices[0].textureCoordinate.x, sizeof(Vertex),
+                                          static_cast<ui32>(vertices.size()), nThreads);
+    }
+  };
+  const auto generate = [&]
+  {
+    for (size_t m = 0; m < meshes.size(); m++)
+    {
+      const std::vector<Vertex>& vertices = meshes[m].vertices;
+      tangents[m].resize(vertices.size() * 4);
+      MeshTangents::generateTangents(tangents[m].data(), 4 * sizeof(f32), meshes[m].indices.data(),
+                                     meshes[m].indices.size(), &vertices[0].position.x, &vertices[0].normal.x,
+                                     &vertices[0].textureCoordinate.x, sizeof(Vertex),
+                                     static_cast<ui32>(vertices.size()), nThreads);
+    }
+  };
+  return f64v2(test::measure(split) - test::measure(copy), test::measure(generate));
+}
+
+void benchmark(const char* name, const std::vector<SphereMesh>& meshes, ui32 maxThreads)
+{
+  ui64 nVertices  = 0;
+  ui64 nTriangles = 0;
+  for (const SphereMesh& mesh : meshes)
+  {
+    nVertices += mesh.vertices.size();
+    nTriangles += mesh.indices.size() / 3;
+  }
+  std::printf("%s: %zu meshes, %llu vertices, %llu triangles\n", name, meshes.size(),
+              static_cast<unsigned long long>(nVertices), static_cast<unsigned long long>(nTriangles));
+  std::printf("threads  split ms  tangents ms  M triangles/s\n");
+  for (const ui32 nThreads : test::getThreadCounts(maxThreads))
+  {
+    const f64v2 seconds = measureTangents(meshes, nThreads);
+    std::printf("%7u %9.2f %12.2f %14.1f\n", nThreads, seconds.x * 1000.0, seconds.y * 1000.0,
+                static_cast<f64>(nTriangles) / (seconds.x + seconds.y) * 1e-6);
+  }
+}
+} // namespace
+
+//! Usage: MeshTangentsBenchmark [maxThreads]. Measures splitMirroredVertices and generateTangents on a sphere with the
+//! number of normal-mapped triangles of Sponza, and on as many smaller spheres as Sponza has such primitives.
+int main(int argc, char** argv)
+{
+  try
+  {
+    const ui32 maxThreads = test::getArgument(argc, argv, 1, 0);
+    // A cube sphere with n x n quads per face has 12 n^2 triangles.
+    const ui32 n = static_cast<ui32>(std::lround(std::sqrt(SPONZA_TRIANGLES / 12.0)));
+    benchmark("One mesh", {createSphere(n)}, maxThreads);
+    const ui32 nPerPrimitive =
+        static_cast<ui32>(std::lround(std::sqrt(SPONZA_TRIANGLES / 12.0 / SPONZA_PRIMITIVES)));
+    benchmark("Sponza primitives", std::vector<SphereMesh>(SPONZA_PRIMITIVES, createSphere(nPerPrimitive)),
+              maxThreads);
+  }
+  catch (const std::exception& e)
+  {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,209 @@
+#include "TestMeshes.hpp"
+#include "TestUtil.hpp"
+#include <cmath>
+#include <cstring>
+#include <gimslib/mesh/MeshTangents.hpp>
+#include <utility>
+#include <vector>
+
+using namespace gims;
+using namespace gims::MeshTangents;
+
+namespace
+{
+//! An interleaved vertex, as the attributes are passed with one stride.
+struct Vertex
+{
+  f32v3 position;
+  f32v3 normal;
+  f32v2 textureCoordinate;
+};
+
+struct Tangent
+{
+  f32v3 direction;
+  f32   handedness;
+};
+
+std::vector<Tangent> computeTangents(const std::vector<Vertex>& vertices, const std::vector<ui32>& indices,
+                                     ui32 nThreads = 1)
+{
+  std::vector<Tangent> result(vertices.size());
+  MeshTangents::generateTangents(&result[0].direction.x, sizeof(Tangent), indices.data(), indices.size(),
+                                 &vertices[0].position.x, &vertices[0].normal.x, &vertices[0].textureCoordinate.x,
+                                 sizeof(Vertex), static_cast<ui32>(vertices.size()), nThreads);
+  return result;
+}
+
+//! Checks that a tangent has length 1, is perpendicular to the normal, and has a handedness of +1 or -1.
+bool isOrthonormal(const Tangent& tangent, const f32v3& normal)
+{
+  return std::abs(glm::length(tangent.direction) - 1.0f) <= 1e-5f &&
+         std::abs(glm::dot(tangent.direction, normal)) <= 1e-5f &&
+         (tangent.handedness == 1.0f || tangent.handedness == -1.0f);
+}
+
+bool isNear(const f32v3& a, const f32v3& b)
+{
+  return glm::length(a - b) <= 1e-5f;
+}
+
+//! Vertices of a grid in the z = 0 plane with normals to +z. The texture coordinates are the positions.
+std::vector<Vertex> createVertices(const test::TestMesh& mesh)
+{
+  std::vector<Vertex> result(mesh.getNumVertices());
+  for (ui32 v = 0; v < mesh.getNumVertices(); v++)
+  {
+    const f32v3 p = mesh.getPosition(v);
+    result[v]     = {p, f32v3(0.0f, 0.0f, 1.0f), f32v2(p.x, p.y)};
+  }
+  return result;
+}
+
+//! On a plane with u along x and v along y, the tangent is +x and the bitangent w * cross(normal, tangent) is +y.
+//! Flipping v flips the handedness only.
+void testPlane()
+{
+  const test::TestMesh mesh     = test::createGrid(4);
+  std::vector<Vertex>  vertices = createVertices(mesh);
+  for (const Tangent& tangent : computeTangents(vertices, mesh.indices))
+  {
+    GIMS_CHECK(isNear(tangent.direction, f32v3(1.0f, 0.0f, 0.0f)));
+    GIMS_CHECK(tangent.handedness == 1.0f);
+  }
+
+  for (Vertex& vertex : vertices)
+  {
+    vertex.textureCoordinate.y = 1.0f - vertex.textureCoordinate.y;
+  }
+  for (const Tangent& tangent : computeTangents(vertices, mesh.indices))
+  {
+    GIMS_CHECK(isNear(tangent.direction, f32v3(1.0f, 0.0f, 0.0f)));
+    GIMS_CHECK(tangent.handedness == -1.0f);
+  }
+}
+
+//! A quad of two halves, whose texture coordinates are mirrored at x = 1: u rises along +x on the left half and along
+//! -x on the right half, v rises along +y on both. Without splitting, the shared vertices at x = 1 can only have one
+//! handedness. After splitMirroredVertices, the tangent frame of every corner matches its triangle.
+void testMirroredQuad()
+{
+  //  3 -- 4 -- 5   y = 1
+  //  |  / |  \ |
+  //  0 -- 1 -- 2   y = 0, u = 0, 1, 0
+  std::vector<Vertex> vertices;
+  for (ui32 y = 0; y < 2; y++)
+  {
+    for (ui32 x = 0; x < 3; x++)
+    {
+      const f32 u = x == 1 ? 1.0f : 0.0f;
+      vertices.push_back({f32v3(f32(x), f32(y), 0.0f), f32v3(0.0f, 0.0f, 1.0f), f32v2(u, f32(y))});
+    }
+  }
+  std::vector<ui32> indices = {0, 1, 4, 0, 4, 3, 1, 2, 4, 2, 5, 4};
+
+  // Tangent and handedness of each corner, of the left and the right half.
+  const auto getExpectedTangent = [](ui32 triangleIdx)
+  { return triangleIdx < 2 ? Tangent{f32v3(1.0f, 0.0f, 0.0f), 1.0f} : Tangent{f32v3(-1.0f, 0.0f, 0.0f), -1.0f}; };
+
+  const std::vector<Tangent> shared = computeTangents(vertices, indices);
+  GIMS_CHECK(shared[1].handedness == shared[4].handedness);
+
+  const ui32              nVertices = static_cast<ui32>(vertices.size());
+  const std::vector<ui32> originals =
+      splitMirroredVertices(indices.data(), indices.size(), &vertices[0].position.x, &vertices[0].normal.x,
+                            &vertices[0].textureCoordinate.x, sizeof(Vertex), nVertices, 1);
+  GIMS_CHECK(originals.size() == 2);
+  for (const ui32 v : originals)
+  {
+    GIMS_CHECK(v == 1 || v == 4);
+    vertices.push_back(vertices[v]);
+  }
+
+  const std::vector<Tangent> tangents = computeTangents(vertices, indices);
+  for (ui32 i = 0; i < indices.size(); i++)
+  {
+    const Tangent& tangent  = tangents[indices[i]];
+    const Tangent  expected = getExpectedTangent(i / 3);
+    GIMS_CHECK(isOrthonormal(tangent, vertices[indices[i]].normal));
+    GIMS_CHECK(isNear(tangent.direction, expected.direction));
+    GIMS_CHECK(tangent.handedness == expected.handedness);
+    // Both halves reconstruct the bitangent along +y, the direction in which v rises.
+    const f32v3 bitangent = tangent.handedness * glm::cross(vertices[indices[i]].normal, tangent.direction);
+    GIMS_CHECK(isNear(bitangent, f32v3(0.0f, 1.0f, 0.0f)));
+  }
+}
+
+//! Mirroring the positions, as when converting to a left-handed coordinate system, flips the handedness, as the
+//! texture is now mirrored relative to the surface.
+void testMirroredPositions()
+{
+  const test::TestMesh mesh     = test::createGrid(4);
+  std::vector<Vertex>  vertices = createVertices(mesh);
+  std::vector<ui32>    indices  = mesh.indices;
+  for (Vertex& vertex : vertices)
+  {
+    vertex.position.x = -vertex.position.x;
+  }
+  for (ui32 i = 0; i < indices.size(); i += 3)
+  {
+    std::swap(indices[i + 1], indices[i + 2]);
+  }
+  for (const Tangent& tangent : computeTangents(vertices, indices))
+  {
+    GIMS_CHECK(isNear(tangent.direction, f32v3(-1.0f, 0.0f, 0.0f)));
+    GIMS_CHECK(tangent.handedness == -1.0f);
+  }
+}
+
+//! On a curved surface the tangents are projected onto the tangent plane of each vertex. The results do not depend on
+//! the number of threads.
+void testSphere()
+{
+  const test::TestMesh mesh = test::createCubeSphere(111);
+  std::vector<Vertex>  vertices(mesh.getNumVertices());
+  for (ui32 v = 0; v < mesh.getNumVertices(); v++)
+  {
+    const f32v3 p = mesh.getPosition(v);
+    vertices[v]   = {p, p, f32v2(std::atan2(p.y, p.x), p.z)};
+  }
+  GIMS_CHECK(mesh.getNumVertices() >= 4 * MIN_VERTICES_PER_THREAD);
+
+  const std::vector<Tangent> tangents = computeTangents(vertices, mesh.indices);
+  ui32                       nFailed  = 0;
+  for (ui32 v = 0; v < mesh.getNumVertices(); v++)
+  {
+    nFailed += isOrthonormal(tangents[v], vertices[v].normal) ? 0 : 1;
+  }
+  GIMS_CHECK(nFailed == 0);
+
+  const std::vector<Tangent> parallel = computeTangents(vertices, mesh.indices, 4);
+  GIMS_CHECK(std::memcmp(parallel.data(), tangents.data(), tangents.size() * sizeof(Tangent)) == 0);
+}
+
+//! Vertices without a triangle of non-zero area in texture space still receive a valid tangent frame.
+void testDegenerateTextureCoordinates()
+{
+  const test::TestMesh mesh     = test::createGrid(2);
+  std::vector<Vertex>  vertices = createVertices(mesh);
+  for (Vertex& vertex : vertices)
+  {
+    vertex.normal            = glm::normalize(f32v3(0.0f, 0.6f, 0.8f));
+    vertex.textureCoordinate = f32v2(0.5f);
+  }
+  for (const Tangent& tangent : computeTangents(vertices, mesh.indices))
+  {
+    GIMS_CHECK(isOrthonormal(tangent, vertices[0].normal));
+  }
+}
+} // namespace
+
+int main()
+{
+  GIMS_RUN_TEST(testPlane);
+  GIMS_RUN_TEST(testMirroredQuad);
+  GIMS_RUN_TEST(testMirroredPositions);
+  GIMS_RUN_TEST(testSphere);
+  GIMS_RUN_TEST(testDegenerateTextureCoordinates);
+  return test::getResult();
+}
@@ -0,0 +1,114 @@
+#include "BenchmarkUtil.hpp"
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/mesh/MeshBounds.hpp>
+#include <gimslib/mesh/Meshlets.hpp>
+#include <string>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+//! Sums of the culling results of all views.
+struct CullingTotals
+{
+  ui64 nVisibleMeshlets = 0;
+  ui64 nVisibleIndices  = 0;
+  ui64 nRanges          = 0;
+};
+
+//! Cameras on a Fibonacci sphere around the center of the mesh, looking at the center from distance * radius. The
+//! field of view is 45 degrees, so the whole mesh is in view from 3 radii, and parts of it are outside the frustum
+//! from closer.
+std::vector<Meshlets::CullingView> createViews(const MeshBounds::Bounds& bounds, ui32 nViews, f32 distance,
+                                               bool cullBackFaces)
+{
+  const f32v3 center      = (bounds.lower + bounds.upper) * 0.5f;
+  const f32   radius      = glm::length(bounds.upper - bounds.lower) * 0.5f;
+  const f32m4 projection  = glm::perspectiveFovLH_ZO<f32>(glm::radians(45.0f), 16.0f, 9.0f, radius * 0.01f,
+                                                         radius * 100.0f);
+  const f32   goldenAngle = 2.39996323f;
+
+  std::vector<Meshlets::CullingView> result;
+  for (ui32 i = 0; i < nViews; i++)
+  {
+    const f32   y = 1.0f - 2.0f * (static_cast<f32>(i) + 0.5f) / static_cast<f32>(nViews);
+    const f32   r = std::sqrt(1.0f - y * y);
+    const f32v3 direction(r * std::cos(goldenAngle * static_cast<f32>(i)), y,
+                          r * std::sin(goldenAngle * static_cast<f32>(i)));
+    // The up vector must not be parallel to the view direction.
+    const f32v3 up   = std::abs(y) > 0.9f ? f32v3(1.0f, 0.0f, 0.0f) : f32v3(0.0f, 1.0f, 0.0f);
+    const f32m4 view = glm::lookAtLH(center + direction * (distance * radius), center, up);
+    result.push_back(Meshlets::createCullingView(view, projection, cullBackFaces));
+  }
+  return result;
+}
+
+CullingTotals cullAll(const std::vector<Meshlets::Meshlet>& meshlets, const std::vector<Meshlets::CullingView>& views)
+{
+  CullingTotals                    result;
+  std::vector<Meshlets::DrawRange> ranges;
+  for (const Meshlets::CullingView& view : views)
+  {
+    result.nVisibleMeshlets +=
+        Meshlets::cullMeshlets(ranges, meshlets.data(), static_cast<ui32>(meshlets.size()), view);
+    result.nRanges += ranges.size();
+    for (const Meshlets::DrawRange& range : ranges)
+    {
+      result.nVisibleIndices += range.nIndices;
+    }
+  }
+  return result;
+}
+} // namespace
+
+//! Usage: MeshletsBenchmark [file.cbm [nViews]]. Without a file, data/bunny.cbm is used. Meshlets stored in the file
+//! are used as they are, otherwise they are built with the default limits.
+int main(int argc, char** argv)
+{
+  try
+  {
+    const std::string fileName = argc > 1 ? argv[1] : std::string(GIMS_DATA_DIRECTORY) + "/bunny.cbm";
+    const ui32        nViews   = test::getArgument(argc, argv, 2, 256);
+
+    CograBinaryMeshFile            mesh(fileName);
+    std::vector<Meshlets::Meshlet> meshlets  = Meshlets::getMeshlets(mesh);
+    f64                            buildTime = 0.0;
+    if (meshlets.empty())
+    {
+      buildTime = test::measure([&] { meshlets = Meshlets::buildMeshlets(mesh); }, 1);
+    }
+    const MeshBounds::Bounds bounds     = MeshBounds::computeBounds(mesh.getPositionsPtr(), mesh.getNumVertices());
+    const f64                nMeshlets  = static_cast<f64>(meshlets.size());
+    const f64                nTriangles = static_cast<f64>(mesh.getNumTriangles());
+    std::printf("%s: %u vertices, %u triangles, %zu meshlets, built in %.1f ms, %u views per row, single thread\n",
+                fileName.c_str(), mesh.getNumVertices(), mesh.getNumTriangles(), meshlets.size(), buildTime * 1000.0,
+                nViews);
+    std::printf("distance  back faces  clusters culled  triangles culled  draw ranges  us per view\n");
+    for (const f32 distance : {3.0f, 1.5f, 0.75f})
+    {
+      for (const bool cullBackFaces : {false, true})
+      {
+        const std::vector<Meshlets::CullingView> views = createViews(bounds, nViews, distance, cullBackFaces);
+        const f64                                n     = static_cast<f64>(nViews);
+        CullingTotals                            totals;
+        const f64                                seconds = test::measure([&] { totals = cullAll(meshlets, views); });
+        std::printf("%8.2f  %10s  %7.1f %6.1f%%  %8.0f %6.1f%%  %11.1f  %11.2f\n", distance,
+                    cullBackFaces ? "culled" : "drawn", nMeshlets - static_cast<f64>(totals.nVisibleMeshlets) / n,
+                    100.0 * (1.0 - static_cast<f64>(totals.nVisibleMeshlets) / n / nMeshlets),
+                    nTriangles - static_cast<f64>(totals.nVisibleIndices) / 3.0 / n,
+                    100.0 * (1.0 - static_cast<f64>(totals.nVisibleIndices) / 3.0 / n / nTriangles),
+                    static_cast<f64>(totals.nRanges) / n, seconds / n * 1e6);
+      }
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
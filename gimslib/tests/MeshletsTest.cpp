@@ -0,0 +1,273 @@
+#include "TestMeshes.hpp"
+#include "TestUtil.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/mesh/Meshlets.hpp>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+//! Culling view whose planes contain all of space, so that only the back-face test can cull.
+Meshlets::CullingView createBackFaceView(const f32v3& cameraPosition)
+{
+  Meshlets::CullingView result;
+  for (auto& plane : result.planes)
+  {
+    plane = f32v4(0.0f, 0.0f, 0.0f, 1.0f);
+  }
+  result.cameraPosition = cameraPosition;
+  return result;
+}
+
+std::vector<std::array<ui32, 3>> getSortedTriangles(const std::vector<ui32>& indices)
+{
+  std::vector<std::array<ui32, 3>> result;
+  for (size_t i = 0; i < indices.size(); i += 3)
+  {
+    result.push_back({indices[i], indices[i + 1], indices[i + 2]});
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+std::vector<Meshlets::Meshlet> buildMeshlets(const test::TestMesh& mesh, std::vector<ui32>& reordered,
+                                             ui32 maxVertices  = Meshlets::DEFAULT_MAX_VERTICES,
+                                             ui32 maxTriangles = Meshlets::DEFAULT_MAX_TRIANGLES)
+{
+  reordered.resize(mesh.indices.size());
+  return Meshlets::buildMeshlets(reordered.data(), mesh.indices.data(), mesh.indices.size(), mesh.positions.data(),
+                                 mesh.getNumVertices(), maxVertices, maxTriangles);
+}
+
+//! Checks that the meshlets partition the reordered index buffer and respect the limits and bounds.
+void checkMeshlets(const test::TestMesh& mesh, const std::vector<ui32>& reordered,
+                   const std::vector<Meshlets::Meshlet>& meshlets, ui32 maxVertices, ui32 maxTriangles)
+{
+  GIMS_CHECK(getSortedTriangles(reordered) == getSortedTriangles(mesh.indices));
+  ui32 nextIndex = 0;
+  for (const auto& m : meshlets)
+  {
+    GIMS_CHECK(m.firstIndex == nextIndex);
+    GIMS_CHECK(m.nIndices > 0 && m.nIndices % 3 == 0);
+    GIMS_CHECK(m.nIndices <= 3 * maxTriangles);
+    GIMS_CHECK(m.nVertices <= maxVertices);
+    nextIndex = m.firstIndex + m.nIndices;
+
+    const std::unordered_set<ui32> vertices(reordered.begin() + m.firstIndex, reordered.begin() + nextIndex);
+    GIMS_CHECK(vertices.size() == m.nVertices);
+    for (const ui32 v : vertices)
+    {
+      GIMS_CHECK(glm::distance(mesh.getPosition(v), m.center) <= m.radius * 1.0001f + 1e-6f);
+    }
+  }
+  GIMS_CHECK(nextIndex == reordered.size());
+}
+
+void testBuildMeshletsLimits()
+{
+  const test::TestMesh mesh         = test::createCubeSphere(16);
+  const ui32           limits[4][2] = {{64, 124}, {3, 1}, {16, 8}, {255, 512}};
+  for (const auto& limit : limits)
+  {
+    std::vector<ui32> reordered;
+    const auto        meshlets = buildMeshlets(mesh, reordered, limit[0], limit[1]);
+    checkMeshlets(mesh, reordered, meshlets, limit[0], limit[1]);
+    if (limit[1] == 1)
+    {
+      GIMS_CHECK(meshlets.size() == mesh.getNumTriangles());
+    }
+  }
+
+  // The output may overwrite the input.
+  std::vector<ui32> inPlace  = mesh.indices;
+  const auto        meshlets = Meshlets::buildMeshlets(inPlace.data(), inPlace.data(), inPlace.size(),
+                                                       mesh.positions.data(), mesh.getNumVertices());
+  checkMeshlets(mesh, inPlace, meshlets, Meshlets::DEFAULT_MAX_VERTICES, Meshlets::DEFAULT_MAX_TRIANGLES);
+}
+
+//! The normal cone is conservative: A meshlet may only be culled, if all of its triangles face away from the camera.
+//! Seen from outside, a closed sphere is about half back-facing, so a good part of it must be culled.
+void testConeCullingIsConservative()
+{
+  const test::TestMesh mesh = test::createCubeSphere(16);
+  std::vector<ui32>    reordered;
+  const auto           meshlets      = buildMeshlets(mesh, reordered);
+  test::TestMesh       reorderedMesh = mesh;
+  reorderedMesh.indices              = reordered;
+
+  std::mt19937                        random(1);
+  std::uniform_real_distribution<f32> direction(-1.0f, 1.0f);
+  std::uniform_real_distribution<f32> distance(1.1f, 10.0f);
+  ui32                                nCulled = 0;
+  for (ui32 i = 0; i < 100; i++)
+  {
+    f32v3 cameraPosition(direction(random), direction(random), direction(random));
+    cameraPosition = glm::normalize(cameraPosition) * distance(random);
+    const Meshlets::CullingView view = createBackFaceView(cameraPosition);
+    for (const auto& m : meshlets)
+    {
+      if (Meshlets::isVisible(m, view))
+      {
+        continue;
+      }
+      nCulled++;
+      for (ui32 t = m.firstIndex / 3; t < (m.firstIndex + m.nIndices) / 3; t++)
+      {
+        const f32v3 p0 = reorderedMesh.getPosition(reorderedMesh.indices[t * 3]);
+        GIMS_CHECK(glm::dot(reorderedMesh.getNormal(t), cameraPosition - p0) <= 1e-6f);
+      }
+    }
+  }
+  GIMS_CHECK(nCulled > meshlets.size() * 100 / 4);
+
+  // Without back-face culling nothing is culled by the cone.
+  Meshlets::CullingView view = createBackFaceView(f32v3(0.0f, 0.0f, 5.0f));
+  view.cullBackFaces         = false;
+  for (const auto& m : meshlets)
+  {
+    GIMS_CHECK(Meshlets::isVisible(m, view));
+  }
+}
+
+//! The triangles of a flat grid share one normal, so the cone is tight and culls the grid from behind only.
+void testConeOfPlanarMeshlets()
+{
+  const test::TestMesh mesh = test::createGrid(32);
+  std::vector<ui32>    reordered;
+  const auto           meshlets = buildMeshlets(mesh, reordered);
+  for (const auto& m : meshlets)
+  {
+    GIMS_CHECK(glm::distance(m.coneAxis, f32v3(0.0f, 0.0f, 1.0f)) < 1e-4f);
+    GIMS_CHECK(m.coneCutoff < 1e-3f);
+    GIMS_CHECK(!Meshlets::isVisible(m, createBackFaceView(f32v3(0.5f, 0.5f, -10.0f))));
+    GIMS_CHECK(Meshlets::isVisible(m, createBackFaceView(f32v3(0.5f, 0.5f, 10.0f))));
+  }
+}
+
+//! Meshlets with a vertex inside the view frustum are never culled, and meshlets behind the camera always are.
+void testFrustumCulling()
+{
+  const test::TestMesh mesh = test::createCubeSphere(16);
+  std::vector<ui32>    reordered;
+  const auto           meshlets = buildMeshlets(mesh, reordered);
+
+  // The camera looks along +z past the sphere, so only a part of it is inside the frustum.
+  const f32m4 projection          = glm::perspectiveFovLH_ZO(glm::radians(60.0f), 1.0f, 1.0f, 0.1f, 100.0f);
+  const f32m4 modelView           = glm::translate(f32m4(1.0f), f32v3(1.2f, 0.0f, 2.0f));
+  const f32m4 modelViewProjection = projection * modelView;
+  const auto  view                = Meshlets::createCullingView(modelView, projection, false);
+  const auto  isInside            = [&modelViewProjection](const f32v3& p)
+  {
+    const f32v4 clip = modelViewProjection * f32v4(p, 1.0f);
+    return std::abs(clip.x) < clip.w && std::abs(clip.y) < clip.w && clip.z > 0.0f && clip.z < clip.w;
+  };
+
+  ui32 nCulled = 0;
+  for (const auto& m : meshlets)
+  {
+    bool hasVertexInside = false;
+    for (ui32 i = m.firstIndex; i < m.firstIndex + m.nIndices; i++)
+    {
+      hasVertexInside = hasVertexInside || isInside(mesh.getPosition(reordered[i]));
+    }
+    const bool visible = Meshlets::isVisible(m, view);
+    GIMS_CHECK(visible || !hasVertexInside);
+    nCulled += visible ? 0 : 1;
+  }
+  GIMS_CHECK(nCulled > 0);
+
+  const f32m4 behindCamera = glm::translate(f32m4(1.0f), f32v3(0.0f, 0.0f, -3.0f));
+  for (const auto& m : meshlets)
+  {
+    GIMS_CHECK(!Meshlets::isVisible(m, Meshlets::createCullingView(behindCamera, projection, false)));
+  }
+}
+
+//! Visible meshlets that are adjacent in the index buffer are merged into one draw range.
+void testCullMeshletsRanges()
+{
+  const test::TestMesh mesh = test::createCubeSphere(16);
+  std::vector<ui32>    reordered;
+  const auto           meshlets = buildMeshlets(mesh, reordered);
+  const auto           view     = createBackFaceView(f32v3(0.0f, 3.0f, 0.0f));
+
+  std::vector<Meshlets::DrawRange> ranges;
+  const ui32 nVisible = Meshlets::cullMeshlets(ranges, meshlets.data(), static_cast<ui32>(meshlets.size()), view);
+  GIMS_CHECK(nVisible > 0 && nVisible < meshlets.size());
+
+  std::vector<bool> drawn(mesh.indices.size(), false);
+  for (size_t r = 0; r < ranges.size(); r++)
+  {
+    GIMS_CHECK(ranges[r].nIndices > 0);
+    if (r > 0)
+    {
+      // Ranges are sorted and maximal, i.e., separated by at least one culled meshlet.
+      GIMS_CHECK(ranges[r - 1].firstIndex + ranges[r - 1].nIndices < ranges[r].firstIndex);
+    }
+    std::fill(drawn.begin() + ranges[r].firstIndex, drawn.begin() + ranges[r].firstIndex + ranges[r].nIndices, true);
+  }
+  ui32 nExpected = 0;
+  for (const auto& m : meshlets)
+  {
+    const bool visible = Meshlets::isVisible(m, view);
+    nExpected += visible ? 1 : 0;
+    GIMS_CHECK(std::all_of(drawn.begin() + m.firstIndex, drawn.begin() + m.firstIndex + m.nIndices,
+                           [visible](bool d) { return d == visible; }));
+  }
+  GIMS_CHECK(nVisible == nExpected);
+
+  Meshlets::cullMeshlets(ranges, meshlets.data(), 0, view);
+  GIMS_CHECK(ranges.empty());
+}
+
+//! Meshlets built for a mesh are stored as a constant and survive saving and loading.
+void testMeshletsStoredInMesh()
+{
+  const test::TestMesh mesh = test::createCubeSphere(8);
+  CograBinaryMeshFile  file;
+  file.setPositions(mesh.positions.data(), mesh.getNumVertices());
+  file.setTriangleIndices(mesh.indices.data(), mesh.getNumTriangles());
+  GIMS_CHECK(Meshlets::getMeshlets(file).empty());
+
+  const auto meshlets = Meshlets::buildMeshlets(file);
+  const auto stored   = Meshlets::getMeshlets(file);
+  GIMS_CHECK(stored.size() == meshlets.size());
+  for (size_t i = 0; i < std::min(stored.size(), meshlets.size()); i++)
+  {
+    GIMS_CHECK(stored[i].firstIndex == meshlets[i].firstIndex && stored[i].nIndices == meshlets[i].nIndices);
+    GIMS_CHECK(stored[i].center == meshlets[i].center && stored[i].radius == meshlets[i].radius);
+  }
+  std::vector<ui32> reordered(file.getTriangleIndices(), file.getTriangleIndices() + mesh.indices.size());
+  checkMeshlets(mesh, reordered, meshlets, Meshlets::DEFAULT_MAX_VERTICES, Meshlets::DEFAULT_MAX_TRIANGLES);
+
+  const std::string fileName = (std::filesystem::temp_directory_path() / "gimslib_meshlets.cbm").string();
+  file.save(fileName, CograBinaryMeshFile::VERSION_2);
+  const auto loaded = Meshlets::getMeshlets(CograBinaryMeshFile(fileName));
+  std::filesystem::remove(fileName);
+  GIMS_CHECK(loaded.size() == meshlets.size() &&
+             std::memcmp(loaded.data(), meshlets.data(), sizeof(Meshlets::Meshlet) * meshlets.size()) == 0);
+
+  // Building again replaces the constant instead of adding a second one.
+  Meshlets::buildMeshlets(file, 16, 16);
+  GIMS_CHECK(file.getNumConstants() == 1);
+}
+} // namespace
+
+int main()
+{
+  GIMS_RUN_TEST(testBuildMeshletsLimits);
+  GIMS_RUN_TEST(testConeCullingIsConservative);
+  GIMS_RUN_TEST(testConeOfPlanarMeshlets);
+  GIMS_RUN_TEST(testFrustumCulling);
+  GIMS_RUN_TEST(testCullMeshletsRanges);
+  GIMS_RUN_TEST(testMeshletsStoredInMesh);
+  return test::getResult();
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <cmath>
+#include <vector>
+//! \brief Small procedural meshes for the host-side tests of gimslib.
+namespace gims
+{
+namespace test
+{
+//! \brief An indexed triangle mesh with three floats per position and three indices per triangle.
+struct TestMesh
+{
+  std::vector<f32>  positions;
+  std::vector<ui32> indices;
+
+  ui32 getNumVertices() const
+  {
+    return static_cast<ui32>(positions.size() / 3);
+  }
+
+  ui32 getNumTriangles() const
+  {
+    return static_cast<ui32>(indices.size() / 3);
+  }
+
+  f32v3 getPosition(ui32 vertexIdx) const
+  {
+    return f32v3(positions[vertexIdx * 3 + 0], positions[vertexIdx * 3 + 1], positions[vertexIdx * 3 + 2]);
+  }
+
+  //! Unnormalized normal cross(p1 - p0, p2 - p0) of a triangle.
+  f32v3 getNormal(ui32 triangleIdx) const
+  {
+    const f32v3 p0 = getPosition(indices[triangleIdx * 3 + 0]);
+    const f32v3 p1 = getPosition(indices[triangleIdx * 3 + 1]);
+    const f32v3 p2 = getPosition(indices[triangleIdx * 3 + 2]);
+    return glm::cross(p1 - p0, p2 - p0);
+  }
+};
+
+//! \brief Grid of n x n quads in the z = 0 plane covering [0, 1]^2, two triangles per quad, normals pointing to +z.
+inline TestMesh createGrid(ui32 n)
+{
+  TestMesh result;
+  for (ui32 y = 0; y <= n; y++)
+  {
+    for (ui32 x = 0; x <= n; x++)
+    {
+      const f32 u = static_cast<f32>(x) / static_cast<f32>(n);
+      const f32 v = static_cast<f32>(y) / static_cast<f32>(n);
+      result.positions.insert(result.positions.end(), {u, v, 0.0f});
+    }
+  }
+  for (ui32 y = 0; y < n; y++)
+  {
+    for (ui32 x = 0; x < n; x++)
+    {
+      const ui32 v00 = y * (n + 1) + x;
+      const ui32 v10 = v00 + 1;
+      const ui32 v01 = v00 + n + 1;
+      const ui32 v11 = v01 + 1;
+      result.indices.insert(result.indices.end(), {v00, v10, v11, v00, v11, v01});
+    }
+  }
+  return result;
+}
+
+//! \brief Unit sphere made of the six faces of a cube with n x n quads each, projected onto the sphere. Normals point
+//! outwards. Vertices along the edges of the cube are duplicated, so the faces are not connected.
+inline TestMesh createCubeSphere(ui32 n)
+{
+  // Origin and the two axes of each face, cross(u, v) points outwards.
+  const f32v3 faces[6][3] = {{f32v3(1, -1, -1), f32v3(0, 2, 0), f32v3(0, 0, 2)},
+                             {f32v3(-1, -1, -1), f32v3(0, 0, 2), f32v3(0, 2, 0)},
+                             {f32v3(-1, 1, -1), f32v3(0, 0, 2), f32v3(2, 0, 0)},
+                             {f32v3(-1, -1, -1), f32v3(2, 0, 0), f32v3(0, 0, 2)},
+                             {f32v3(-1, -1, 1), f32v3(2, 0, 0), f32v3(0, 2, 0)},
+                             {f32v3(-1, -1, -1), f32v3(0, 2, 0), f32v3(2, 0, 0)}};
+  TestMesh result;
+  for (const auto& face : faces)
+  {
+    const TestMesh grid        = createGrid(n);
+    const ui32     firstVertex = result.getNumVertices();
+    for (ui32 v = 0; v < grid.getNumVertices(); v++)
+    {
+      const f32v3 p = glm::normalize(face[0] + face[1] * grid.positions[v * 3] + face[2] * grid.positions[v * 3 + 1]);
+      result.positions.insert(result.positions.end(), {p.x, p.y, p.z});
+    }
+    for (const ui32 i : grid.indices)
+    {
+      result.indices.push_back(firstVertex + i);
+    }
+  }
+  return result;
+}
+} // namespace test
+} // namespace gims
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdio>
+#include <exception>
+//! \brief Minimal support for the host-side tests of gimslib.
+//!
+//! Each test is an executable, whose main runs its test functions with GIMS_RUN_TEST and returns
+//! gims::test::getResult(). Failed checks are reported with file and line, and the test continues.
+namespace gims
+{
+namespace test
+{
+//! \brief Number of failed checks and tests of the executable so far.
+inline int& getNumFailures()
+{
+  static int nFailures = 0;
+  return nFailures;
+}
+
+//! \brief Reports a failed check.
+inline void check(bool condition, const char* expression, const char* file, int line)
+{
+  if (!condition)
+  {
+    std::fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+    getNumFailures()++;
+  }
+}
+
+//! \brief Runs a test function. An exception that escapes the test counts as a failure.
+inline void run(const char* name, void (*testFunction)())
+{
+  const int nFailures = getNumFailures();
+  try
+  {
+    testFunction();
+  }
+  catch (const std::exception& e)
+  {
+    std::fprintf(stderr, "%s: unexpected exception: %s\n", name, e.what());
+    getNumFailures()++;
+  }
+  std::printf("%s %s\n", getNumFailures() == nFailures ? "passed" : "FAILED", name);
+}
+
+//! \brief Exit code of the test executable.
+inline int getResult()
+{
+  return getNumFailures() == 0 ? 0 : 1;
+}
+} // namespace test
+} // namespace gims
+
+#define GIMS_CHECK(condition) gims::test::check((condition), #condition, __FILE__, __LINE__)
+
+#define GIMS_CHECK_THROWS(statement, exceptionType)                                                                    \
+  do                                                                                                                   \
+  {                                                                                                                    \
+    bool thrown = false;                                                                                               \
+    try                                                                                                                \
+    {                                                                                                                  \
+      statement;                                                                                                       \
+    }                                                                                                                  \
+    catch (const exceptionType&)                                                                                       \
+    {                                                                                                                  \
+      thrown = true;                                                                                                   \
+    }                                                                                                                  \
+    gims::test::check(thrown, #statement " throws " #exceptionType, __FILE__, __LINE__);                               \
+  } while (false)
+
+#define GIMS_RUN_TEST(testFunction) gims::test::run(#testFunction, testFunction)
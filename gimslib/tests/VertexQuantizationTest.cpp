@@ -0,0 +1,344 @@
+#include "TestUtil.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <gimslib/mesh/VertexQuantization.hpp>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace gims;
+using namespace gims::VertexQuantization;
+
+namespace
+{
+// Not a multiple of four, so the SSE2 path and the scalar tail are both exercised.
+constexpr ui32 N_VERTICES = 1003;
+
+//! Random unit vectors, plus the axes and the diagonals, where the octahedral mapping folds.
+std::vector<f32> createUnitVectors(ui32 nVertices)
+{
+  const f32v3 special[] = {f32v3(1, 0, 0),  f32v3(-1, 0, 0), f32v3(0, 1, 0), f32v3(0, -1, 0), f32v3(0, 0, 1),
+                           f32v3(0, 0, -1), f32v3(1, 1, 1),  f32v3(-1, 1, -1), f32v3(1, -1, 0), f32v3(-1, 0, -1)};
+  std::mt19937                        random(1);
+  std::uniform_real_distribution<f32> uniform(-1.0f, 1.0f);
+  std::vector<f32>                    result;
+  for (const f32v3& v : special)
+  {
+    const f32v3 n = glm::normalize(v);
+    result.insert(result.end(), {n.x, n.y, n.z});
+  }
+  while (result.size() < nVertices * 3)
+  {
+    const f32v3 v(uniform(random), uniform(random), uniform(random));
+    if (glm::length(v) > 0.1f)
+    {
+      const f32v3 n = glm::normalize(v);
+      result.insert(result.end(), {n.x, n.y, n.z});
+    }
+  }
+  return result;
+}
+
+f32v3 getVector(const std::vector<f32>& values, ui32 vertexIdx)
+{
+  return f32v3(values[vertexIdx * 3], values[vertexIdx * 3 + 1], values[vertexIdx * 3 + 2]);
+}
+
+bool isWithin(const f32v3& error, const f32v3& tolerance)
+{
+  return error.x <= tolerance.x && error.y <= tolerance.y && error.z <= tolerance.z;
+}
+
+f32 getAngle(const f32v3& a, const f32v3& b)
+{
+  // atan2 of the cross and dot product is accurate for small angles, unlike acos.
+  return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+}
+
+//! Positions round to the nearest of 65535 steps per axis, including the corners of the bounding box. An axis without
+//! extent decodes exactly. The encoded positions are strided, as in an interleaved vertex.
+void testPositionsUnorm16()
+{
+  const f32v3                         boundsMin(-12.5f, 3.0f, 7.0f);
+  const f32v3                         boundsMax(40.0f, 3.5f, 7.0f);
+  std::mt19937                        random(2);
+  std::uniform_real_distribution<f32> uniform(0.0f, 1.0f);
+  std::vector<f32>                    positions;
+  positions.insert(positions.end(), {boundsMin.x, boundsMin.y, boundsMin.z, boundsMax.x, boundsMax.y, boundsMax.z});
+  for (ui32 v = 2; v < N_VERTICES; v++)
+  {
+    const f32v3 p = boundsMin + (boundsMax - boundsMin) * f32v3(uniform(random), uniform(random), uniform(random));
+    positions.insert(positions.end(), {p.x, p.y, p.z});
+  }
+
+  const PositionDequantization dequantization = getPositionDequantization(POSITION_UNORM16, boundsMin, boundsMax);
+  constexpr size_t             encodedStride  = 20;
+  std::vector<ui8>             encoded(N_VERTICES * encodedStride);
+  std::vector<f32>             decoded(N_VERTICES * 3);
+  encodePositionsUnorm16(encoded.data(), encodedStride, positions.data(), 3 * sizeof(f32), N_VERTICES,
+                         dequantization);
+  decodePositionsUnorm16(decoded.data(), 3 * sizeof(f32), encoded.data(), encodedStride, N_VERTICES, dequantization);
+
+  const f32v3 extent    = boundsMax - boundsMin;
+  const f32v3 tolerance = extent * (0.5f / 65535.0f) + glm::max(glm::abs(boundsMin), glm::abs(boundsMax)) * 4e-7f;
+  for (ui32 v = 0; v < N_VERTICES; v++)
+  {
+    const f32v3 error = glm::abs(getVector(decoded, v) - getVector(positions, v));
+    GIMS_CHECK(error.x <= tolerance.x && error.y <= tolerance.y && error.z == 0.0f);
+    ui16 w;
+    std::memcpy(&w, &encoded[v * encodedStride + 6], sizeof(w));
+    GIMS_CHECK(w == 0);
+  }
+  GIMS_CHECK(getVector(decoded, 0) == boundsMin);
+  GIMS_CHECK(isWithin(glm::abs(getVector(decoded, 1) - boundsMax), tolerance));
+
+  const PositionDequantization identity = getPositionDequantization(POSITION_FLOAT3, boundsMin, boundsMax);
+  GIMS_CHECK(identity.offset == f32v3(0.0f) && identity.scale == f32v3(1.0f));
+}
+
+//! Octahedral normals stay within 0.0004 radians of the input, decode to length 1, and zero vectors decode to +z.
+void testNormalsOctahedral()
+{
+  std::vector<f32> normals = createUnitVectors(N_VERTICES);
+  normals[0] = normals[1] = normals[2] = 0.0f;
+  std::vector<i16> encoded(N_VERTICES * 2);
+  std::vector<f32> decoded(N_VERTICES * 3);
+  encodeNormalsOctahedral(encoded.data(), 2 * sizeof(i16), normals.data(), 3 * sizeof(f32), N_VERTICES);
+  decodeNormalsOctahedral(decoded.data(), 3 * sizeof(f32), encoded.data(), 2 * sizeof(i16), N_VERTICES);
+
+  GIMS_CHECK(getVector(decoded, 0) == f32v3(0.0f, 0.0f, 1.0f));
+  f32 maxAngle = 0.0f;
+  for (ui32 v = 1; v < N_VERTICES; v++)
+  {
+    const f32v3 n = getVector(decoded, v);
+    GIMS_CHECK(std::abs(glm::length(n) - 1.0f) <= 1e-6f);
+    maxAngle = std::max(maxAngle, getAngle(n, getVector(normals, v)));
+  }
+  GIMS_CHECK(maxAngle <= 0.0004f);
+}
+
+//! Each component of a 10 bit normal is within 0.5 / 1023 * 2 of the input, about 0.0017 radians after
+//! renormalization.
+void testNormalsUnorm10()
+{
+  const std::vector<f32> normals = createUnitVectors(N_VERTICES);
+  std::vector<ui32>      encoded(N_VERTICES);
+  std::vector<f32>       decoded(N_VERTICES * 3);
+  encodeNormalsUnorm10(encoded.data(), sizeof(ui32), normals.data(), 3 * sizeof(f32), N_VERTICES);
+  decodeNormalsUnorm10(decoded.data(), 3 * sizeof(f32), encoded.data(), sizeof(ui32), N_VERTICES);
+
+  f32 maxAngle = 0.0f;
+  for (ui32 v = 0; v < N_VERTICES; v++)
+  {
+    const f32v3 n     = getVector(decoded, v);
+    const f32v3 error = glm::abs(n - getVector(normals, v));
+    GIMS_CHECK(isWithin(error, f32v3(0.5f / 1023.0f * 2.0f + 1e-6f)));
+    GIMS_CHECK(encoded[v] >> 30 == 0);
+    maxAngle = std::max(maxAngle, getAngle(glm::normalize(n), getVector(normals, v)));
+  }
+  GIMS_CHECK(maxAngle <= 0.0017f);
+}
+
+//! Half floats are within 2^-11 relative to the input, keep values that are representable, round ties to even, and
+//! keep the sign of zero.
+void testTextureCoordinatesHalf()
+{
+  std::mt19937                        random(3);
+  std::uniform_real_distribution<f32> exponent(-14.0f, 15.0f);
+  std::vector<f32>                    textureCoordinates = {0.0f,    -0.0f,    1.0f,  -1.0f,          0.5f,
+                                                            2048.0f, 65504.0f, 0.25f, 1.00048828125f, 1.00146484375f};
+  while (textureCoordinates.size() < N_VERTICES * 2)
+  {
+    const f32 value = std::exp2(exponent(random));
+    textureCoordinates.push_back(textureCoordinates.size() % 3 == 0 ? -value : value);
+  }
+  std::vector<ui16> encoded(N_VERTICES * 2);
+  std::vector<f32>  decoded(N_VERTICES * 2);
+  encodeTextureCoordinatesHalf(encoded.data(), 2 * sizeof(ui16), textureCoordinates.data(), 2 * sizeof(f32),
+                               N_VERTICES);
+  decodeTextureCoordinatesHalf(decoded.data(), 2 * sizeof(f32), encoded.data(), 2 * sizeof(ui16), N_VERTICES);
+
+  for (ui32 i = 0; i < N_VERTICES * 2; i++)
+  {
+    GIMS_CHECK(std::abs(decoded[i] - textureCoordinates[i]) <= std::abs(textureCoordinates[i]) * std::exp2(-11.0f));
+  }
+  for (ui32 i = 0; i < 8; i++)
+  {
+    GIMS_CHECK(decoded[i] == textureCoordinates[i]);
+  }
+  GIMS_CHECK(encoded[0] == 0x0000 && encoded[1] == 0x8000);
+  GIMS_CHECK(encoded[2] == 0x3c00 && encoded[3] == 0xbc00);
+  // 1 + 2^-11 is halfway between 1 and 1 + 2^-10 and rounds to the even 1, 1 + 3 * 2^-11 rounds up to 1 + 2^-9.
+  GIMS_CHECK(decoded[8] == 1.0f);
+  GIMS_CHECK(decoded[9] == 1.0f + std::exp2(-9.0f));
+}
+
+//! Tangent components are within 0.5 / 32767 of the input, and the handedness is kept exactly.
+void testTangentsSnorm16()
+{
+  const std::vector<f32> directions = createUnitVectors(N_VERTICES);
+  std::vector<f32>       tangents(N_VERTICES * 4);
+  for (ui32 v = 0; v < N_VERTICES; v++)
+  {
+    std::copy_n(&directions[v * 3], 3, &tangents[v * 4]);
+    tangents[v * 4 + 3] = v % 2 == 0 ? 1.0f : -1.0f;
+  }
+  std::vector<i16> encoded(N_VERTICES * 4);
+  std::vector<f32> decoded(N_VERTICES * 4);
+  encodeTangentsSnorm16(encoded.data(), 4 * sizeof(i16), tangents.data(), 4 * sizeof(f32), N_VERTICES);
+  decodeTangentsSnorm16(decoded.data(), 4 * sizeof(f32), encoded.data(), 4 * sizeof(i16), N_VERTICES);
+
+  for (ui32 v = 0; v < N_VERTICES; v++)
+  {
+    for (ui32 c = 0; c < 3; c++)
+    {
+      GIMS_CHECK(std::abs(decoded[v * 4 + c] - tangents[v * 4 + c]) <= 0.5f / 32767.0f + 1e-7f);
+    }
+    GIMS_CHECK(decoded[v * 4 + 3] == tangents[v * 4 + 3]);
+  }
+}
+
+//! Encoding all vertices at once, four at a time, gives the same bits as encoding one vertex after the other with the
+//! scalar path.
+void testBatchesMatchSingleVertices()
+{
+  const std::vector<f32> normals = createUnitVectors(N_VERTICES);
+  std::vector<f32>       tangents(N_VERTICES * 4);
+  for (ui32 v = 0; v < N_VERTICES; v++)
+  {
+    std::copy_n(&normals[v * 3], 3, &tangents[v * 4]);
+    tangents[v * 4 + 3] = -1.0f;
+  }
+  const PositionDequantization dequantization =
+      getPositionDequantization(POSITION_UNORM16, f32v3(-1.0f), f32v3(1.0f, 2.0f, 3.0f));
+
+  const auto compare = [](auto encode, size_t encodedSize)
+  {
+    std::vector<ui8> batch(N_VERTICES * encodedSize);
+    std::vector<ui8> single(N_VERTICES * encodedSize);
+    encode(batch.data(), 0, N_VERTICES);
+    for (ui32 v = 0; v < N_VERTICES; v++)
+    {
+      encode(single.data() + v * encodedSize, v, 1);
+    }
+    return batch == single;
+  };
+  GIMS_CHECK(compare(
+      [&](void* destination, ui32 first, ui32 n)
+      { encodePositionsUnorm16(destination, 8, &normals[first * 3], 3 * sizeof(f32), n, dequantization); },
+      8));
+  GIMS_CHECK(compare([&](void* destination, ui32 first, ui32 n)
+                     { encodeNormalsOctahedral(destination, 4, &normals[first * 3], 3 * sizeof(f32), n); },
+                     4));
+  GIMS_CHECK(compare([&](void* destination, ui32 first, ui32 n)
+                     { encodeNormalsUnorm10(destination, 4, &normals[first * 3], 3 * sizeof(f32), n); },
+                     4));
+  GIMS_CHECK(compare([&](void* destination, ui32 first, ui32 n)
+                     { encodeTextureCoordinatesHalf(destination, 4, &normals[first * 3], 3 * sizeof(f32), n); },
+                     4));
+  GIMS_CHECK(compare([&](void* destination, ui32 first, ui32 n)
+                     { encodeTangentsSnorm16(destination, 8, &tangents[first * 4], 4 * sizeof(f32), n); },
+                     8));
+}
+
+//! encodeVertices writes each attribute with its own encoder at the offsets of getVertexLayout.
+void testEncodeVertices()
+{
+  // Interleaved source vertices: position, normal, texture coordinate.
+  constexpr ui32   sourceFloats = 8;
+  std::vector<f32> source(N_VERTICES * sourceFloats);
+  std::vector<f32> tangents(N_VERTICES * 4);
+  const auto       normals = createUnitVectors(N_VERTICES);
+  for (ui32 v = 0; v < N_VERTICES; v++)
+  {
+    f32* const vertex = &source[v * sourceFloats];
+    vertex[0]         = static_cast<f32>(v % 17);
+    vertex[1]         = static_cast<f32>(v % 5) * 0.5f;
+    vertex[2]         = -static_cast<f32>(v % 3);
+    std::copy_n(&normals[v * 3], 3, vertex + 3);
+    vertex[6] = static_cast<f32>(v) / static_cast<f32>(N_VERTICES);
+    vertex[7] = 1.0f - vertex[6];
+    std::copy_n(&normals[v * 3], 3, &tangents[v * 4]);
+    tangents[v * 4 + 3] = 1.0f;
+  }
+  const PositionDequantization dequantization =
+      getPositionDequantization(POSITION_UNORM16, f32v3(0.0f, 0.0f, -2.0f), f32v3(16.0f, 2.0f, 0.0f));
+  constexpr size_t sourceStride = sourceFloats * sizeof(f32);
+
+  const VertexFormat formats[] = {VertexFormat(),
+                                  {POSITION_UNORM16, NORMAL_UNORM10_10_10_2, TEXTURE_COORDINATE_HALF2, TANGENT_SNORM16},
+                                  UNCOMPRESSED_VERTEX_FORMAT};
+  for (const VertexFormat& format : formats)
+  {
+    const VertexLayout layout = getVertexLayout(format);
+    GIMS_CHECK(layout.stride % 4 == 0);
+    std::vector<ui8> vertices(N_VERTICES * layout.stride);
+    encodeVertices(vertices.data(), format, &source[0], &source[3], &source[6], sourceStride, N_VERTICES,
+                   dequantization, tangents.data());
+
+    // Each attribute separately, with the stride of the vertex.
+    std::vector<ui8> expected(N_VERTICES * layout.stride);
+    if (format.position == POSITION_UNORM16)
+    {
+      encodePositionsUnorm16(&expected[layout.positionOffset], layout.stride, &source[0], sourceStride, N_VERTICES,
+                             dequantization);
+    }
+    if (format.normal == NORMAL_OCTAHEDRAL_SNORM16)
+    {
+      encodeNormalsOctahedral(&expected[layout.normalOffset], layout.stride, &source[3], sourceStride, N_VERTICES);
+    }
+    else if (format.normal == NORMAL_UNORM10_10_10_2)
+    {
+      encodeNormalsUnorm10(&expected[layout.normalOffset], layout.stride, &source[3], sourceStride, N_VERTICES);
+    }
+    if (format.textureCoordinate == TEXTURE_COORDINATE_HALF2)
+    {
+      encodeTextureCoordinatesHalf(&expected[layout.textureCoordinateOffset], layout.stride, &source[6], sourceStride,
+                                   N_VERTICES);
+    }
+    if (format.tangent == TANGENT_SNORM16)
+    {
+      encodeTangentsSnorm16(&expected[layout.tangentOffset], layout.stride, tangents.data(), 4 * sizeof(f32),
+                            N_VERTICES);
+    }
+    for (ui32 v = 0; v < N_VERTICES; v++)
+    {
+      ui8* const vertex = &expected[v * layout.stride];
+      if (format.position == POSITION_FLOAT3)
+      {
+        std::memcpy(vertex + layout.positionOffset, &source[v * sourceFloats], 3 * sizeof(f32));
+      }
+      if (format.normal == NORMAL_FLOAT3)
+      {
+        std::memcpy(vertex + layout.normalOffset, &source[v * sourceFloats + 3], 3 * sizeof(f32));
+      }
+      if (format.textureCoordinate == TEXTURE_COORDINATE_FLOAT2)
+      {
+        std::memcpy(vertex + layout.textureCoordinateOffset, &source[v * sourceFloats + 6], 2 * sizeof(f32));
+      }
+    }
+    GIMS_CHECK(vertices == expected);
+  }
+  GIMS_CHECK(getVertexLayout(VertexFormat()).stride == 16);
+  GIMS_CHECK(getVertexLayout(UNCOMPRESSED_VERTEX_FORMAT).stride == 32);
+
+  const VertexFormat withTangents = {POSITION_FLOAT3, NORMAL_FLOAT3, TEXTURE_COORDINATE_FLOAT2, TANGENT_FLOAT4};
+  std::vector<ui8>   vertices(getVertexLayout(withTangents).stride);
+  GIMS_CHECK_THROWS(encodeVertices(vertices.data(), withTangents, &source[0], &source[3], &source[6], sourceStride, 1,
+                                   dequantization),
+                    std::runtime_error);
+}
+} // namespace
+
+int main()
+{
+  GIMS_RUN_TEST(testPositionsUnorm16);
+  GIMS_RUN_TEST(testNormalsOctahedral);
+  GIMS_RUN_TEST(testNormalsUnorm10);
+  GIMS_RUN_TEST(testTextureCoordinatesHalf);
+  GIMS_RUN_TEST(testTangentsSnorm16);
+  GIMS_RUN_TEST(testBatchesMatchSingleVertices);
+  GIMS_RUN_TEST(testEncodeVertices);
+  return test::getResult();
+}